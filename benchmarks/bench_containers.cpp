@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: MIT
+
+/// \file
+/// \brief Benchmark flat and small containers against std containers
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "dfe/dfe_flat.hpp"
+#include "dfe/dfe_smallvector.hpp"
+
+static constexpr std::size_t kNLookups = 1 << 16;
+
+using Keys = std::vector<uint64_t>;
+
+// unique keys in random order
+Keys
+make_keys(std::size_t n, unsigned seed) {
+  std::mt19937_64 rng(seed);
+  std::set<uint64_t> unique;
+  while (unique.size() < n) {
+    unique.insert(rng() % (4 * n));
+  }
+  Keys keys(unique.begin(), unique.end());
+  std::shuffle(keys.begin(), keys.end(), rng);
+  return keys;
+}
+
+// keys to look up with roughly half of them present in the container
+Keys
+make_queries(std::size_t n, unsigned seed) {
+  std::mt19937_64 rng(seed);
+  Keys queries(kNLookups);
+  for (auto& q : queries) {
+    q = rng() % (2 * n);
+  }
+  return queries;
+}
+
+template<typename Set>
+void
+run_set(bench::Runner& runner, const std::string& name, std::size_t n) {
+  const auto keys = make_keys(n, 0);
+  const auto queries = make_queries(n, 1);
+  const auto label = "/size=" + std::to_string(n);
+
+  runner.run(name + "_insert" + label, n, 0, [&](auto reps) {
+    for (decltype(reps) r = 0; r < reps; ++r) {
+      Set set;
+      for (auto k : keys) {
+        set.insert(k);
+      }
+      bench::keep(set);
+    }
+  });
+  runner.run(name + "_bulk_insert" + label, n, 0, [&](auto reps) {
+    for (decltype(reps) r = 0; r < reps; ++r) {
+      Set set;
+      set.insert(keys.begin(), keys.end());
+      bench::keep(set);
+    }
+  });
+  Set set;
+  set.insert(keys.begin(), keys.end());
+  runner.run(name + "_contains" + label, kNLookups, 0, [&](auto reps) {
+    std::size_t found = 0;
+    for (decltype(reps) r = 0; r < reps; ++r) {
+      for (auto q : queries) {
+        found += (set.find(q) != set.end());
+      }
+    }
+    bench::keep(found);
+  });
+}
+
+// adapt the dfe::FlatSet interface to the std::set calls used above
+struct FlatSet : dfe::FlatSet<uint64_t> {
+  using dfe::FlatSet<uint64_t>::insert;
+  void insert(uint64_t k) { insert_or_assign(k); }
+};
+struct FlatSetEytzinger : FlatSet {
+  FlatSetEytzinger() { set_eytzinger_index(true); }
+};
+
+template<typename Map>
+void
+run_map(bench::Runner& runner, const std::string& name, std::size_t n) {
+  const auto keys = make_keys(n, 2);
+  const auto queries = make_queries(n, 3);
+  const auto label = "/size=" + std::to_string(n);
+
+  runner.run(name + "_insert" + label, n, 0, [&](auto reps) {
+    for (decltype(reps) r = 0; r < reps; ++r) {
+      Map map;
+      for (auto k : keys) {
+        map.emplace(k, static_cast<double>(k));
+      }
+      bench::keep(map);
+    }
+  });
+  Map map;
+  for (auto k : keys) {
+    map.emplace(k, static_cast<double>(k));
+  }
+  runner.run(name + "_contains" + label, kNLookups, 0, [&](auto reps) {
+    std::size_t found = 0;
+    for (decltype(reps) r = 0; r < reps; ++r) {
+      for (auto q : queries) {
+        found += map.contains(q);
+      }
+    }
+    bench::keep(found);
+  });
+}
+
+// adapt the std::map interface to the dfe::FlatMap calls used above
+struct StdMap : std::map<uint64_t, double> {
+  bool contains(uint64_t k) const { return find(k) != end(); }
+};
+
+template<typename Vector>
+void
+run_vector(bench::Runner& runner, const std::string& name, std::size_t n) {
+  static constexpr std::size_t kNVectors = 1024;
+
+  // many short-lived vectors, e.g. temporary per-entry lists
+  const auto label = "/size=" + std::to_string(n);
+  runner.run(name + "_push_back" + label, kNVectors * n, 0, [&](auto reps) {
+    for (decltype(reps) r = 0; r < reps; ++r) {
+      for (std::size_t v = 0; v < kNVectors; ++v) {
+        Vector vec;
+        for (std::size_t i = 0; i < n; ++i) {
+          vec.push_back(static_cast<int32_t>(v + i));
+        }
+        bench::keep(vec);
+      }
+    }
+  });
+}
+
+int
+main(int argc, char* argv[]) {
+  bench::Runner runner(argc, argv);
+  for (std::size_t n : {16u, 1024u, 65536u}) {
+    run_set<std::set<uint64_t>>(runner, "std_set", n);
+    run_set<FlatSet>(runner, "flat_set", n);
+    run_set<FlatSetEytzinger>(runner, "flat_set_eytzinger", n);
+  }
+  for (std::size_t n : {16u, 1024u, 65536u}) {
+    run_map<StdMap>(runner, "std_map", n);
+    run_map<dfe::FlatMap<uint64_t, double>>(runner, "flat_map", n);
+  }
+  for (std::size_t n : {4u, 8u, 32u}) {
+    run_vector<std::vector<int32_t>>(runner, "std_vector", n);
+    run_vector<dfe::SmallVector<int32_t, 8>>(runner, "small_vector", n);
+  }
+  return runner.finish();
+}
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: MIT
+
+/// \file
+/// \brief Benchmark the dfe::Dispatcher call overhead
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "dfe/dfe_dispatcher.hpp"
+
+static constexpr std::size_t kNCalls = 1 << 14;
+
+double
+add(int x, double f) {
+  return x + f;
+}
+
+int
+main(int argc, char* argv[]) {
+  bench::Runner runner(argc, argv);
+  dfe::Dispatcher dispatcher(1);
+  dispatcher.add("add", add);
+
+  // baseline w/o any dispatch overhead except the type-erased call
+  std::function<double(int, double)> direct = add;
+  runner.run("dispatcher/std_function", kNCalls, 0, [&](auto n) {
+    double sum = 0;
+    for (decltype(n) r = 0; r < n; ++r) {
+      for (std::size_t i = 0; i < kNCalls; ++i) {
+        sum += direct(static_cast<int>(i), 0.5);
+      }
+    }
+    bench::keep(sum);
+  });
+  runner.run("dispatcher/call", kNCalls, 0, [&](auto n) {
+    double sum = 0;
+    for (decltype(n) r = 0; r < n; ++r) {
+      for (std::size_t i = 0; i < kNCalls; ++i) {
+        sum += dispatcher.call("add", static_cast<int>(i), 0.5).as<double>();
+      }
+    }
+    bench::keep(sum);
+  });
+  auto handle = dispatcher.lookup("add");
+  runner.run("dispatcher/invoke", kNCalls, 0, [&](auto n) {
+    double sum = 0;
+    for (decltype(n) r = 0; r < n; ++r) {
+      for (std::size_t i = 0; i < kNCalls; ++i) {
+        sum += dispatcher.invoke<double>(handle, static_cast<int>(i), 0.5);
+      }
+    }
+    bench::keep(sum);
+  });
+  const std::vector<std::string> args = {"42", "0.5"};
+  runner.run("dispatcher/call_parsed", kNCalls, 0, [&](auto n) {
+    double sum = 0;
+    for (decltype(n) r = 0; r < n; ++r) {
+      for (std::size_t i = 0; i < kNCalls; ++i) {
+        sum += dispatcher.call_parsed("add", args).as<double>();
+      }
+    }
+    bench::keep(sum);
+  });
+  return runner.finish();
+}
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: MIT
+
+/// \file
+/// \brief Benchmark histogram filling for different axes and dimensions
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "dfe/dfe_histogram.hpp"
+
+static constexpr std::size_t kNEntries = 1 << 16;
+
+using Values = std::vector<double>;
+
+// uniformly distributed values that also cover the under/overflow range
+Values
+make_values(unsigned seed) {
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> uniform(-0.1, 1.1);
+  Values values(kNEntries);
+  for (auto& v : values) {
+    v = uniform(rng);
+  }
+  return values;
+}
+
+// values strictly within the axis range
+Values
+make_values_within(unsigned seed) {
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> uniform(0.001, 0.999);
+  Values values(kNEntries);
+  for (auto& v : values) {
+    v = uniform(rng);
+  }
+  return values;
+}
+
+std::vector<double>
+make_edges(std::size_t nbins) {
+  std::vector<double> edges(nbins + 1);
+  for (std::size_t i = 0; i <= nbins; ++i) {
+    // non-uniform edges with increasing bin size
+    double x = static_cast<double>(i) / nbins;
+    edges[i] = x * x;
+  }
+  return edges;
+}
+
+template<typename H, typename... Vs>
+void
+run_fill(
+  bench::Runner& runner, const std::string& name, H h, const Vs&... values) {
+  runner.run(name, kNEntries, 0, [&](auto n) {
+    for (decltype(n) r = 0; r < n; ++r) {
+      for (std::size_t i = 0; i < kNEntries; ++i) {
+        h.fill(values[i]...);
+      }
+    }
+    bench::keep(h);
+  });
+  runner.run(name + "/fill_n", kNEntries, 0, [&](auto n) {
+    for (decltype(n) r = 0; r < n; ++r) {
+      h.fill_n(kNEntries, values.data()...);
+    }
+    bench::keep(h);
+  });
+}
+
+void
+run_axes(bench::Runner& runner, const Values& x) {
+  using dfe::Histogram;
+  using dfe::LogAxis;
+  using dfe::OverflowAxis;
+  using dfe::UniformAxis;
+  using dfe::VariableAxis;
+  // enforce a separate shifted range for the logarithmic axis
+  Values log_x(x.size());
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    log_x[i] = 1 + 999 * x[i];
+  }
+
+  for (std::size_t nbins : {16u, 1024u}) {
+    const auto label = "/bins=" + std::to_string(nbins);
+    run_fill(
+      runner, "hist_fill/axis=uniform" + label,
+      Histogram<double, UniformAxis<double>>({0.0, 1.0, nbins}), x);
+    run_fill(
+      runner, "hist_fill/axis=overflow" + label,
+      Histogram<double, OverflowAxis<double>>({0.0, 1.0, nbins}), x);
+    run_fill(
+      runner, "hist_fill/axis=variable" + label,
+      Histogram<double, VariableAxis<double>>(
+        VariableAxis<double>(make_edges(nbins))),
+      x);
+    run_fill(
+      runner, "hist_fill/axis=log" + label,
+      Histogram<double, LogAxis<double>>({1.0, 1000.0, nbins}), log_x);
+  }
+}
+
+void
+run_dimensions(bench::Runner& runner) {
+  using dfe::Histogram;
+  using Axis = dfe::OverflowAxis<double>;
+
+  const auto x = make_values(1);
+  const auto y = make_values(2);
+  const auto z = make_values(3);
+  run_fill(
+    runner, "hist_fill/dims=1", Histogram<double, Axis>({0.0, 1.0, 64}), x);
+  run_fill(
+    runner, "hist_fill/dims=2",
+    Histogram<double, Axis, Axis>({0.0, 1.0, 64}, {0.0, 1.0, 64}), x, y);
+  run_fill(
+    runner, "hist_fill/dims=3",
+    Histogram<double, Axis, Axis, Axis>(
+      {0.0, 1.0, 64}, {0.0, 1.0, 64}, {0.0, 1.0, 64}),
+    x, y, z);
+}
+
+int
+main(int argc, char* argv[]) {
+  bench::Runner runner(argc, argv);
+  // axes w/o under/overflow bins throw for values outside their range
+  run_axes(runner, make_values_within(0));
+  run_dimensions(runner);
+  return runner.finish();
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MIT
+
+/// \file
+/// \brief Benchmark the delimiter-based and numpy i/o throughput
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "dfe/dfe_io_dsv.hpp"
+#include "dfe/dfe_io_numpy.hpp"
+#include "records.hpp"
+
+static constexpr std::size_t kNRecords = 100000;
+
+template<typename Writer, typename Record>
+void
+write_file(const std::string& path, const std::vector<Record>& records) {
+  Writer writer(path);
+  for (const auto& record : records) {
+    writer.append(record);
+  }
+}
+
+template<typename Reader, typename Record>
+void
+read_file(const std::string& path) {
+  Reader reader(path);
+  Record record;
+  while (reader.read(record)) {
+    bench::keep(record);
+  }
+}
+
+template<typename Record>
+void
+run_io(bench::Runner& runner, const std::string& label) {
+  using Csv = dfe::NamedTupleCsvWriter<Record>;
+  using CsvReader = dfe::NamedTupleCsvReader<Record>;
+  using Npy = dfe::NamedTupleNumpyWriter<Record>;
+  using NpyReader = dfe::NamedTupleNumpyReader<Record>;
+
+  const auto records = make_records<Record>(kNRecords);
+  const std::string csv = "bench_io_" + label + ".csv";
+  const std::string npy = "bench_io_" + label + ".npy";
+  const std::string suffix = "/fields=" + label;
+
+  // write once to determine the file size used for the byte throughput
+  write_file<Csv>(csv, records);
+  write_file<Npy>(npy, records);
+
+  runner.run("csv_write" + suffix, kNRecords, file_size(csv), [&](auto n) {
+    for (decltype(n) i = 0; i < n; ++i) {
+      write_file<Csv>(csv, records);
+    }
+  });
+  runner.run("csv_read" + suffix, kNRecords, file_size(csv), [&](auto n) {
+    for (decltype(n) i = 0; i < n; ++i) {
+      read_file<CsvReader, Record>(csv);
+    }
+  });
+  runner.run("npy_write" + suffix, kNRecords, file_size(npy), [&](auto n) {
+    for (decltype(n) i = 0; i < n; ++i) {
+      write_file<Npy>(npy, records);
+    }
+  });
+  runner.run("npy_read" + suffix, kNRecords, file_size(npy), [&](auto n) {
+    for (decltype(n) i = 0; i < n; ++i) {
+      read_file<NpyReader, Record>(npy);
+    }
+  });
+}
+
+int
+main(int argc, char* argv[]) {
+  bench::Runner runner(argc, argv);
+  run_io<Narrow>(runner, "2");
+  run_io<Medium>(runner, "8");
+  run_io<Wide>(runner, "16");
+  return runner.finish();
+}
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: MIT
+
+/// \file
+/// \brief Benchmark the ROOT i/o throughput
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "dfe/dfe_io_root.hpp"
+#include "records.hpp"
+
+static constexpr std::size_t kNRecords = 100000;
+static constexpr std::size_t kBatchSize = 4096;
+static const char* kTreeName = "records";
+
+template<typename Record>
+void
+write_file(const std::string& path, const std::vector<Record>& records) {
+  dfe::NamedTupleRootWriter<Record> writer(path, kTreeName);
+  for (const auto& record : records) {
+    writer.append(record);
+  }
+}
+
+template<typename Record>
+void
+read_file(const std::string& path) {
+  dfe::NamedTupleRootReader<Record> reader(path, kTreeName);
+  Record record;
+  while (reader.read(record)) {
+    bench::keep(record);
+  }
+}
+
+template<typename Record>
+void
+read_file_batched(const std::string& path) {
+  dfe::NamedTupleRootReader<Record> reader(path, kTreeName);
+  dfe::NamedTupleColumns<Record> columns;
+  while (0 < reader.read_batch(kBatchSize, columns)) {
+    bench::keep(columns);
+  }
+}
+
+template<typename Record>
+void
+run_io(bench::Runner& runner, const std::string& label) {
+  const auto records = make_records<Record>(kNRecords);
+  const std::string path = "bench_io_root_" + label + ".root";
+  const std::string suffix = "/fields=" + label;
+
+  // write once to determine the file size used for the byte throughput
+  write_file(path, records);
+  // compressed on-disk size; not directly comparable to other backends
+  const auto bytes = file_size(path);
+
+  runner.run("root_write" + suffix, kNRecords, bytes, [&](auto n) {
+    for (decltype(n) i = 0; i < n; ++i) {
+      write_file(path, records);
+    }
+  });
+  runner.run("root_read" + suffix, kNRecords, bytes, [&](auto n) {
+    for (decltype(n) i = 0; i < n; ++i) {
+      read_file<Record>(path);
+    }
+  });
+  runner.run("root_read_batch" + suffix, kNRecords, bytes, [&](auto n) {
+    for (decltype(n) i = 0; i < n; ++i) {
+      read_file_batched<Record>(path);
+    }
+  });
+}
+
+int
+main(int argc, char* argv[]) {
+  bench::Runner runner(argc, argv);
+  run_io<Narrow>(runner, "2");
+  run_io<Medium>(runner, "8");
+  run_io<Wide>(runner, "16");
+  return runner.finish();
+}
@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: MIT
+
+/// \file
+/// \brief Minimal benchmark runner shared among benchmarks
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+/// Prevent the compiler from optimizing away the computation of a value.
+template<typename T>
+inline void
+keep(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  __asm__ __volatile__("" : : "r"(&value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+/// Run benchmarks and report the results as JSON.
+///
+/// Each benchmark is a callable that executes a fixed unit of work, e.g.
+/// writing a complete file, for the given number of repetitions. The number
+/// of repetitions is increased until the measurement takes at least the
+/// minimum time. The best of multiple measurements is reported together with
+/// the throughput derived from the number of items and bytes per repetition.
+///
+/// Supported command line arguments are
+///
+///     --filter <substring>  only run benchmarks whose name contains it
+///     --min-time <seconds>  minimum duration of each measurement
+///     --output <path>       write the JSON report to a file, not stdout
+///     --repetitions <n>     number of measurements per benchmark
+///
+class Runner {
+public:
+  Runner(int argc, char* argv[]);
+  Runner(const Runner&) = delete;
+  Runner& operator=(const Runner&) = delete;
+
+  /// Run a benchmark and record its result.
+  ///
+  /// \param name   Unique name, e.g. `csv_write/fields=8`
+  /// \param items  Number of processed items, e.g. records, per repetition
+  /// \param bytes  Number of processed bytes per repetition; can be zero
+  /// \param func   Callable with signature `void(std::size_t repetitions)`
+  template<typename Function>
+  void run(
+    const std::string& name, std::size_t items, std::size_t bytes,
+    Function&& func);
+  /// Write the report and return the program exit code.
+  int finish();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Result {
+    std::string name;
+    std::size_t repetitions;
+    double seconds; // per repetition
+    std::size_t items;
+    std::size_t bytes;
+  };
+
+  static std::string escape(const std::string& str);
+  void write_json(std::ostream& os) const;
+
+  std::string m_filter;
+  std::string m_output;
+  double m_min_time = 0.25;
+  std::size_t m_num_measurements = 3;
+  std::vector<Result> m_results;
+};
+
+// implementation
+
+inline Runner::Runner(int argc, char* argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if ((i + 1) == argc) {
+      throw std::invalid_argument("Missing value for '" + arg + "'");
+    }
+    std::string value = argv[++i];
+    if (arg == "--filter") {
+      m_filter = value;
+    } else if (arg == "--min-time") {
+      m_min_time = std::stod(value);
+    } else if (arg == "--output") {
+      m_output = value;
+    } else if (arg == "--repetitions") {
+      m_num_measurements = std::max<long>(1, std::stol(value));
+    } else {
+      throw std::invalid_argument("Unknown argument '" + arg + "'");
+    }
+  }
+}
+
+template<typename Function>
+inline void
+Runner::run(
+  const std::string& name, std::size_t items, std::size_t bytes,
+  Function&& func) {
+  if (name.find(m_filter) == std::string::npos) {
+    return;
+  }
+
+  // warm-up and calibration; grow until one measurement is long enough
+  std::size_t repetitions = 1;
+  double elapsed = 0;
+  while (true) {
+    auto start = Clock::now();
+    func(repetitions);
+    auto stop = Clock::now();
+    elapsed = std::chrono::duration<double>(stop - start).count();
+    if (m_min_time <= elapsed) {
+      break;
+    }
+    // overshoot slightly such that the next attempt is likely sufficient
+    double scale = (0 < elapsed) ? (1.25 * m_min_time / elapsed) : 10.0;
+    scale = std::min(std::max(scale, 1.5), 10.0);
+    repetitions = static_cast<std::size_t>(repetitions * scale) + 1;
+  }
+  double best = elapsed / repetitions;
+  for (std::size_t i = 1; i < m_num_measurements; ++i) {
+    auto start = Clock::now();
+    func(repetitions);
+    auto stop = Clock::now();
+    elapsed = std::chrono::duration<double>(stop - start).count();
+    best = std::min(best, elapsed / repetitions);
+  }
+  m_results.push_back(Result{name, repetitions, best, items, bytes});
+
+  // human-readable progress goes to stderr to keep stdout valid json
+  std::fprintf(
+    stderr, "%-48s %12.1f ns %14.4g items/s %10.1f MB/s\n", name.c_str(),
+    1e9 * best, items / best, bytes / best / 1e6);
+}
+
+inline int
+Runner::finish() {
+  if (m_output.empty()) {
+    write_json(std::cout);
+    return std::cout ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  std::ofstream file(m_output, std::ios_base::out | std::ios_base::trunc);
+  write_json(file);
+  file.close();
+  return file ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+inline std::string
+Runner::escape(const std::string& str) {
+  std::string escaped;
+  for (char c : str) {
+    if ((c == '"') || (c == '\\')) {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped;
+}
+
+inline void
+Runner::write_json(std::ostream& os) const {
+  char date[32] = "";
+  std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+  os << "{\n";
+  os << "  \"context\": {\n";
+  os << "    \"date\": \"" << date << "\",\n";
+#if defined(__VERSION__)
+  os << "    \"compiler\": \"" << escape(__VERSION__) << "\",\n";
+#endif
+#if defined(NDEBUG)
+  os << "    \"assertions\": false,\n";
+#else
+  os << "    \"assertions\": true,\n";
+#endif
+  os << "    \"min_time\": " << m_min_time << ",\n";
+  os << "    \"repetitions\": " << m_num_measurements << "\n";
+  os << "  },\n";
+  os << "  \"benchmarks\": [";
+  for (std::size_t i = 0; i < m_results.size(); ++i) {
+    const auto& r = m_results[i];
+    os << ((i == 0) ? "\n" : ",\n");
+    os << "    {";
+    os << "\"name\": \"" << escape(r.name) << "\", ";
+    os << "\"iterations\": " << r.repetitions << ", ";
+    os << "\"real_time_ns\": " << (1e9 * r.seconds) << ", ";
+    os << "\"items\": " << r.items << ", ";
+    os << "\"items_per_second\": " << (r.items / r.seconds) << ", ";
+    os << "\"bytes\": " << r.bytes << ", ";
+    os << "\"bytes_per_second\": " << (r.bytes / r.seconds);
+    os << "}";
+  }
+  os << "\n  ]\n";
+  os << "}\n";
+}
+
+} // namespace bench
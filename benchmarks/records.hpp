@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: MIT
+
+/// \file
+/// \brief Records of different widths shared among i/o benchmarks
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "dfe/dfe_namedtuple.hpp"
+
+// two elements
+struct Narrow {
+  uint32_t id = 0;
+  float value = 0;
+
+  DFE_NAMEDTUPLE(Narrow, id, value)
+};
+
+// eight elements of mixed types
+struct Medium {
+  int16_t a = 0;
+  int32_t b = 0;
+  int64_t c = 0;
+  uint64_t d = 0;
+  float e = 0;
+  double f = 0;
+  double g = 0;
+  bool h = false;
+
+  DFE_NAMEDTUPLE(Medium, a, b, c, d, e, f, g, h)
+};
+
+// sixteen floating point elements
+struct Wide {
+  double v00 = 0, v01 = 0, v02 = 0, v03 = 0;
+  double v04 = 0, v05 = 0, v06 = 0, v07 = 0;
+  float v08 = 0, v09 = 0, v10 = 0, v11 = 0;
+  float v12 = 0, v13 = 0, v14 = 0, v15 = 0;
+
+  DFE_NAMEDTUPLE(
+    Wide, v00, v01, v02, v03, v04, v05, v06, v07, v08, v09, v10, v11, v12, v13,
+    v14, v15)
+};
+
+inline void
+fill_record(std::size_t i, Narrow& r) {
+  r.id = i;
+  r.value = 0.23126121f * i;
+}
+inline void
+fill_record(std::size_t i, Medium& r) {
+  r.a = i;
+  r.b = -2 * i;
+  r.c = 4 * i;
+  r.d = 8 * i;
+  r.e = 0.23126121f * i;
+  r.f = -42.53425 * i;
+  r.g = 1.0 / (1 + i);
+  r.h = ((i % 2) != 0);
+}
+inline void
+fill_record(std::size_t i, Wide& r) {
+  r.v00 = r.v01 = r.v02 = r.v03 = 1.0 / (1 + i);
+  r.v04 = r.v05 = r.v06 = r.v07 = -42.53425 * i;
+  r.v08 = r.v09 = r.v10 = r.v11 = 0.23126121f * i;
+  r.v12 = r.v13 = r.v14 = r.v15 = i;
+}
+
+/// Create a deterministic set of records.
+template<typename Record>
+inline std::vector<Record>
+make_records(std::size_t n) {
+  std::vector<Record> records(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    fill_record(i, records[i]);
+  }
+  return records;
+}
+
+/// Size of the file at the given path in bytes.
+inline std::size_t
+file_size(const std::string& path) {
+  std::ifstream file(path, std::ios_base::binary | std::ios_base::ate);
+  return file ? static_cast<std::size_t>(file.tellg()) : 0u;
+}
@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: MIT
+// Copyright 2020 Moritz Kiehn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/// \file
+/// \brief   Monotonic memory arena and allocator for short-lived containers
+/// \author  Moritz Kiehn <msmk@cern.ch>
+/// \date    2026-10-14
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace dfe {
+
+/// Monotonic memory arena with bulk release.
+///
+/// Memory is handed out by bumping a pointer within large blocks. Individual
+/// deallocations do nothing; all memory is released at once by `reset()`,
+/// e.g. at the end of each event. If the current block is exhausted, a new
+/// block with at least twice the size is added. The arena is not thread-safe.
+class Arena {
+public:
+  /// \param block_size Size of the first memory block in bytes
+  explicit Arena(std::size_t block_size = 64 * 1024);
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  ~Arena();
+
+  /// Allocate uninitialized memory with the given size and alignment.
+  ///
+  /// \param alignment Must be a power of two
+  void* allocate(std::size_t size, std::size_t alignment);
+  /// Release all allocations at once.
+  ///
+  /// All memory obtained from the arena becomes invalid. The blocks are kept
+  /// for reuse; multiple blocks are merged into a single block so the next
+  /// cycle with similar usage needs no further allocations.
+  void reset();
+
+  /// Number of bytes allocated from the arena since the last reset.
+  std::size_t used() const { return m_used; }
+  /// Total size of all memory blocks in bytes.
+  std::size_t capacity() const;
+
+private:
+  struct Block {
+    char* data;
+    std::size_t size;
+  };
+
+  void add_block(std::size_t min_size);
+  void release();
+
+  std::size_t m_block_size;
+  std::vector<Block> m_blocks;
+  char* m_pos = nullptr;
+  char* m_end = nullptr;
+  std::size_t m_used = 0;
+};
+
+/// Standard-compatible allocator that obtains its memory from an arena.
+///
+/// Can be used with any allocator-aware container, e.g. `std::vector`,
+/// `SmallVector`, `FlatSet`, `FlatMap`, or the dense `Histogram` storage.
+/// Allocators compare equal if they use the same arena. The arena must
+/// outlive all containers that use it.
+template<typename T>
+class ArenaAllocator {
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  ArenaAllocator(Arena& arena) noexcept : m_arena(&arena) {}
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+    : m_arena(other.m_arena) {}
+
+  T* allocate(std::size_t n);
+  /// Does nothing; memory is only released by resetting the arena.
+  void deallocate(T*, std::size_t) noexcept {}
+
+  Arena& arena() const { return *m_arena; }
+
+private:
+  Arena* m_arena;
+
+  template<typename U>
+  friend class ArenaAllocator;
+};
+
+template<typename T, typename U>
+inline bool
+operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+  return &lhs.arena() == &rhs.arena();
+}
+template<typename T, typename U>
+inline bool
+operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+  return !(lhs == rhs);
+}
+
+// implementation Arena
+
+inline Arena::Arena(std::size_t block_size)
+  : m_block_size(std::max<std::size_t>(block_size, 64)) {}
+
+inline Arena::~Arena() { release(); }
+
+inline void*
+Arena::allocate(std::size_t size, std::size_t alignment) {
+  auto padding = [=](const char* ptr) {
+    auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+    auto aligned = (addr + (alignment - 1)) & ~(alignment - 1);
+    return static_cast<std::size_t>(aligned - addr);
+  };
+
+  // block ends are not necessarily aligned; the padding alone might not fit
+  bool fits = false;
+  if (m_pos != nullptr) {
+    auto available = static_cast<std::size_t>(m_end - m_pos);
+    auto pad = padding(m_pos);
+    fits = (pad <= available) and (size <= (available - pad));
+  }
+  if (not fits) {
+    if ((std::numeric_limits<std::size_t>::max() - alignment) < size) {
+      throw std::bad_alloc();
+    }
+    add_block(size + alignment);
+  }
+  char* ptr = m_pos + padding(m_pos);
+  m_pos = ptr + size;
+  m_used += size;
+  return ptr;
+}
+
+inline void
+Arena::reset() {
+  if (1 < m_blocks.size()) {
+    std::size_t total = capacity();
+    release();
+    add_block(total);
+  }
+  m_pos = m_blocks.empty() ? nullptr : m_blocks.front().data;
+  m_used = 0;
+}
+
+inline std::size_t
+Arena::capacity() const {
+  std::size_t total = 0;
+  for (const auto& block : m_blocks) {
+    total += block.size;
+  }
+  return total;
+}
+
+inline void
+Arena::add_block(std::size_t min_size) {
+  std::size_t size =
+    m_blocks.empty() ? m_block_size : (2 * m_blocks.back().size);
+  size = std::max(size, min_size);
+  // reserve first so storing the block can not throw and leak it
+  m_blocks.reserve(m_blocks.size() + 1);
+  Block block;
+  block.data = static_cast<char*>(::operator new(size));
+  block.size = size;
+  m_blocks.push_back(block);
+  m_pos = block.data;
+  m_end = block.data + block.size;
+}
+
+inline void
+Arena::release() {
+  for (auto& block : m_blocks) {
+    ::operator delete(block.data);
+  }
+  m_blocks.clear();
+  m_pos = nullptr;
+  m_end = nullptr;
+}
+
+// implementation ArenaAllocator
+
+template<typename T>
+inline T*
+ArenaAllocator<T>::allocate(std::size_t n) {
+  if ((std::numeric_limits<std::size_t>::max() / sizeof(T)) < n) {
+    throw std::bad_alloc();
+  }
+  return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+}
+
+} // namespace dfe
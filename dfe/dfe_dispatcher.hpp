@@ -26,46 +26,69 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cerrno>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "dfe_smallvector.hpp"
+#include "dfe_threadpool.hpp"
+
 namespace dfe {
 
 /// Variable-type value object a.k.a. a poor mans std::variant.
+///
+/// Numeric values and short strings are stored in-place without additional
+/// memory allocations. Only strings longer than the in-place capacity are
+/// stored on the heap. The object never points into itself and can always
+/// be relocated by copying its bytes; for numeric values and in-place strings
+/// copies and moves are plain memory copies.
 class Variable final {
 public:
   /// Supported value types.
   enum class Type { Empty, Boolean, Integer, Float, String };
 
-  Variable() : m_type(Type::Empty) {}
-  Variable(Variable&& v) { *this = std::move(v); }
-  Variable(const Variable& v) { *this = v; }
-  explicit Variable(std::string&& s)
-    : m_string(std::move(s)), m_type(Type::String) {}
-  explicit Variable(const std::string& s) : Variable(std::string(s)) {}
-  explicit Variable(const char* s) : Variable(std::string(s)) {}
+  Variable() : m_data{}, m_type(Type::Empty), m_inline_size(0) {}
+  Variable(Variable&& v) noexcept;
+  Variable(const Variable& v);
+  /// Construct a string variable from a character sequence.
+  explicit Variable(const char* s, std::size_t size);
+  explicit Variable(const std::string& s) : Variable(s.data(), s.size()) {}
+  explicit Variable(const char* s) : Variable(s, std::strlen(s)) {}
   // suppport all possible integer types
   template<typename I, typename = std::enable_if_t<std::is_integral<I>::value>>
-  explicit Variable(I integer)
-    : m_integer(static_cast<int64_t>(integer)), m_type(Type::Integer) {}
-  explicit Variable(double d) : m_float(d), m_type(Type::Float) {}
+  explicit Variable(I integer) : Variable(Type::Integer) {
+    m_data.integer = static_cast<int64_t>(integer);
+  }
+  explicit Variable(double d) : Variable(Type::Float) { m_data.real = d; }
   explicit Variable(float f) : Variable(static_cast<double>(f)) {}
-  explicit Variable(bool b) : m_boolean(b), m_type(Type::Boolean) {}
-  ~Variable() = default;
+  explicit Variable(bool b) : Variable(Type::Boolean) { m_data.boolean = b; }
+  ~Variable() { release(); }
 
-  Variable& operator=(Variable&& v);
+  Variable& operator=(Variable&& v) noexcept;
   Variable& operator=(const Variable& v);
 
   /// Parse a string into a value of the requested type.
+  ///
+  /// \exception std::invalid_argument if the string is not a valid value
+  /// \exception std::out_of_range if the value is not representable
   static Variable parse_as(const std::string& str, Type type);
+  /// Parse a character sequence into a value without allocating memory.
+  static Variable parse_as(const char* str, std::size_t size, Type type);
 
   /// In a boolean context a variable is false if it does not contain a value.
   ///
@@ -87,26 +110,115 @@ private:
   template<typename I>
   struct IntegerConverter;
 
-  union {
-    int64_t m_integer;
-    double m_float;
-    bool m_boolean;
+  struct HeapString {
+    char* data;
+    std::size_t size;
   };
-  // std::string has non-trivial constructor; cannot store by value in union
-  // TODO 2018-11-29 msmk: more space-efficient string storage
-  std::string m_string;
+  union Storage {
+    int64_t integer;
+    double real;
+    bool boolean;
+    HeapString heap;
+    char chars[sizeof(HeapString)];
+  };
+  // marks a string that does not fit into the in-place storage
+  static constexpr uint8_t kOnHeap = UINT8_MAX;
+
+  explicit Variable(Type type)
+    : m_data{}, m_type(type), m_inline_size(0) {}
+  bool is_heap_string() const {
+    return (m_type == Type::String) && (m_inline_size == kOnHeap);
+  }
+  const char* string_data() const {
+    return is_heap_string() ? m_data.heap.data : m_data.chars;
+  }
+  std::size_t string_size() const {
+    return is_heap_string() ? m_data.heap.size : m_inline_size;
+  }
+  void release() noexcept;
+  static int64_t parse_integer(const char* str, std::size_t size);
+  static double parse_float(const char* str, std::size_t size);
+
+  Storage m_data;
   Type m_type;
+  uint8_t m_inline_size;
 
   friend std::ostream& operator<<(std::ostream& os, const Variable& v);
 };
 
+namespace dispatcher_impl {
+struct Token;
+template<typename T>
+class NameCache;
+} // namespace dispatcher_impl
+
 /// A simple command dispatcher.
 ///
-/// You can register commands and call them by name.
+/// You can register commands and call them by name. Commands can be
+/// registered and called concurrently from multiple threads. Calls look up
+/// commands without locking; registrations are serialized and fill entries
+/// of the lookup table that are never modified afterwards. Growing the table
+/// publishes a larger copy; the superseded tables are kept until destruction
+/// and use at most as much memory as the current one. The registered
+/// functions must be safe to call concurrently if the dispatcher is used from
+/// multiple threads.
 class Dispatcher {
+private:
+  struct Command;
+
 public:
+  /// Non-owning view of the arguments passed to a native function.
+  ///
+  /// Converts implicitly to `std::vector<Variable>` so native functions
+  /// written against a vector interface can still be registered.
+  class Arguments {
+  public:
+    using const_iterator = const Variable*;
+
+    Arguments(const Variable* data, std::size_t size)
+      : m_data(data), m_size(size) {}
+    Arguments(const std::vector<Variable>& args)
+      : Arguments(args.data(), args.size()) {}
+
+    std::size_t size() const { return m_size; }
+    bool empty() const { return (m_size == 0); }
+    const Variable& operator[](std::size_t idx) const { return m_data[idx]; }
+    /// \exception std::out_of_range if the index is invalid
+    const Variable& at(std::size_t idx) const;
+    const_iterator begin() const { return m_data; }
+    const_iterator end() const { return m_data + m_size; }
+    operator std::vector<Variable>() const { return {begin(), end()}; }
+
+  private:
+    const Variable* m_data;
+    std::size_t m_size;
+  };
   /// The native dispatcher function interface.
-  using Interface = std::function<Variable(const std::vector<Variable>&)>;
+  using Interface = std::function<Variable(const Arguments&)>;
+
+  /// \param num_workers Worker threads for `call_async`, 0 for one per core
+  explicit Dispatcher(std::size_t num_workers = 0);
+  Dispatcher(const Dispatcher&) = delete;
+  Dispatcher& operator=(const Dispatcher&) = delete;
+  /// Waits for all pending asynchronous calls to finish.
+  ~Dispatcher();
+  /// Pre-resolved reference to a registered command.
+  ///
+  /// Handles stay valid for the lifetime of the dispatcher.
+  class Handle {
+  public:
+    Handle() = default;
+
+    /// A default-constructed handle does not refer to any command.
+    explicit operator bool() const { return (m_cmd != nullptr); }
+
+  private:
+    explicit Handle(const Command* cmd) : m_cmd(cmd) {}
+
+    const Command* m_cmd = nullptr;
+
+    friend class Dispatcher;
+  };
 
   /// Register a native dispatcher function.
   ///
@@ -133,6 +245,9 @@ public:
     std::string help = std::string());
 
   /// Call a command with arbitrary arguments.
+  ///
+  /// Arguments are passed via stack storage; calls with up to
+  /// `kInlineArguments` arguments do not allocate memory.
   template<typename... Args>
   Variable call(const std::string& name, Args&&... args);
   /// Call a command with arguments parsed from strings into the expected types.
@@ -142,114 +257,288 @@ public:
   Variable call_native(
     const std::string& name, const std::vector<Variable>& args);
 
+  /// A single command call with unparsed string arguments.
+  struct ParsedCall {
+    std::string name;
+    std::vector<std::string> args;
+  };
+  /// Call multiple commands in order with arguments parsed from strings.
+  ///
+  /// Each distinct command name is resolved only once. Invalid names or
+  /// arguments throw with the index of the failing call in the message.
+  ///
+  /// \returns Results of all calls in order
+  std::vector<Variable> call_parsed(const std::vector<ParsedCall>& calls);
+  /// Execute a script with one command call per line.
+  ///
+  /// Each line contains the command name followed by its arguments separated
+  /// by whitespace. Arguments that contain whitespace can be enclosed in
+  /// double quotes. A `#` at the start of a token comments out the rest of
+  /// the line. The script is tokenized in-place and each distinct command
+  /// name is resolved only once. Invalid names or arguments throw with the
+  /// line number in the message.
+  ///
+  /// \returns Results of all executed commands in order
+  std::vector<Variable> call_script(const char* script, std::size_t size);
+  std::vector<Variable> call_script(const std::string& script);
+  /// Call a command asynchronously on the worker pool.
+  ///
+  /// The command is resolved immediately and invalid names or argument
+  /// counts throw directly. Exceptions raised by the command itself are
+  /// stored in the returned future. The worker threads are only started
+  /// with the first asynchronous call.
+  template<typename... Args>
+  std::future<Variable> call_async(const std::string& name, Args&&... args);
+
+  /// Resolve a command name once for repeated calls via `invoke`.
+  ///
+  /// \exception std::invalid_argument if the command does not exist
+  Handle lookup(const std::string& name) const;
+  /// Call a pre-resolved command and return its result as type `R`.
+  ///
+  /// If the decayed return and argument types match the registered function
+  /// exactly, the function is called directly without converting any values
+  /// to or from `Variable`. Otherwise, the call falls back to the regular
+  /// conversion with the usual type checks.
+  template<typename R, typename... Args>
+  R invoke(Handle handle, const Args&... args);
+
   /// Return a list of registered commands.
   std::vector<std::string> commands() const;
   /// Return the help text for the command.
   const std::string& help(const std::string& name) const;
 
+  /// Number of arguments that are passed without memory allocation.
+  static constexpr std::size_t kInlineArguments = 8;
+
 private:
   struct Command {
+    std::string name;
+    std::size_t hash = 0;
     Interface func;
     std::vector<Variable::Type> argument_types;
     std::string help;
+    // optional direct-call function and its signature tag
+    std::shared_ptr<void> typed;
+    const void* signature = nullptr;
+  };
+  using ArgumentBuffer = SmallVector<Variable, kInlineArguments>;
+
+  // Insert-only open-addressing table of the registered commands.
+  //
+  // Filled slots are never modified, so readers can probe the table while a
+  // registration fills an empty slot.
+  struct Table {
+    explicit Table(std::size_t num_slots);
+
+    std::unique_ptr<std::atomic<const Command*>[]> slots;
+    std::size_t mask;
   };
-  std::unordered_map<std::string, Command> m_commands;
+
+  using TokenBuffer = SmallVector<dispatcher_impl::Token, 16>;
+
+  void add_command(std::string name, Command&& cmd);
+  const Command& prepare(
+    dispatcher_impl::NameCache<Command>& cache, const TokenBuffer& tokens,
+    ArgumentBuffer& args) const;
+  static void insert(Table& table, const Command* cmd);
+  const Command* find_command(const std::string& name) const;
+  const Command& find(const std::string& name) const;
+  const Command& find(const std::string& name, std::size_t num_args) const;
+  std::future<Variable>
+  submit(const Command& cmd, std::vector<Variable>&& args);
+
+  // current lookup table
+  std::atomic<const Table*> m_table;
+  // serializes registrations and owns all commands and tables. superseded
+  // tables can still be probed by concurrent readers and are only released
+  // together with the dispatcher; they shrink geometrically.
+  std::mutex m_mutex;
+  std::vector<std::unique_ptr<const Command>> m_commands;
+  std::vector<std::unique_ptr<Table>> m_tables;
+  std::size_t m_num_workers;
+  std::once_flag m_pool_started;
+  // declared last so pending asynchronous calls finish first
+  std::unique_ptr<threadpool_impl::ThreadPool> m_pool;
 };
 
 // implementation Variable
 
-inline Variable
-Variable::parse_as(const std::string& str, Type type) {
-  if (type == Type::Boolean) {
-    return Variable((str == "true"));
-  } else if (type == Type::Integer) {
-    return Variable(std::stoll(str));
-  } else if (type == Type::Float) {
-    return Variable(std::stod(str));
-  } else if (type == Type::String) {
-    return Variable(str);
+inline Variable::Variable(const char* s, std::size_t size)
+  : Variable(Type::String) {
+  if (size <= sizeof(m_data.chars)) {
+    std::copy_n(s, size, m_data.chars);
+    m_inline_size = static_cast<uint8_t>(size);
   } else {
-    return Variable();
+    m_data.heap.data = new char[size];
+    m_data.heap.size = size;
+    std::copy_n(s, size, m_data.heap.data);
+    m_inline_size = kOnHeap;
   }
 }
 
-inline std::ostream&
-operator<<(std::ostream& os, const Variable& v) {
-  if (v.type() == Variable::Type::Boolean) {
-    os << (v.m_boolean ? "true" : "false");
-  } else if (v.m_type == Variable::Type::Integer) {
-    os << v.m_integer;
-  } else if (v.m_type == Variable::Type::Float) {
-    os << v.m_float;
-  } else if (v.m_type == Variable::Type::String) {
-    os << v.m_string;
+inline Variable::Variable(Variable&& v) noexcept
+  : m_data(v.m_data), m_type(v.m_type), m_inline_size(v.m_inline_size) {
+  // heap-allocated strings are now owned by this object
+  v.m_type = Type::Empty;
+  v.m_inline_size = 0;
+}
+
+inline Variable::Variable(const Variable& v)
+  : m_data(v.m_data), m_type(v.m_type), m_inline_size(v.m_inline_size) {
+  if (is_heap_string()) {
+    m_data.heap.data = new char[v.m_data.heap.size];
+    std::copy_n(v.m_data.heap.data, v.m_data.heap.size, m_data.heap.data);
   }
-  return os;
+}
+
+inline void
+Variable::release() noexcept {
+  if (is_heap_string()) {
+    delete[] m_data.heap.data;
+  }
+  m_type = Type::Empty;
+  m_inline_size = 0;
 }
 
 inline Variable&
-Variable::operator=(Variable&& v) {
+Variable::operator=(Variable&& v) noexcept {
   // handle `x = std::move(x)`
   if (this == &v) {
     return *this;
   }
-  if (v.m_type == Type::Boolean) {
-    m_boolean = v.m_boolean;
-  } else if (v.m_type == Type::Integer) {
-    m_integer = v.m_integer;
-  } else if (v.m_type == Type::Float) {
-    m_float = v.m_float;
-  } else if (v.m_type == Type::String) {
-    m_string = std::move(v.m_string);
-  }
+  release();
+  m_data = v.m_data;
   m_type = v.m_type;
+  m_inline_size = v.m_inline_size;
+  v.m_type = Type::Empty;
+  v.m_inline_size = 0;
   return *this;
 }
 
 inline Variable&
 Variable::operator=(const Variable& v) {
-  if (v.m_type == Type::Boolean) {
-    m_boolean = v.m_boolean;
-  } else if (v.m_type == Type::Integer) {
-    m_integer = v.m_integer;
-  } else if (v.m_type == Type::Float) {
-    m_float = v.m_float;
-  } else if (v.m_type == Type::String) {
-    m_string = v.m_string;
+  // copy first so self-assignment and allocation failures are safe
+  return *this = Variable(v);
+}
+
+inline Variable
+Variable::parse_as(const std::string& str, Type type) {
+  return parse_as(str.data(), str.size(), type);
+}
+
+inline Variable
+Variable::parse_as(const char* str, std::size_t size, Type type) {
+  if (type == Type::Boolean) {
+    return Variable((size == 4) and (std::strncmp(str, "true", 4) == 0));
+  } else if (type == Type::Integer) {
+    return Variable(parse_integer(str, size));
+  } else if (type == Type::Float) {
+    return Variable(parse_float(str, size));
+  } else if (type == Type::String) {
+    return Variable(str, size);
+  } else {
+    return Variable();
   }
-  m_type = v.m_type;
-  return *this;
+}
+
+inline int64_t
+Variable::parse_integer(const char* str, std::size_t size) {
+  const char* end = str + size;
+  bool negative = false;
+  if ((str != end) and ((*str == '-') or (*str == '+'))) {
+    negative = (*str == '-');
+    ++str;
+  }
+  if (str == end) {
+    throw std::invalid_argument("Could not parse integer value");
+  }
+  // accumulate the magnitude; the negative range is larger by one
+  const uint64_t limit = static_cast<uint64_t>(INT64_MAX) + (negative ? 1 : 0);
+  uint64_t value = 0;
+  for (; str != end; ++str) {
+    if ((*str < '0') or ('9' < *str)) {
+      throw std::invalid_argument("Could not parse integer value");
+    }
+    uint64_t digit = static_cast<uint64_t>(*str - '0');
+    if (((limit - digit) / 10) < value) {
+      throw std::out_of_range("Integer value is out of range");
+    }
+    value = 10 * value + digit;
+  }
+  // negate in unsigned arithmetic to handle the minimum value
+  return negative ? static_cast<int64_t>(~value + 1)
+                  : static_cast<int64_t>(value);
+}
+
+inline double
+Variable::parse_float(const char* str, std::size_t size) {
+  // strtod requires a terminated string; only very long inputs allocate
+  char buffer[64];
+  std::string fallback;
+  const char* terminated = buffer;
+  if (size < sizeof(buffer)) {
+    std::copy_n(str, size, buffer);
+    buffer[size] = '\0';
+  } else {
+    fallback.assign(str, size);
+    terminated = fallback.c_str();
+  }
+  char* end = nullptr;
+  errno = 0;
+  double value = std::strtod(terminated, &end);
+  if ((size == 0) or (end != (terminated + size))) {
+    throw std::invalid_argument("Could not parse floating point value");
+  }
+  if (errno == ERANGE) {
+    throw std::out_of_range("Floating point value is out of range");
+  }
+  return value;
+}
+
+inline std::ostream&
+operator<<(std::ostream& os, const Variable& v) {
+  if (v.type() == Variable::Type::Boolean) {
+    os << (v.m_data.boolean ? "true" : "false");
+  } else if (v.m_type == Variable::Type::Integer) {
+    os << v.m_data.integer;
+  } else if (v.m_type == Variable::Type::Float) {
+    os << v.m_data.real;
+  } else if (v.m_type == Variable::Type::String) {
+    os.write(v.string_data(), v.string_size());
+  }
+  return os;
 }
 
 template<>
 struct Variable::Converter<bool> {
   static constexpr Type type() { return Type::Boolean; }
-  static constexpr bool as_t(const Variable& v) { return v.m_boolean; }
+  static constexpr bool as_t(const Variable& v) { return v.m_data.boolean; }
 };
 template<>
 struct Variable::Converter<float> {
   static constexpr Type type() { return Type::Float; }
   static constexpr float as_t(const Variable& v) {
-    return static_cast<float>(v.m_float);
+    return static_cast<float>(v.m_data.real);
   }
 };
 template<>
 struct Variable::Converter<double> {
   static constexpr Type type() { return Type::Float; }
-  static constexpr double as_t(const Variable& v) { return v.m_float; }
+  static constexpr double as_t(const Variable& v) { return v.m_data.real; }
 };
 template<>
 struct Variable::Converter<std::string> {
   static constexpr Type type() { return Type::String; }
-  static constexpr const std::string& as_t(const Variable& v) {
-    return v.m_string;
+  static std::string as_t(const Variable& v) {
+    return std::string(v.string_data(), v.string_size());
   }
 };
 template<typename I>
 struct Variable::IntegerConverter {
   static constexpr Type type() { return Type::Integer; }
   static constexpr I as_t(const Variable& v) {
-    return static_cast<I>(v.m_integer);
+    return static_cast<I>(v.m_data.integer);
   }
 };
 template<>
@@ -289,12 +578,13 @@ template<typename R, typename... Args>
 struct InterfaceWrappper {
   std::function<R(Args...)> func;
 
-  Variable operator()(const std::vector<Variable>& args) {
+  Variable operator()(const Dispatcher::Arguments& args) {
     return call(args, std::index_sequence_for<Args...>());
   }
   template<std::size_t... I>
-  Variable call(const std::vector<Variable>& args, std::index_sequence<I...>) {
-    return Variable(func(args.at(I).as<typename std::decay_t<Args>>()...));
+  Variable
+  call(const Dispatcher::Arguments& args, std::index_sequence<I...>) {
+    return Variable(func(args[I].as<typename std::decay_t<Args>>()...));
   }
 };
 
@@ -303,12 +593,13 @@ template<typename... Args>
 struct InterfaceWrappper<void, Args...> {
   std::function<void(Args...)> func;
 
-  Variable operator()(const std::vector<Variable>& args) {
+  Variable operator()(const Dispatcher::Arguments& args) {
     return call(args, std::index_sequence_for<Args...>());
   }
   template<std::size_t... I>
-  Variable call(const std::vector<Variable>& args, std::index_sequence<I...>) {
-    func(args.at(I).as<typename std::decay_t<Args>>()...);
+  Variable
+  call(const Dispatcher::Arguments& args, std::index_sequence<I...>) {
+    func(args[I].as<typename std::decay_t<Args>>()...);
     return Variable();
   }
 };
@@ -326,31 +617,271 @@ make_types(const std::function<R(Args...)>&) {
 }
 
 } // namespace
+
+// Unique tag for a function signature that is identical in all units.
+template<typename Signature>
+inline const void*
+signature_tag() {
+  static const char tag = 0;
+  return &tag;
+}
+
+template<typename R, typename... Args>
+inline const void*
+make_signature(const std::function<R(Args...)>&) {
+  return signature_tag<std::decay_t<R>(std::decay_t<Args>...)>();
+}
+
+// The direct-call function always takes its arguments by const reference and
+// uses the same decayed types as the signature tag.
+template<typename R, typename... Args>
+using TypedFunction =
+  std::function<std::decay_t<R>(const std::decay_t<Args>&...)>;
+
+// Pass a const reference as-is or as a copy for rvalue reference parameters.
+template<typename Arg, typename T>
+inline std::conditional_t<std::is_rvalue_reference<Arg>::value, T, const T&>
+pass_argument(const T& arg) {
+  return arg;
+}
+
+template<typename R, typename... Args>
+inline std::shared_ptr<void>
+make_typed(const std::function<R(Args...)>& function) {
+  return std::make_shared<TypedFunction<R, Args...>>(
+    [function](const std::decay_t<Args>&... args) {
+      return function(pass_argument<Args>(args)...);
+    });
+}
+
+// Convert the result of the generic call into the requested type.
+template<typename R>
+struct Unbox {
+  static R convert(Variable&& v) { return v.as<R>(); }
+};
+template<>
+struct Unbox<Variable> {
+  static Variable convert(Variable&& v) { return std::move(v); }
+};
+template<>
+struct Unbox<void> {
+  static void convert(Variable&&) {}
+};
+
+// Non-owning view of a part of a character sequence.
+struct Token {
+  const char* data = nullptr;
+  std::size_t size = 0;
+};
+
+// Split a single line into whitespace-separated, optionally quoted tokens.
+inline void
+tokenize_line(
+  const char* pos, const char* end, SmallVector<Token, 16>& tokens) {
+  auto is_space = [](char c) {
+    return (c == ' ') or (c == '\t') or (c == '\r');
+  };
+
+  tokens.clear();
+  while (true) {
+    pos = std::find_if_not(pos, end, is_space);
+    if ((pos == end) or (*pos == '#')) {
+      break;
+    }
+    Token token;
+    if (*pos == '"') {
+      const char* close = std::find(pos + 1, end, '"');
+      if (close == end) {
+        throw std::invalid_argument("Unterminated quoted argument");
+      }
+      token.data = pos + 1;
+      token.size = close - token.data;
+      pos = close + 1;
+    } else {
+      const char* stop = std::find_if(pos, end, is_space);
+      token.data = pos;
+      token.size = stop - pos;
+      pos = stop;
+    }
+    tokens.emplace_back(token);
+  }
+}
+
+// FNV-1a
+inline std::size_t
+hash_name(const char* data, std::size_t size) {
+  uint64_t h = UINT64_C(14695981039346656037);
+  for (std::size_t i = 0; i < size; ++i) {
+    h ^= static_cast<unsigned char>(data[i]);
+    h *= UINT64_C(1099511628211);
+  }
+  return static_cast<std::size_t>(h);
+}
+
+// Open-addressing cache that maps names to resolved values.
+//
+// Only views of the names are stored; they must outlive the cache.
+template<typename T>
+class NameCache {
+public:
+  NameCache() : m_slots(16) {}
+
+  // Find a cached value or resolve and cache it on first use.
+  template<typename Resolve>
+  const T& get(const Token& name, Resolve&& resolve);
+
+private:
+  struct Slot {
+    Token name;
+    std::size_t hash = 0;
+    const T* value = nullptr;
+  };
+
+  static std::size_t hash(const Token& name);
+  void grow();
+
+  std::vector<Slot> m_slots;
+  std::size_t m_size = 0;
+};
+
+template<typename T>
+inline std::size_t
+NameCache<T>::hash(const Token& name) {
+  return hash_name(name.data, name.size);
+}
+
+template<typename T>
+template<typename Resolve>
+inline const T&
+NameCache<T>::get(const Token& name, Resolve&& resolve) {
+  std::size_t h = hash(name);
+  std::size_t mask = m_slots.size() - 1;
+  for (std::size_t i = h & mask;; i = (i + 1) & mask) {
+    Slot& slot = m_slots[i];
+    if (!slot.value) {
+      slot.name = name;
+      slot.hash = h;
+      slot.value = &resolve(name);
+      const T& value = *slot.value;
+      // keep the load factor below one half
+      if (m_slots.size() < (2 * ++m_size)) {
+        grow();
+      }
+      return value;
+    }
+    if ((slot.hash == h) and (slot.name.size == name.size)
+        and std::equal(name.data, name.data + name.size, slot.name.data)) {
+      return *slot.value;
+    }
+  }
+}
+
+template<typename T>
+inline void
+NameCache<T>::grow() {
+  std::vector<Slot> previous(2 * m_slots.size());
+  previous.swap(m_slots);
+  std::size_t mask = m_slots.size() - 1;
+  for (const auto& slot : previous) {
+    if (slot.value) {
+      std::size_t i = slot.hash & mask;
+      while (m_slots[i].value) {
+        i = (i + 1) & mask;
+      }
+      m_slots[i] = slot;
+    }
+  }
+}
+
 } // namespace dispatcher_impl
 
+inline Dispatcher::Dispatcher(std::size_t num_workers)
+  : m_num_workers(num_workers) {
+  if (m_num_workers == 0) {
+    m_num_workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  m_tables.emplace_back(new Table(16));
+  m_table.store(m_tables.back().get(), std::memory_order_release);
+}
+
+inline Dispatcher::~Dispatcher() = default;
+
+inline Dispatcher::Table::Table(std::size_t num_slots)
+  : slots(new std::atomic<const Command*>[num_slots]), mask(num_slots - 1) {
+  for (std::size_t i = 0; i < num_slots; ++i) {
+    slots[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+// must only be called while holding the registration lock
 inline void
-Dispatcher::add(
-  std::string name, Dispatcher::Interface&& func,
-  std::vector<Variable::Type>&& arg_types, std::string help) {
+Dispatcher::insert(Table& table, const Command* cmd) {
+  std::size_t i = cmd->hash & table.mask;
+  while (table.slots[i].load(std::memory_order_relaxed)) {
+    i = (i + 1) & table.mask;
+  }
+  // publishes the completely constructed command to concurrent readers
+  table.slots[i].store(cmd, std::memory_order_release);
+}
+
+inline void
+Dispatcher::add_command(std::string name, Command&& cmd) {
   if (name.empty()) {
     throw std::invalid_argument("Can not register command with empty name");
   }
-  if (m_commands.count(name)) {
+  cmd.hash = dispatcher_impl::hash_name(name.data(), name.size());
+  cmd.name = std::move(name);
+  std::unique_ptr<const Command> command(new Command(std::move(cmd)));
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (find_command(command->name)) {
     throw std::invalid_argument(
-      "Can not register command '" + name + "' more than once");
+      "Can not register command '" + command->name + "' more than once");
+  }
+  Table* table = m_tables.back().get();
+  std::size_t num_slots = table->mask + 1;
+  // keep the load factor below one half so probing always terminates
+  std::unique_ptr<Table> grown;
+  if (num_slots < (2 * (m_commands.size() + 1))) {
+    grown.reset(new Table(2 * num_slots));
+    m_tables.reserve(m_tables.size() + 1);
+  }
+  m_commands.push_back(std::move(command));
+  // nothing can throw anymore and the registration is always completed
+  if (grown) {
+    // readers continue to use the previous table until the new one is full
+    for (const auto& existing : m_commands) {
+      insert(*grown, existing.get());
+    }
+    m_tables.push_back(std::move(grown));
+    m_table.store(m_tables.back().get(), std::memory_order_release);
+  } else {
+    insert(*table, m_commands.back().get());
   }
-  m_commands[std::move(name)] =
-    Command{std::move(func), std::move(arg_types), std::move(help)};
+}
+
+inline void
+Dispatcher::add(
+  std::string name, Dispatcher::Interface&& func,
+  std::vector<Variable::Type>&& arg_types, std::string help) {
+  Command cmd;
+  cmd.func = std::move(func);
+  cmd.argument_types = std::move(arg_types);
+  cmd.help = std::move(help);
+  add_command(std::move(name), std::move(cmd));
 }
 
 template<typename R, typename... Args>
 inline void
 Dispatcher::add(
   std::string name, std::function<R(Args...)>&& func, std::string help) {
-  auto args = dispatcher_impl::make_types(func);
-  add(
-    std::move(name), dispatcher_impl::make_wrapper(std::move(func)),
-    std::move(args), std::move(help));
+  Command cmd;
+  cmd.argument_types = dispatcher_impl::make_types(func);
+  cmd.help = std::move(help);
+  cmd.typed = dispatcher_impl::make_typed(func);
+  cmd.signature = dispatcher_impl::make_signature(func);
+  cmd.func = dispatcher_impl::make_wrapper(std::move(func));
+  add_command(std::move(name), std::move(cmd));
 }
 
 template<typename R, typename... Args>
@@ -373,58 +904,235 @@ Dispatcher::add(
     std::move(help));
 }
 
-inline Variable
-Dispatcher::call_native(
-  const std::string& name, const std::vector<Variable>& args) {
-  auto cmd = m_commands.find(name);
-  if (cmd == m_commands.end()) {
+inline const Dispatcher::Command*
+Dispatcher::find_command(const std::string& name) const {
+  std::size_t h = dispatcher_impl::hash_name(name.data(), name.size());
+  const Table* table = m_table.load(std::memory_order_acquire);
+  for (std::size_t i = h & table->mask;; i = (i + 1) & table->mask) {
+    const Command* cmd = table->slots[i].load(std::memory_order_acquire);
+    if (not cmd) {
+      return nullptr;
+    }
+    if ((cmd->hash == h) and (cmd->name == name)) {
+      return cmd;
+    }
+  }
+}
+
+inline const Dispatcher::Command&
+Dispatcher::find(const std::string& name) const {
+  const Command* cmd = find_command(name);
+  if (not cmd) {
     throw std::invalid_argument("Unknown command '" + name + "'");
   }
-  if (args.size() != cmd->second.argument_types.size()) {
+  return *cmd;
+}
+
+inline const Dispatcher::Command&
+Dispatcher::find(const std::string& name, std::size_t num_args) const {
+  const Command& cmd = find(name);
+  if (num_args != cmd.argument_types.size()) {
     throw std::invalid_argument("Invalid number of arguments");
   }
-  return cmd->second.func(args);
+  return cmd;
+}
+
+inline Variable
+Dispatcher::call_native(
+  const std::string& name, const std::vector<Variable>& args) {
+  return find(name, args.size()).func(Arguments(args));
 }
 
 inline Variable
 Dispatcher::call_parsed(
   const std::string& name, const std::vector<std::string>& args) {
-  // dont reuse call_native since we need to have access to the command anyways
-  auto cmd = m_commands.find(name);
-  if (cmd == m_commands.end()) {
-    throw std::invalid_argument("Unknown command '" + name + "'");
-  }
-  if (args.size() != cmd->second.argument_types.size()) {
-    throw std::invalid_argument("Invalid number of arguments");
-  }
+  const auto& cmd = find(name, args.size());
   // convert string arguments into Variable values
-  std::vector<Variable> vargs;
+  ArgumentBuffer vargs;
   for (std::size_t i = 0; i < args.size(); ++i) {
-    vargs.push_back(Variable::parse_as(args[i], cmd->second.argument_types[i]));
+    vargs.emplace_back(Variable::parse_as(args[i], cmd.argument_types[i]));
   }
-  return cmd->second.func(vargs);
+  return cmd.func(Arguments(vargs.begin(), vargs.size()));
 }
 
 template<typename... Args>
 inline Variable
 Dispatcher::call(const std::string& name, Args&&... args) {
-  return call_native(
-    name, std::vector<Variable>{Variable(std::forward<Args>(args))...});
+  const auto& cmd = find(name, sizeof...(Args));
+  ArgumentBuffer vargs;
+  // see namedtuple_impl::print_tuple for explanation
+  using Vacuum = int[];
+  (void)Vacuum{(vargs.emplace_back(std::forward<Args>(args)), 0)..., 0};
+  return cmd.func(Arguments(vargs.begin(), vargs.size()));
+}
+
+// Resolve the command in the first token and parse the remaining ones.
+inline const Dispatcher::Command&
+Dispatcher::prepare(
+  dispatcher_impl::NameCache<Command>& cache, const TokenBuffer& tokens,
+  ArgumentBuffer& args) const {
+  using dispatcher_impl::Token;
+
+  const Command& cmd =
+    cache.get(tokens[0], [this](const Token& name) -> const Command& {
+      return find(std::string(name.data, name.size));
+    });
+  if ((tokens.size() - 1) != cmd.argument_types.size()) {
+    throw std::invalid_argument("Invalid number of arguments");
+  }
+  args.clear();
+  for (std::size_t i = 1; i < tokens.size(); ++i) {
+    args.emplace_back(Variable::parse_as(
+      tokens[i].data, tokens[i].size, cmd.argument_types[i - 1]));
+  }
+  return cmd;
+}
+
+inline std::vector<Variable>
+Dispatcher::call_parsed(const std::vector<ParsedCall>& calls) {
+  dispatcher_impl::NameCache<Command> cache;
+  TokenBuffer tokens;
+  ArgumentBuffer args;
+  std::vector<Variable> results;
+
+  results.reserve(calls.size());
+  for (std::size_t i = 0; i < calls.size(); ++i) {
+    const auto& call = calls[i];
+    tokens.clear();
+    tokens.emplace_back(dispatcher_impl::Token{
+      call.name.data(), call.name.size()});
+    for (const auto& arg : call.args) {
+      tokens.emplace_back(dispatcher_impl::Token{arg.data(), arg.size()});
+    }
+    const Command* cmd = nullptr;
+    try {
+      cmd = &prepare(cache, tokens, args);
+    } catch (const std::invalid_argument& e) {
+      throw std::invalid_argument(
+        "Call " + std::to_string(i) + ": " + e.what());
+    } catch (const std::out_of_range& e) {
+      throw std::out_of_range("Call " + std::to_string(i) + ": " + e.what());
+    }
+    results.push_back(cmd->func(Arguments(args.begin(), args.size())));
+  }
+  return results;
+}
+
+inline std::vector<Variable>
+Dispatcher::call_script(const char* script, std::size_t size) {
+  dispatcher_impl::NameCache<Command> cache;
+  TokenBuffer tokens;
+  ArgumentBuffer args;
+  std::vector<Variable> results;
+
+  const char* pos = script;
+  const char* end = script + size;
+  for (std::size_t line = 1; pos != end; ++line) {
+    const char* eol = std::find(pos, end, '\n');
+    const Command* cmd = nullptr;
+    try {
+      dispatcher_impl::tokenize_line(pos, eol, tokens);
+      if (!tokens.empty()) {
+        cmd = &prepare(cache, tokens, args);
+      }
+    } catch (const std::invalid_argument& e) {
+      throw std::invalid_argument(
+        "Line " + std::to_string(line) + ": " + e.what());
+    } catch (const std::out_of_range& e) {
+      throw std::out_of_range(
+        "Line " + std::to_string(line) + ": " + e.what());
+    }
+    if (cmd) {
+      results.push_back(cmd->func(Arguments(args.begin(), args.size())));
+    }
+    pos = (eol == end) ? end : (eol + 1);
+  }
+  return results;
+}
+
+inline std::vector<Variable>
+Dispatcher::call_script(const std::string& script) {
+  return call_script(script.data(), script.size());
+}
+
+template<typename... Args>
+inline std::future<Variable>
+Dispatcher::call_async(const std::string& name, Args&&... args) {
+  return submit(
+    find(name, sizeof...(Args)),
+    std::vector<Variable>{Variable(std::forward<Args>(args))...});
+}
+
+inline std::future<Variable>
+Dispatcher::submit(const Command& cmd, std::vector<Variable>&& args) {
+  std::call_once(m_pool_started, [this]() {
+    m_pool.reset(new threadpool_impl::ThreadPool(m_num_workers));
+  });
+  return m_pool->submit(
+    [&cmd, args = std::move(args)]() { return cmd.func(Arguments(args)); });
+}
+
+inline Dispatcher::Handle
+Dispatcher::lookup(const std::string& name) const {
+  // commands are owned by all later tables and never move
+  return Handle(&find(name));
+}
+
+template<typename R, typename... Args>
+inline R
+Dispatcher::invoke(Handle handle, const Args&... args) {
+  // arguments are always passed as const, e.g. literals decay to const char*
+  using Typed = dispatcher_impl::TypedFunction<R, const Args...>;
+
+  if (!handle) {
+    throw std::invalid_argument("Can not invoke an invalid command handle");
+  }
+  const Command& cmd = *handle.m_cmd;
+  if (cmd.signature == dispatcher_impl::signature_tag<std::decay_t<R>(
+                         std::decay_t<const Args>...)>()) {
+    return (*static_cast<const Typed*>(cmd.typed.get()))(args...);
+  }
+  // generic fallback with conversions and runtime type checks
+  if (sizeof...(Args) != cmd.argument_types.size()) {
+    throw std::invalid_argument("Invalid number of arguments");
+  }
+  ArgumentBuffer vargs;
+  // see namedtuple_impl::print_tuple for explanation
+  using Vacuum = int[];
+  (void)Vacuum{(vargs.emplace_back(args), 0)..., 0};
+  return dispatcher_impl::Unbox<R>::convert(
+    cmd.func(Arguments(vargs.begin(), vargs.size())));
 }
 
 inline std::vector<std::string>
 Dispatcher::commands() const {
   std::vector<std::string> cmds;
 
-  for (const auto& cmd : m_commands) {
-    cmds.emplace_back(cmd.first);
+  const Table* table = m_table.load(std::memory_order_acquire);
+  for (std::size_t i = 0; i <= table->mask; ++i) {
+    const Command* cmd = table->slots[i].load(std::memory_order_acquire);
+    if (cmd) {
+      cmds.emplace_back(cmd->name);
+    }
   }
   return cmds;
 }
 
+inline const Variable&
+Dispatcher::Arguments::at(std::size_t idx) const {
+  if (m_size <= idx) {
+    throw std::out_of_range("Argument index is out of range");
+  }
+  return m_data[idx];
+}
+
 inline const std::string&
 Dispatcher::help(const std::string& name) const {
-  return m_commands.at(name).help;
+  const Command* cmd = find_command(name);
+  if (not cmd) {
+    throw std::out_of_range("Unknown command '" + name + "'");
+  }
+  return cmd->help;
 }
 
 } // namespace dfe
@@ -28,10 +28,41 @@
 
 #include <algorithm>
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace dfe {
+namespace flat_impl {
+
+// Sorted sequences up to this size are searched with a linear scan.
+constexpr std::size_t kLinearSearchSize = 16;
+
+// Detect transparent comparators; the lookup type delays the evaluation.
+template<typename...>
+struct MakeVoid {
+  using type = void;
+};
+template<typename Compare, typename K, typename = void>
+struct IsTransparent : std::false_type {};
+template<typename Compare, typename K>
+struct IsTransparent<
+  Compare, K, typename MakeVoid<typename Compare::is_transparent>::type>
+  : std::true_type {};
+
+// Allocator for a different element type.
+template<typename Allocator, typename T>
+using Rebind =
+  typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+// Position of the first element in the sorted sequence not less than `u`.
+template<typename Compare, typename RandomIt, typename U>
+std::size_t lower_bound_index(RandomIt items, std::size_t n, const U& u);
+
+} // namespace flat_impl
 
 /// An container adaptor to store a set of elements in a sequential container.
 ///
@@ -49,6 +80,13 @@ namespace dfe {
 /// The set elements can not be modified on purpose. With a non-standard
 /// `Compare` function modifying a contained object might change its identity
 /// and thus its position in the set. This would break the internal sorting.
+///
+/// Lookups in small sets use a branchless linear scan and a branchless binary
+/// search otherwise. Large sets with frequent lookups can additionally keep
+/// a search index in Eytzinger layout, see `set_eytzinger_index`.
+///
+/// All memory, including the optional search index, is obtained from the
+/// allocator of the underlying container.
 template<
   typename T, typename Compare = std::less<T>,
   typename Container = std::vector<T>>
@@ -57,6 +95,12 @@ public:
   using value_type = T;
   using size_type = typename Container::size_type;
   using const_iterator = typename Container::const_iterator;
+  using allocator_type = typename Container::allocator_type;
+
+  FlatSet() = default;
+  /// Construct an empty set that uses the given allocator.
+  explicit FlatSet(const allocator_type& alloc)
+    : m_items(alloc), m_eytzinger(alloc), m_eytzinger_ranks(alloc) {}
 
   /// Access the equivalent element or throw if it does not exists.
   template<typename U>
@@ -70,8 +114,10 @@ public:
   /// Return the number of elements in the set.
   size_type size() const { return m_items.size(); }
 
+  /// Reserve storage for at least the given number of elements.
+  void reserve(size_type n) { m_items.reserve(n); }
   /// Remove all elements from the container.
-  void clear() { m_items.clear(); }
+  void clear();
   /// Add the element to the set or replace the existing equivalent element.
   ///
   /// Depending on the `Compare` function we might have elements with different
@@ -79,6 +125,22 @@ public:
   /// function. Only one can be kept and this function replaces the existing
   /// element with the new one in such a case.
   void insert_or_assign(const T& t);
+  /// Add all elements in the range with the same semantic as above.
+  ///
+  /// The elements are appended and sorted once, i.e. the total cost is
+  /// O(n log n) instead of O(n) per element. If equivalent elements exist,
+  /// the one inserted last is kept.
+  template<typename InputIt>
+  void insert(InputIt first, InputIt last);
+
+  /// Enable or disable the additional Eytzinger-layout search index.
+  ///
+  /// The index stores a copy of the elements in breadth-first order of the
+  /// implicit search tree. This yields a very cache-friendly memory access
+  /// pattern for lookups in large sets at the expense of additional memory
+  /// and slower modifications. It is only used for sets that are too large
+  /// for the linear scan.
+  void set_eytzinger_index(bool enabled);
 
   /// Return an interator to the equivalent element or `.end()` if not found.
   template<typename U>
@@ -87,32 +149,74 @@ public:
   template<typename U>
   bool contains(U&& u) const;
 
+  /// Sets up to this size are searched with a linear scan.
+  static constexpr size_type kLinearSearchSize = flat_impl::kLinearSearchSize;
+
 private:
+  template<typename U>
+  size_type lower_bound_index(const U& u) const;
+  template<typename U>
+  size_type eytzinger_lower_bound_node(const U& u) const;
+  void build_eytzinger_index();
+
+  using Ranks =
+    std::vector<size_type, flat_impl::Rebind<allocator_type, size_type>>;
+
   Container m_items;
+  bool m_use_eytzinger = false;
+  // elements in Eytzinger order and their positions in the sorted items
+  std::vector<T, flat_impl::Rebind<allocator_type, T>> m_eytzinger;
+  Ranks m_eytzinger_ranks;
 };
 
 /// A key-value map that stores keys and values in sequential containers.
 ///
-/// \tparam Key     Stored element key type
-/// \tparam T       Stored element value type
-/// \tparam Compare Function satisfying the `Compare` name requirements for keys
+/// \tparam Key       Stored element key type
+/// \tparam T         Stored element value type
+/// \tparam Compare   Function satisfying the `Compare` requirements for keys
+/// \tparam Allocator Allocator that is rebound for the keys and the values
 ///
 /// Supports access by key, clearing all elements, adding or replacing the
 /// stored value for a given key, and membership checks. Keys and values are
 /// stored in separate sequential containers to simplify allocation and benefit
-/// from greater memory locality.
-template<typename Key, typename T, typename Compare = std::less<Key>>
+/// from greater memory locality. Both are sorted by key and share the same
+/// position, i.e. a lookup only searches the keys once and then accesses the
+/// value directly.
+///
+/// If `Compare` defines `is_transparent`, e.g. `std::less<>`, elements can be
+/// accessed with any type comparable to the key without a temporary key.
+template<
+  typename Key, typename T, typename Compare = std::less<Key>,
+  typename Allocator = std::allocator<std::pair<const Key, T>>>
 class FlatMap {
+  template<typename K>
+  using IfTransparent =
+    std::enable_if_t<flat_impl::IsTransparent<Compare, K>::value>;
+
 public:
   using key_type = Key;
   using value_type = T;
   using size_type = std::size_t;
+  using allocator_type = Allocator;
+
+  FlatMap() = default;
+  /// Construct an empty map that uses the given allocator.
+  explicit FlatMap(const Allocator& alloc)
+    : m_keys(KeyAllocator(alloc)), m_values(ValueAllocator(alloc)) {}
 
   /// Writable access to an element or throw if it does not exists.
-  value_type& at(const Key& key) { return m_items[m_keys.at(key).index]; }
+  value_type& at(const Key& key) { return m_values[checked_index(key)]; }
+  template<typename K, typename = IfTransparent<K>>
+  value_type& at(const K& key) {
+    return m_values[checked_index(key)];
+  }
   /// Read-only access to an element or throw if it does not exists.
   const value_type& at(const Key& key) const {
-    return m_items[m_keys.at(key).index];
+    return m_values[checked_index(key)];
+  }
+  template<typename K, typename = IfTransparent<K>>
+  const value_type& at(const K& key) const {
+    return m_values[checked_index(key)];
   }
 
   /// Return true if there are no elements in the map.
@@ -120,39 +224,88 @@ public:
   /// Return the number of elements in the container.
   size_type size() const { return m_keys.size(); }
 
+  /// Reserve storage for at least the given number of elements.
+  void reserve(size_type n) { m_keys.reserve(n), m_values.reserve(n); }
   /// Remove all elements from the container.
-  void clear() { m_keys.clear(), m_items.clear(); }
+  void clear() { m_keys.clear(), m_values.clear(); }
   /// Add the element under the given key or replace an existing element.
   ///
   /// New elements are constructed or assigned in-place with the parameters
   /// forwarded to a `T(...)` constructor call.
   template<typename... Params>
   void emplace(const Key& key, Params&&... params);
+  /// Add the element under the given key only if it does not exist yet.
+  ///
+  /// The value is only constructed if it is added.
+  ///
+  /// \returns true if the element was added
+  template<typename... Params>
+  bool try_emplace(const Key& key, Params&&... params);
+  /// Add the element under the given key or assign to the existing element.
+  ///
+  /// \returns true if the element was added
+  template<typename M>
+  bool insert_or_assign(const Key& key, M&& value);
+  /// Add or replace all key-value pairs in the range.
+  ///
+  /// The keys are sorted once, i.e. the total cost is O(n log n) instead of
+  /// O(n) per element. If a key is given multiple times, the value inserted
+  /// last is kept.
+  template<typename InputIt>
+  void insert(InputIt first, InputIt last);
 
   /// Return true if an element exists for the given key
-  bool contains(const Key& key) const { return m_keys.contains(key); }
+  bool contains(const Key& key) const { return (find_index(key) != size()); }
+  template<typename K, typename = IfTransparent<K>>
+  bool contains(const K& key) const {
+    return (find_index(key) != size());
+  }
 
 private:
-  struct KeyIndex {
-    Key key;
-    size_type index;
-  };
-  struct KeyCompare {
-    constexpr bool operator()(const KeyIndex& lhs, const KeyIndex& rhs) const {
-      return Compare()(lhs.key, rhs.key);
-    }
-    constexpr bool operator()(const KeyIndex& lhs, const Key& rhs_key) const {
-      return Compare()(lhs.key, rhs_key);
-    }
-    constexpr bool operator()(const Key& lhs_key, const KeyIndex& rhs) const {
-      return Compare()(lhs_key, rhs.key);
-    }
-  };
+  // Insert position for the key; appending in key order needs no search.
+  template<typename K>
+  size_type lower_bound_index(const K& key) const;
+  template<typename K>
+  bool is_equivalent(size_type idx, const K& key) const;
+  template<typename K>
+  size_type find_index(const K& key) const;
+  template<typename K>
+  size_type checked_index(const K& key) const;
+  template<typename... Params>
+  void insert_at(size_type idx, const Key& key, Params&&... params);
+
+  using KeyAllocator = flat_impl::Rebind<Allocator, Key>;
+  using ValueAllocator = flat_impl::Rebind<Allocator, T>;
 
-  FlatSet<KeyIndex, KeyCompare> m_keys;
-  std::vector<T> m_items;
+  std::vector<Key, KeyAllocator> m_keys;
+  std::vector<T, ValueAllocator> m_values;
 };
 
+// implementation helpers
+
+template<typename Compare, typename RandomIt, typename U>
+inline std::size_t
+flat_impl::lower_bound_index(RandomIt items, std::size_t n, const U& u) {
+  Compare cmp;
+
+  if (n <= kLinearSearchSize) {
+    // count smaller elements w/o branches; compilers can vectorize this
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      pos += static_cast<std::size_t>(cmp(items[i], u));
+    }
+    return pos;
+  }
+  // binary search with a fixed number of iterations that only depends on the
+  // size. the conditional move does not need a branch.
+  std::size_t base = 0;
+  for (std::size_t len = n; 1 < len; len -= len / 2) {
+    std::size_t half = len / 2;
+    base = cmp(items[base + half], u) ? (base + half) : base;
+  }
+  return base + static_cast<std::size_t>(cmp(items[base], u));
+}
+
 // implementation FlatSet
 
 template<typename T, typename Compare, typename Container>
@@ -166,15 +319,134 @@ FlatSet<T, Compare, Container>::at(U&& u) const {
   return *pos;
 }
 
+template<typename T, typename Compare, typename Container>
+constexpr typename FlatSet<T, Compare, Container>::size_type
+  FlatSet<T, Compare, Container>::kLinearSearchSize;
+
+template<typename T, typename Compare, typename Container>
+inline void
+FlatSet<T, Compare, Container>::clear() {
+  m_items.clear();
+  m_eytzinger.clear();
+  m_eytzinger_ranks.clear();
+}
+
 template<typename T, typename Compare, typename Container>
 inline void
 FlatSet<T, Compare, Container>::insert_or_assign(const T& t) {
-  auto pos = std::lower_bound(m_items.begin(), m_items.end(), t, Compare());
+  auto pos = std::next(m_items.begin(), lower_bound_index(t));
   if (((pos != m_items.end()) and !Compare()(t, *pos))) {
     *pos = t;
   } else {
     m_items.emplace(pos, t);
   }
+  build_eytzinger_index();
+}
+
+template<typename T, typename Compare, typename Container>
+template<typename InputIt>
+inline void
+FlatSet<T, Compare, Container>::insert(InputIt first, InputIt last) {
+  auto num_existing = m_items.size();
+  m_items.insert(m_items.end(), first, last);
+  auto begin = m_items.begin();
+  auto middle = std::next(begin, num_existing);
+  auto end = m_items.end();
+  // stable sorting keeps equivalent elements in insertion order
+  std::stable_sort(middle, end, Compare());
+  std::inplace_merge(begin, middle, end, Compare());
+  // keep only the last element of each run of equivalent elements
+  auto out = begin;
+  for (auto it = begin; it != end; ++out) {
+    auto next = std::next(it);
+    while ((next != end) and !Compare()(*it, *next)) {
+      it = next++;
+    }
+    if (out != it) {
+      *out = std::move(*it);
+    }
+    it = next;
+  }
+  m_items.erase(out, end);
+  build_eytzinger_index();
+}
+
+template<typename T, typename Compare, typename Container>
+inline void
+FlatSet<T, Compare, Container>::set_eytzinger_index(bool enabled) {
+  m_use_eytzinger = enabled;
+  build_eytzinger_index();
+}
+
+template<typename T, typename Compare, typename Container>
+inline void
+FlatSet<T, Compare, Container>::build_eytzinger_index() {
+  m_eytzinger.clear();
+  m_eytzinger_ranks.clear();
+  if (not m_use_eytzinger or (m_items.size() <= kLinearSearchSize)) {
+    return;
+  }
+  m_eytzinger.resize(m_items.size(), *m_items.begin());
+  m_eytzinger_ranks.resize(m_items.size());
+  // an in-order traversal of the implicit tree visits the sorted elements.
+  size_type rank = 0;
+  size_type node = 0;
+  Ranks parents(m_eytzinger_ranks.get_allocator());
+  while ((node < m_items.size()) or not parents.empty()) {
+    if (node < m_items.size()) {
+      parents.push_back(node);
+      node = 2 * node + 1;
+    } else {
+      node = parents.back();
+      parents.pop_back();
+      m_eytzinger[node] = *std::next(m_items.begin(), rank);
+      m_eytzinger_ranks[node] = rank;
+      rank += 1;
+      node = 2 * node + 2;
+    }
+  }
+}
+
+// Position of the first element that is not less than the given value.
+template<typename T, typename Compare, typename Container>
+template<typename U>
+inline typename FlatSet<T, Compare, Container>::size_type
+FlatSet<T, Compare, Container>::lower_bound_index(const U& u) const {
+  const size_type n = m_items.size();
+  // the index is only built for sets that are too large for a linear scan
+  if (not m_eytzinger.empty()) {
+    size_type node = eytzinger_lower_bound_node(u);
+    return (node < n) ? m_eytzinger_ranks[node] : n;
+  }
+  return flat_impl::lower_bound_index<Compare>(m_items.begin(), n, u);
+}
+
+template<typename T, typename Compare, typename Container>
+template<typename U>
+inline typename FlatSet<T, Compare, Container>::size_type
+FlatSet<T, Compare, Container>::eytzinger_lower_bound_node(
+  const U& u) const {
+  Compare cmp;
+  const size_type n = m_eytzinger.size();
+  const T* nodes = m_eytzinger.data();
+
+  // descend w/o branches; go right if the node is less than the value
+  size_type node = 0;
+  while (node < n) {
+#if defined(__GNUC__)
+    // children of the grand-grand-children are contiguous in memory
+    __builtin_prefetch(nodes + std::min(16 * node + 15, n - 1));
+#endif
+    node = 2 * node + 1 + static_cast<size_type>(cmp(nodes[node], u));
+  }
+  // the lower bound is the last node where we went left. in the one-based
+  // node numbering, this removes all trailing right-turns and the last left.
+  size_type k = node + 1;
+  while (k & 1u) {
+    k >>= 1;
+  }
+  k >>= 1;
+  return (k == 0) ? n : (k - 1);
 }
 
 template<typename T, typename Compare, typename Container>
@@ -182,32 +454,164 @@ template<typename U>
 inline typename FlatSet<T, Compare, Container>::const_iterator
 FlatSet<T, Compare, Container>::find(U&& u) const {
   auto end = m_items.end();
-  auto pos =
-    std::lower_bound(m_items.begin(), end, std::forward<U>(u), Compare());
-  return ((pos != end) and !Compare()(std::forward<U>(u), *pos)) ? pos : end;
+  if (not m_eytzinger.empty()) {
+    // check the candidate in the index to avoid touching the sorted items
+    size_type node = eytzinger_lower_bound_node(u);
+    if ((node == m_eytzinger.size()) or Compare()(u, m_eytzinger[node])) {
+      return end;
+    }
+    return std::next(m_items.begin(), m_eytzinger_ranks[node]);
+  }
+  auto pos = std::next(m_items.begin(), lower_bound_index(u));
+  return ((pos != end) and !Compare()(u, *pos)) ? pos : end;
 }
 
 template<typename T, typename Compare, typename Container>
 template<typename U>
 inline bool
 FlatSet<T, Compare, Container>::contains(U&& u) const {
-  return std::binary_search(
-    m_items.begin(), m_items.end(), std::forward<U>(u), Compare());
+  return find(std::forward<U>(u)) != end();
 }
 
 // implementation FlatMap
 
-template<typename Key, typename T, typename Compare>
+template<typename Key, typename T, typename Compare, typename Allocator>
+template<typename K>
+inline typename FlatMap<Key, T, Compare, Allocator>::size_type
+FlatMap<Key, T, Compare, Allocator>::lower_bound_index(const K& key) const {
+  if (m_keys.empty() or Compare()(m_keys.back(), key)) {
+    return m_keys.size();
+  }
+  return flat_impl::lower_bound_index<Compare>(
+    m_keys.begin(), m_keys.size(), key);
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+template<typename K>
+inline bool
+FlatMap<Key, T, Compare, Allocator>::is_equivalent(
+  size_type idx, const K& key) const {
+  return (idx < m_keys.size()) and !Compare()(key, m_keys[idx]);
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+template<typename K>
+inline typename FlatMap<Key, T, Compare, Allocator>::size_type
+FlatMap<Key, T, Compare, Allocator>::find_index(const K& key) const {
+  auto idx =
+    flat_impl::lower_bound_index<Compare>(m_keys.begin(), m_keys.size(), key);
+  return is_equivalent(idx, key) ? idx : m_keys.size();
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+template<typename K>
+inline typename FlatMap<Key, T, Compare, Allocator>::size_type
+FlatMap<Key, T, Compare, Allocator>::checked_index(const K& key) const {
+  auto idx = find_index(key);
+  if (idx == m_keys.size()) {
+    throw std::out_of_range("The requested element does not exists");
+  }
+  return idx;
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
 template<typename... Params>
 inline void
-FlatMap<Key, T, Compare>::emplace(const Key& key, Params&&... params) {
-  auto idx = m_keys.find(key);
-  if (idx != m_keys.end()) {
-    m_items[idx->index] = T(std::forward<Params>(params)...);
+FlatMap<Key, T, Compare, Allocator>::insert_at(
+  size_type idx, const Key& key, Params&&... params) {
+  m_values.emplace(
+    std::next(m_values.begin(), idx), std::forward<Params>(params)...);
+  try {
+    m_keys.emplace(std::next(m_keys.begin(), idx), key);
+  } catch (...) {
+    // keep keys and values consistent
+    m_values.erase(std::next(m_values.begin(), idx));
+    throw;
+  }
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+template<typename... Params>
+inline void
+FlatMap<Key, T, Compare, Allocator>::emplace(
+  const Key& key, Params&&... params) {
+  auto idx = lower_bound_index(key);
+  if (is_equivalent(idx, key)) {
+    m_values[idx] = T(std::forward<Params>(params)...);
   } else {
-    m_items.emplace_back(std::forward<Params>(params)...);
-    m_keys.insert_or_assign(KeyIndex{key, m_items.size() - 1});
+    insert_at(idx, key, std::forward<Params>(params)...);
+  }
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+template<typename... Params>
+inline bool
+FlatMap<Key, T, Compare, Allocator>::try_emplace(
+  const Key& key, Params&&... params) {
+  auto idx = lower_bound_index(key);
+  if (is_equivalent(idx, key)) {
+    return false;
+  }
+  insert_at(idx, key, std::forward<Params>(params)...);
+  return true;
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+template<typename M>
+inline bool
+FlatMap<Key, T, Compare, Allocator>::insert_or_assign(
+  const Key& key, M&& value) {
+  auto idx = lower_bound_index(key);
+  if (is_equivalent(idx, key)) {
+    m_values[idx] = std::forward<M>(value);
+    return false;
+  }
+  insert_at(idx, key, std::forward<M>(value));
+  return true;
+}
+
+template<typename Key, typename T, typename Compare, typename Allocator>
+template<typename InputIt>
+inline void
+FlatMap<Key, T, Compare, Allocator>::insert(InputIt first, InputIt last) {
+  using Element = std::pair<Key, T>;
+
+  std::vector<Element, flat_impl::Rebind<Allocator, Element>> added(
+    first, last, m_keys.get_allocator());
+  auto compare = [](const Element& a, const Element& b) {
+    return Compare()(a.first, b.first);
+  };
+  // stable sorting keeps equivalent keys in insertion order
+  std::stable_sort(added.begin(), added.end(), compare);
+
+  std::vector<Key, KeyAllocator> keys(m_keys.get_allocator());
+  std::vector<T, ValueAllocator> values(m_values.get_allocator());
+  keys.reserve(m_keys.size() + added.size());
+  values.reserve(m_keys.size() + added.size());
+  // merge the existing and the added elements. for equivalent keys only the
+  // last of the added elements is kept.
+  size_type i = 0;
+  for (auto it = added.begin(); it != added.end(); ++it) {
+    auto next = std::next(it);
+    if ((next != added.end()) and !compare(*it, *next)) {
+      continue;
+    }
+    for (; (i < m_keys.size()) and Compare()(m_keys[i], it->first); ++i) {
+      keys.push_back(std::move(m_keys[i]));
+      values.push_back(std::move(m_values[i]));
+    }
+    if (is_equivalent(i, it->first)) {
+      ++i;
+    }
+    keys.push_back(std::move(it->first));
+    values.push_back(std::move(it->second));
+  }
+  for (; i < m_keys.size(); ++i) {
+    keys.push_back(std::move(m_keys[i]));
+    values.push_back(std::move(m_values[i]));
   }
+  m_keys = std::move(keys);
+  m_values = std::move(values);
 }
 
 } // namespace dfe
@@ -28,30 +28,127 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <initializer_list>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <stdexcept>
+#include <thread>
+#include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace dfe {
+
+template<typename T>
+class AtomicBin;
+template<typename T, typename Allocator = std::allocator<T>>
+struct DenseStorage;
+template<typename T>
+struct SparseStorage;
+struct CounterStorage;
+
 namespace histogram_impl {
+
+// Compute the edges of uniform bins.
+template<typename T>
+inline std::vector<T>
+uniform_edges(T lower, T upper, std::size_t nbins) {
+  std::vector<T> edges(nbins + 1);
+  for (std::size_t i = 0; i < nbins; ++i) {
+    edges[i] = lower + ((upper - lower) * static_cast<T>(i)) / nbins;
+  }
+  edges.back() = upper;
+  return edges;
+}
+
+// Type of the weight that is added to a bin.
+template<typename T>
+struct BinWeight {
+  using type = T;
+};
+template<typename T>
+struct BinWeight<AtomicBin<T>> {
+  using type = T;
+};
+
+// Total number of elements for the given size along each dimension.
+template<std::size_t NDimensions>
+inline std::size_t
+total_size(const std::array<std::size_t, NDimensions>& size) {
+  return std::accumulate(
+    size.begin(), size.end(), static_cast<std::size_t>(1),
+    std::multiplies<std::size_t>());
+}
+
+// Construct linear column-major index from n-dimensional index.
+template<std::size_t NDimensions>
+constexpr std::size_t
+linear_index(
+  const std::array<std::size_t, NDimensions>& size,
+  const std::array<std::size_t, NDimensions>& idx) {
+  std::size_t result = 0;
+  std::size_t step = 1;
+  for (std::size_t i = 0; i < NDimensions; ++i) {
+    result += step * idx[i];
+    step *= size[i];
+  }
+  return result;
+}
+
+template<std::size_t NDimensions>
+constexpr bool
+within_bounds(
+  const std::array<std::size_t, NDimensions>& size,
+  const std::array<std::size_t, NDimensions>& idx) {
+  for (std::size_t i = 0; i < NDimensions; ++i) {
+    if (size[i] <= idx[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template<std::size_t NDimensions>
+inline std::array<std::size_t, NDimensions>
+column_major_strides(const std::array<std::size_t, NDimensions>& size) {
+  std::array<std::size_t, NDimensions> result;
+  std::size_t step = 1;
+  for (std::size_t i = 0; i < NDimensions; ++i) {
+    result[i] = step;
+    step *= size[i];
+  }
+  return result;
+}
+
 namespace {
 
 /// A simple n-dimensional array.
 ///
 /// Data must be accessed through n-dimensional indices. The internal
 /// storage format is considered an implementation detail. The size along
-/// each dimension is set at run-time.
-template<typename T, std::size_t NDimensions>
+/// each dimension is set at run-time. The elements are stored in a single
+/// block obtained from the allocator.
+template<
+  typename T, std::size_t NDimensions, typename Allocator = std::allocator<T>>
 class NArray {
 public:
   using Index = std::array<std::size_t, NDimensions>;
+  using Weight = typename BinWeight<T>::type;
 
   /// Construct default-initialized NArray with given size along each dimension.
-  NArray(Index size, const T& value = T());
+  NArray(
+    Index size, const T& value = T(), const Allocator& alloc = Allocator());
+  /// Construct default-initialized NArray using the given allocator.
+  NArray(Index size, const Allocator& alloc) : NArray(size, T(), alloc) {}
   NArray(const NArray&) = default;
   NArray(NArray&&) = default;
   NArray& operator=(const NArray&) = default;
@@ -68,18 +165,296 @@ public:
   const T& at(Index idx) const;
   /// Access element with boundary check.
   T& at(Index idx);
+  /// Add the elements of another array with the same size.
+  NArray& operator+=(const NArray& other);
+  /// Reset all elements to their default value.
+  void clear() { std::fill(m_data.begin(), m_data.end(), T()); }
+  /// Add a weight to the element without boundary check.
+  void add(Index idx, Weight weight) { m_data[linear(idx)] += weight; }
+  /// Add weights to multiple elements given by their linear indices.
+  ///
+  /// \param linear  Pointer to n linear indices
+  /// \param n       Number of elements
+  /// \param weights Pointer to n weights; nullptr adds one to each element.
+  void add_n(const std::size_t* linear, std::size_t n, const Weight* weights);
+  /// Step between neighboring elements along each dimension.
+  ///
+  /// Together with `data()` allows direct access to the underlying storage.
+  Index strides() const { return column_major_strides(m_size); }
+  /// Access the underlying linear storage.
+  T* data() { return m_data.data(); }
+  const T* data() const { return m_data.data(); }
+
+private:
+  constexpr std::size_t linear(Index idx) const {
+    return linear_index(m_size, idx);
+  }
+
+  Index m_size;
+  std::vector<T, Allocator> m_data;
+};
+
+/// A n-dimensional array of integer counters that widen on overflow.
+///
+/// All counters start with the smallest width and the whole array is
+/// promoted to the next wider integer type once any counter overflows.
+/// Provides the same interface as `NArray` except for direct data access.
+template<std::size_t NDimensions>
+class CounterArray {
+public:
+  using Index = std::array<std::size_t, NDimensions>;
+  using Weight = std::uint64_t;
+
+  /// Construct zero-initialized array with given size along each dimension.
+  CounterArray(Index size);
+
+  /// Size along all dimensions.
+  constexpr const Index& size() const { return m_size; }
+  /// Read-only access element with boundary check.
+  std::uint64_t at(Index idx) const;
+  /// Add the elements of another array with the same size.
+  CounterArray& operator+=(const CounterArray& other);
+  /// Reset all counters to zero and to the smallest width.
+  void clear();
+  /// Add a weight to the element without boundary check.
+  void add(Index idx, Weight weight) {
+    add_linear(linear_index(m_size, idx), weight);
+  }
+  /// Add weights to multiple elements given by their linear indices.
+  void add_n(const std::size_t* linear, std::size_t n, const Weight* weights);
+  /// Step between neighboring elements along each dimension.
+  Index strides() const { return column_major_strides(m_size); }
+  /// Current size of each counter in bytes.
+  std::size_t counter_size() const { return m_width; }
 
 private:
-  constexpr std::size_t linear(Index idx) const;
-  constexpr bool within_bounds(Index idx) const;
+  template<typename U>
+  static bool try_add(std::vector<U>& counters, std::size_t i, Weight weight);
+  template<typename U>
+  std::vector<U> widened() const;
+  std::uint64_t load(std::size_t i) const;
+  void add_linear(std::size_t i, Weight weight);
+  void promote();
 
   Index m_size;
-  std::vector<T> m_data;
+  std::size_t m_width;
+  // only the container that matches the current width is used
+  std::vector<std::uint8_t> m_u8;
+  std::vector<std::uint16_t> m_u16;
+  std::vector<std::uint32_t> m_u32;
+  std::vector<std::uint64_t> m_u64;
+};
+
+/// A n-dimensional array that only stores non-empty elements.
+///
+/// Elements are stored in a hash map keyed by their linear index. Memory use
+/// scales with the number of filled elements and not with the total size.
+/// Provides the same interface as `NArray` except for direct data access.
+template<typename T, std::size_t NDimensions>
+class SparseArray {
+public:
+  using Index = std::array<std::size_t, NDimensions>;
+  using Weight = typename BinWeight<T>::type;
+
+  /// Construct empty array with given size along each dimension.
+  SparseArray(Index size) : m_size(size) {}
+
+  /// Size along all dimensions.
+  constexpr const Index& size() const { return m_size; }
+  /// Read-only access element with boundary check.
+  ///
+  /// Elements that were never filled are default-initialized.
+  T at(Index idx) const;
+  /// Add the elements of another array with the same size.
+  SparseArray& operator+=(const SparseArray& other);
+  /// Remove all stored elements.
+  void clear() { m_elements.clear(); }
+  /// Add a weight to the element without boundary check.
+  void add(Index idx, Weight weight) {
+    m_elements[linear_index(m_size, idx)] += weight;
+  }
+  /// Add weights to multiple elements given by their linear indices.
+  void add_n(const std::size_t* linear, std::size_t n, const Weight* weights);
+  /// Step between neighboring elements along each dimension.
+  Index strides() const { return column_major_strides(m_size); }
+  /// Number of stored, i.e. filled, elements.
+  std::size_t num_stored() const { return m_elements.size(); }
+
+private:
+  Index m_size;
+  std::unordered_map<std::size_t, T> m_elements;
 };
 
 } // namespace
+
+// Storage type for the bin type or storage policy.
+template<typename T, std::size_t NDimensions>
+struct Storage {
+  using type = NArray<T, NDimensions>;
+};
+template<typename T, typename Allocator, std::size_t NDimensions>
+struct Storage<DenseStorage<T, Allocator>, NDimensions> {
+  using type = NArray<T, NDimensions, Allocator>;
+};
+template<typename T, std::size_t NDimensions>
+struct Storage<SparseStorage<T>, NDimensions> {
+  using type = SparseArray<T, NDimensions>;
+};
+template<std::size_t NDimensions>
+struct Storage<CounterStorage, NDimensions> {
+  using type = CounterArray<NDimensions>;
+};
+
+// Position of a value within uniform axis limits in units of the bin width.
+//
+// Floating point values use the precomputed inverse bin width to avoid a
+// per-value division. Integral values use exact integer arithmetic, the
+// truncated inverse bin width would be meaningless.
+template<typename T>
+constexpr std::enable_if_t<std::is_floating_point<T>::value, T>
+uniform_position(T value, T lower, T, T scale, std::size_t) {
+  return (value - lower) * scale;
+}
+template<typename T>
+constexpr std::enable_if_t<std::is_integral<T>::value, T>
+uniform_position(T value, T lower, T upper, T, std::size_t nbins) {
+  return static_cast<T>(nbins * (value - lower) / (upper - lower));
+}
+
+// Compute uniform bin numbers w/ the given integer type for the conversion.
+//
+// Clamps and selects are used instead of branches so the loop can be
+// vectorized. Values below/above the limits map to the positions before/after
+// the data bins, i.e. `offset - 1` and `offset + nbins`.
+template<typename Integer, typename T>
+inline void
+uniform_index_n_as(
+  const T* values, std::size_t n, std::size_t* indices, T lower, T upper,
+  T scale, std::size_t nbins, std::size_t offset) {
+  const T zero = static_cast<T>(0);
+  const T last = static_cast<T>(nbins - 1);
+  const std::size_t underflow = offset - 1;
+  const std::size_t overflow = offset + nbins;
+  for (std::size_t i = 0; i < n; ++i) {
+    T x = uniform_position(values[i], lower, upper, scale, nbins);
+    x = (x < zero) ? zero : x;
+    // rounding might move values just below the upper limit beyond last bin
+    x = (x < last) ? x : last;
+    auto idx = offset + static_cast<std::size_t>(static_cast<Integer>(x));
+    idx = (values[i] < upper) ? idx : overflow;
+    idx = (values[i] < lower) ? underflow : idx;
+    indices[i] = idx;
+  }
+}
+
+// Compute uniform bin numbers for multiple values.
+template<typename T>
+inline void
+uniform_index_n(
+  const T* values, std::size_t n, std::size_t* indices, T lower, T upper,
+  T scale, std::size_t nbins, std::size_t offset) {
+  // 32bit conversions are vectorizable on more platforms
+  if (nbins <= static_cast<std::size_t>(INT32_MAX)) {
+    uniform_index_n_as<std::int32_t>(
+      values, n, indices, lower, upper, scale, nbins, offset);
+  } else {
+    uniform_index_n_as<std::int64_t>(
+      values, n, indices, lower, upper, scale, nbins, offset);
+  }
+}
+
+// Compute bin numbers for multiple values w/ the axis batch interface.
+template<typename Axis>
+inline auto
+index_n(
+  const Axis& axis, const typename Axis::Value* values, std::size_t n,
+  std::size_t* indices, int)
+  -> decltype(axis.index_n(values, n, indices), void()) {
+  axis.index_n(values, n, indices);
+}
+
+// Compute bin numbers for multiple values for axes w/o batch interface.
+template<typename Axis>
+inline void
+index_n(
+  const Axis& axis, const typename Axis::Value* values, std::size_t n,
+  std::size_t* indices, long) {
+  for (std::size_t i = 0; i < n; ++i) {
+    indices[i] = axis.index(values[i]);
+  }
+}
+
+// Add the bin numbers along one axis to the linear storage indices.
+template<typename Axis>
+inline void
+accumulate_linear(
+  const Axis& axis, const typename Axis::Value* values, std::size_t n,
+  std::size_t stride, std::size_t* indices, std::size_t* linear) {
+  // select the batch interface if available
+  index_n(axis, values, n, indices, 0);
+  for (std::size_t i = 0; i < n; ++i) {
+    linear[i] += stride * indices[i];
+  }
+}
+
 } // namespace histogram_impl
 
+/// Bin content that can be filled concurrently from multiple threads.
+///
+/// Use as the bin type, e.g. `Histogram<AtomicBin<double>, ...>`, when many
+/// threads fill a single histogram with many bins and low contention per
+/// bin. Updates use relaxed memory ordering; the content is only guaranteed
+/// to be complete after all filling threads have been synchronized, e.g.
+/// joined.
+template<typename T>
+class AtomicBin {
+public:
+  using Value = T;
+
+  AtomicBin(T value = T()) : m_value(value) {}
+  AtomicBin(const AtomicBin& other) : m_value(other.load()) {}
+  AtomicBin& operator=(const AtomicBin& other) {
+    m_value.store(other.load(), std::memory_order_relaxed);
+    return *this;
+  }
+
+  /// Get the current content.
+  T load() const { return m_value.load(std::memory_order_relaxed); }
+  operator T() const { return load(); }
+  /// Atomically add to the content.
+  AtomicBin& operator+=(T weight);
+  AtomicBin& operator+=(const AtomicBin& other) {
+    return *this += other.load();
+  }
+
+private:
+  std::atomic<T> m_value;
+};
+
+/// Dense bin storage; equivalent to using the bin type directly.
+///
+/// Use as the bin type, e.g. `Histogram<DenseStorage<double>, ...>`. All bins
+/// are allocated up front. The optional allocator is used for the bin storage,
+/// e.g. `DenseStorage<double, ArenaAllocator<double>>`, and must be passed to
+/// the histogram constructor if it is not default-constructible.
+template<typename T, typename Allocator>
+struct DenseStorage {};
+
+/// Sparse bin storage that only allocates filled bins.
+///
+/// Use as the bin type, e.g. `Histogram<SparseStorage<double>, ...>`, for
+/// high-dimensional histograms where most bins stay empty. Filling is slower
+/// than for dense storage.
+template<typename T>
+struct SparseStorage {};
+
+/// Compact integer counters that widen on overflow.
+///
+/// Use as the bin type, e.g. `Histogram<CounterStorage, ...>`, for unweighted
+/// or integer-weighted counts. Bins start as 8bit counters and the whole
+/// storage is promoted to 16, 32, or 64bit counters as required.
+struct CounterStorage {};
+
 /// Uniform binning without under/overflow bins.
 template<typename T>
 class UniformAxis {
@@ -95,11 +470,25 @@ public:
   constexpr std::size_t nbins() const { return m_nbins; }
   /// Compute bin number for a test value.
   std::size_t index(T value) const;
+  /// Compute bin numbers for multiple test values.
+  void index_n(const T* values, std::size_t n, std::size_t* indices) const;
+  /// Edges of the data bins, i.e. excluding under/overflow bins.
+  std::vector<T> edges() const {
+    return histogram_impl::uniform_edges(m_lower, m_upper, m_nbins);
+  }
+
+  /// Check if both axes have the same binning.
+  bool operator==(const UniformAxis& other) const {
+    return (m_nbins == other.m_nbins) and (m_lower == other.m_lower)
+           and (m_upper == other.m_upper);
+  }
 
 private:
   std::size_t m_nbins;
   T m_lower;
   T m_upper;
+  // inverse bin width to avoid per-value division; unused for integral types
+  T m_scale;
 };
 
 /// Uniform binning with under/overflow bins.
@@ -119,14 +508,32 @@ public:
   constexpr std::size_t nbins() const { return 2 + m_ndatabins; }
   /// Compute bin number for a test value.
   constexpr std::size_t index(T value) const;
+  /// Compute bin numbers for multiple test values.
+  void index_n(const T* values, std::size_t n, std::size_t* indices) const;
+  /// Edges of the data bins, i.e. excluding under/overflow bins.
+  std::vector<T> edges() const {
+    return histogram_impl::uniform_edges(m_lower, m_upper, m_ndatabins);
+  }
+
+  /// Check if both axes have the same binning.
+  bool operator==(const OverflowAxis& other) const {
+    return (m_ndatabins == other.m_ndatabins) and (m_lower == other.m_lower)
+           and (m_upper == other.m_upper);
+  }
 
 private:
   std::size_t m_ndatabins;
   T m_lower;
   T m_upper;
+  // inverse bin width to avoid per-value division; unused for integral types
+  T m_scale;
 };
 
 /// Variable binninng defined by arbitrary bin edges.
+///
+/// A uniform lookup grid over the axis range maps each value to a small
+/// range of candidate bins, so that finding the bin requires only few
+/// comparisons independent of the number of bins.
 template<typename T>
 class VariableAxis {
 public:
@@ -141,9 +548,57 @@ public:
   constexpr std::size_t nbins() const { return m_edges.size() - 1; }
   /// Compute bin number for a test value.
   std::size_t index(T value) const;
+  /// Edges of the data bins, i.e. excluding under/overflow bins.
+  const std::vector<T>& edges() const { return m_edges; }
+
+  /// Check if both axes have the same binning.
+  bool operator==(const VariableAxis& other) const {
+    return (m_edges == other.m_edges);
+  }
 
 private:
   std::vector<T> m_edges;
+  // first candidate bin for each grid cell w/ an additional trailing entry
+  std::vector<std::size_t> m_cells;
+  double m_lower;
+  // inverse grid cell width
+  double m_scale;
+
+  void build_cells();
+};
+
+/// Logarithmic binning without under/overflow bins.
+///
+/// Bins have uniform width in the logarithm of the value. The bin is
+/// computed directly and not via a search.
+template<typename T>
+class LogAxis {
+public:
+  using Value = T;
+
+  /// \param lower Lower inclusive boundary, must be positive
+  /// \param upper Upper exclusive boundary
+  /// \param nbins Number of data bins within those boundaries
+  LogAxis(T lower, T upper, std::size_t nbins);
+
+  /// Total number of bins along this axis.
+  constexpr std::size_t nbins() const { return m_edges.size() - 1; }
+  /// Compute bin number for a test value.
+  std::size_t index(T value) const;
+  /// Edges of the data bins, i.e. excluding under/overflow bins.
+  const std::vector<T>& edges() const { return m_edges; }
+
+  /// Check if both axes have the same binning.
+  bool operator==(const LogAxis& other) const {
+    return (m_edges == other.m_edges);
+  }
+
+private:
+  // explicit edges allow to correct rounding in the computed bin
+  std::vector<T> m_edges;
+  T m_log_lower;
+  // inverse bin width in logarithmic space
+  T m_scale;
 };
 
 /// A generic histogram with configurable axes.
@@ -153,35 +608,117 @@ private:
 template<typename T, typename... Axes>
 class Histogram {
 public:
-  using Data = dfe::histogram_impl::NArray<T, sizeof...(Axes)>;
+  using Data = typename histogram_impl::Storage<T, sizeof...(Axes)>::type;
   using Index = typename Data::Index;
+  using Weight = typename Data::Weight;
 
   Histogram(Axes&&... axes);
+  /// Construct the histogram with bin storage from the given allocator.
+  ///
+  /// Only available for dense storage with a matching allocator type.
+  template<typename Allocator>
+  Histogram(std::allocator_arg_t, const Allocator& alloc, Axes&&... axes);
 
   /// Get the number of bins along all axes.
   constexpr const Index& size() const { return m_data.size(); }
   /// Get the current entry value in the given bin.
-  const T& value(Index idx) const { return m_data.at(idx); }
+  ///
+  /// Returns a reference for dense storage and a copy otherwise.
+  decltype(auto) value(Index idx) const { return m_data.at(idx); }
+  /// Access the underlying bin storage.
+  const Data& data() const { return m_data; }
+  Data& data() { return m_data; }
+  /// Access the axis along the given dimension.
+  template<std::size_t I>
+  const auto& axis() const {
+    return std::get<I>(m_axes);
+  }
   /// Fill an entry into the histogram.
   ///
   /// \param values
   /// \param weight Associated weight, the default of 1 just counts entries.
-  void fill(typename Axes::Value... values, T weight = static_cast<T>(1)) {
+  void fill(
+    typename Axes::Value... values, Weight weight = static_cast<Weight>(1)) {
     // TODO 2018-11-28 how to typedef parameter pack Axes::Value...?
-    m_data[index(std::index_sequence_for<Axes...>(), values...)] += weight;
+    m_data.add(index(std::index_sequence_for<Axes...>(), values...), weight);
+  }
+  /// Fill multiple entries into the histogram.
+  ///
+  /// \param n       Number of entries
+  /// \param values  Pointer to n values for each axis
+  /// \param weights Pointer to n weights; the default nullptr counts entries.
+  ///
+  /// Equivalent to calling `fill(...)` for each entry. Bin numbers are
+  /// computed in blocks using the axis `.index_n(...)` if available.
+  /// If an entry is invalid, e.g. out of range on an axis w/o overflow bins,
+  /// the exception is thrown after earlier entries may have been added
+  /// already, i.e. the histogram is left partially filled. The invalid entry
+  /// and all following entries are never added.
+  void fill_n(
+    std::size_t n, const typename Axes::Value*... values,
+    const Weight* weights = nullptr) {
+    fill_n_impl(std::index_sequence_for<Axes...>(), n, weights, values...);
   }
+  /// Add the content of another histogram with identical axes.
+  ///
+  /// Axes must provide `operator==` to check their compatibility.
+  Histogram& operator+=(const Histogram& other);
+  /// Reset the content of all bins while keeping the axes.
+  void reset() { m_data.clear(); }
 
 private:
+  // number of entries per block in batch filling
+  static constexpr std::size_t kBlockSize = 256;
+
   template<std::size_t... Is>
   constexpr Index index(
     std::index_sequence<Is...>, typename Axes::Value... values) const {
     return Index{std::get<Is>(m_axes).index(values)...};
   }
+  template<std::size_t... Is>
+  void fill_n_impl(
+    std::index_sequence<Is...>, std::size_t n, const Weight* weights,
+    const typename Axes::Value*... values);
+  template<std::size_t... Is>
+  bool has_equal_axes(
+    const Histogram& other, std::index_sequence<Is...>) const;
 
   Data m_data;
   std::tuple<Axes...> m_axes;
 };
 
+/// Fill a histogram concurrently via independent per-thread shards.
+///
+/// Each thread fills its own copy of the histogram w/o any synchronization
+/// and the copies are only combined when requested. Retrieving the local
+/// shard requires a lock; it should be done once per thread and not for
+/// every entry.
+///
+/// \tparam H Histogram type that supports `operator+=` and `reset()`.
+template<typename H>
+class ShardedHistogram {
+public:
+  /// \param prototype Histogram that defines the axes and initial content
+  ///
+  /// Shards start empty; the initial content is only added once on merge.
+  explicit ShardedHistogram(H prototype) : m_prototype(std::move(prototype)) {}
+  ShardedHistogram(const ShardedHistogram&) = delete;
+  ShardedHistogram& operator=(const ShardedHistogram&) = delete;
+
+  /// Get the histogram shard of the calling thread. Created on first use.
+  H& local();
+  /// Combine all shards into a single histogram.
+  ///
+  /// Must not be called while shards are filled concurrently.
+  H merge() const;
+
+private:
+  H m_prototype;
+  mutable std::mutex m_mutex;
+  // pointers keep the references to the shards stable
+  std::vector<std::pair<std::thread::id, std::unique_ptr<H>>> m_shards;
+};
+
 // predefined histogram types
 
 using Histogram1 = Histogram<double, OverflowAxis<double>>;
@@ -190,63 +727,251 @@ using Histogram2 =
 
 // implementation NArray
 
-template<typename T, std::size_t NDimensions>
-inline histogram_impl::NArray<T, NDimensions>::NArray(
-  Index size, const T& value)
-  : m_size(size)
-  , m_data(
-      std::accumulate(
-        size.begin(), size.end(), static_cast<std::size_t>(1),
-        std::multiplies<std::size_t>()),
-      value) {}
-
-// construct linear column-major index from n-dimensional index
-template<typename T, std::size_t NDimensions>
-constexpr std::size_t
-histogram_impl::NArray<T, NDimensions>::linear(Index idx) const {
-  std::size_t result = 0;
-  std::size_t step = 1;
-  for (std::size_t i = 0; i < NDimensions; ++i) {
-    result += step * idx[i];
-    step *= m_size[i];
+template<typename T, std::size_t NDimensions, typename Allocator>
+inline histogram_impl::NArray<T, NDimensions, Allocator>::NArray(
+  Index size, const T& value, const Allocator& alloc)
+  : m_size(size), m_data(total_size(size), value, alloc) {}
+
+template<typename T, std::size_t NDimensions, typename Allocator>
+inline histogram_impl::NArray<T, NDimensions, Allocator>&
+histogram_impl::NArray<T, NDimensions, Allocator>::operator+=(
+  const NArray& other) {
+  if (m_size != other.m_size) {
+    throw std::invalid_argument("NArray sizes are not identical");
   }
-  return result;
+  for (std::size_t i = 0; i < m_data.size(); ++i) {
+    m_data[i] += other.m_data[i];
+  }
+  return *this;
 }
 
-template<typename T, std::size_t NDimensions>
-constexpr bool
-histogram_impl::NArray<T, NDimensions>::within_bounds(Index idx) const {
-  for (std::size_t i = 0; i < NDimensions; ++i) {
-    if (m_size[i] <= idx[i]) {
-      return false;
+template<typename T, std::size_t NDimensions, typename Allocator>
+inline void
+histogram_impl::NArray<T, NDimensions, Allocator>::add_n(
+  const std::size_t* linear, std::size_t n, const Weight* weights) {
+  T* data = m_data.data();
+  if (weights) {
+    for (std::size_t i = 0; i < n; ++i) {
+      data[linear[i]] += weights[i];
+    }
+  } else {
+    for (std::size_t i = 0; i < n; ++i) {
+      data[linear[i]] += static_cast<Weight>(1);
     }
   }
-  return true;
 }
 
-template<typename T, std::size_t NDimensions>
+template<typename T, std::size_t NDimensions, typename Allocator>
 inline const T&
-histogram_impl::NArray<T, NDimensions>::at(Index idx) const {
-  if (!within_bounds(idx)) {
+histogram_impl::NArray<T, NDimensions, Allocator>::at(Index idx) const {
+  if (!within_bounds(m_size, idx)) {
     throw std::out_of_range("NArray index is out of valid range");
   }
   return m_data[linear(idx)];
 }
 
-template<typename T, std::size_t NDimensions>
+template<typename T, std::size_t NDimensions, typename Allocator>
 inline T&
-histogram_impl::NArray<T, NDimensions>::at(Index idx) {
-  if (!within_bounds(idx)) {
+histogram_impl::NArray<T, NDimensions, Allocator>::at(Index idx) {
+  if (!within_bounds(m_size, idx)) {
     throw std::out_of_range("NArray index is out of valid range");
   }
   return m_data[linear(idx)];
 }
 
+// implementation CounterArray
+
+template<std::size_t NDimensions>
+inline histogram_impl::CounterArray<NDimensions>::CounterArray(Index size)
+  : m_size(size), m_width(1), m_u8(total_size(size), 0u) {}
+
+template<std::size_t NDimensions>
+inline void
+histogram_impl::CounterArray<NDimensions>::clear() {
+  m_width = 1;
+  m_u8.assign(total_size(m_size), 0u);
+  m_u16 = std::vector<std::uint16_t>();
+  m_u32 = std::vector<std::uint32_t>();
+  m_u64 = std::vector<std::uint64_t>();
+}
+
+template<std::size_t NDimensions>
+inline std::uint64_t
+histogram_impl::CounterArray<NDimensions>::at(Index idx) const {
+  if (!within_bounds(m_size, idx)) {
+    throw std::out_of_range("CounterArray index is out of valid range");
+  }
+  return load(linear_index(m_size, idx));
+}
+
+template<std::size_t NDimensions>
+inline histogram_impl::CounterArray<NDimensions>&
+histogram_impl::CounterArray<NDimensions>::operator+=(
+  const CounterArray& other) {
+  if (m_size != other.m_size) {
+    throw std::invalid_argument("CounterArray sizes are not identical");
+  }
+  std::size_t n = total_size(m_size);
+  for (std::size_t i = 0; i < n; ++i) {
+    add_linear(i, other.load(i));
+  }
+  return *this;
+}
+
+template<std::size_t NDimensions>
+inline void
+histogram_impl::CounterArray<NDimensions>::add_n(
+  const std::size_t* linear, std::size_t n, const Weight* weights) {
+  for (std::size_t i = 0; i < n; ++i) {
+    add_linear(linear[i], weights ? weights[i] : 1u);
+  }
+}
+
+template<std::size_t NDimensions>
+template<typename U>
+inline bool
+histogram_impl::CounterArray<NDimensions>::try_add(
+  std::vector<U>& counters, std::size_t i, Weight weight) {
+  constexpr Weight kMax = std::numeric_limits<U>::max();
+  if ((kMax - counters[i]) < weight) {
+    return false;
+  }
+  counters[i] = static_cast<U>(counters[i] + weight);
+  return true;
+}
+
+template<std::size_t NDimensions>
+template<typename U>
+inline std::vector<U>
+histogram_impl::CounterArray<NDimensions>::widened() const {
+  std::size_t n = total_size(m_size);
+  std::vector<U> result(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    result[i] = static_cast<U>(load(i));
+  }
+  return result;
+}
+
+template<std::size_t NDimensions>
+inline std::uint64_t
+histogram_impl::CounterArray<NDimensions>::load(std::size_t i) const {
+  switch (m_width) {
+  case 1:
+    return m_u8[i];
+  case 2:
+    return m_u16[i];
+  case 4:
+    return m_u32[i];
+  default:
+    return m_u64[i];
+  }
+}
+
+template<std::size_t NDimensions>
+inline void
+histogram_impl::CounterArray<NDimensions>::add_linear(
+  std::size_t i, Weight weight) {
+  while (true) {
+    bool is_added = false;
+    switch (m_width) {
+    case 1:
+      is_added = try_add(m_u8, i, weight);
+      break;
+    case 2:
+      is_added = try_add(m_u16, i, weight);
+      break;
+    case 4:
+      is_added = try_add(m_u32, i, weight);
+      break;
+    default:
+      if (not try_add(m_u64, i, weight)) {
+        throw std::overflow_error("Bin counter overflow");
+      }
+      is_added = true;
+    }
+    if (is_added) {
+      return;
+    }
+    promote();
+  }
+}
+
+template<std::size_t NDimensions>
+inline void
+histogram_impl::CounterArray<NDimensions>::promote() {
+  switch (m_width) {
+  case 1:
+    m_u16 = widened<std::uint16_t>();
+    m_u8 = std::vector<std::uint8_t>();
+    m_width = 2;
+    break;
+  case 2:
+    m_u32 = widened<std::uint32_t>();
+    m_u16 = std::vector<std::uint16_t>();
+    m_width = 4;
+    break;
+  default:
+    m_u64 = widened<std::uint64_t>();
+    m_u32 = std::vector<std::uint32_t>();
+    m_width = 8;
+  }
+}
+
+// implementation SparseArray
+
+template<typename T, std::size_t NDimensions>
+inline T
+histogram_impl::SparseArray<T, NDimensions>::at(Index idx) const {
+  if (!within_bounds(m_size, idx)) {
+    throw std::out_of_range("SparseArray index is out of valid range");
+  }
+  auto it = m_elements.find(linear_index(m_size, idx));
+  return (it != m_elements.end()) ? it->second : T();
+}
+
+template<typename T, std::size_t NDimensions>
+inline histogram_impl::SparseArray<T, NDimensions>&
+histogram_impl::SparseArray<T, NDimensions>::operator+=(
+  const SparseArray& other) {
+  if (m_size != other.m_size) {
+    throw std::invalid_argument("SparseArray sizes are not identical");
+  }
+  for (const auto& element : other.m_elements) {
+    m_elements[element.first] += element.second;
+  }
+  return *this;
+}
+
+template<typename T, std::size_t NDimensions>
+inline void
+histogram_impl::SparseArray<T, NDimensions>::add_n(
+  const std::size_t* linear, std::size_t n, const Weight* weights) {
+  for (std::size_t i = 0; i < n; ++i) {
+    m_elements[linear[i]] += weights ? weights[i] : static_cast<Weight>(1);
+  }
+}
+
+// implementation AtomicBin
+
+template<typename T>
+inline AtomicBin<T>&
+AtomicBin<T>::operator+=(T weight) {
+  // std::atomic<T>::fetch_add is only available for integral types
+  T current = m_value.load(std::memory_order_relaxed);
+  while (not m_value.compare_exchange_weak(
+    current, current + weight, std::memory_order_relaxed)) {
+  }
+  return *this;
+}
+
 // implementation UniformAxis
 
 template<typename T>
 inline UniformAxis<T>::UniformAxis(T lower, T upper, std::size_t nbins)
-  : m_nbins(nbins), m_lower(lower), m_upper(upper) {}
+  : m_nbins(nbins)
+  , m_lower(lower)
+  , m_upper(upper)
+  , m_scale(nbins / (upper - lower)) {}
 
 template<typename T>
 inline std::size_t
@@ -254,12 +979,32 @@ UniformAxis<T>::index(T value) const {
   if (value < this->m_lower) {
     throw std::out_of_range("Value is smaller than lower axis limit");
   }
-  if (m_upper <= value) {
+  // also rejects NaN
+  if (not(value < m_upper)) {
     throw std::out_of_range("Value is equal or larger than upper axis limit");
   }
   // cast truncates to integer part; should work since index is always > 0.
-  return static_cast<std::size_t>(
-    m_nbins * (value - m_lower) / (m_upper - m_lower));
+  // rounding might move values just below the upper limit beyond the last bin
+  return std::min(
+    static_cast<std::size_t>(histogram_impl::uniform_position(
+      value, m_lower, m_upper, m_scale, m_nbins)),
+    m_nbins - 1);
+}
+
+template<typename T>
+inline void
+UniformAxis<T>::index_n(
+  const T* values, std::size_t n, std::size_t* indices) const {
+  // validate all values first to keep the computation loop branch-free
+  bool is_valid = true;
+  for (std::size_t i = 0; i < n; ++i) {
+    is_valid &= (m_lower <= values[i]) & (values[i] < m_upper);
+  }
+  if (not is_valid) {
+    throw std::out_of_range("Value is outside the axis limits");
+  }
+  histogram_impl::uniform_index_n(
+    values, n, indices, m_lower, m_upper, m_scale, m_nbins, 0);
 }
 
 // implementation OverflowAxis
@@ -267,7 +1012,10 @@ UniformAxis<T>::index(T value) const {
 template<typename T>
 inline OverflowAxis<T>::OverflowAxis(
   Value lower, Value upper, std::size_t nbins)
-  : m_ndatabins(nbins), m_lower(lower), m_upper(upper) {}
+  : m_ndatabins(nbins)
+  , m_lower(lower)
+  , m_upper(upper)
+  , m_scale(nbins / (upper - lower)) {}
 
 template<typename T>
 constexpr std::size_t
@@ -275,13 +1023,26 @@ OverflowAxis<T>::index(T value) const {
   if (value < m_lower) {
     return 0;
   }
-  if (m_upper <= value) {
+  // NaN ends up in the overflow bin
+  if (not(value < m_upper)) {
     return m_ndatabins + 1;
   }
   // cast truncates to integer part; should work since index is always > 0.
+  // rounding might move values just below the upper limit beyond the last bin
   return 1
-         + static_cast<std::size_t>(
-           m_ndatabins * (value - m_lower) / (m_upper - m_lower));
+         + std::min(
+           static_cast<std::size_t>(histogram_impl::uniform_position(
+             value, m_lower, m_upper, m_scale, m_ndatabins)),
+           m_ndatabins - 1);
+}
+
+template<typename T>
+inline void
+OverflowAxis<T>::index_n(
+  const T* values, std::size_t n, std::size_t* indices) const {
+  // bin positions are shifted by one due to the underflow bin
+  histogram_impl::uniform_index_n(
+    values, n, indices, m_lower, m_upper, m_scale, m_ndatabins, 1);
 }
 
 // implementation VariableAxis
@@ -297,24 +1058,114 @@ inline VariableAxis<T>::VariableAxis(std::vector<Value>&& edges)
         m_edges.begin(), m_edges.end(), std::less_equal<Value>())) {
     throw std::invalid_argument("Bin edges are not sorted or have duplicates");
   }
+  build_cells();
 }
 
 template<typename T>
 inline VariableAxis<T>::VariableAxis(std::initializer_list<Value> edges)
   : VariableAxis(std::vector<Value>(edges)) {}
 
+template<typename T>
+inline void
+VariableAxis<T>::build_cells() {
+  const std::size_t nbins = m_edges.size() - 1;
+  m_lower = static_cast<double>(m_edges.front());
+  double range = static_cast<double>(m_edges.back()) - m_lower;
+  double min_width = range;
+  for (std::size_t i = 0; i < nbins; ++i) {
+    min_width = std::min(
+      min_width,
+      static_cast<double>(m_edges[i + 1]) - static_cast<double>(m_edges[i]));
+  }
+  // one cell per smallest bin but limit the memory for very uneven binning
+  const std::size_t max_cells = 4 * nbins + 16;
+  double ratio = std::ceil(range / min_width);
+  std::size_t ncells = (ratio < static_cast<double>(max_cells))
+                         ? static_cast<std::size_t>(ratio)
+                         : max_cells;
+  m_scale = static_cast<double>(ncells) / range;
+  // find the bin that contains the lower boundary of each cell
+  m_cells.resize(ncells + 1);
+  std::size_t bin = 0;
+  for (std::size_t c = 0; c <= ncells; ++c) {
+    double boundary = m_lower + static_cast<double>(c) / m_scale;
+    while (((bin + 1) < nbins)
+           and (static_cast<double>(m_edges[bin + 1]) <= boundary)) {
+      ++bin;
+    }
+    m_cells[c] = bin;
+  }
+}
+
 template<typename T>
 inline std::size_t
 VariableAxis<T>::index(T value) const {
-  // find upper edge of the corresponding bin
-  auto it = std::upper_bound(m_edges.begin(), m_edges.end(), value);
-  if (it == m_edges.begin()) {
+  if (value < m_edges.front()) {
     throw std::out_of_range("Value is smaller than lower axis limit");
   }
-  if (it == m_edges.end()) {
+  // also rejects NaN
+  if (not(value < m_edges.back())) {
     throw std::out_of_range("Value is equal or larger than upper axis limit");
   }
-  return std::distance(m_edges.begin(), it) - 1;
+  // restrict the search to the candidate bins of the grid cell
+  auto cell = static_cast<std::size_t>(
+    (static_cast<double>(value) - m_lower) * m_scale);
+  cell = std::min(cell, m_cells.size() - 2);
+  auto begin = m_edges.begin();
+  auto it = std::upper_bound(
+    begin + m_cells[cell] + 1, begin + m_cells[cell + 1] + 1, value);
+  auto bin = static_cast<std::size_t>(std::distance(begin, it) - 1);
+  // rounding in the cell computation could select a neighboring cell
+  if ((value < m_edges[bin]) or (m_edges[bin + 1] <= value)) {
+    it = std::upper_bound(begin, m_edges.end(), value);
+    bin = static_cast<std::size_t>(std::distance(begin, it) - 1);
+  }
+  return bin;
+}
+
+// implementation LogAxis
+
+template<typename T>
+inline LogAxis<T>::LogAxis(T lower, T upper, std::size_t nbins)
+  : m_edges(nbins + 1)
+  , m_log_lower(std::log(lower))
+  , m_scale(nbins / (std::log(upper) - std::log(lower))) {
+  if (not(0 < lower) or not(lower < upper)) {
+    throw std::invalid_argument("Invalid logarithmic axis limits");
+  }
+  if (nbins == 0) {
+    throw std::invalid_argument("Logarithmic axis without bins");
+  }
+  m_edges.front() = lower;
+  for (std::size_t i = 1; i < nbins; ++i) {
+    m_edges[i] = std::exp(m_log_lower + i / m_scale);
+  }
+  m_edges.back() = upper;
+  if (!std::is_sorted(m_edges.begin(), m_edges.end(), std::less_equal<T>())) {
+    throw std::invalid_argument("Logarithmic axis range is too small");
+  }
+}
+
+template<typename T>
+inline std::size_t
+LogAxis<T>::index(T value) const {
+  if (value < m_edges.front()) {
+    throw std::out_of_range("Value is smaller than lower axis limit");
+  }
+  // also rejects NaN
+  if (not(value < m_edges.back())) {
+    throw std::out_of_range("Value is equal or larger than upper axis limit");
+  }
+  T x = (std::log(value) - m_log_lower) * m_scale;
+  auto bin = std::min(
+    static_cast<std::size_t>((x < 0) ? 0 : x), m_edges.size() - 2);
+  // rounding in the logarithm could select a neighboring bin
+  if (value < m_edges[bin]) {
+    bin -= 1;
+  } else if (m_edges[bin + 1] <= value) {
+    bin += 1;
+  }
+  return bin;
 }
 
 // implementation Histogram
@@ -322,7 +1173,97 @@ VariableAxis<T>::index(T value) const {
 template<typename T, typename... Axes>
 inline Histogram<T, Axes...>::Histogram(Axes&&... axes)
   // access nbins *before* moving the axes, otherwise the axes are invalid.
-  : m_data(Index{axes.nbins()...}, static_cast<T>(0))
+  : m_data(Index{axes.nbins()...})
   , m_axes(std::move(axes)...) {}
 
+template<typename T, typename... Axes>
+template<typename Allocator>
+inline Histogram<T, Axes...>::Histogram(
+  std::allocator_arg_t, const Allocator& alloc, Axes&&... axes)
+  // access nbins *before* moving the axes, otherwise the axes are invalid.
+  : m_data(Index{axes.nbins()...}, alloc)
+  , m_axes(std::move(axes)...) {}
+
+template<typename T, typename... Axes>
+constexpr std::size_t Histogram<T, Axes...>::kBlockSize;
+
+template<typename T, typename... Axes>
+template<std::size_t... Is>
+inline void
+Histogram<T, Axes...>::fill_n_impl(
+  std::index_sequence<Is...>, std::size_t n, const Weight* weights,
+  const typename Axes::Value*... values) {
+  auto strides = m_data.strides();
+  std::size_t indices[kBlockSize];
+  std::size_t linear[kBlockSize];
+
+  for (std::size_t begin = 0; begin < n; begin += kBlockSize) {
+    std::size_t size = ((n - begin) < kBlockSize) ? (n - begin) : kBlockSize;
+    // compute all storage indices before modifying any bins
+    std::fill(linear, linear + size, 0u);
+    // see namedtuple_impl::print_tuple for explanation
+    using Vacuum = int[];
+    (void)Vacuum{
+      (histogram_impl::accumulate_linear(
+         std::get<Is>(m_axes), values + begin, size, strides[Is], indices,
+         linear),
+       0)...};
+    // scatter increments
+    m_data.add_n(linear, size, weights ? (weights + begin) : nullptr);
+  }
+}
+
+template<typename T, typename... Axes>
+inline Histogram<T, Axes...>&
+Histogram<T, Axes...>::operator+=(const Histogram& other) {
+  if (not has_equal_axes(other, std::index_sequence_for<Axes...>())) {
+    throw std::invalid_argument("Histogram axes are not identical");
+  }
+  m_data += other.m_data;
+  return *this;
+}
+
+template<typename T, typename... Axes>
+template<std::size_t... Is>
+inline bool
+Histogram<T, Axes...>::has_equal_axes(
+  const Histogram& other, std::index_sequence<Is...>) const {
+  bool is_equal = true;
+  // see namedtuple_impl::print_tuple for explanation
+  using Vacuum = int[];
+  (void)Vacuum{
+    (is_equal &= (std::get<Is>(m_axes) == std::get<Is>(other.m_axes)), 0)...};
+  return is_equal;
+}
+
+// implementation ShardedHistogram
+
+template<typename H>
+inline H&
+ShardedHistogram<H>::local() {
+  auto id = std::this_thread::get_id();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto& shard : m_shards) {
+    if (shard.first == id) {
+      return *shard.second;
+    }
+  }
+  // shards only share the axes; the prototype content is added on merge
+  std::unique_ptr<H> shard(new H(m_prototype));
+  shard->reset();
+  m_shards.emplace_back(id, std::move(shard));
+  return *m_shards.back().second;
+}
+
+template<typename H>
+inline H
+ShardedHistogram<H>::merge() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  H result = m_prototype;
+  for (const auto& shard : m_shards) {
+    result += *shard.second;
+  }
+  return result;
+}
+
 } // namespace dfe
@@ -0,0 +1,336 @@
+// SPDX-License-Identifier: MIT
+// Copyright 2020 Moritz Kiehn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/// \file
+/// \brief   Write records asynchronously on a dedicated background thread
+/// \author  Moritz Kiehn <msmk@cern.ch>
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dfe {
+namespace io_async_impl {
+
+// Record type of a writer class template w/ the record as last parameter.
+//
+// Specialize for writers that do not follow this convention.
+template<typename Writer>
+struct RecordType;
+template<template<typename> class Writer, typename NamedTuple>
+struct RecordType<Writer<NamedTuple>> {
+  using type = NamedTuple;
+};
+template<
+  template<char, typename> class Writer, char Delimiter, typename NamedTuple>
+struct RecordType<Writer<Delimiter, NamedTuple>> {
+  using type = NamedTuple;
+};
+
+// Bounded, lock-free queue for a single producer and a single consumer.
+template<typename T>
+class SpscQueue {
+public:
+  // capacity is rounded up to the next power of two
+  explicit SpscQueue(std::size_t capacity);
+
+  // only called by the producer
+  bool try_push(const T& value);
+  // only called by the consumer
+  bool try_pop(T& value);
+
+private:
+  // padding avoids false sharing of the consumer and producer members.
+  // alignas would be cleaner, but over-aligned allocations require C++17.
+  static constexpr std::size_t kCacheLine = 64;
+
+  std::vector<T> m_slots;
+  std::size_t m_mask;
+  char m_pad0[kCacheLine];
+  std::atomic<std::size_t> m_head{0};
+  // consumer-local copy of the tail to reduce cross-thread loads
+  std::size_t m_tail_cache = 0;
+  char m_pad1[kCacheLine];
+  std::atomic<std::size_t> m_tail{0};
+  // producer-local copy of the head to reduce cross-thread loads
+  std::size_t m_head_cache = 0;
+  char m_pad2[kCacheLine];
+};
+
+// Call `flush()` on the writer if it is available.
+template<typename Writer>
+inline auto
+flush(Writer& writer, int) -> decltype(writer.flush(), void()) {
+  writer.flush();
+}
+template<typename Writer>
+inline void
+flush(Writer&, long) {}
+
+} // namespace io_async_impl
+
+/// Behaviour when records are appended faster than they can be written.
+enum class AsyncPolicy {
+  /// Wait until the writer thread has made space in the queue.
+  Block,
+  /// Discard the record and count it as dropped.
+  Drop,
+};
+
+/// Write records asynchronously through any record writer.
+///
+/// \tparam Writer Writer type w/ an `append(const Record&)` method
+/// \tparam Record Record type; deduced for the namedtuple writers
+///
+/// Records are copied into a bounded, lock-free queue and written by a
+/// dedicated thread that exclusively owns the wrapped writer. Formatting,
+/// compression, and i/o thus happen in the background. Records must be
+/// appended from a single thread. On destruction all queued records are
+/// written before the wrapped writer is closed.
+///
+/// Errors on the writer thread stop all further writing and are rethrown by
+/// the next call to `append(...)` or `flush()`.
+template<
+  typename Writer,
+  typename Record = typename io_async_impl::RecordType<Writer>::type>
+class AsyncWriter {
+public:
+  AsyncWriter() = delete;
+  AsyncWriter(const AsyncWriter&) = delete;
+  AsyncWriter(AsyncWriter&&) = delete;
+  AsyncWriter& operator=(const AsyncWriter&) = delete;
+  AsyncWriter& operator=(AsyncWriter&&) = delete;
+
+  /// \param writer    Wrapped writer; ownership is transferred
+  /// \param capacity  Maximum number of queued records
+  /// \param policy    Behaviour when the queue is full
+  explicit AsyncWriter(
+    std::unique_ptr<Writer> writer, std::size_t capacity = 4096,
+    AsyncPolicy policy = AsyncPolicy::Block);
+  /// Write all queued records and close the wrapped writer.
+  ~AsyncWriter();
+
+  /// Queue a record for writing.
+  void append(const Record& record);
+  /// Block until all previously queued records are written.
+  ///
+  /// Also flushes the wrapped writer if it provides `flush()`.
+  void flush();
+  /// Number of records that were dropped due to a full queue.
+  std::size_t num_dropped() const { return m_num_dropped; }
+
+private:
+  io_async_impl::SpscQueue<Record> m_queue;
+  AsyncPolicy m_policy;
+  std::size_t m_num_dropped = 0;
+  std::unique_ptr<Writer> m_writer;
+  // flush requests are serviced in order by the writer thread
+  std::atomic<std::uint64_t> m_flush_requested{0};
+  std::uint64_t m_flush_done = 0;
+  std::atomic<bool> m_stop{false};
+  std::atomic<bool> m_failed{false};
+  std::exception_ptr m_error;
+  std::mutex m_mutex;
+  std::condition_variable m_flushed;
+  std::thread m_thread;
+
+  void work();
+  bool drain();
+  void rethrow_error();
+};
+
+// implementation queue
+
+template<typename T>
+inline io_async_impl::SpscQueue<T>::SpscQueue(std::size_t capacity) {
+  std::size_t size = 1;
+  while (size < capacity) {
+    size *= 2;
+  }
+  m_slots.resize(size);
+  m_mask = size - 1;
+}
+
+template<typename T>
+inline bool
+io_async_impl::SpscQueue<T>::try_push(const T& value) {
+  auto tail = m_tail.load(std::memory_order_relaxed);
+  if ((tail - m_head_cache) == m_slots.size()) {
+    m_head_cache = m_head.load(std::memory_order_acquire);
+    if ((tail - m_head_cache) == m_slots.size()) {
+      return false;
+    }
+  }
+  m_slots[tail & m_mask] = value;
+  m_tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+template<typename T>
+inline bool
+io_async_impl::SpscQueue<T>::try_pop(T& value) {
+  auto head = m_head.load(std::memory_order_relaxed);
+  if (head == m_tail_cache) {
+    m_tail_cache = m_tail.load(std::memory_order_acquire);
+    if (head == m_tail_cache) {
+      return false;
+    }
+  }
+  value = m_slots[head & m_mask];
+  m_head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+// implementation writer
+
+template<typename Writer, typename Record>
+inline AsyncWriter<Writer, Record>::AsyncWriter(
+  std::unique_ptr<Writer> writer, std::size_t capacity, AsyncPolicy policy)
+  : m_queue(capacity), m_policy(policy), m_writer(std::move(writer)) {
+  if (not m_writer) {
+    throw std::invalid_argument("Invalid writer given");
+  }
+  m_thread = std::thread([this]() { work(); });
+}
+
+template<typename Writer, typename Record>
+inline AsyncWriter<Writer, Record>::~AsyncWriter() {
+  m_stop.store(true, std::memory_order_release);
+  m_thread.join();
+  // the wrapped writer is closed here on the owning thread
+}
+
+template<typename Writer, typename Record>
+inline void
+AsyncWriter<Writer, Record>::append(const Record& record) {
+  rethrow_error();
+  if (m_queue.try_push(record)) {
+    return;
+  }
+  if (m_policy == AsyncPolicy::Drop) {
+    m_num_dropped += 1;
+    return;
+  }
+  while (not m_queue.try_push(record)) {
+    rethrow_error();
+    std::this_thread::yield();
+  }
+}
+
+template<typename Writer, typename Record>
+inline void
+AsyncWriter<Writer, Record>::flush() {
+  rethrow_error();
+  auto request = m_flush_requested.fetch_add(1, std::memory_order_acq_rel) + 1;
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_flushed.wait(lock, [&]() {
+    return (request <= m_flush_done) or m_failed.load();
+  });
+  lock.unlock();
+  rethrow_error();
+}
+
+template<typename Writer, typename Record>
+inline void
+AsyncWriter<Writer, Record>::work() {
+  using Clock = std::chrono::steady_clock;
+  // back off exponentially while idle to avoid hogging a core
+  constexpr auto kMinIdle = std::chrono::microseconds(1);
+  constexpr auto kMaxIdle = std::chrono::microseconds(1000);
+
+  auto idle = kMinIdle;
+  while (true) {
+    // records queued before a flush request must be visible after reading it
+    auto stop = m_stop.load(std::memory_order_acquire);
+    auto requested = m_flush_requested.load(std::memory_order_acquire);
+    auto has_written = drain();
+    if (m_flush_done < requested) {
+      if (not m_failed.load()) {
+        try {
+          io_async_impl::flush(*m_writer, 0);
+        } catch (...) {
+          m_error = std::current_exception();
+          m_failed.store(true);
+        }
+      }
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_flush_done = requested;
+      }
+      m_flushed.notify_all();
+    }
+    if (stop) {
+      break;
+    }
+    if (has_written) {
+      idle = kMinIdle;
+    } else {
+      auto until = Clock::now() + idle;
+      std::this_thread::sleep_until(until);
+      idle = std::min(2 * idle, kMaxIdle);
+    }
+  }
+}
+
+// write all queued records; returns true if any record was available
+template<typename Writer, typename Record>
+inline bool
+AsyncWriter<Writer, Record>::drain() {
+  bool has_records = false;
+  Record record;
+  while (m_queue.try_pop(record)) {
+    has_records = true;
+    // keep draining after an error so the producer never blocks forever
+    if (m_failed.load(std::memory_order_relaxed)) {
+      continue;
+    }
+    try {
+      m_writer->append(record);
+    } catch (...) {
+      m_error = std::current_exception();
+      m_failed.store(true);
+    }
+  }
+  return has_records;
+}
+
+template<typename Writer, typename Record>
+inline void
+AsyncWriter<Writer, Record>::rethrow_error() {
+  // the error is only set once and never modified afterwards
+  if (m_failed.load()) {
+    std::rethrow_exception(m_error);
+  }
+}
+
+} // namespace dfe
@@ -0,0 +1,732 @@
+// SPDX-License-Identifier: MIT
+// Copyright 2020 Moritz Kiehn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/// \file
+/// \brief   Read/write chunked, column-oriented binary files
+/// \author  Moritz Kiehn <msmk@cern.ch>
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "dfe_io_mmap.hpp"
+#include "dfe_io_numpy.hpp"
+#include "dfe_namedtuple.hpp"
+
+namespace dfe {
+namespace io_columnar_impl {
+
+// Identifies the file format and version at the begin and end of a file.
+constexpr char kMagic[8] = {'D', 'F', 'E', 'C', 'O', 'L', '0', '1'};
+// Column data is aligned to allow direct access to the mapped memory.
+constexpr std::size_t kAlignment = 8;
+
+// Location and statistics of one column within one chunk.
+//
+// Minimum and maximum are stored as raw bytes of the stored value type; all
+// supported types fit into eight bytes.
+struct ChunkColumn {
+  uint64_t offset = 0;
+  char min[8] = {};
+  char max[8] = {};
+};
+
+// Serialize the file footer.
+class Encoder {
+public:
+  void u64(uint64_t value) { bytes(&value, sizeof(value)); }
+  void bytes(const void* data, std::size_t size) {
+    m_buffer.append(static_cast<const char*>(data), size);
+  }
+  void string(const std::string& str) {
+    u64(str.size());
+    bytes(str.data(), str.size());
+  }
+  const std::string& buffer() const { return m_buffer; }
+
+private:
+  std::string m_buffer;
+};
+
+// Deserialize the file footer with bounds checks.
+class Decoder {
+public:
+  Decoder(const char* data, std::size_t size)
+    : m_pos(data), m_end(data + size) {}
+
+  uint64_t u64() {
+    uint64_t value;
+    bytes(&value, sizeof(value));
+    return value;
+  }
+  void bytes(void* data, std::size_t size);
+  std::string string();
+  // Number of following entries that each need at least the given size.
+  std::size_t count(std::size_t entry_size);
+
+private:
+  const char* m_pos;
+  const char* m_end;
+};
+
+// Numpy-equivalent type code including byte order, e.g. `<f8`.
+template<typename T>
+inline std::string
+dtype() {
+  std::string code(1, io_npy_impl::dtype_endianness_modifier());
+  code += io_npy_impl::kNumpyDtypeCode<T>;
+  return code;
+}
+
+} // namespace io_columnar_impl
+
+/// Write records into a chunked, column-oriented binary file.
+///
+/// Records are buffered and written as chunks with a fixed number of rows.
+/// Within each chunk, all values of a member are stored contiguously. The
+/// file ends with a footer that describes the columns and contains an index
+/// of all chunks with the position, minimum, and maximum of each column. It
+/// is written when the writer is destroyed.
+///
+/// Values are stored in the native byte order. Column types use the same
+/// type codes as the numpy i/o.
+template<typename NamedTuple>
+class NamedTupleColumnarWriter {
+public:
+  NamedTupleColumnarWriter() = delete;
+  NamedTupleColumnarWriter(const NamedTupleColumnarWriter&) = delete;
+  NamedTupleColumnarWriter(NamedTupleColumnarWriter&&) = default;
+  ~NamedTupleColumnarWriter();
+  NamedTupleColumnarWriter& operator=(const NamedTupleColumnarWriter&) = delete;
+  /// Write the remaining records and the footer before taking over.
+  NamedTupleColumnarWriter& operator=(NamedTupleColumnarWriter&& other);
+
+  /// Create a file at the given path. Overwrites existing data.
+  ///
+  /// \param path        Path to the output file
+  /// \param chunk_size  Number of records per chunk
+  NamedTupleColumnarWriter(
+    const std::string& path, std::size_t chunk_size = 1 << 16);
+
+  /// Append a record to the end of the file.
+  void append(const NamedTuple& record);
+  /// Append all records in the range to the end of the file.
+  template<typename InputIt>
+  void append(InputIt first, InputIt last);
+
+private:
+  using Tuple = typename NamedTuple::Tuple;
+  static constexpr std::size_t kNumFields = std::tuple_size<Tuple>::value;
+
+  std::ofstream m_file;
+  uint64_t m_offset;
+  std::size_t m_chunk_size;
+  NamedTupleColumns<NamedTuple> m_chunk;
+  std::vector<uint64_t> m_chunk_rows;
+  // one entry per column for each chunk
+  std::vector<io_columnar_impl::ChunkColumn> m_index;
+
+  void write_chunk();
+  template<std::size_t... I>
+  void write_columns(std::index_sequence<I...>);
+  template<std::size_t I>
+  void write_column();
+  void write_footer();
+  void close();
+};
+
+/// Read records from a chunked, column-oriented binary file.
+///
+/// The file is memory-mapped and only the requested columns of the requested
+/// chunks are accessed. The per-chunk statistics allow skipping chunks that
+/// can not contain interesting values without reading them, e.g.
+///
+///     for (std::size_t c = 0; c < reader.num_chunks(); ++c) {
+///       if (reader.may_contain<2>(c, 10.0, 20.0)) {
+///         reader.read_column<2>(c, values);
+///         ...
+///       }
+///     }
+///
+/// Members are matched to the file columns by name. The file may contain
+/// additional columns in any order; missing columns or columns with a
+/// different type are an error.
+template<typename NamedTuple>
+class NamedTupleColumnarReader {
+private:
+  using Tuple = typename NamedTuple::Tuple;
+  static constexpr std::size_t kNumFields = std::tuple_size<Tuple>::value;
+
+public:
+  using Columns = NamedTupleColumns<NamedTuple>;
+  /// The value type of the I-th member.
+  template<std::size_t I>
+  using Value = std::tuple_element_t<I, Tuple>;
+  /// The column type for the I-th member.
+  template<std::size_t I>
+  using Column = typename Columns::template Column<I>;
+
+  NamedTupleColumnarReader() = delete;
+  NamedTupleColumnarReader(const NamedTupleColumnarReader&) = delete;
+  NamedTupleColumnarReader(NamedTupleColumnarReader&&) = default;
+  ~NamedTupleColumnarReader() = default;
+  NamedTupleColumnarReader& operator=(const NamedTupleColumnarReader&) = delete;
+  NamedTupleColumnarReader& operator=(NamedTupleColumnarReader&&) = default;
+
+  /// Open a file for reading.
+  ///
+  /// Throws if the file can not be read or if the stored columns are not
+  /// compatible with the named tuple.
+  NamedTupleColumnarReader(const std::string& path);
+
+  /// Return the total number of records in the file.
+  std::size_t size() const { return m_size; }
+  /// Return the number of chunks in the file.
+  std::size_t num_chunks() const { return m_chunk_rows.size(); }
+  /// Return the number of records in the given chunk.
+  std::size_t chunk_size(std::size_t chunk) const;
+  /// Return the number of records read sequentially so far.
+  std::size_t num_records() const { return m_next; }
+
+  /// Return the minimum value of the I-th member in the given chunk.
+  template<std::size_t I>
+  Value<I> min(std::size_t chunk) const;
+  /// Return the maximum value of the I-th member in the given chunk.
+  template<std::size_t I>
+  Value<I> max(std::size_t chunk) const;
+  /// Check if the chunk might contain I-th member values in [lower, upper].
+  ///
+  /// Uses only the chunk statistics. Returns false only if the chunk can
+  /// definitely be skipped.
+  template<std::size_t I>
+  bool may_contain(
+    std::size_t chunk, const Value<I>& lower, const Value<I>& upper) const;
+
+  /// Read only the I-th member of all records in the given chunk.
+  ///
+  /// \param chunk   Chunk index
+  /// \param column  Output column; existing content is replaced
+  template<std::size_t I>
+  void read_column(std::size_t chunk, Column<I>& column) const;
+  /// Read only the selected members of all records in the given chunk.
+  ///
+  /// All other columns are left empty, e.g. `read_columns<0, 2>(c, columns)`
+  /// reads only the first and the third member.
+  template<std::size_t... I>
+  void read_columns(std::size_t chunk, Columns& columns) const;
+  /// Read all members of all records in the given chunk.
+  void read_chunk(std::size_t chunk, Columns& columns) const;
+
+  /// Read the next record from the file.
+  ///
+  /// \returns true   if a record was successfully read
+  /// \returns false  if no more records are available
+  bool read(NamedTuple& record);
+
+private:
+  // stored value type, i.e. booleans are stored as bytes
+  template<std::size_t I>
+  using Stored = typename Column<I>::value_type;
+
+  MappedFile m_mapped;
+  // file content for platforms w/o memory-mapping
+  std::vector<char> m_contents;
+  const char* m_data = nullptr;
+  std::size_t m_size = 0;
+  std::size_t m_num_file_columns = 0;
+  // file column index for each member
+  std::array<std::size_t, kNumFields> m_columns;
+  std::vector<uint64_t> m_chunk_rows;
+  // one entry per file column for each chunk
+  std::vector<io_columnar_impl::ChunkColumn> m_index;
+  // sequential reading position
+  std::size_t m_next = 0;
+  std::size_t m_next_chunk = 0;
+  std::size_t m_next_row = 0;
+
+  void check_chunk(std::size_t chunk) const;
+  const io_columnar_impl::ChunkColumn&
+  entry(std::size_t chunk, std::size_t member) const {
+    return m_index[chunk * m_num_file_columns + m_columns[member]];
+  }
+  template<std::size_t I>
+  const Stored<I>* column_data(std::size_t chunk) const {
+    return reinterpret_cast<const Stored<I>*>(
+      m_data + entry(chunk, I).offset);
+  }
+  template<std::size_t... I>
+  void setup_columns(
+    const std::vector<std::pair<std::string, std::string>>& columns,
+    std::index_sequence<I...>);
+  template<std::size_t I>
+  void setup_column(
+    const std::vector<std::pair<std::string, std::string>>& columns);
+  template<std::size_t... I>
+  void check_columns(uint64_t end, std::index_sequence<I...>) const;
+  template<std::size_t I>
+  void check_column(uint64_t end) const;
+  template<std::size_t... I>
+  void read_chunk_impl(
+    std::size_t chunk, Columns& columns, std::index_sequence<I...>) const {
+    read_columns<I...>(chunk, columns);
+  }
+  template<std::size_t... I>
+  void load_record(
+    std::size_t chunk, std::size_t row, NamedTuple& record,
+    std::index_sequence<I...>) const {
+    record = Tuple(static_cast<Value<I>>(column_data<I>(chunk)[row])...);
+  }
+};
+
+// implementation helpers
+
+inline void
+io_columnar_impl::Decoder::bytes(void* data, std::size_t size) {
+  if (static_cast<std::size_t>(m_end - m_pos) < size) {
+    throw std::runtime_error("Truncated columnar file footer");
+  }
+  std::memcpy(data, m_pos, size);
+  m_pos += size;
+}
+
+inline std::size_t
+io_columnar_impl::Decoder::count(std::size_t entry_size) {
+  uint64_t n = u64();
+  if ((static_cast<uint64_t>(m_end - m_pos) / entry_size) < n) {
+    throw std::runtime_error("Truncated columnar file footer");
+  }
+  return n;
+}
+
+inline std::string
+io_columnar_impl::Decoder::string() {
+  uint64_t size = u64();
+  if (static_cast<uint64_t>(m_end - m_pos) < size) {
+    throw std::runtime_error("Truncated columnar file footer");
+  }
+  std::string str(m_pos, size);
+  m_pos += size;
+  return str;
+}
+
+namespace io_columnar_impl {
+
+// Minimum and maximum w/o NaN values unless all values are NaN.
+template<typename T>
+inline void
+minmax(const T* values, std::size_t n, T& lo, T& hi) {
+  lo = values[0];
+  hi = values[0];
+  for (std::size_t i = 1; i < n; ++i) {
+    const T v = values[i];
+    // the self-comparisons are only relevant for floating point NaN
+    lo = ((v < lo) or (lo != lo)) ? v : lo;
+    hi = ((hi < v) or (hi != hi)) ? v : hi;
+  }
+}
+
+} // namespace io_columnar_impl
+
+// implementation writer
+
+template<typename NamedTuple>
+inline NamedTupleColumnarWriter<NamedTuple>::NamedTupleColumnarWriter(
+  const std::string& path, std::size_t chunk_size)
+  : m_offset(0), m_chunk_size(chunk_size) {
+  if (chunk_size == 0) {
+    throw std::invalid_argument("Chunk size must be positive");
+  }
+  // make our life easier. always throw on error
+  m_file.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+  m_file.open(
+    path, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+  m_file.write(io_columnar_impl::kMagic, sizeof(io_columnar_impl::kMagic));
+  m_offset += sizeof(io_columnar_impl::kMagic);
+  m_chunk.reserve(chunk_size);
+}
+
+template<typename NamedTuple>
+inline NamedTupleColumnarWriter<NamedTuple>::~NamedTupleColumnarWriter() {
+  close();
+}
+
+template<typename NamedTuple>
+inline NamedTupleColumnarWriter<NamedTuple>&
+NamedTupleColumnarWriter<NamedTuple>::operator=(
+  NamedTupleColumnarWriter&& other) {
+  if (this != &other) {
+    // the current file would be unreadable w/o its last chunk and the footer
+    close();
+    m_file = std::move(other.m_file);
+    m_offset = other.m_offset;
+    m_chunk_size = other.m_chunk_size;
+    m_chunk = std::move(other.m_chunk);
+    m_chunk_rows = std::move(other.m_chunk_rows);
+    m_index = std::move(other.m_index);
+  }
+  return *this;
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleColumnarWriter<NamedTuple>::close() {
+  // the writer might have been moved from
+  if (!m_file.is_open()) {
+    return;
+  }
+  write_chunk();
+  write_footer();
+  m_file.close();
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleColumnarWriter<NamedTuple>::append(const NamedTuple& record) {
+  m_chunk.push_back(record);
+  if (m_chunk_size <= m_chunk.size()) {
+    write_chunk();
+  }
+}
+
+template<typename NamedTuple>
+template<typename InputIt>
+inline void
+NamedTupleColumnarWriter<NamedTuple>::append(InputIt first, InputIt last) {
+  for (; first != last; ++first) {
+    append(*first);
+  }
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleColumnarWriter<NamedTuple>::write_chunk() {
+  if (m_chunk.empty()) {
+    return;
+  }
+  m_chunk_rows.push_back(m_chunk.size());
+  write_columns(std::make_index_sequence<kNumFields>{});
+  m_chunk.clear();
+}
+
+template<typename NamedTuple>
+template<std::size_t... I>
+inline void
+NamedTupleColumnarWriter<NamedTuple>::write_columns(
+  std::index_sequence<I...>) {
+  // see namedtuple_impl::print_tuple for explanation
+  using Vacuum = int[];
+  (void)Vacuum{(write_column<I>(), 0)...};
+}
+
+template<typename NamedTuple>
+template<std::size_t I>
+inline void
+NamedTupleColumnarWriter<NamedTuple>::write_column() {
+  const auto& column = m_chunk.template column<I>();
+  using Stored = typename std::decay_t<decltype(column)>::value_type;
+
+  // pad to the required alignment
+  const char padding[io_columnar_impl::kAlignment] = {};
+  std::size_t npad = (io_columnar_impl::kAlignment -
+                      (m_offset % io_columnar_impl::kAlignment)) %
+                     io_columnar_impl::kAlignment;
+  m_file.write(padding, npad);
+  m_offset += npad;
+
+  io_columnar_impl::ChunkColumn entry;
+  Stored lo, hi;
+  io_columnar_impl::minmax(column.data(), column.size(), lo, hi);
+  std::memcpy(entry.min, &lo, sizeof(Stored));
+  std::memcpy(entry.max, &hi, sizeof(Stored));
+  entry.offset = m_offset;
+  m_index.push_back(entry);
+
+  std::size_t nbytes = column.size() * sizeof(Stored);
+  m_file.write(reinterpret_cast<const char*>(column.data()), nbytes);
+  m_offset += nbytes;
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleColumnarWriter<NamedTuple>::write_footer() {
+  io_columnar_impl::Encoder footer;
+  const auto names = NamedTuple::names();
+  const auto codes = io_npy_impl::dtypes_codes(Tuple());
+  footer.u64(kNumFields);
+  for (std::size_t i = 0; i < kNumFields; ++i) {
+    std::string dtype(1, io_npy_impl::dtype_endianness_modifier());
+    dtype += codes[i];
+    footer.string(names[i]);
+    footer.string(dtype);
+  }
+  footer.u64(m_chunk_size);
+  footer.u64(m_chunk_rows.size());
+  for (std::size_t c = 0; c < m_chunk_rows.size(); ++c) {
+    footer.u64(m_chunk_rows[c]);
+    for (std::size_t i = 0; i < kNumFields; ++i) {
+      const auto& entry = m_index[c * kNumFields + i];
+      footer.u64(entry.offset);
+      footer.bytes(entry.min, sizeof(entry.min));
+      footer.bytes(entry.max, sizeof(entry.max));
+    }
+  }
+  // the footer position and the magic are at a fixed position from the end
+  footer.u64(m_offset);
+  footer.bytes(io_columnar_impl::kMagic, sizeof(io_columnar_impl::kMagic));
+  m_file.write(footer.buffer().data(), footer.buffer().size());
+}
+
+// implementation reader
+
+template<typename NamedTuple>
+inline NamedTupleColumnarReader<NamedTuple>::NamedTupleColumnarReader(
+  const std::string& path) {
+  using io_columnar_impl::ChunkColumn;
+  using io_columnar_impl::kMagic;
+
+  std::size_t size = 0;
+  if (m_mapped.map(path, MappedFile::Access::Random)) {
+    m_data = m_mapped.data();
+    size = m_mapped.size();
+  } else {
+    // fall back to reading the whole file into memory
+    std::ifstream file(path, std::ios_base::binary | std::ios_base::in);
+    if (not file.is_open() or file.fail()) {
+      throw std::runtime_error("Could not open file '" + path + "'");
+    }
+    m_contents.assign(
+      std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    m_data = m_contents.data();
+    size = m_contents.size();
+  }
+
+  // magic at the begin, footer position and magic at the end
+  const std::size_t kTrailerSize = sizeof(uint64_t) + sizeof(kMagic);
+  if ((size < (sizeof(kMagic) + kTrailerSize))
+      or (std::memcmp(m_data, kMagic, sizeof(kMagic)) != 0)
+      or (std::memcmp(m_data + size - sizeof(kMagic), kMagic, sizeof(kMagic))
+          != 0)) {
+    throw std::runtime_error("Invalid columnar file '" + path + "'");
+  }
+  uint64_t footer_offset;
+  std::memcpy(&footer_offset, m_data + size - kTrailerSize, sizeof(uint64_t));
+  if ((footer_offset < sizeof(kMagic))
+      or ((size - kTrailerSize) < footer_offset)) {
+    throw std::runtime_error("Invalid columnar file '" + path + "'");
+  }
+
+  io_columnar_impl::Decoder footer(
+    m_data + footer_offset, size - kTrailerSize - footer_offset);
+  // each column needs at least the two string sizes
+  std::vector<std::pair<std::string, std::string>> columns(
+    footer.count(2 * sizeof(uint64_t)));
+  for (auto& column : columns) {
+    column.first = footer.string();
+    column.second = footer.string();
+  }
+  m_num_file_columns = columns.size();
+  setup_columns(columns, std::make_index_sequence<kNumFields>{});
+
+  (void)footer.u64(); // nominal chunk size is only informational
+  // each chunk needs at least the number of rows and its columns
+  m_chunk_rows.resize(footer.count(
+    sizeof(uint64_t) +
+    m_num_file_columns * (sizeof(uint64_t) + 2 * sizeof(ChunkColumn::min))));
+  m_index.resize(m_chunk_rows.size() * m_num_file_columns);
+  for (std::size_t c = 0; c < m_chunk_rows.size(); ++c) {
+    m_chunk_rows[c] = footer.u64();
+    m_size += m_chunk_rows[c];
+    for (std::size_t i = 0; i < m_num_file_columns; ++i) {
+      auto& entry = m_index[c * m_num_file_columns + i];
+      entry.offset = footer.u64();
+      footer.bytes(entry.min, sizeof(entry.min));
+      footer.bytes(entry.max, sizeof(entry.max));
+      if ((entry.offset % io_columnar_impl::kAlignment) != 0) {
+        throw std::runtime_error("Invalid columnar file '" + path + "'");
+      }
+    }
+  }
+  check_columns(footer_offset, std::make_index_sequence<kNumFields>{});
+}
+
+template<typename NamedTuple>
+template<std::size_t... I>
+inline void
+NamedTupleColumnarReader<NamedTuple>::check_columns(
+  uint64_t end, std::index_sequence<I...>) const {
+  // see namedtuple_impl::print_tuple for explanation
+  using Vacuum = int[];
+  (void)Vacuum{(check_column<I>(end), 0)...};
+}
+
+// Column data of all chunks must be located before the footer.
+template<typename NamedTuple>
+template<std::size_t I>
+inline void
+NamedTupleColumnarReader<NamedTuple>::check_column(uint64_t end) const {
+  for (std::size_t c = 0; c < m_chunk_rows.size(); ++c) {
+    uint64_t offset = entry(c, I).offset;
+    if ((end < offset)
+        or (((end - offset) / sizeof(Stored<I>)) < m_chunk_rows[c])) {
+      throw std::runtime_error("Truncated columnar file data");
+    }
+  }
+}
+
+template<typename NamedTuple>
+template<std::size_t... I>
+inline void
+NamedTupleColumnarReader<NamedTuple>::setup_columns(
+  const std::vector<std::pair<std::string, std::string>>& columns,
+  std::index_sequence<I...>) {
+  // see namedtuple_impl::print_tuple for explanation
+  using Vacuum = int[];
+  (void)Vacuum{(setup_column<I>(columns), 0)...};
+}
+
+template<typename NamedTuple>
+template<std::size_t I>
+inline void
+NamedTupleColumnarReader<NamedTuple>::setup_column(
+  const std::vector<std::pair<std::string, std::string>>& columns) {
+  const auto name = std::get<I>(NamedTuple::field_names());
+  const auto dtype = io_columnar_impl::dtype<Value<I>>();
+  auto it = std::find_if(
+    columns.begin(), columns.end(),
+    [&](const std::pair<std::string, std::string>& column) {
+      return (column.first == name);
+    });
+  if (it == columns.end()) {
+    throw std::runtime_error(
+      "Missing column '" + name.to_string() + "' in columnar file");
+  }
+  if (it->second != dtype) {
+    throw std::runtime_error(
+      "Incompatible column ('" + it->first + "', '" + it->second +
+      "'), expected '" + dtype + "'");
+  }
+  m_columns[I] = std::distance(columns.begin(), it);
+}
+
+template<typename NamedTuple>
+inline std::size_t
+NamedTupleColumnarReader<NamedTuple>::chunk_size(std::size_t chunk) const {
+  check_chunk(chunk);
+  return m_chunk_rows[chunk];
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleColumnarReader<NamedTuple>::check_chunk(std::size_t chunk) const {
+  if (m_chunk_rows.size() <= chunk) {
+    throw std::out_of_range("Chunk index is out of valid range");
+  }
+}
+
+template<typename NamedTuple>
+template<std::size_t I>
+inline typename NamedTupleColumnarReader<NamedTuple>::template Value<I>
+NamedTupleColumnarReader<NamedTuple>::min(std::size_t chunk) const {
+  check_chunk(chunk);
+  Stored<I> value;
+  std::memcpy(&value, entry(chunk, I).min, sizeof(value));
+  return static_cast<Value<I>>(value);
+}
+
+template<typename NamedTuple>
+template<std::size_t I>
+inline typename NamedTupleColumnarReader<NamedTuple>::template Value<I>
+NamedTupleColumnarReader<NamedTuple>::max(std::size_t chunk) const {
+  check_chunk(chunk);
+  Stored<I> value;
+  std::memcpy(&value, entry(chunk, I).max, sizeof(value));
+  return static_cast<Value<I>>(value);
+}
+
+template<typename NamedTuple>
+template<std::size_t I>
+inline bool
+NamedTupleColumnarReader<NamedTuple>::may_contain(
+  std::size_t chunk, const Value<I>& lower, const Value<I>& upper) const {
+  // NaN statistics compare false and never allow skipping the chunk
+  return not((max<I>(chunk) < lower) or (upper < min<I>(chunk)));
+}
+
+template<typename NamedTuple>
+template<std::size_t I>
+inline void
+NamedTupleColumnarReader<NamedTuple>::read_column(
+  std::size_t chunk, Column<I>& column) const {
+  check_chunk(chunk);
+  const Stored<I>* data = column_data<I>(chunk);
+  column.assign(data, data + m_chunk_rows[chunk]);
+}
+
+template<typename NamedTuple>
+template<std::size_t... I>
+inline void
+NamedTupleColumnarReader<NamedTuple>::read_columns(
+  std::size_t chunk, Columns& columns) const {
+  check_chunk(chunk);
+  columns.clear();
+  // see namedtuple_impl::print_tuple for explanation
+  using Vacuum = int[];
+  (void)Vacuum{(read_column<I>(chunk, columns.template column<I>()), 0)...};
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleColumnarReader<NamedTuple>::read_chunk(
+  std::size_t chunk, Columns& columns) const {
+  read_chunk_impl(chunk, columns, std::make_index_sequence<kNumFields>{});
+}
+
+template<typename NamedTuple>
+inline bool
+NamedTupleColumnarReader<NamedTuple>::read(NamedTuple& record) {
+  // skip empty or fully read chunks
+  while ((m_next_chunk < m_chunk_rows.size())
+         and (m_chunk_rows[m_next_chunk] <= m_next_row)) {
+    m_next_chunk += 1;
+    m_next_row = 0;
+  }
+  if (m_next_chunk == m_chunk_rows.size()) {
+    return false;
+  }
+  load_record(
+    m_next_chunk, m_next_row, record, std::make_index_sequence<kNumFields>{});
+  m_next_row += 1;
+  m_next += 1;
+  return true;
+}
+
+} // namespace dfe
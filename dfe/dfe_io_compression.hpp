@@ -0,0 +1,603 @@
+// SPDX-License-Identifier: MIT
+// Copyright 2020 Moritz Kiehn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/// \file
+/// \brief   Streaming gzip/zstd compression shared by the i/o libraries
+/// \author  Moritz Kiehn <msmk@cern.ch>
+///
+/// Each compression format is only available if the corresponding switch is
+/// defined before including any i/o header and the program is linked to the
+/// library:
+///
+/// -   `DFE_USE_IO_ZLIB` enables gzip via zlib
+/// -   `DFE_USE_IO_ZSTD` enables zstd via libzstd
+///
+/// Using a disabled format throws an exception.
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef DFE_USE_IO_ZLIB
+#include <zlib.h>
+#endif
+#ifdef DFE_USE_IO_ZSTD
+#include <zstd.h>
+#endif
+
+namespace dfe {
+namespace io_compression_impl {
+
+enum class Format { None, Gzip, Zstd };
+
+// size of the blocks handed between the codecs and the file
+constexpr std::size_t kBlockSize = 1u << 20;
+
+// Select the format from the file extension, e.g. for writing.
+inline Format
+format_from_extension(const std::string& path) {
+  auto ends_with = [&](const char* suffix) {
+    std::size_t n = std::strlen(suffix);
+    return (n <= path.size())
+           and (path.compare(path.size() - n, n, suffix) == 0);
+  };
+  if (ends_with(".gz")) {
+    return Format::Gzip;
+  }
+  if (ends_with(".zst")) {
+    return Format::Zstd;
+  }
+  return Format::None;
+}
+
+// Select the format from the magic bytes at the start of the file content.
+//
+// Takes the already read content since the file itself might not be
+// readable twice, e.g. for pipes.
+inline Format
+format_from_magic(const char* data, std::size_t size) {
+  auto magic = reinterpret_cast<const unsigned char*>(data);
+  if ((2 <= size) and (magic[0] == 0x1f) and (magic[1] == 0x8b)) {
+    return Format::Gzip;
+  }
+  if ((4 <= size) and (magic[0] == 0x28) and (magic[1] == 0xb5)
+      and (magic[2] == 0x2f) and (magic[3] == 0xfd)) {
+    return Format::Zstd;
+  }
+  return Format::None;
+}
+
+inline std::ifstream
+open_input(const std::string& path) {
+  std::ifstream file(path, std::ios_base::binary | std::ios_base::in);
+  if (not file.is_open() or file.fail()) {
+    throw std::runtime_error("Could not open file '" + path + "'");
+  }
+  return file;
+}
+
+inline void
+check_format(Format format) {
+#ifndef DFE_USE_IO_ZLIB
+  if (format == Format::Gzip) {
+    throw std::runtime_error("gzip compression requires DFE_USE_IO_ZLIB");
+  }
+#endif
+#ifndef DFE_USE_IO_ZSTD
+  if (format == Format::Zstd) {
+    throw std::runtime_error("zstd compression requires DFE_USE_IO_ZSTD");
+  }
+#endif
+  (void)format;
+}
+
+/// Compress data and write it to a file.
+///
+/// zstd compression uses one worker thread per core if libzstd supports it.
+class CompressedOutput {
+public:
+  CompressedOutput(const std::string& path, Format format);
+  CompressedOutput(const CompressedOutput&) = delete;
+  CompressedOutput& operator=(const CompressedOutput&) = delete;
+  ~CompressedOutput();
+
+  /// Compress the data; output might be held back by the codec.
+  void write(const char* data, std::size_t size);
+  /// Write all pending output such that it can be decompressed.
+  void flush();
+  /// Finish the compressed stream and close the file.
+  void finish();
+
+private:
+  enum class Mode { Continue, Flush, End };
+
+  Format m_format;
+  std::ofstream m_file;
+  std::vector<char> m_out;
+#ifdef DFE_USE_IO_ZLIB
+  z_stream m_zstream;
+#endif
+#ifdef DFE_USE_IO_ZSTD
+  ZSTD_CCtx* m_cctx = nullptr;
+#endif
+
+  void encode(const char* data, std::size_t size, Mode mode);
+  void encode_gzip(const char* data, std::size_t size, Mode mode);
+  void encode_zstd(const char* data, std::size_t size, Mode mode);
+  void write_output(std::size_t size);
+};
+
+/// Read a file and decompress its content.
+///
+/// The file is read and decompressed on a separate thread such that the
+/// decompression overlaps with the processing of already decompressed data.
+/// Concatenated gzip members and zstd frames are read as one stream.
+class DecompressedInput {
+public:
+  DecompressedInput(const std::string& path, Format format);
+  /// Continue reading an open file whose first bytes were already consumed.
+  ///
+  /// \param file    Open input file positioned after the consumed bytes
+  /// \param prefix  Pointer to the consumed bytes at the start of the file
+  /// \param size    Number of consumed bytes
+  /// \param format  Compression format
+  DecompressedInput(
+    std::ifstream&& file, const char* prefix, std::size_t size, Format format);
+  DecompressedInput(const DecompressedInput&) = delete;
+  DecompressedInput& operator=(const DecompressedInput&) = delete;
+  /// Stop the decompression and join the thread.
+  ~DecompressedInput();
+
+  /// Read up to size decompressed bytes.
+  ///
+  /// \returns Number of bytes read, less than size only at the end-of-data
+  ///
+  /// Errors during decompression are rethrown here.
+  std::size_t read(char* data, std::size_t size);
+
+private:
+  // maximum number of decompressed blocks waiting to be read
+  static constexpr std::size_t kMaxBlocks = 4;
+
+  Format m_format;
+  std::ifstream m_file;
+  std::vector<char> m_in;
+  // number of already consumed bytes at the start of the input buffer
+  std::size_t m_in_prefix = 0;
+  bool m_input_done = false;
+  // true if the last compressed member/frame is complete
+  bool m_stream_end = false;
+#ifdef DFE_USE_IO_ZLIB
+  z_stream m_zstream;
+#endif
+#ifdef DFE_USE_IO_ZSTD
+  ZSTD_DCtx* m_dctx = nullptr;
+  ZSTD_inBuffer m_zin = {nullptr, 0, 0};
+#endif
+  // decompressed blocks shared between the threads
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<std::vector<char>> m_ready;
+  bool m_done = false;
+  bool m_stop = false;
+  std::exception_ptr m_error;
+  // block that is currently being read; only accessed by the reading thread
+  std::vector<char> m_current;
+  std::size_t m_current_pos = 0;
+  std::thread m_thread;
+
+  void produce();
+  std::size_t fill_input();
+  void decode(std::vector<char>& block);
+  void decode_gzip(std::vector<char>& block);
+  void decode_zstd(std::vector<char>& block);
+  [[noreturn]] void throw_truncated() const {
+    throw std::runtime_error("Truncated compressed file");
+  }
+};
+
+// implementation compressed output
+
+inline CompressedOutput::CompressedOutput(
+  const std::string& path, Format format)
+  : m_format(format) {
+  check_format(format);
+  m_file.open(
+    path, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+  if (not m_file.is_open() or m_file.fail()) {
+    throw std::runtime_error("Could not open file '" + path + "'");
+  }
+  m_out.resize(kBlockSize);
+#ifdef DFE_USE_IO_ZLIB
+  if (m_format == Format::Gzip) {
+    std::memset(&m_zstream, 0, sizeof(m_zstream));
+    // window bits + 16 selects the gzip instead of the zlib container
+    auto ret = deflateInit2(
+      &m_zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+      Z_DEFAULT_STRATEGY);
+    if (ret != Z_OK) {
+      throw std::runtime_error("Could not initialize gzip compression");
+    }
+  }
+#endif
+#ifdef DFE_USE_IO_ZSTD
+  if (m_format == Format::Zstd) {
+    m_cctx = ZSTD_createCCtx();
+    if (not m_cctx) {
+      throw std::runtime_error("Could not initialize zstd compression");
+    }
+    ZSTD_CCtx_setParameter(m_cctx, ZSTD_c_compressionLevel, 3);
+    // fails w/o multi-threading support and then compresses serially
+    ZSTD_CCtx_setParameter(
+      m_cctx, ZSTD_c_nbWorkers,
+      static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+  }
+#endif
+}
+
+inline CompressedOutput::~CompressedOutput() {
+#ifdef DFE_USE_IO_ZLIB
+  if (m_format == Format::Gzip) {
+    deflateEnd(&m_zstream);
+  }
+#endif
+#ifdef DFE_USE_IO_ZSTD
+  ZSTD_freeCCtx(m_cctx);
+#endif
+}
+
+inline void
+CompressedOutput::write(const char* data, std::size_t size) {
+  encode(data, size, Mode::Continue);
+}
+
+inline void
+CompressedOutput::flush() {
+  encode(nullptr, 0, Mode::Flush);
+  m_file.flush();
+}
+
+inline void
+CompressedOutput::finish() {
+  if (not m_file.is_open()) {
+    return;
+  }
+  encode(nullptr, 0, Mode::End);
+  m_file.close();
+  if (m_file.fail()) {
+    throw std::runtime_error("Could not write data to file");
+  }
+}
+
+inline void
+CompressedOutput::encode(const char* data, std::size_t size, Mode mode) {
+  if (m_format == Format::Gzip) {
+    encode_gzip(data, size, mode);
+  } else if (m_format == Format::Zstd) {
+    encode_zstd(data, size, mode);
+  }
+}
+
+inline void
+CompressedOutput::encode_gzip(const char* data, std::size_t size, Mode mode) {
+#ifdef DFE_USE_IO_ZLIB
+  int flush = Z_NO_FLUSH;
+  if (mode == Mode::Flush) {
+    flush = Z_SYNC_FLUSH;
+  } else if (mode == Mode::End) {
+    flush = Z_FINISH;
+  }
+  // zlib does not modify the input but does not declare it as const
+  m_zstream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  m_zstream.avail_in = static_cast<uInt>(size);
+  while (true) {
+    m_zstream.next_out = reinterpret_cast<Bytef*>(m_out.data());
+    m_zstream.avail_out = static_cast<uInt>(m_out.size());
+    auto ret = deflate(&m_zstream, flush);
+    if (ret == Z_STREAM_ERROR) {
+      throw std::runtime_error("Could not compress gzip data");
+    }
+    write_output(m_out.size() - m_zstream.avail_out);
+    // all input is consumed once the output is not completely filled
+    bool done = (flush == Z_FINISH) ? (ret == Z_STREAM_END)
+                                    : (m_zstream.avail_out != 0);
+    if (done) {
+      break;
+    }
+  }
+#else
+  (void)data;
+  (void)size;
+  (void)mode;
+#endif
+}
+
+inline void
+CompressedOutput::encode_zstd(const char* data, std::size_t size, Mode mode) {
+#ifdef DFE_USE_IO_ZSTD
+  ZSTD_EndDirective directive = ZSTD_e_continue;
+  if (mode == Mode::Flush) {
+    directive = ZSTD_e_flush;
+  } else if (mode == Mode::End) {
+    directive = ZSTD_e_end;
+  }
+  ZSTD_inBuffer in = {data, size, 0};
+  while (true) {
+    ZSTD_outBuffer out = {m_out.data(), m_out.size(), 0};
+    auto remaining = ZSTD_compressStream2(m_cctx, &out, &in, directive);
+    if (ZSTD_isError(remaining)) {
+      throw std::runtime_error(
+        std::string("Could not compress zstd data: ")
+        + ZSTD_getErrorName(remaining));
+    }
+    write_output(out.pos);
+    // w/o flushing, input can be buffered internally by the workers
+    bool done = (directive == ZSTD_e_continue) ? (in.pos == in.size)
+                                               : (remaining == 0);
+    if (done) {
+      break;
+    }
+  }
+#else
+  (void)data;
+  (void)size;
+  (void)mode;
+#endif
+}
+
+inline void
+CompressedOutput::write_output(std::size_t size) {
+  m_file.write(m_out.data(), size);
+  if (not m_file.good()) {
+    throw std::runtime_error("Could not write data to file");
+  }
+}
+
+// implementation decompressed input
+
+inline DecompressedInput::DecompressedInput(
+  const std::string& path, Format format)
+  : DecompressedInput(open_input(path), nullptr, 0u, format) {}
+
+inline DecompressedInput::DecompressedInput(
+  std::ifstream&& file, const char* prefix, std::size_t size, Format format)
+  : m_format(format), m_file(std::move(file)) {
+  check_format(format);
+  // the consumed bytes are returned first as regular input
+  m_in.resize(std::max(kBlockSize, size));
+  std::copy(prefix, prefix + size, m_in.begin());
+  m_in_prefix = size;
+#ifdef DFE_USE_IO_ZLIB
+  if (m_format == Format::Gzip) {
+    std::memset(&m_zstream, 0, sizeof(m_zstream));
+    // window bits + 16 accepts only the gzip container
+    if (inflateInit2(&m_zstream, 15 + 16) != Z_OK) {
+      throw std::runtime_error("Could not initialize gzip decompression");
+    }
+  }
+#endif
+#ifdef DFE_USE_IO_ZSTD
+  if (m_format == Format::Zstd) {
+    m_dctx = ZSTD_createDCtx();
+    if (not m_dctx) {
+      throw std::runtime_error("Could not initialize zstd decompression");
+    }
+  }
+#endif
+  // only start once everything is initialized
+  m_thread = std::thread([this] { produce(); });
+}
+
+inline DecompressedInput::~DecompressedInput() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+#ifdef DFE_USE_IO_ZLIB
+  if (m_format == Format::Gzip) {
+    inflateEnd(&m_zstream);
+  }
+#endif
+#ifdef DFE_USE_IO_ZSTD
+  ZSTD_freeDCtx(m_dctx);
+#endif
+}
+
+inline std::size_t
+DecompressedInput::read(char* data, std::size_t size) {
+  std::size_t total = 0;
+  while (total < size) {
+    if (m_current_pos == m_current.size()) {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [&] { return (not m_ready.empty()) or m_done; });
+      if (m_ready.empty()) {
+        if (m_error) {
+          std::rethrow_exception(m_error);
+        }
+        break;
+      }
+      m_current = std::move(m_ready.front());
+      m_current_pos = 0;
+      m_ready.pop_front();
+      lock.unlock();
+      m_cv.notify_all();
+    }
+    auto n = std::min(size - total, m_current.size() - m_current_pos);
+    std::memcpy(data + total, m_current.data() + m_current_pos, n);
+    m_current_pos += n;
+    total += n;
+  }
+  return total;
+}
+
+// decompress blocks until the end-of-data or until stopped
+inline void
+DecompressedInput::produce() {
+  try {
+    bool last = false;
+    while (not last) {
+      std::vector<char> block(kBlockSize);
+      decode(block);
+      // only the last block can be incomplete
+      last = (block.size() < kBlockSize);
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [&] { return m_stop or (m_ready.size() < kMaxBlocks); });
+      if (m_stop) {
+        return;
+      }
+      if (not block.empty()) {
+        m_ready.push_back(std::move(block));
+      }
+      m_done = last;
+      lock.unlock();
+      m_cv.notify_all();
+    }
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_error = std::current_exception();
+      m_done = true;
+    }
+    m_cv.notify_all();
+  }
+}
+
+// read the next block of compressed input, returns zero at the end-of-file
+inline std::size_t
+DecompressedInput::fill_input() {
+  if (0 < m_in_prefix) {
+    return std::exchange(m_in_prefix, 0u);
+  }
+  m_file.read(m_in.data(), m_in.size());
+  if (m_file.bad()) {
+    throw std::runtime_error("Could not read data from file");
+  }
+  return static_cast<std::size_t>(m_file.gcount());
+}
+
+// decompress into the block and shrink it to the decompressed size
+inline void
+DecompressedInput::decode(std::vector<char>& block) {
+  if (m_format == Format::Gzip) {
+    decode_gzip(block);
+  } else if (m_format == Format::Zstd) {
+    decode_zstd(block);
+  } else {
+    block.clear();
+  }
+}
+
+inline void
+DecompressedInput::decode_gzip(std::vector<char>& block) {
+#ifdef DFE_USE_IO_ZLIB
+  m_zstream.next_out = reinterpret_cast<Bytef*>(block.data());
+  m_zstream.avail_out = static_cast<uInt>(block.size());
+  while (m_zstream.avail_out != 0) {
+    if ((m_zstream.avail_in == 0) and not m_input_done) {
+      auto n = fill_input();
+      m_zstream.next_in = reinterpret_cast<Bytef*>(m_in.data());
+      m_zstream.avail_in = static_cast<uInt>(n);
+      m_input_done = (n == 0);
+    }
+    if (m_stream_end) {
+      if (m_zstream.avail_in == 0) {
+        break;
+      }
+      // another gzip member follows, e.g. from appending compressed files
+      if (inflateReset(&m_zstream) != Z_OK) {
+        throw std::runtime_error("Could not decompress gzip data");
+      }
+      m_stream_end = false;
+    }
+    auto avail_in = m_zstream.avail_in;
+    auto avail_out = m_zstream.avail_out;
+    auto ret = inflate(&m_zstream, Z_NO_FLUSH);
+    if (ret == Z_STREAM_END) {
+      m_stream_end = true;
+    } else if ((ret != Z_OK) and (ret != Z_BUF_ERROR)) {
+      throw std::runtime_error("Could not decompress gzip data");
+    } else if (
+      m_input_done and (avail_in == m_zstream.avail_in)
+      and (avail_out == m_zstream.avail_out)) {
+      // no progress is possible and no more input is available
+      throw_truncated();
+    }
+  }
+  block.resize(block.size() - m_zstream.avail_out);
+#else
+  block.clear();
+#endif
+}
+
+inline void
+DecompressedInput::decode_zstd(std::vector<char>& block) {
+#ifdef DFE_USE_IO_ZSTD
+  ZSTD_outBuffer out = {block.data(), block.size(), 0};
+  while (out.pos < out.size) {
+    if ((m_zin.pos == m_zin.size) and not m_input_done) {
+      auto n = fill_input();
+      m_zin = {m_in.data(), n, 0};
+      m_input_done = (n == 0);
+    }
+    if (m_stream_end and (m_zin.pos == m_zin.size)) {
+      break;
+    }
+    auto in_pos = m_zin.pos;
+    auto out_pos = out.pos;
+    // consecutive frames are decompressed automatically
+    auto ret = ZSTD_decompressStream(m_dctx, &out, &m_zin);
+    if (ZSTD_isError(ret)) {
+      throw std::runtime_error(
+        std::string("Could not decompress zstd data: ")
+        + ZSTD_getErrorName(ret));
+    }
+    // zero means the frame is complete and all its output was written
+    m_stream_end = (ret == 0);
+    if (
+      m_input_done and not m_stream_end and (in_pos == m_zin.pos)
+      and (out_pos == out.pos)) {
+      throw_truncated();
+    }
+  }
+  block.resize(out.pos);
+#else
+  block.clear();
+#endif
+}
+
+} // namespace io_compression_impl
+} // namespace dfe
@@ -28,29 +28,87 @@
 
 #include <algorithm>
 #include <array>
+#include <cerrno>
+#include <clocale>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <fstream>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "dfe_io_compression.hpp"
+#include "dfe_io_mmap.hpp"
+#include "dfe_io_statistics.hpp"
+#include "dfe_namedtuple.hpp"
+
 namespace dfe {
 namespace io_dsv_impl {
 
+/// A non-owning, read-only view of a character sequence.
+///
+/// Minimal replacement for `std::string_view` which is not available in C++14.
+/// The referenced characters must outlive the view.
+class StringView {
+public:
+  constexpr StringView() = default;
+  constexpr StringView(const char* data, std::size_t size)
+    : m_data(data), m_size(size) {}
+  StringView(const std::string& str) : m_data(str.data()), m_size(str.size()) {}
+
+  constexpr const char* data() const { return m_data; }
+  constexpr std::size_t size() const { return m_size; }
+  constexpr bool empty() const { return (m_size == 0); }
+  constexpr const char* begin() const { return m_data; }
+  constexpr const char* end() const { return m_data + m_size; }
+
+  /// Create an owning copy of the viewed characters.
+  std::string to_string() const { return std::string(m_data, m_size); }
+
+private:
+  const char* m_data = nullptr;
+  std::size_t m_size = 0;
+};
+
+inline bool
+operator==(StringView lhs, StringView rhs) {
+  return (lhs.size() == rhs.size())
+         and (std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+}
+inline bool
+operator!=(StringView lhs, StringView rhs) {
+  return not(lhs == rhs);
+}
+
 /// Write arbitrary data as delimiter-separated values into a text file.
+///
+/// Rows are formatted directly into an internal buffer that is written to
+/// the file in large blocks. Paths ending in `.gz` or `.zst` are compressed
+/// with gzip or zstd, see `dfe_io_compression.hpp` for the requirements.
 template<char Delimiter>
 class DsvWriter {
 public:
   DsvWriter() = delete;
   DsvWriter(const DsvWriter&) = delete;
   DsvWriter(DsvWriter&&) = default;
-  ~DsvWriter() = default;
+  /// Write remaining buffered rows and close the file.
+  ~DsvWriter();
   DsvWriter& operator=(const DsvWriter&) = delete;
-  DsvWriter& operator=(DsvWriter&&) = default;
+  /// Write remaining buffered rows and close the file before taking over.
+  DsvWriter& operator=(DsvWriter&& other);
 
   /// Create a file at the given path. Overwrites existing data.
   ///
@@ -71,23 +129,56 @@ public:
   ///       is written as a separate column.
   template<typename Arg0, typename... Args>
   void append(Arg0&& arg0, Args&&... args);
+  /// Write all buffered rows to the file.
+  ///
+  /// Compressed output can be read up to this point, but is only complete
+  /// once the writer is closed.
+  void flush();
+  /// Write all buffered rows, finish the compression, and close the file.
+  ///
+  /// Called automatically by the destructor, but errors can only be
+  /// reported when it is called explicitly.
+  void close();
+
+  /// Return the i/o statistics; only collected with DFE_USE_IO_STATISTICS.
+  const IoStatistics& statistics() const { return m_recorder.statistics(); }
+  /// Set a function that receives the statistics after each flush.
+  void set_statistics_callback(IoStatisticsCallback callback) {
+    m_recorder.set_callback(std::move(callback));
+  }
 
 private:
+  // buffered rows are written once the buffer exceeds this size
+  static constexpr std::size_t kBufferSize = 1u << 20;
+
   std::ofstream m_file;
+  // replaces the file for compressed output
+  std::unique_ptr<io_compression_impl::CompressedOutput> m_compressed;
+  std::string m_buffer;
   std::size_t m_num_columns;
+  int m_precision;
+  io_statistics_impl::Recorder m_recorder;
+
+  void write_buffer();
 
   // enable_if to prevent this overload to be used for std::vector<T> as well
   template<typename T>
-  static std::enable_if_t<
+  std::enable_if_t<
     std::is_arithmetic<std::decay_t<T>>::value
       or std::is_convertible<T, std::string>::value,
     unsigned>
-  write(T&& x, std::ostream& os);
+  write(T&& x);
   template<typename T, typename Allocator>
-  static unsigned write(const std::vector<T, Allocator>& xs, std::ostream& os);
+  unsigned write(const std::vector<T, Allocator>& xs);
 };
 
 /// Read arbitrary data as delimiter-separated values from a text file.
+///
+/// Regular files are memory-mapped and lines are split directly in the mapped
+/// region. Files that can not be mapped are read in large buffered blocks.
+/// Files compressed with gzip or zstd are detected from their content and
+/// decompressed on a separate thread while reading, see
+/// `dfe_io_compression.hpp` for the requirements.
 template<char Delimiter>
 class DsvReader {
 public:
@@ -108,14 +199,78 @@ public:
   /// \returns true   if the line was successfully read
   /// \returns false  if no more lines are available
   bool read(std::vector<std::string>& columns);
+  /// Read the next line from the file without copying the column content.
+  ///
+  /// \returns true   if the line was successfully read
+  /// \returns false  if no more lines are available
+  ///
+  /// The column views are only valid until the next call to `read(...)` or
+  /// until the reader is destroyed.
+  bool read(std::vector<StringView>& columns);
+
+  /// Split the unread lines into readers for disjoint ranges of the file.
+  ///
+  /// \param n  Requested number of readers
+  /// \returns  Up to n readers
+  ///
+  /// Ranges are aligned to line boundaries and cover all unread lines in file
+  /// order; empty ranges are dropped. Each reader can be used independently,
+  /// e.g. on separate threads, and counts its lines starting from zero.
+  /// Afterwards, this reader has no unread lines left. Files that can not be
+  /// memory-mapped can not be split and all unread lines are moved into a
+  /// single reader.
+  std::vector<DsvReader> split(std::size_t n);
 
   /// Return the number of lines read so far.
   std::size_t num_lines() const { return m_num_lines; }
+  /// Return the number of unread bytes if known, zero otherwise.
+  std::size_t num_unread_bytes() const;
+
+  /// Return the i/o statistics; only collected with DFE_USE_IO_STATISTICS.
+  ///
+  /// For memory-mapped files, the i/o time includes the line search that
+  /// implicitly reads the mapped pages.
+  const IoStatistics& statistics() const { return m_recorder.statistics(); }
+  /// Set a function that receives the statistics on destruction.
+  void set_statistics_callback(IoStatisticsCallback callback) {
+    m_recorder.set_callback(std::move(callback));
+  }
 
 private:
+  // block size for buffered reads if the file can not be mapped
+  static constexpr std::size_t kBufferSize = 1u << 20;
+
+  // the mapping is shared among all readers created by splitting
+  std::shared_ptr<const MappedFile> m_mapped;
+  // range [pos, end) of unread lines within the mapped file
+  std::size_t m_mapped_pos = 0;
+  std::size_t m_mapped_end = 0;
+  // buffered fallback; unread data is stored in [m_buffer_begin, m_buffer_end)
   std::ifstream m_file;
-  std::string m_line;
+  // replaces the file for compressed input
+  std::unique_ptr<io_compression_impl::DecompressedInput> m_decompressed;
+  bool m_eof = false;
+  std::vector<char> m_buffer;
+  std::size_t m_buffer_begin = 0;
+  std::size_t m_buffer_end = 0;
+  // column views for the copying read interface
+  std::vector<StringView> m_views;
   std::size_t m_num_lines = 0;
+  io_statistics_impl::Recorder m_recorder;
+
+  // the named tuple reader records its conversion time
+  template<char, typename>
+  friend class NamedTupleDsvReader;
+
+  DsvReader(
+    std::shared_ptr<const MappedFile> mapped, std::size_t begin,
+    std::size_t end);
+
+  bool read_line(StringView& line);
+  bool read_line_mapped(StringView& line);
+  bool read_line_buffered(StringView& line);
+  std::size_t read_block(char* data, std::size_t size);
+  std::size_t read_file(char* data, std::size_t size);
 };
 
 /// Write records as delimiter-separated values into a text file.
@@ -144,6 +299,22 @@ public:
       record, std::make_index_sequence<
                 std::tuple_size<typename NamedTuple::Tuple>::value>{});
   }
+  /// Write all buffered records to the file.
+  void flush() { m_writer.flush(); }
+  /// Write all buffered records and close the file.
+  ///
+  /// Called automatically by the destructor, but errors can only be
+  /// reported when it is called explicitly.
+  void close() { m_writer.close(); }
+
+  /// Return the i/o statistics; only collected with DFE_USE_IO_STATISTICS.
+  ///
+  /// Records include the header line.
+  const IoStatistics& statistics() const { return m_writer.statistics(); }
+  /// Set a function that receives the statistics after each flush.
+  void set_statistics_callback(IoStatisticsCallback callback) {
+    m_writer.set_statistics_callback(std::move(callback));
+  }
 
 private:
   DsvWriter<Delimiter> m_writer;
@@ -161,14 +332,391 @@ private:
 
 // string conversion helper functions
 
+[[noreturn]] inline void
+throw_parse_error(StringView str) {
+  throw std::runtime_error("Could not parse value '" + str.to_string() + "'");
+}
+
+// Decimal point of the current C locale or nullptr if it is '.'.
+//
+// The C library number conversions use the decimal point of the current
+// `LC_NUMERIC` locale, but the file format must not depend on the locale.
+inline const char*
+localized_decimal_point() {
+  const char* point = std::localeconv()->decimal_point;
+  return ((point[0] == '.') and (point[1] == '\0')) ? nullptr : point;
+}
+
+// Convert the full string into a value of the given type.
+//
+// The conversion is selected at compile time by the value type. Arithmetic
+// types use dedicated parsers that never allocate memory; all other types
+// fall back to the generic stream-based conversion.
+//
+// see: https://cpppatterns.com/patterns/class-template-sfinae.html
+template<typename T, typename Enable = void>
+struct Parser {
+  static void parse(StringView str, T& value) {
+    std::istringstream is(str.to_string());
+    is >> value;
+  }
+};
+template<>
+struct Parser<std::string> {
+  static void parse(StringView str, std::string& value) {
+    value.assign(str.data(), str.size());
+  }
+};
+template<>
+struct Parser<char> {
+  static void parse(StringView str, char& value) {
+    if (str.size() != 1) {
+      throw_parse_error(str);
+    }
+    value = str.data()[0];
+  }
+};
+template<>
+struct Parser<bool> {
+  static void parse(StringView str, bool& value) {
+    // consistent with the default, non-alpha stream output
+    if ((str.size() != 1)
+        or ((str.data()[0] != '0') and (str.data()[0] != '1'))) {
+      throw_parse_error(str);
+    }
+    value = (str.data()[0] == '1');
+  }
+};
+// integer types w/o the character and boolean types handled above.
+// [u]int8_t are explicitely parsed as numbers and not as characters.
+template<typename T>
+struct Parser<
+  T, std::enable_if_t<
+       std::is_integral<T>::value and not std::is_same<T, bool>::value
+       and not std::is_same<T, char>::value>> {
+  static void parse(StringView str, T& value) {
+    const char* pos = str.begin();
+    const char* end = str.end();
+    bool is_negative = false;
+    if ((pos != end) and ((*pos == '-') or (*pos == '+'))) {
+      is_negative = (*pos == '-');
+      ++pos;
+    }
+    if (pos == end) {
+      throw_parse_error(str);
+    }
+    // largest allowed magnitude; unsigned types only allow negative zero
+    uint64_t limit = std::numeric_limits<T>::max();
+    if (is_negative) {
+      limit = std::is_signed<T>::value ? (limit + 1u) : 0u;
+    }
+    uint64_t magnitude = 0;
+    for (; pos != end; ++pos) {
+      auto digit = static_cast<unsigned>(*pos) - static_cast<unsigned>('0');
+      if (9u < digit) {
+        throw_parse_error(str);
+      }
+      // detect overflow before it happens
+      if (((limit / 10u) < magnitude) or ((limit - 10u * magnitude) < digit)) {
+        throw_parse_error(str);
+      }
+      magnitude = 10u * magnitude + digit;
+    }
+    if (not is_negative) {
+      value = static_cast<T>(magnitude);
+    } else if (magnitude == limit) {
+      // most negative value has no positive equivalent
+      value = std::numeric_limits<T>::min();
+    } else {
+      value = static_cast<T>(-static_cast<int64_t>(magnitude));
+    }
+  }
+};
+// floating point limits for the exact fast path
 template<typename T>
-static void
-parse(const std::string& str, T& value) {
-  // TODO use somthing w/ lower overhead then stringstream e.g. std::from_chars
-  std::istringstream is(str);
-  is >> value;
+struct FloatingPointTraits;
+template<>
+struct FloatingPointTraits<float> {
+  // largest exactly representable power of ten and mantissa
+  static constexpr int kMaxExactExponent = 10;
+  static constexpr uint64_t kMaxExactMantissa = UINT64_C(1) << 24;
+  static float convert(const char* str, char** end) {
+    return std::strtof(str, end);
+  }
+};
+template<>
+struct FloatingPointTraits<double> {
+  static constexpr int kMaxExactExponent = 22;
+  static constexpr uint64_t kMaxExactMantissa = UINT64_C(1) << 53;
+  static double convert(const char* str, char** end) {
+    return std::strtod(str, end);
+  }
+};
+template<>
+struct FloatingPointTraits<long double> {
+  // not worth a separate fast path; always use the slow path
+  static constexpr int kMaxExactExponent = -1;
+  static constexpr uint64_t kMaxExactMantissa = 0;
+  static long double convert(const char* str, char** end) {
+    return std::strtold(str, end);
+  }
+};
+template<typename T>
+struct Parser<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+  using Traits = FloatingPointTraits<T>;
+
+  static void parse(StringView str, T& value) {
+    if (not parse_exact(str, value)) {
+      parse_fallback(str, value);
+    }
+  }
+  // Fast path for values that can be computed exactly.
+  //
+  // If the decimal mantissa and the power of ten are both exactly
+  // representable, a single multiplication or division yields the correctly
+  // rounded result (Clinger's fast path). Returns false for everything else,
+  // including invalid input, to defer to the fallback.
+  static bool parse_exact(StringView str, T& value) {
+    static const T kPowersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                     1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                     1e18, 1e19, 1e20, 1e21, 1e22};
+
+    const char* pos = str.begin();
+    const char* end = str.end();
+    bool is_negative = false;
+    if ((pos != end) and ((*pos == '-') or (*pos == '+'))) {
+      is_negative = (*pos == '-');
+      ++pos;
+    }
+    uint64_t mantissa = 0;
+    int num_digits = 0;
+    int exponent = 0;
+    bool has_digits = false;
+    bool in_fraction = false;
+    for (; pos != end; ++pos) {
+      if (*pos == '.') {
+        if (in_fraction) {
+          return false;
+        }
+        in_fraction = true;
+        continue;
+      }
+      auto digit = static_cast<unsigned>(*pos) - static_cast<unsigned>('0');
+      if (9u < digit) {
+        break;
+      }
+      has_digits = true;
+      // leading zeros are not significant
+      if ((mantissa != 0) or (digit != 0)) {
+        // at most 19 decimal digits always fit into 64bit
+        if (19 <= num_digits) {
+          return false;
+        }
+        mantissa = 10u * mantissa + digit;
+        num_digits += 1;
+      }
+      exponent -= in_fraction ? 1 : 0;
+    }
+    if (not has_digits) {
+      return false;
+    }
+    if ((pos != end) and ((*pos == 'e') or (*pos == 'E'))) {
+      ++pos;
+      bool is_exponent_negative = false;
+      if ((pos != end) and ((*pos == '-') or (*pos == '+'))) {
+        is_exponent_negative = (*pos == '-');
+        ++pos;
+      }
+      if (pos == end) {
+        return false;
+      }
+      int explicit_exponent = 0;
+      for (; pos != end; ++pos) {
+        auto digit = static_cast<unsigned>(*pos) - static_cast<unsigned>('0');
+        // limit the exponent size to avoid overflows
+        if ((9u < digit) or (10000 < explicit_exponent)) {
+          return false;
+        }
+        explicit_exponent = 10 * explicit_exponent + digit;
+      }
+      exponent += is_exponent_negative ? -explicit_exponent : explicit_exponent;
+    }
+    if (pos != end) {
+      return false;
+    }
+    if ((Traits::kMaxExactMantissa < mantissa)
+        or (exponent < -Traits::kMaxExactExponent)
+        or (Traits::kMaxExactExponent < exponent)) {
+      return false;
+    }
+    T x = static_cast<T>(mantissa);
+    if (exponent < 0) {
+      x /= kPowersOfTen[-exponent];
+    } else {
+      x *= kPowersOfTen[exponent];
+    }
+    value = is_negative ? -x : x;
+    return true;
+  }
+  // Slow path with full validation using the C library conversion.
+  static void parse_fallback(StringView str, T& value) {
+    // the C library skips leading whitespace; reject it like for integers
+    if (str.empty() or std::strchr(" \t\n\v\f\r", str.data()[0])) {
+      throw_parse_error(str);
+    }
+    // the C library requires null-terminated strings. use stack storage for
+    // all reasonable inputs; longer strings are most likely invalid anyways.
+    char buffer[128];
+    std::string large;
+    const char* first = buffer;
+    std::size_t size = str.size();
+    if (const char* point = localized_decimal_point()) {
+      std::size_t point_size = std::strlen(point);
+      // only '.' is a valid decimal point regardless of the locale
+      if (std::search(str.begin(), str.end(), point, point + point_size)
+          != str.end()) {
+        throw_parse_error(str);
+      }
+      large = str.to_string();
+      auto dot = large.find('.');
+      if (dot != std::string::npos) {
+        large.replace(dot, 1u, point, point_size);
+      }
+      first = large.c_str();
+      size = large.size();
+    } else if (str.size() < sizeof(buffer)) {
+      std::memcpy(buffer, str.data(), str.size());
+      buffer[str.size()] = '\0';
+    } else {
+      large = str.to_string();
+      first = large.c_str();
+    }
+    char* last = nullptr;
+    errno = 0;
+    T x = Traits::convert(first, &last);
+    if (last != (first + size)) {
+      throw_parse_error(str);
+    }
+    // overflows are errors; underflows round towards zero as for streams
+    if ((errno == ERANGE) and std::isinf(x)) {
+      throw_parse_error(str);
+    }
+    value = x;
+  }
+};
+
+template<typename T>
+inline void
+parse(StringView str, T& value) {
+  Parser<T>::parse(str, value);
 }
 
+// Append the string representation of the value to the output.
+//
+// The output is consistent with the default stream formatting with the
+// exception of `[u]int8_t` which are written as numbers and not as
+// characters. Only string-like types require a temporary allocation.
+template<typename T, typename Enable = void>
+struct Formatter {
+  static void format(const T& value, int, std::string& out) {
+    out.append(std::string(value));
+  }
+};
+template<>
+struct Formatter<std::string> {
+  static void format(const std::string& value, int, std::string& out) {
+    out.append(value);
+  }
+};
+template<>
+struct Formatter<const char*> {
+  static void format(const char* value, int, std::string& out) {
+    out.append(value);
+  }
+};
+template<>
+struct Formatter<char*> : Formatter<const char*> {};
+template<>
+struct Formatter<char> {
+  static void format(char value, int, std::string& out) {
+    out.push_back(value);
+  }
+};
+template<>
+struct Formatter<bool> {
+  static void format(bool value, int, std::string& out) {
+    out.push_back(value ? '1' : '0');
+  }
+};
+template<typename T>
+struct Formatter<
+  T, std::enable_if_t<
+       std::is_integral<T>::value and not std::is_same<T, bool>::value
+       and not std::is_same<T, char>::value>> {
+  static void format(T value, int, std::string& out) {
+    // enough space for all digits of a 64bit number and the sign
+    char buffer[24];
+    char* end = buffer + sizeof(buffer);
+    char* pos = end;
+    // compute the magnitude in unsigned arithmetic to handle the minimum value
+    uint64_t magnitude = static_cast<uint64_t>(value);
+    if (value < 0) {
+      magnitude = UINT64_C(0) - magnitude;
+    }
+    do {
+      *(--pos) = static_cast<char>('0' + (magnitude % 10u));
+      magnitude /= 10u;
+    } while (magnitude != 0);
+    if (value < 0) {
+      *(--pos) = '-';
+    }
+    out.append(pos, end - pos);
+  }
+};
+// Append a number formatted by the C library w/ a '.' decimal point.
+inline void
+append_number(const char* str, std::size_t size, std::string& out) {
+  const char* point = localized_decimal_point();
+  std::size_t point_size = point ? std::strlen(point) : 0u;
+  const char* end = str + size;
+  const char* pos = point ? std::search(str, end, point, point + point_size)
+                          : end;
+  out.append(str, pos);
+  if (pos != end) {
+    out.push_back('.');
+    out.append(pos + point_size, end);
+  }
+}
+template<typename T>
+struct Formatter<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+  static void format(T value, int precision, std::string& out) {
+    // equivalent to the default stream formatting w/ the given precision.
+    // maximum length is sign, digits, point, exponent and its sign/digits.
+    char buffer[64];
+    int n = (std::is_same<T, long double>::value)
+              ? std::snprintf(
+                buffer, sizeof(buffer), "%.*Lg", precision,
+                static_cast<long double>(value))
+              : std::snprintf(
+                buffer, sizeof(buffer), "%.*g", precision,
+                static_cast<double>(value));
+    if (n < 0) {
+      throw std::runtime_error("Could not format floating point value");
+    }
+    // only possible for absurdly large precision values
+    if (static_cast<std::size_t>(n) < sizeof(buffer)) {
+      append_number(buffer, n, out);
+    } else {
+      std::string large(n + 1, '\0');
+      (void)std::snprintf(
+        &large[0], large.size(), "%.*Lg", precision,
+        static_cast<long double>(value));
+      append_number(large.data(), n, out);
+    }
+  }
+};
+
 /// Read records as delimiter-separated values from a text file.
 ///
 /// The reader is strict about its input format to avoid ambiguities. If
@@ -218,18 +766,56 @@ public:
   /// \returns false  if no more records are available
   template<typename T>
   bool read(NamedTuple& record, std::vector<T>& extra);
+  /// Read up to n records into column-oriented storage.
+  ///
+  /// \param n        Maximum number of records to read
+  /// \param columns  Output columns; existing content is replaced
+  /// \returns        Number of records read, less than n at the end-of-file
+  ///
+  /// Values are parsed directly into the columns without an intermediate
+  /// record. Elements that correspond to missing, optional columns are
+  /// default-initialized. Extra columns in the file will be ignored.
+  std::size_t read_batch(std::size_t n, NamedTupleColumns<NamedTuple>& columns);
+  /// Read up to n records into new column-oriented storage.
+  NamedTupleColumns<NamedTuple> read_batch(std::size_t n);
+
+  /// Split the unread records into readers for disjoint ranges of the file.
+  ///
+  /// \param n  Requested number of readers
+  /// \returns  Up to n readers
+  ///
+  /// The header is only parsed once and all readers use the same column
+  /// mapping. See `DsvReader::split` for further details. Line numbers in
+  /// error messages are relative to the start of each range.
+  std::vector<NamedTupleDsvReader> split(std::size_t n);
 
   /// Return the number of additional columns that are not part of the tuple.
   std::size_t num_extra_columns() const { return m_extra_columns.size(); }
   /// Return the number of records read so far.
-  std::size_t num_records() const { return m_reader.num_lines() - 1u; }
+  std::size_t num_records() const {
+    return m_reader.num_lines() - m_num_header_lines;
+  }
+  /// Return the number of unread bytes if known, zero otherwise.
+  std::size_t num_unread_bytes() const { return m_reader.num_unread_bytes(); }
+  /// Return the i/o statistics; only collected with DFE_USE_IO_STATISTICS.
+  ///
+  /// Lines include the header line and the conversion time includes the
+  /// line splitting. See `DsvReader::statistics` for further details.
+  const IoStatistics& statistics() const { return m_reader.statistics(); }
+  /// Set a function that receives the statistics on destruction.
+  void set_statistics_callback(IoStatisticsCallback callback) {
+    m_reader.set_statistics_callback(std::move(callback));
+  }
 
 private:
   // the equivalent std::tuple-like type
   using Tuple = typename NamedTuple::Tuple;
 
   DsvReader<Delimiter> m_reader;
-  std::vector<std::string> m_columns;
+  // only the reader created from the file path reads the header line
+  std::size_t m_num_header_lines = 1;
+  // views into the reader; reused for all lines to avoid reallocations
+  std::vector<StringView> m_columns;
   // #columns is fixed to a reasonable value after reading the header
   std::size_t m_num_columns = SIZE_MAX;
   // map tuple index to column index in the file, SIZE_MAX for missing elements
@@ -237,8 +823,16 @@ private:
   // column indices that do not map to a tuple items
   std::vector<std::size_t> m_extra_columns;
 
+  NamedTupleDsvReader(
+    DsvReader<Delimiter>&& reader, const NamedTupleDsvReader& other);
+
+  // the parallel reader requires access to the column mapping
+  template<char, typename>
+  friend class NamedTupleDsvParallelReader;
+
   void use_default_columns();
   void parse_header(const std::vector<std::string>& optional_columns);
+  bool read_columns();
   template<std::size_t... I>
   void parse_record(NamedTuple& record, std::index_sequence<I...>) const {
     // see namedtuple_impl::print_tuple for explanation
@@ -253,6 +847,123 @@ private:
       parse(m_columns[m_tuple_column_map[I]], get<I>(record));
     }
   }
+  template<std::size_t... I>
+  void parse_columns(
+    NamedTupleColumns<NamedTuple>& columns, std::index_sequence<I...>) const {
+    using Vacuum = int[];
+    (void)Vacuum{(parse_column<I>(columns.template column<I>()), 0)...};
+  }
+  template<std::size_t I, typename Column>
+  void parse_column(Column& column) const {
+    // parse as the tuple type and not as the, possibly different, column type
+    std::tuple_element_t<I, Tuple> value{};
+    if (m_tuple_column_map[I] != SIZE_MAX) {
+      parse(m_columns[m_tuple_column_map[I]], value);
+    }
+    column.push_back(value);
+  }
+};
+
+/// Read records in file order using multiple worker threads.
+///
+/// The header is parsed once and the remaining file is split into chunks with
+/// `NamedTupleDsvReader::split`. Chunks are parsed concurrently by a pool of
+/// worker threads and delivered in file order through a bounded queue. The
+/// number of parsed but not yet consumed chunks is limited to bound the
+/// memory usage. Records are identical to the records read by the serial
+/// `NamedTupleDsvReader` with the same configuration.
+template<char Delimiter, typename NamedTuple>
+class NamedTupleDsvParallelReader {
+public:
+  NamedTupleDsvParallelReader() = delete;
+  NamedTupleDsvParallelReader(const NamedTupleDsvParallelReader&) = delete;
+  NamedTupleDsvParallelReader(NamedTupleDsvParallelReader&&) = delete;
+  /// Stop and join all worker threads.
+  ~NamedTupleDsvParallelReader();
+  NamedTupleDsvParallelReader&
+  operator=(const NamedTupleDsvParallelReader&) = delete;
+  NamedTupleDsvParallelReader&
+  operator=(NamedTupleDsvParallelReader&&) = delete;
+
+  /// Open a file at the given path.
+  ///
+  /// \param path              Path to the input file
+  /// \param num_threads       Number of worker threads, zero to auto-detect
+  /// \param optional_columns  Record columns that can be missing in the file
+  /// \param verify_header     true to check header column names, false to skip
+  ///
+  /// See `NamedTupleDsvReader` for the header verification and the optional
+  /// columns behaviour.
+  NamedTupleDsvParallelReader(
+    const std::string& path, std::size_t num_threads = 0,
+    const std::vector<std::string>& optional_columns = {},
+    bool verify_header = true);
+
+  /// Read the next record from the file.
+  ///
+  /// Extra columns in the file will be ignored. Elements of the record that
+  /// correspond to missing, optional columns will not be set and retain
+  /// their value. Errors that occured in the worker threads are rethrown
+  /// after all records preceding the bad line have been read, i.e. at the
+  /// same point as for the serial reader. Reading can continue afterwards
+  /// but the remaining records of the affected chunk are skipped.
+  ///
+  /// \returns true   if a record was successfully read
+  /// \returns false  if no more records are available
+  bool read(NamedTuple& record);
+
+  /// Return the number of additional columns that are not part of the tuple.
+  std::size_t num_extra_columns() const { return m_num_extra_columns; }
+  /// Return the number of records read so far.
+  std::size_t num_records() const { return m_num_records; }
+
+private:
+  using Reader = NamedTupleDsvReader<Delimiter, NamedTuple>;
+
+  // target size of a single chunk
+  static constexpr std::size_t kChunkSize = 1u << 22;
+
+  struct Chunk {
+    std::vector<NamedTuple> records;
+    std::exception_ptr error;
+    bool is_ready = false;
+  };
+
+  std::size_t m_num_extra_columns;
+  std::size_t m_num_records = 0;
+  // map tuple index to column index in the file, SIZE_MAX for missing elements
+  std::array<
+    std::size_t, std::tuple_size<typename NamedTuple::Tuple>::value>
+    m_tuple_column_map;
+  std::vector<Reader> m_readers;
+  // ring buffer of parsed chunks; its size limits the chunks in-flight
+  std::vector<Chunk> m_chunks;
+  // next chunk to be parsed by the workers and next chunk to be consumed
+  std::size_t m_next_parse = 0;
+  std::size_t m_next_consume = 0;
+  bool m_stop = false;
+  std::mutex m_mutex;
+  std::condition_variable m_parsed;
+  std::condition_variable m_consumed;
+  std::vector<std::thread> m_workers;
+  // records from the current chunk that are delivered to the user
+  std::vector<NamedTuple> m_current;
+  std::size_t m_current_pos = 0;
+  // worker error from the current chunk; rethrown once its records are used
+  std::exception_ptr m_error;
+
+  void work();
+  template<std::size_t... I>
+  void assign_record(
+    NamedTuple& record, NamedTuple&& parsed, std::index_sequence<I...>) {
+    // see namedtuple_impl::print_tuple for explanation
+    using std::get;
+    using Vacuum = int[];
+    (void)Vacuum{
+      ((m_tuple_column_map[I] != SIZE_MAX)
+         ? (get<I>(record) = std::move(get<I>(parsed)), 0)
+         : 0)...};
+  }
 };
 
 // implementation writer
@@ -261,56 +972,158 @@ template<char Delimiter>
 inline DsvWriter<Delimiter>::DsvWriter(
   const std::vector<std::string>& columns, const std::string& path,
   int precision)
-  : m_file(
-    path, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc)
-  , m_num_columns(columns.size()) {
-  if (not m_file.is_open() or m_file.fail()) {
-    throw std::runtime_error("Could not open file '" + path + "'");
+  : m_num_columns(columns.size()), m_precision(precision) {
+  auto format = io_compression_impl::format_from_extension(path);
+  if (format != io_compression_impl::Format::None) {
+    m_compressed =
+      std::make_unique<io_compression_impl::CompressedOutput>(path, format);
+  } else {
+    m_file.open(
+      path, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+    if (not m_file.is_open() or m_file.fail()) {
+      throw std::runtime_error("Could not open file '" + path + "'");
+    }
   }
-  m_file.precision(precision);
   if (m_num_columns == 0) {
     throw std::invalid_argument("No columns were specified");
   }
+  // keep sufficient space to avoid reallocations for regular rows
+  m_buffer.reserve(2 * kBufferSize);
   // write column names as header row
   append(columns);
 }
 
+template<char Delimiter>
+inline DsvWriter<Delimiter>::~DsvWriter() {
+  try {
+    close();
+  } catch (...) {
+    // the destructor must not throw; use `close` to get errors
+  }
+}
+
+template<char Delimiter>
+inline DsvWriter<Delimiter>&
+DsvWriter<Delimiter>::operator=(DsvWriter&& other) {
+  if (this != &other) {
+    // the buffered rows of the current file would be lost otherwise
+    try {
+      close();
+    } catch (...) {
+      // same as for the destructor; use `close` to get errors
+    }
+    m_file = std::move(other.m_file);
+    m_compressed = std::move(other.m_compressed);
+    m_buffer = std::move(other.m_buffer);
+    m_num_columns = other.m_num_columns;
+    m_precision = other.m_precision;
+    m_recorder = std::move(other.m_recorder);
+  }
+  return *this;
+}
+
+template<char Delimiter>
+inline void
+DsvWriter<Delimiter>::close() {
+  // the writer might have been moved from
+  if (not m_file.is_open() and not m_compressed) {
+    return;
+  }
+  // release the outputs even on errors so that closing is attempted only once
+  struct Release {
+    std::ofstream& file;
+    std::unique_ptr<io_compression_impl::CompressedOutput>& compressed;
+    ~Release() {
+      file.close();
+      compressed.reset();
+    }
+  } release{m_file, m_compressed};
+  write_buffer();
+  if (m_compressed) {
+    auto timer = m_recorder.time_io();
+    m_compressed->finish();
+  } else {
+    m_file.close();
+    if (m_file.fail()) {
+      throw std::runtime_error("Could not write data to file");
+    }
+  }
+}
+
 template<char Delimiter>
 template<typename Arg0, typename... Args>
 inline void
 DsvWriter<Delimiter>::append(Arg0&& arg0, Args&&... args) {
-  // we can only check how many columns were written after they have been
-  // written. write to temporary first to prevent bad data on file.
-  std::stringstream line;
-  // ensure consistent formatting
-  line.precision(m_file.precision());
-  unsigned written_columns[] = {
-    // write the first item without a delimiter and store columns written
-    write(std::forward<Arg0>(arg0), line),
-    // for all other items, write the delimiter followed by the item itself
-    // (<expr1>, <expr2>) use the comma operator (yep, ',' in c++ is a weird
-    // but helpful operator) to execute both expression and return the return
-    // value of the last one, i.e. here thats the number of columns written.
-    // the ... pack expansion creates this expression for all arguments
-    (line << Delimiter, write(std::forward<Args>(args), line))...,
-  };
-  line << '\n';
-  // validate that the total number of written columns matches the specs.
-  unsigned total_columns = 0;
-  for (auto nc : written_columns) {
-    total_columns += nc;
+  {
+    auto timer = m_recorder.time_convert();
+    // we can only check how many columns were written after they have been
+    // written. remember the start of the row to remove bad data again.
+    std::size_t row_begin = m_buffer.size();
+    unsigned written_columns[] = {
+      // write the first item without a delimiter and store columns written
+      write(std::forward<Arg0>(arg0)),
+      // for all other items, write the delimiter followed by the item itself
+      // (<expr1>, <expr2>) use the comma operator (yep, ',' in c++ is a weird
+      // but helpful operator) to execute both expression and return the return
+      // value of the last one, i.e. here thats the number of columns written.
+      // the ... pack expansion creates this expression for all arguments
+      (m_buffer.push_back(Delimiter), write(std::forward<Args>(args)))...,
+    };
+    // validate that the total number of written columns matches the specs.
+    unsigned total_columns = 0;
+    for (auto nc : written_columns) {
+      total_columns += nc;
+    }
+    if (total_columns != m_num_columns) {
+      m_buffer.resize(row_begin);
+    }
+    if (total_columns < m_num_columns) {
+      throw std::invalid_argument("Not enough columns");
+    }
+    if (m_num_columns < total_columns) {
+      throw std::invalid_argument("Too many columns");
+    }
+    m_buffer.push_back('\n');
   }
-  if (total_columns < m_num_columns) {
-    throw std::invalid_argument("Not enough columns");
+  m_recorder.add_records(1);
+  m_recorder.update_buffer(m_buffer.size());
+  if (kBufferSize <= m_buffer.size()) {
+    write_buffer();
   }
-  if (m_num_columns < total_columns) {
-    throw std::invalid_argument("Too many columns");
+}
+
+template<char Delimiter>
+inline void
+DsvWriter<Delimiter>::flush() {
+  write_buffer();
+  // only flush the compression on request since it degrades the compression
+  // and blocks the zstd worker threads
+  if (m_compressed) {
+    auto timer = m_recorder.time_io();
+    m_compressed->flush();
+  }
+}
+
+template<char Delimiter>
+inline void
+DsvWriter<Delimiter>::write_buffer() {
+  {
+    auto timer = m_recorder.time_io();
+    // write the buffered rows to disk and check that it actually happened
+    if (m_compressed) {
+      m_compressed->write(m_buffer.data(), m_buffer.size());
+    } else {
+      m_file.write(m_buffer.data(), m_buffer.size());
+      m_file.flush();
+    }
   }
-  // write the line to disk and check that it actually happened
-  m_file << line.rdbuf();
+  m_recorder.add_bytes(m_buffer.size());
+  m_recorder.add_flush();
+  m_buffer.clear();
   if (not m_file.good()) {
     throw std::runtime_error("Could not write data to file");
   }
+  m_recorder.report();
 }
 
 template<char Delimiter>
@@ -319,22 +1132,21 @@ inline std::enable_if_t<
   std::is_arithmetic<std::decay_t<T>>::value
     or std::is_convertible<T, std::string>::value,
   unsigned>
-DsvWriter<Delimiter>::write(T&& x, std::ostream& os) {
-  os << x;
+DsvWriter<Delimiter>::write(T&& x) {
+  Formatter<std::decay_t<T>>::format(x, m_precision, m_buffer);
   return 1u;
 }
 
 template<char Delimiter>
 template<typename T, typename Allocator>
 inline unsigned
-DsvWriter<Delimiter>::write(
-  const std::vector<T, Allocator>& xs, std::ostream& os) {
+DsvWriter<Delimiter>::write(const std::vector<T, Allocator>& xs) {
   unsigned n = 0;
   for (const auto& x : xs) {
     if (0 < n) {
-      os << Delimiter;
+      m_buffer.push_back(Delimiter);
     }
-    os << x;
+    Formatter<std::decay_t<T>>::format(x, m_precision, m_buffer);
     n += 1;
   }
   return n;
@@ -343,37 +1155,142 @@ DsvWriter<Delimiter>::write(
 // implementation reader
 
 template<char Delimiter>
-inline DsvReader<Delimiter>::DsvReader(const std::string& path)
-  : m_file(path, std::ios_base::binary | std::ios_base::in) {
+inline DsvReader<Delimiter>::DsvReader(const std::string& path) {
+  using io_compression_impl::DecompressedInput;
+  using io_compression_impl::Format;
+  using io_compression_impl::format_from_magic;
+
+  MappedFile mapped;
+  if (mapped.map(path)) {
+    auto format = format_from_magic(mapped.data(), mapped.size());
+    if (format == Format::None) {
+      m_mapped = std::make_shared<const MappedFile>(std::move(mapped));
+      m_mapped_end = m_mapped->size();
+    } else {
+      m_decompressed = std::make_unique<DecompressedInput>(path, format);
+      m_buffer.resize(kBufferSize);
+    }
+    return;
+  }
+  // fall back to buffered reads, e.g. for empty files or pipes
+  m_file.open(path, std::ios_base::binary | std::ios_base::in);
   if (not m_file.is_open() or m_file.fail()) {
     throw std::runtime_error("Could not open file '" + path + "'");
   }
+  m_buffer.resize(kBufferSize);
+  // pipes can only be read once; detect the format from the first block
+  std::size_t n = read_file(m_buffer.data(), m_buffer.size());
+  auto format = format_from_magic(m_buffer.data(), n);
+  if (format == Format::None) {
+    m_buffer_end = n;
+    m_eof = (n < m_buffer.size());
+    m_recorder.add_bytes(n);
+    m_recorder.add_flush();
+    m_recorder.update_buffer(m_buffer.size());
+  } else {
+    m_decompressed = std::make_unique<DecompressedInput>(
+      std::move(m_file), m_buffer.data(), n, format);
+    m_file = std::ifstream();
+  }
+}
+
+template<char Delimiter>
+inline DsvReader<Delimiter>::DsvReader(
+  std::shared_ptr<const MappedFile> mapped, std::size_t begin,
+  std::size_t end)
+  : m_mapped(std::move(mapped)), m_mapped_pos(begin), m_mapped_end(end) {}
+
+template<char Delimiter>
+inline std::vector<DsvReader<Delimiter>>
+DsvReader<Delimiter>::split(std::size_t n) {
+  std::vector<DsvReader> readers;
+
+  if (not m_mapped) {
+    // only attempt to move if there is something left to read
+    if (m_file.is_open() or m_decompressed) {
+      readers.push_back(std::move(*this));
+      readers.back().m_num_lines = 0;
+      // reset the moved-from reader to a well-defined, exhausted state
+      m_file = std::ifstream();
+      m_decompressed.reset();
+      m_buffer.clear();
+      m_buffer_begin = 0;
+      m_buffer_end = 0;
+    }
+    return readers;
+  }
+
+  const char* data = m_mapped->data();
+  std::size_t begin = m_mapped_pos;
+  std::size_t total = m_mapped_end - m_mapped_pos;
+  n = std::max<std::size_t>(n, 1u);
+  for (std::size_t i = 1; i <= n; ++i) {
+    std::size_t end = m_mapped_end;
+    if (i < n) {
+      // boundary is the first line start at or after the nominal position
+      std::size_t search = std::max(begin, m_mapped_pos + (total * i) / n);
+      if (m_mapped_pos < search) {
+        search -= 1;
+      }
+      auto eol = static_cast<const char*>(
+        std::memchr(data + search, '\n', m_mapped_end - search));
+      end = eol ? ((eol + 1) - data) : m_mapped_end;
+    }
+    if (begin < end) {
+      readers.push_back(DsvReader(m_mapped, begin, end));
+    }
+    begin = end;
+  }
+  m_mapped_pos = m_mapped_end;
+  return readers;
+}
+
+template<char Delimiter>
+inline std::size_t
+DsvReader<Delimiter>::num_unread_bytes() const {
+  return m_mapped ? (m_mapped_end - m_mapped_pos) : 0u;
 }
 
 template<char Delimiter>
 inline bool
 DsvReader<Delimiter>::read(std::vector<std::string>& columns) {
-  // read the next line and check for both end-of-file and errors
-  std::getline(m_file, m_line);
-  if (m_file.eof()) {
+  if (not read(m_views)) {
     return false;
   }
-  if (m_file.fail()) {
-    throw std::runtime_error(
-      "Could not read line " + std::to_string(m_num_lines));
+  // reuse existing string storage where possible
+  columns.resize(m_views.size());
+  for (std::size_t i = 0; i < m_views.size(); ++i) {
+    columns[i].assign(m_views[i].data(), m_views[i].size());
+  }
+  return true;
+}
+
+template<char Delimiter>
+inline bool
+DsvReader<Delimiter>::read(std::vector<StringView>& columns) {
+  StringView line;
+  {
+    auto timer = m_recorder.time_io();
+    if (not read_line(line)) {
+      return false;
+    }
   }
   m_num_lines += 1;
+  m_recorder.add_records(1);
 
   // split the line into columns
+  auto timer = m_recorder.time_convert();
   columns.clear();
-  for (std::string::size_type pos = 0; pos < m_line.size();) {
-    auto del = m_line.find_first_of(Delimiter, pos);
-    if (del == std::string::npos) {
+  const char* pos = line.begin();
+  const char* end = line.end();
+  while (pos < end) {
+    auto del = static_cast<const char*>(std::memchr(pos, Delimiter, end - pos));
+    if (not del) {
       // reached the end of the line; also determines the last column
-      columns.emplace_back(m_line, pos);
+      columns.emplace_back(pos, end - pos);
       break;
     } else {
-      columns.emplace_back(m_line, pos, del - pos);
+      columns.emplace_back(pos, del - pos);
       // start next column search after the delimiter
       pos = del + 1;
     }
@@ -381,6 +1298,107 @@ DsvReader<Delimiter>::read(std::vector<std::string>& columns) {
   return true;
 }
 
+template<char Delimiter>
+inline bool
+DsvReader<Delimiter>::read_line(StringView& line) {
+  if (m_mapped) {
+    return read_line_mapped(line);
+  }
+  // the unmapped reader might have been moved into a split reader
+  if (not m_file.is_open() and not m_decompressed) {
+    return false;
+  }
+  return read_line_buffered(line);
+}
+
+template<char Delimiter>
+inline bool
+DsvReader<Delimiter>::read_line_mapped(StringView& line) {
+  const char* begin = m_mapped->data() + m_mapped_pos;
+  const char* end = m_mapped->data() + m_mapped_end;
+  if (end <= begin) {
+    return false;
+  }
+  auto eol = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+  if (not eol) {
+    // last line w/o a trailing newline
+    line = StringView(begin, end - begin);
+    m_mapped_pos = m_mapped_end;
+  } else {
+    line = StringView(begin, eol - begin);
+    m_mapped_pos = (eol + 1) - m_mapped->data();
+  }
+  m_recorder.add_bytes((m_mapped->data() + m_mapped_pos) - begin);
+  return true;
+}
+
+template<char Delimiter>
+inline bool
+DsvReader<Delimiter>::read_line_buffered(StringView& line) {
+  // number of already searched bytes to avoid rescanning after a refill
+  std::size_t searched = 0;
+  while (true) {
+    const char* begin = m_buffer.data() + m_buffer_begin;
+    const char* end = m_buffer.data() + m_buffer_end;
+    auto eol = static_cast<const char*>(
+      std::memchr(begin + searched, '\n', (end - begin) - searched));
+    if (eol) {
+      line = StringView(begin, eol - begin);
+      m_buffer_begin = (eol + 1) - m_buffer.data();
+      return true;
+    }
+    searched = end - begin;
+    if (m_eof) {
+      // last line w/o a trailing newline
+      if (begin < end) {
+        line = StringView(begin, end - begin);
+        m_buffer_begin = m_buffer_end;
+        return true;
+      }
+      return false;
+    }
+    // move the incomplete line to the front and refill the buffer
+    std::memmove(m_buffer.data(), begin, end - begin);
+    m_buffer_end -= m_buffer_begin;
+    m_buffer_begin = 0;
+    // line is longer than the whole buffer
+    if (m_buffer_end == m_buffer.size()) {
+      m_buffer.resize(2 * m_buffer.size());
+    }
+    m_buffer_end += read_block(
+      m_buffer.data() + m_buffer_end, m_buffer.size() - m_buffer_end);
+  }
+}
+
+// read directly from the uncompressed file
+template<char Delimiter>
+inline std::size_t
+DsvReader<Delimiter>::read_file(char* data, std::size_t size) {
+  m_file.read(data, size);
+  if (m_file.bad() or (m_file.fail() and not m_file.eof())) {
+    throw std::runtime_error(
+      "Could not read line " + std::to_string(m_num_lines));
+  }
+  return static_cast<std::size_t>(m_file.gcount());
+}
+
+// read the next block from the file, sets eof if it is incomplete
+template<char Delimiter>
+inline std::size_t
+DsvReader<Delimiter>::read_block(char* data, std::size_t size) {
+  std::size_t n = 0;
+  if (m_decompressed) {
+    n = m_decompressed->read(data, size);
+  } else {
+    n = read_file(data, size);
+  }
+  m_eof = (n < size);
+  m_recorder.add_bytes(n);
+  m_recorder.add_flush();
+  m_recorder.update_buffer(m_buffer.size());
+  return n;
+}
+
 // implementation named tuple reader
 
 template<char Delimiter, typename NamedTuple>
@@ -404,9 +1422,65 @@ inline NamedTupleDsvReader<Delimiter, NamedTuple>::NamedTupleDsvReader(
   }
 }
 
+template<char Delimiter, typename NamedTuple>
+inline NamedTupleDsvReader<Delimiter, NamedTuple>::NamedTupleDsvReader(
+  DsvReader<Delimiter>&& reader, const NamedTupleDsvReader& other)
+  : m_reader(std::move(reader))
+  , m_num_header_lines(0)
+  , m_num_columns(other.m_num_columns)
+  , m_tuple_column_map(other.m_tuple_column_map)
+  , m_extra_columns(other.m_extra_columns) {}
+
+template<char Delimiter, typename NamedTuple>
+inline std::vector<NamedTupleDsvReader<Delimiter, NamedTuple>>
+NamedTupleDsvReader<Delimiter, NamedTuple>::split(std::size_t n) {
+  std::vector<NamedTupleDsvReader> readers;
+  for (auto& reader : m_reader.split(n)) {
+    readers.push_back(NamedTupleDsvReader(std::move(reader), *this));
+  }
+  return readers;
+}
+
 template<char Delimiter, typename NamedTuple>
 inline bool
 NamedTupleDsvReader<Delimiter, NamedTuple>::read(NamedTuple& record) {
+  if (not read_columns()) {
+    return false;
+  }
+  // convert to tuple
+  auto timer = m_reader.m_recorder.time_convert();
+  parse_record(
+    record, std::make_index_sequence<std::tuple_size<Tuple>::value>{});
+  return true;
+}
+
+template<char Delimiter, typename NamedTuple>
+inline std::size_t
+NamedTupleDsvReader<Delimiter, NamedTuple>::read_batch(
+  std::size_t n, NamedTupleColumns<NamedTuple>& columns) {
+  columns.clear();
+  std::size_t i = 0;
+  for (; (i < n) and read_columns(); ++i) {
+    auto timer = m_reader.m_recorder.time_convert();
+    parse_columns(
+      columns, std::make_index_sequence<std::tuple_size<Tuple>::value>{});
+  }
+  return i;
+}
+
+template<char Delimiter, typename NamedTuple>
+inline NamedTupleColumns<NamedTuple>
+NamedTupleDsvReader<Delimiter, NamedTuple>::read_batch(std::size_t n) {
+  NamedTupleColumns<NamedTuple> columns;
+  columns.reserve(n);
+  read_batch(n, columns);
+  return columns;
+}
+
+// read the next line into the column buffer and check its consistency
+template<char Delimiter, typename NamedTuple>
+inline bool
+NamedTupleDsvReader<Delimiter, NamedTuple>::read_columns() {
   if (not m_reader.read(m_columns)) {
     return false;
   }
@@ -419,9 +1493,6 @@ NamedTupleDsvReader<Delimiter, NamedTuple>::read(NamedTuple& record) {
     throw std::runtime_error(
       "Too many columns in line " + std::to_string(m_reader.num_lines()));
   }
-  // convert to tuple
-  parse_record(
-    record, std::make_index_sequence<std::tuple_size<Tuple>::value>{});
   return true;
 }
 
@@ -435,6 +1506,7 @@ NamedTupleDsvReader<Delimiter, NamedTuple>::read(
     return false;
   }
   // parse extra columns
+  auto timer = m_reader.m_recorder.time_convert();
   extra.resize(m_extra_columns.size());
   for (std::size_t i = 0; i < m_extra_columns.size(); ++i) {
     parse(m_columns[m_extra_columns[i]], extra[i]);
@@ -458,7 +1530,12 @@ template<char Delimiter, typename NamedTuple>
 inline void
 NamedTupleDsvReader<Delimiter, NamedTuple>::parse_header(
   const std::vector<std::string>& optional_columns) {
-  const auto& names = NamedTuple::names();
+  // compare the member names against the header w/o allocations
+  std::array<StringView, std::tuple_size<Tuple>::value> names;
+  for (std::size_t i = 0; i < names.size(); ++i) {
+    auto field = NamedTuple::field_names()[i];
+    names[i] = StringView(field.data(), field.size());
+  }
 
   // the number of header columns fixes the expected number of data columns
   m_num_columns = m_columns.size();
@@ -473,7 +1550,8 @@ NamedTupleDsvReader<Delimiter, NamedTuple>::parse_header(
     // missing, non-optional column mean we can not continue
     auto c = std::find(m_columns.begin(), m_columns.end(), name);
     if (c == m_columns.end()) {
-      throw std::runtime_error("Missing header column '" + name + "'");
+      throw std::runtime_error(
+        "Missing header column '" + name.to_string() + "'");
     }
   }
 
@@ -495,6 +1573,123 @@ NamedTupleDsvReader<Delimiter, NamedTuple>::parse_header(
   }
 }
 
+// implementation parallel named tuple reader
+
+template<char Delimiter, typename NamedTuple>
+inline NamedTupleDsvParallelReader<Delimiter, NamedTuple>::
+  NamedTupleDsvParallelReader(
+    const std::string& path, std::size_t num_threads,
+    const std::vector<std::string>& optional_columns, bool verify_header) {
+  Reader reader(path, optional_columns, verify_header);
+  m_num_extra_columns = reader.num_extra_columns();
+  m_tuple_column_map = reader.m_tuple_column_map;
+
+  if (num_threads == 0) {
+    num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  // use more chunks than threads to balance the load
+  auto num_chunks = std::max<std::size_t>(
+    4u * num_threads, reader.num_unread_bytes() / kChunkSize);
+  m_readers = reader.split(num_chunks);
+  num_threads = std::min(num_threads, m_readers.size());
+  m_chunks.resize(2u * num_threads);
+  for (std::size_t i = 0; i < num_threads; ++i) {
+    m_workers.emplace_back([this]() { work(); });
+  }
+}
+
+template<char Delimiter, typename NamedTuple>
+inline NamedTupleDsvParallelReader<Delimiter, NamedTuple>::
+  ~NamedTupleDsvParallelReader() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_consumed.notify_all();
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+template<char Delimiter, typename NamedTuple>
+inline bool
+NamedTupleDsvParallelReader<Delimiter, NamedTuple>::read(NamedTuple& record) {
+  // move to the next non-empty chunk if the current one is exhausted
+  while (m_current.size() <= m_current_pos) {
+    // deliver the records before the bad line first, as the serial reader
+    if (m_error) {
+      std::rethrow_exception(std::exchange(m_error, nullptr));
+    }
+    if (m_readers.size() <= m_next_consume) {
+      return false;
+    }
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      auto& chunk = m_chunks[m_next_consume % m_chunks.size()];
+      m_parsed.wait(lock, [&]() { return chunk.is_ready; });
+      // keep the previous buffer to reuse its allocated memory
+      std::swap(m_current, chunk.records);
+      m_error = chunk.error;
+      chunk.records.clear();
+      chunk.error = nullptr;
+      chunk.is_ready = false;
+      m_next_consume += 1;
+    }
+    m_consumed.notify_all();
+    m_current_pos = 0;
+  }
+  // only set elements w/ existing columns to be consistent w/ the serial reader
+  assign_record(
+    record, std::move(m_current[m_current_pos]),
+    std::make_index_sequence<
+      std::tuple_size<typename NamedTuple::Tuple>::value>{});
+  m_current_pos += 1;
+  m_num_records += 1;
+  return true;
+}
+
+template<char Delimiter, typename NamedTuple>
+inline void
+NamedTupleDsvParallelReader<Delimiter, NamedTuple>::work() {
+  std::vector<NamedTuple> records;
+
+  while (true) {
+    std::size_t index;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      // only parse if a free slot is available in the ring buffer
+      m_consumed.wait(lock, [&]() {
+        return m_stop or (m_readers.size() <= m_next_parse)
+               or (m_next_parse < (m_next_consume + m_chunks.size()));
+      });
+      if (m_stop or (m_readers.size() <= m_next_parse)) {
+        return;
+      }
+      index = m_next_parse++;
+      // reuse memory from previously consumed chunks
+      std::swap(records, m_chunks[index % m_chunks.size()].records);
+    }
+    std::exception_ptr error;
+    records.clear();
+    try {
+      NamedTuple record;
+      while (m_readers[index].read(record)) {
+        records.push_back(record);
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto& chunk = m_chunks[index % m_chunks.size()];
+      std::swap(chunk.records, records);
+      chunk.error = error;
+      chunk.is_ready = true;
+    }
+    m_parsed.notify_all();
+  }
+}
+
 } // namespace io_dsv_impl
 
 /// Write arbitrary data as comma-separated values into as text file.
@@ -511,6 +1706,11 @@ using NamedTupleCsvWriter = io_dsv_impl::NamedTupleDsvWriter<',', T>;
 template<typename T>
 using NamedTupleCsvReader = io_dsv_impl::NamedTupleDsvReader<',', T>;
 
+/// Read tuple-like records from a comma-separated file w/ multiple threads.
+template<typename T>
+using NamedTupleCsvParallelReader =
+  io_dsv_impl::NamedTupleDsvParallelReader<',', T>;
+
 /// Write tuple-like records as tab-separated values into a text file.
 template<typename T>
 using NamedTupleTsvWriter = io_dsv_impl::NamedTupleDsvWriter<'\t', T>;
@@ -519,4 +1719,9 @@ using NamedTupleTsvWriter = io_dsv_impl::NamedTupleDsvWriter<'\t', T>;
 template<typename T>
 using NamedTupleTsvReader = io_dsv_impl::NamedTupleDsvReader<'\t', T>;
 
+/// Read tuple-like records from a tab-separated file w/ multiple threads.
+template<typename T>
+using NamedTupleTsvParallelReader =
+  io_dsv_impl::NamedTupleDsvParallelReader<'\t', T>;
+
 } // namespace dfe
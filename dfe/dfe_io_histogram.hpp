@@ -0,0 +1,334 @@
+// SPDX-License-Identifier: MIT
+// Copyright 2020 Moritz Kiehn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/// \file
+/// \brief   Write and merge histograms as numpy .npy files
+/// \author  Moritz Kiehn <msmk@cern.ch>
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "dfe_histogram.hpp"
+#include "dfe_io_mmap.hpp"
+#include "dfe_io_numpy.hpp"
+
+namespace dfe {
+
+/// Write the histogram content and the axis edges to numpy .npy files.
+///
+/// \param prefix Path prefix for the written files
+/// \param h      Histogram to write
+///
+/// The content is written to `<prefix>.npy` as an n-dimensional array in
+/// Fortran order including the under/overflow bins of the axes. The edges of
+/// the data bins along axis i are written to `<prefix>.axis<i>.npy`. Dense
+/// storage of arithmetic types is written as a single contiguous block.
+template<typename T, typename... Axes>
+void write_histogram_npy(
+  const std::string& prefix, const Histogram<T, Axes...>& h);
+
+/// Add the content of histogram .npy files to a histogram.
+///
+/// \param prefix Path prefix of the files written by `write_histogram_npy`
+/// \param h      Histogram that receives the stored content
+///
+/// The stored content must have the same weight type and shape and the stored
+/// edges must be identical to the edges of the histogram axes. Files are
+/// memory-mapped if possible. This allows to efficiently merge histograms
+/// that were filled by separate jobs.
+template<typename T, typename... Axes>
+void add_histogram_npy(const std::string& prefix, Histogram<T, Axes...>& h);
+
+// implementation helpers
+namespace io_histogram_impl {
+
+inline std::string
+content_path(const std::string& prefix) {
+  return prefix + ".npy";
+}
+inline std::string
+axis_path(const std::string& prefix, std::size_t i) {
+  return prefix + ".axis" + std::to_string(i) + ".npy";
+}
+
+template<typename T>
+inline std::string
+dtype_descr() {
+  std::string descr;
+  descr += '\'';
+  descr += io_npy_impl::dtype_endianness_modifier();
+  descr += io_npy_impl::kNumpyDtypeCode<T>;
+  descr += '\'';
+  return descr;
+}
+
+// Whether the storage holds the weights in one contiguous native block.
+template<typename Storage, typename Weight>
+struct IsContiguous : std::false_type {};
+template<typename T, std::size_t NDimensions, typename Allocator>
+struct IsContiguous<histogram_impl::NArray<T, NDimensions, Allocator>, T>
+  : std::is_arithmetic<T> {};
+
+// Convert a linear column-major index into an n-dimensional index.
+template<std::size_t NDimensions>
+inline std::array<std::size_t, NDimensions>
+unravel(std::size_t linear, const std::array<std::size_t, NDimensions>& size) {
+  std::array<std::size_t, NDimensions> idx;
+  for (std::size_t i = 0; i < NDimensions; ++i) {
+    idx[i] = linear % size[i];
+    linear /= size[i];
+  }
+  return idx;
+}
+
+inline std::ofstream
+open_output(const std::string& path) {
+  std::ofstream file;
+  // make our life easier. always throw on error
+  file.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+  file.open(
+    path, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+  return file;
+}
+
+inline void
+write_header(
+  std::ofstream& file, const std::string& descr,
+  const std::vector<std::size_t>& shape) {
+  auto header = io_npy_impl::make_header(descr, shape, true, 0);
+  file.write(header.data(), header.size());
+}
+
+// Write the storage content as a single block.
+template<typename Storage, typename Weight>
+inline void
+write_content(std::ofstream& file, const Storage& data, std::true_type) {
+  auto n = histogram_impl::total_size(data.size());
+  file.write(
+    reinterpret_cast<const char*>(data.data()),
+    static_cast<std::streamsize>(n * sizeof(Weight)));
+}
+
+// Write the storage content element-wise via an intermediate buffer.
+template<typename Storage, typename Weight>
+inline void
+write_content(std::ofstream& file, const Storage& data, std::false_type) {
+  constexpr std::size_t kBlockSize = 4096;
+  auto n = histogram_impl::total_size(data.size());
+  std::vector<Weight> block;
+  block.reserve(kBlockSize);
+  for (std::size_t i = 0; i < n; ++i) {
+    block.push_back(static_cast<Weight>(data.at(unravel(i, data.size()))));
+    if ((block.size() == kBlockSize) or ((i + 1) == n)) {
+      file.write(
+        reinterpret_cast<const char*>(block.data()),
+        static_cast<std::streamsize>(block.size() * sizeof(Weight)));
+      block.clear();
+    }
+  }
+}
+
+template<typename Axis>
+inline void
+write_axis(const std::string& path, const Axis& axis) {
+  using Value = typename Axis::Value;
+  const auto& edges = axis.edges();
+  auto file = open_output(path);
+  write_header(file, dtype_descr<Value>(), {edges.size()});
+  file.write(
+    reinterpret_cast<const char*>(edges.data()),
+    static_cast<std::streamsize>(edges.size() * sizeof(Value)));
+}
+
+// A plain numeric array loaded from a .npy file.
+template<typename T>
+class NumpyArray {
+public:
+  explicit NumpyArray(const std::string& path);
+
+  const std::vector<std::size_t>& shape() const { return m_header.shape; }
+  std::size_t size() const { return m_size; }
+  /// Read-only access element without boundary check.
+  T operator[](std::size_t i) const;
+
+private:
+  MappedFile m_mapped;
+  std::vector<char> m_contents;
+  io_npy_impl::Header m_header;
+  const char* m_data = nullptr;
+  std::size_t m_size = 0;
+  bool m_swap = false;
+};
+
+template<typename T>
+inline NumpyArray<T>::NumpyArray(const std::string& path) {
+  const char* data = nullptr;
+  std::size_t size = 0;
+  if (m_mapped.map(path, MappedFile::Access::Sequential)) {
+    data = m_mapped.data();
+    size = m_mapped.size();
+  } else {
+    // fall back to reading the whole file into memory
+    std::ifstream file(path, std::ios_base::binary | std::ios_base::in);
+    if (not file.is_open() or file.fail()) {
+      throw std::runtime_error("Could not open file '" + path + "'");
+    }
+    m_contents.assign(
+      std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data = m_contents.data();
+    size = m_contents.size();
+  }
+
+  m_header = io_npy_impl::read_header(data, size);
+  if ((m_header.fields.size() != 1) or not m_header.fields[0].first.empty()
+      or not io_npy_impl::check_dtype<T>(m_header.fields[0].second, m_swap)) {
+    throw std::runtime_error(
+      "Incompatible npy dtype in '" + path + "', expected " +
+      dtype_descr<T>());
+  }
+  if ((1 < m_header.shape.size()) and not m_header.fortran_order) {
+    throw std::runtime_error(
+      "Only Fortran-ordered npy arrays are supported in '" + path + "'");
+  }
+  m_size = 1;
+  for (auto n : m_header.shape) {
+    m_size *= n;
+  }
+  if (((size - m_header.data_offset) / sizeof(T)) < m_size) {
+    throw std::runtime_error("Truncated npy data in '" + path + "'");
+  }
+  m_data = data + m_header.data_offset;
+}
+
+template<typename T>
+inline T
+NumpyArray<T>::operator[](std::size_t i) const {
+  T value;
+  std::memcpy(&value, m_data + i * sizeof(T), sizeof(T));
+  if (m_swap) {
+    io_npy_impl::swap_bytes(value);
+  }
+  return value;
+}
+
+template<typename Axis>
+inline void
+check_axis(const std::string& path, const Axis& axis) {
+  NumpyArray<typename Axis::Value> stored(path);
+  const auto& edges = axis.edges();
+  bool is_equal =
+    (stored.shape().size() == 1) and (stored.size() == edges.size());
+  for (std::size_t i = 0; is_equal and (i < edges.size()); ++i) {
+    is_equal = (stored[i] == edges[i]);
+  }
+  if (not is_equal) {
+    throw std::runtime_error("Incompatible histogram axis in '" + path + "'");
+  }
+}
+
+template<typename T, typename... Axes, std::size_t... Is>
+inline void
+write_axes(
+  const std::string& prefix, const Histogram<T, Axes...>& h,
+  std::index_sequence<Is...>) {
+  // see namedtuple_impl::print_tuple for explanation
+  using Vacuum = int[];
+  (void)Vacuum{
+    (write_axis(axis_path(prefix, Is), h.template axis<Is>()), 0)...};
+}
+
+template<typename T, typename... Axes, std::size_t... Is>
+inline void
+check_axes(
+  const std::string& prefix, const Histogram<T, Axes...>& h,
+  std::index_sequence<Is...>) {
+  // see namedtuple_impl::print_tuple for explanation
+  using Vacuum = int[];
+  (void)Vacuum{
+    (check_axis(axis_path(prefix, Is), h.template axis<Is>()), 0)...};
+}
+
+} // namespace io_histogram_impl
+
+// implementation
+
+template<typename T, typename... Axes>
+inline void
+write_histogram_npy(
+  const std::string& prefix, const Histogram<T, Axes...>& h) {
+  using Data = typename Histogram<T, Axes...>::Data;
+  using Weight = typename Histogram<T, Axes...>::Weight;
+  using namespace io_histogram_impl;
+
+  const auto& size = h.data().size();
+  auto file = open_output(content_path(prefix));
+  write_header(
+    file, dtype_descr<Weight>(),
+    std::vector<std::size_t>(size.begin(), size.end()));
+  write_content<Data, Weight>(file, h.data(), IsContiguous<Data, Weight>());
+  write_axes(prefix, h, std::index_sequence_for<Axes...>());
+}
+
+template<typename T, typename... Axes>
+inline void
+add_histogram_npy(const std::string& prefix, Histogram<T, Axes...>& h) {
+  using Weight = typename Histogram<T, Axes...>::Weight;
+  using namespace io_histogram_impl;
+  constexpr std::size_t kBlockSize = 4096;
+
+  // check everything before modifying the histogram
+  check_axes(prefix, h, std::index_sequence_for<Axes...>());
+  auto path = content_path(prefix);
+  NumpyArray<Weight> stored(path);
+  const auto& size = h.data().size();
+  if (stored.shape() != std::vector<std::size_t>(size.begin(), size.end())) {
+    throw std::runtime_error("Incompatible histogram shape in '" + path + "'");
+  }
+  // add non-empty bins in blocks
+  std::size_t linear[kBlockSize];
+  Weight weights[kBlockSize];
+  for (std::size_t begin = 0; begin < stored.size(); begin += kBlockSize) {
+    std::size_t end = std::min(begin + kBlockSize, stored.size());
+    std::size_t n = 0;
+    for (std::size_t i = begin; i < end; ++i) {
+      Weight weight = stored[i];
+      if (weight != static_cast<Weight>(0)) {
+        linear[n] = i;
+        weights[n] = weight;
+        n += 1;
+      }
+    }
+    h.data().add_n(linear, n, weights);
+  }
+}
+
+} // namespace dfe
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: MIT
+// Copyright 2020 Moritz Kiehn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/// \file
+/// \brief   Read-only memory-mapped files shared by the i/o libraries
+/// \author  Moritz Kiehn <msmk@cern.ch>
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define DFE_USE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dfe {
+
+/// Read-only memory mapping of a complete file.
+class MappedFile {
+public:
+  /// Access pattern hint for the mapped memory.
+  enum class Access { Sequential, Random };
+
+  MappedFile() = default;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+  ~MappedFile() { unmap(); }
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  /// Map the file at the given path.
+  ///
+  /// \returns true   if the file was successfully mapped
+  /// \returns false  if the file can not be mapped, e.g. it is not a regular
+  ///                 or a non-empty file or memory-mapping is not supported.
+  bool map(const std::string& path, Access access = Access::Sequential);
+  /// Return true if a file is currently mapped.
+  bool is_mapped() const { return (m_data != nullptr); }
+  /// Return the mapped file content.
+  const char* data() const { return m_data; }
+  /// Return the size of the mapped file content.
+  std::size_t size() const { return m_size; }
+
+private:
+  void unmap();
+
+  const char* m_data = nullptr;
+  std::size_t m_size = 0;
+};
+
+// implementation
+
+inline MappedFile&
+MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    unmap();
+    m_data = other.m_data;
+    m_size = other.m_size;
+    other.m_data = nullptr;
+    other.m_size = 0;
+  }
+  return *this;
+}
+
+inline bool
+MappedFile::map(const std::string& path, Access access) {
+  unmap();
+#ifdef DFE_USE_MMAP
+  struct stat info;
+  // do not open special files, e.g. named pipes, that can only be read once
+  if ((::stat(path.c_str(), &info) != 0) or (not S_ISREG(info.st_mode))) {
+    return false;
+  }
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  // only regular, non-empty files can be mapped
+  if ((::fstat(fd, &info) != 0) or (not S_ISREG(info.st_mode))
+      or (info.st_size <= 0)) {
+    ::close(fd);
+    return false;
+  }
+  auto size = static_cast<std::size_t>(info.st_size);
+  void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping stays valid after the file descriptor is closed
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    return false;
+  }
+  // allow the kernel to optimize read-ahead for the expected access pattern
+  (void)::madvise(
+    addr, size,
+    (access == Access::Sequential) ? MADV_SEQUENTIAL : MADV_RANDOM);
+  m_data = static_cast<const char*>(addr);
+  m_size = size;
+  return true;
+#else
+  (void)path;
+  (void)access;
+  return false;
+#endif
+}
+
+inline void
+MappedFile::unmap() {
+#ifdef DFE_USE_MMAP
+  if (m_data) {
+    ::munmap(const_cast<char*>(m_data), m_size);
+  }
+#endif
+  m_data = nullptr;
+  m_size = 0;
+}
+
+} // namespace dfe
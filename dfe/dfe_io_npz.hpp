@@ -0,0 +1,566 @@
+// SPDX-License-Identifier: MIT
+// Copyright 2015,2018-2019 Moritz Kiehn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/// \file
+/// \brief   Write numpy-compatible .npz archives w/ one array per column
+/// \author  Moritz Kiehn <msmk@cern.ch>
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+#include "dfe_io_numpy.hpp"
+#include "dfe_threadpool.hpp"
+
+namespace dfe {
+namespace io_npz_impl {
+
+// Encoded array data that can be concatenated w/ other blocks.
+struct Block {
+  std::vector<char> data;
+  uLong crc = 0;
+  // size of the data before compression
+  std::size_t size = 0;
+};
+
+// Staging area for the content of a single array.
+struct Column {
+  std::string name;
+  std::string descr;
+  // values that have not yet been encoded
+  std::vector<char> buffer;
+  // blocks that are still being encoded, in order
+  std::deque<std::future<Block>> pending;
+  // encoded blocks are stored in a temporary file until the archive is written
+  std::unique_ptr<std::FILE, int (*)(std::FILE*)> spill{nullptr, &std::fclose};
+  uLong crc = 0;
+  std::uint64_t size = 0;
+  std::uint64_t encoded_size = 0;
+};
+
+// Zip archive entry information.
+struct Entry {
+  std::string name;
+  std::uint16_t method = 0;
+  std::uint32_t crc = 0;
+  std::uint64_t compressed_size = 0;
+  std::uint64_t size = 0;
+  std::uint64_t offset = 0;
+};
+
+} // namespace io_npz_impl
+
+/// Write records into a NumPy-compatible `.npz` archive.
+///
+/// Each element of the named tuple is stored as a separate one-dimensional
+/// array named after the element, e.g. `numpy.load(path)['x']`. Arrays are
+/// optionally deflate-compressed on a pool of background threads while
+/// records are still being appended. Encoded data is kept in temporary files
+/// and the archive is assembled when the writer is closed.
+template<typename NamedTuple>
+class NamedTupleNpzWriter {
+public:
+  NamedTupleNpzWriter() = delete;
+  NamedTupleNpzWriter(const NamedTupleNpzWriter&) = delete;
+  NamedTupleNpzWriter(NamedTupleNpzWriter&&) = default;
+  ~NamedTupleNpzWriter();
+  NamedTupleNpzWriter& operator=(const NamedTupleNpzWriter&) = delete;
+  /// Write the archive of this writer before taking over the other one.
+  NamedTupleNpzWriter& operator=(NamedTupleNpzWriter&& other);
+
+  /// Create a npz archive at the given path. Overwrites existing data.
+  ///
+  /// \param path         Path to the output file
+  /// \param compress     Deflate-compress the arrays
+  /// \param num_threads  Number of compression threads, 0 for automatic
+  NamedTupleNpzWriter(
+    const std::string& path, bool compress = true, std::size_t num_threads = 0);
+
+  /// Append a record to the end of the arrays.
+  void append(const NamedTuple& record);
+  /// Finish encoding and write the archive.
+  ///
+  /// Called automatically by the destructor, but errors can only be
+  /// reported when it is called explicitly.
+  void close();
+
+private:
+  // the equivalent std::tuple-like type
+  using Tuple = typename NamedTuple::Tuple;
+
+  static constexpr std::size_t kNumFields = std::tuple_size<Tuple>::value;
+  // uncompressed size of the blocks that are encoded independently
+  static constexpr std::size_t kBlockSize = 1 << 20;
+
+  std::ofstream m_file;
+  bool m_compress;
+  // maximum number of blocks per column that are encoded simultaneously
+  std::size_t m_max_pending;
+  std::size_t m_num_records;
+  std::vector<io_npz_impl::Column> m_columns;
+  // only available while the writer is open
+  std::unique_ptr<threadpool_impl::ThreadPool> m_pool;
+
+  template<std::size_t... I>
+  void append_values(const NamedTuple& record, std::index_sequence<I...>);
+  template<typename T>
+  void append_value(io_npz_impl::Column& column, const T& value);
+  void submit(io_npz_impl::Column& column);
+  void retire(io_npz_impl::Column& column, bool wait);
+  void write_archive();
+};
+
+// implementation helpers
+namespace io_npz_impl {
+
+// Combine the CRCs of two consecutive byte ranges w/ a 64bit length.
+//
+// `z_off_t` might only have 32bit, e.g. on Windows, and `crc32_combine64` is
+// only declared if zlib is configured for large files. Otherwise, combine in
+// steps that fit into `z_off_t`; appending zeros is equivalent to shifting.
+inline uLong
+crc32_combine_u64(uLong crc1, uLong crc2, std::uint64_t size2) {
+#if defined(Z_LARGE64) || defined(Z_WANT64)
+  return crc32_combine64(crc1, crc2, static_cast<z_off64_t>(size2));
+#else
+  const std::uint64_t step = std::min<std::uint64_t>(
+    std::numeric_limits<z_off_t>::max(), UINT64_C(1) << 30);
+  for (; step < size2; size2 -= step) {
+    crc1 = crc32_combine(crc1, 0, static_cast<z_off_t>(step));
+  }
+  return crc32_combine(crc1, crc2, static_cast<z_off_t>(size2));
+#endif
+}
+
+// Blocks are compressed as independent raw deflate streams that end w/ a
+// sync flush except for the last one. Their concatenation forms a single
+// valid deflate stream.
+inline Block
+encode_block(const char* data, std::size_t size, bool compress, bool last) {
+  auto bytes = reinterpret_cast<const Bytef*>(data);
+  Block block;
+  block.size = size;
+  block.crc = crc32(crc32(0, Z_NULL, 0), bytes, static_cast<uInt>(size));
+  if (not compress) {
+    block.data.assign(data, data + size);
+    return block;
+  }
+
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  // negative window bits create raw deflate data as required in zip archives
+  if (
+    deflateInit2(
+      &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+      Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw std::runtime_error("Could not initialize compression");
+  }
+  // the bound does not include the sync flush marker
+  block.data.resize(deflateBound(&stream, static_cast<uLong>(size)) + 16);
+  stream.next_in = const_cast<Bytef*>(bytes);
+  stream.avail_in = static_cast<uInt>(size);
+  stream.next_out = reinterpret_cast<Bytef*>(block.data.data());
+  stream.avail_out = static_cast<uInt>(block.data.size());
+  int ret = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+  // unfinished streams are expected to report an error here
+  deflateEnd(&stream);
+  if ((ret != (last ? Z_STREAM_END : Z_OK)) or (stream.avail_in != 0)) {
+    throw std::runtime_error("Could not compress data");
+  }
+  block.data.resize(stream.total_out);
+  return block;
+}
+
+inline void
+write_block(Column& column, Block&& block) {
+  if (not column.spill) {
+    column.spill.reset(std::tmpfile());
+    if (not column.spill) {
+      throw std::runtime_error("Could not create temporary file");
+    }
+  }
+  if (
+    std::fwrite(block.data.data(), 1, block.data.size(), column.spill.get()) !=
+    block.data.size()) {
+    throw std::runtime_error("Could not write temporary file");
+  }
+  column.crc = crc32_combine_u64(column.crc, block.crc, block.size);
+  column.size += block.size;
+  column.encoded_size += block.data.size();
+}
+
+// Little-endian encoding of unsigned integers.
+template<typename T>
+inline void
+put(std::string& out, T value) {
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    out += static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+constexpr std::uint32_t kZip64Marker = 0xFFFFFFFF;
+
+// Entries exceeding 4GiB require the zip64 extension.
+inline bool
+needs_zip64(std::uint64_t value) {
+  return (kZip64Marker <= value);
+}
+
+inline std::uint32_t
+zip32(std::uint64_t value) {
+  return needs_zip64(value) ? kZip64Marker : static_cast<std::uint32_t>(value);
+}
+
+inline std::string
+local_header(const Entry& entry) {
+  bool zip64 = needs_zip64(entry.size) or needs_zip64(entry.compressed_size);
+  std::string header;
+  put<std::uint32_t>(header, 0x04034b50);
+  // version needed to extract
+  put<std::uint16_t>(header, zip64 ? 45 : 20);
+  // flags
+  put<std::uint16_t>(header, 0);
+  put<std::uint16_t>(header, entry.method);
+  // modification time and date, fixed to 1980-01-01 for reproducibility
+  put<std::uint16_t>(header, 0);
+  put<std::uint16_t>(header, (1 << 5) | 1);
+  put<std::uint32_t>(header, entry.crc);
+  // sizes are stored in the extra field for zip64 entries
+  put<std::uint32_t>(
+    header, zip64 ? kZip64Marker : zip32(entry.compressed_size));
+  put<std::uint32_t>(header, zip64 ? kZip64Marker : zip32(entry.size));
+  put<std::uint16_t>(header, static_cast<std::uint16_t>(entry.name.size()));
+  put<std::uint16_t>(header, zip64 ? 20 : 0);
+  header += entry.name;
+  if (zip64) {
+    // the local zip64 extra field must contain both sizes
+    put<std::uint16_t>(header, 0x0001);
+    put<std::uint16_t>(header, 16);
+    put<std::uint64_t>(header, entry.size);
+    put<std::uint64_t>(header, entry.compressed_size);
+  }
+  return header;
+}
+
+inline std::string
+central_header(const Entry& entry) {
+  std::string extra;
+  if (needs_zip64(entry.size)) {
+    put<std::uint64_t>(extra, entry.size);
+  }
+  if (needs_zip64(entry.compressed_size)) {
+    put<std::uint64_t>(extra, entry.compressed_size);
+  }
+  if (needs_zip64(entry.offset)) {
+    put<std::uint64_t>(extra, entry.offset);
+  }
+  std::string header;
+  put<std::uint32_t>(header, 0x02014b50);
+  // version made by and version needed to extract
+  put<std::uint16_t>(header, 45);
+  put<std::uint16_t>(header, extra.empty() ? 20 : 45);
+  // flags
+  put<std::uint16_t>(header, 0);
+  put<std::uint16_t>(header, entry.method);
+  // modification time and date, see local header
+  put<std::uint16_t>(header, 0);
+  put<std::uint16_t>(header, (1 << 5) | 1);
+  put<std::uint32_t>(header, entry.crc);
+  put<std::uint32_t>(header, zip32(entry.compressed_size));
+  put<std::uint32_t>(header, zip32(entry.size));
+  put<std::uint16_t>(header, static_cast<std::uint16_t>(entry.name.size()));
+  put<std::uint16_t>(
+    header, static_cast<std::uint16_t>(extra.empty() ? 0 : (4 + extra.size())));
+  // comment length, disk number, internal and external attributes
+  put<std::uint16_t>(header, 0);
+  put<std::uint16_t>(header, 0);
+  put<std::uint16_t>(header, 0);
+  put<std::uint32_t>(header, 0);
+  put<std::uint32_t>(header, zip32(entry.offset));
+  header += entry.name;
+  if (not extra.empty()) {
+    put<std::uint16_t>(header, 0x0001);
+    put<std::uint16_t>(header, static_cast<std::uint16_t>(extra.size()));
+    header += extra;
+  }
+  return header;
+}
+
+inline std::string
+end_of_central_directory(
+  std::uint64_t num_entries, std::uint64_t offset, std::uint64_t size) {
+  bool zip64 = (0xFFFF <= num_entries) or needs_zip64(offset)
+               or needs_zip64(size);
+  std::string record;
+  if (zip64) {
+    // zip64 end of central directory record
+    put<std::uint32_t>(record, 0x06064b50);
+    put<std::uint64_t>(record, 44);
+    put<std::uint16_t>(record, 45);
+    put<std::uint16_t>(record, 45);
+    put<std::uint32_t>(record, 0);
+    put<std::uint32_t>(record, 0);
+    put<std::uint64_t>(record, num_entries);
+    put<std::uint64_t>(record, num_entries);
+    put<std::uint64_t>(record, size);
+    put<std::uint64_t>(record, offset);
+    // zip64 end of central directory locator
+    put<std::uint32_t>(record, 0x07064b50);
+    put<std::uint32_t>(record, 0);
+    put<std::uint64_t>(record, offset + size);
+    put<std::uint32_t>(record, 1);
+  }
+  auto entries16 = static_cast<std::uint16_t>(
+    zip64 ? 0xFFFF : static_cast<std::uint16_t>(num_entries));
+  put<std::uint32_t>(record, 0x06054b50);
+  // disk numbers
+  put<std::uint16_t>(record, 0);
+  put<std::uint16_t>(record, 0);
+  put<std::uint16_t>(record, entries16);
+  put<std::uint16_t>(record, entries16);
+  put<std::uint32_t>(record, zip32(size));
+  put<std::uint32_t>(record, zip32(offset));
+  // comment length
+  put<std::uint16_t>(record, 0);
+  return record;
+}
+
+} // namespace io_npz_impl
+
+// implementation
+
+template<typename NamedTuple>
+inline NamedTupleNpzWriter<NamedTuple>::NamedTupleNpzWriter(
+  const std::string& path, bool compress, std::size_t num_threads)
+  : m_compress(compress), m_num_records(0), m_columns(kNumFields) {
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  // tuples w/o any fields are valid and result in an empty archive
+  m_max_pending = std::max<std::size_t>(
+    2, (2 * num_threads) / std::max<std::size_t>(kNumFields, 1));
+  // make our life easier. always throw on error
+  m_file.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+  m_file.open(
+    path, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+
+  auto names = NamedTuple::field_names();
+  auto codes = io_npy_impl::dtypes_codes(Tuple());
+  for (std::size_t i = 0; i < kNumFields; ++i) {
+    m_columns[i].name = names[i].to_string() + ".npy";
+    m_columns[i].descr = "'";
+    m_columns[i].descr += io_npy_impl::dtype_endianness_modifier();
+    m_columns[i].descr += codes[i];
+    m_columns[i].descr += "'";
+    m_columns[i].buffer.reserve(kBlockSize);
+  }
+  m_pool.reset(new threadpool_impl::ThreadPool(num_threads));
+}
+
+template<typename NamedTuple>
+inline NamedTupleNpzWriter<NamedTuple>::~NamedTupleNpzWriter() {
+  try {
+    close();
+  } catch (...) {
+    // the destructor must not throw; use `close` to get errors
+  }
+}
+
+template<typename NamedTuple>
+inline NamedTupleNpzWriter<NamedTuple>&
+NamedTupleNpzWriter<NamedTuple>::operator=(NamedTupleNpzWriter&& other) {
+  if (this != &other) {
+    // the pending arrays and the archive would be lost otherwise
+    try {
+      close();
+    } catch (...) {
+      // same as for the destructor; use `close` to get errors
+    }
+    m_file = std::move(other.m_file);
+    m_compress = other.m_compress;
+    m_max_pending = other.m_max_pending;
+    m_num_records = other.m_num_records;
+    m_columns = std::move(other.m_columns);
+    m_pool = std::move(other.m_pool);
+  }
+  return *this;
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleNpzWriter<NamedTuple>::append(const NamedTuple& record) {
+  if (not m_pool) {
+    throw std::runtime_error("Can not append to a closed npz writer");
+  }
+  append_values(record, std::make_index_sequence<kNumFields>{});
+  m_num_records += 1;
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleNpzWriter<NamedTuple>::close() {
+  if (not m_pool) {
+    return;
+  }
+  // release the pool even on errors so that closing is attempted only once
+  struct Release {
+    std::unique_ptr<threadpool_impl::ThreadPool>& pool;
+    ~Release() { pool.reset(); }
+  } release{m_pool};
+  for (auto& column : m_columns) {
+    if (not column.buffer.empty()) {
+      submit(column);
+    }
+    retire(column, true);
+  }
+  write_archive();
+  m_file.close();
+}
+
+template<typename NamedTuple>
+template<std::size_t... I>
+inline void
+NamedTupleNpzWriter<NamedTuple>::append_values(
+  const NamedTuple& record, std::index_sequence<I...>) {
+  // see namedtuple_impl::print_tuple for explanation
+  using std::get;
+  using Vacuum = int[];
+  (void)Vacuum{(append_value(m_columns[I], get<I>(record)), 0)...};
+}
+
+template<typename NamedTuple>
+template<typename T>
+inline void
+NamedTupleNpzWriter<NamedTuple>::append_value(
+  io_npz_impl::Column& column, const T& value) {
+  auto pos = column.buffer.size();
+  column.buffer.resize(pos + sizeof(T));
+  std::memcpy(&column.buffer[pos], &value, sizeof(T));
+  if (kBlockSize <= column.buffer.size()) {
+    submit(column);
+  }
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleNpzWriter<NamedTuple>::submit(io_npz_impl::Column& column) {
+  bool compress = m_compress;
+  std::vector<char> data;
+  data.swap(column.buffer);
+  column.buffer.reserve(kBlockSize);
+  column.pending.push_back(
+    m_pool->submit([compress, data = std::move(data)]() {
+      return io_npz_impl::encode_block(
+        data.data(), data.size(), compress, false);
+    }));
+  retire(column, false);
+}
+
+// write finished blocks in order and limit the number of blocks in flight
+template<typename NamedTuple>
+inline void
+NamedTupleNpzWriter<NamedTuple>::retire(
+  io_npz_impl::Column& column, bool wait) {
+  while (not column.pending.empty()) {
+    auto& front = column.pending.front();
+    bool is_ready = (front.wait_for(std::chrono::seconds(0)) ==
+                     std::future_status::ready);
+    if (not is_ready and not wait
+        and (column.pending.size() <= m_max_pending)) {
+      break;
+    }
+    auto block = front.get();
+    column.pending.pop_front();
+    io_npz_impl::write_block(column, std::move(block));
+  }
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleNpzWriter<NamedTuple>::write_archive() {
+  std::vector<io_npz_impl::Entry> entries;
+  std::vector<char> buffer(kBlockSize);
+  std::uint64_t offset = 0;
+
+  for (auto& column : m_columns) {
+    // the array header is only known once all records are available
+    auto header = io_npy_impl::make_header(column.descr, m_num_records, 0);
+    auto head = io_npz_impl::encode_block(
+      header.data(), header.size(), m_compress, false);
+    auto tail = io_npz_impl::encode_block(nullptr, 0, m_compress, true);
+
+    io_npz_impl::Entry entry;
+    entry.name = column.name;
+    entry.method = m_compress ? 8 : 0;
+    entry.crc = static_cast<std::uint32_t>(
+      io_npz_impl::crc32_combine_u64(head.crc, column.crc, column.size));
+    entry.size = head.size + column.size;
+    entry.compressed_size =
+      head.data.size() + column.encoded_size + tail.data.size();
+    entry.offset = offset;
+
+    auto local = io_npz_impl::local_header(entry);
+    m_file.write(local.data(), local.size());
+    m_file.write(head.data.data(), head.data.size());
+    if (column.spill) {
+      std::rewind(column.spill.get());
+      std::size_t n = 0;
+      while (0 < (n = std::fread(
+                    buffer.data(), 1, buffer.size(), column.spill.get()))) {
+        m_file.write(buffer.data(), n);
+      }
+      if (std::ferror(column.spill.get())) {
+        throw std::runtime_error("Could not read temporary file");
+      }
+      column.spill.reset();
+    }
+    m_file.write(tail.data.data(), tail.data.size());
+    offset += local.size() + entry.compressed_size;
+    entries.push_back(std::move(entry));
+  }
+
+  std::string directory;
+  for (const auto& entry : entries) {
+    directory += io_npz_impl::central_header(entry);
+  }
+  directory += io_npz_impl::end_of_central_directory(
+    entries.size(), offset, directory.size());
+  m_file.write(directory.data(), directory.size());
+}
+
+} // namespace dfe
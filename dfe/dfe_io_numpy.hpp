@@ -20,23 +20,37 @@
 // SOFTWARE.
 
 /// \file
-/// \brief   Write numpy-compatible .npy binary files
+/// \brief   Read/write numpy-compatible .npy binary files
 /// \author  Moritz Kiehn <msmk@cern.ch>
 /// \date    2019-09-08, Split numpy i/o from the namedtuple library
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <iterator>
+#include <stdexcept>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#include "dfe_io_mmap.hpp"
+#include "dfe_io_statistics.hpp"
+#include "dfe_namedtuple.hpp"
 
 namespace dfe {
 
 /// Write records into a binary NumPy-compatible `.npy` file.
 ///
+/// Records are serialized into an internal buffer that is written to the
+/// file in large blocks. Records whose in-memory layout is identical to the
+/// packed on-file layout are copied as a whole.
+///
 /// See
 /// https://docs.scipy.org/doc/numpy/reference/generated/numpy.lib.format.html
 /// for an explanation of the file format.
@@ -48,29 +62,241 @@ public:
   NamedTupleNumpyWriter(NamedTupleNumpyWriter&&) = default;
   ~NamedTupleNumpyWriter();
   NamedTupleNumpyWriter& operator=(const NamedTupleNumpyWriter&) = delete;
-  NamedTupleNumpyWriter& operator=(NamedTupleNumpyWriter&&) = default;
+  /// Write the remaining records and the final header before taking over.
+  NamedTupleNumpyWriter& operator=(NamedTupleNumpyWriter&& other);
 
   /// Create a npy file at the given path. Overwrites existing data.
   NamedTupleNumpyWriter(const std::string& path);
 
   /// Append a record to the end of the file.
   void append(const NamedTuple& record);
+  /// Append all records in the range to the end of the file.
+  template<typename InputIt>
+  void append(InputIt first, InputIt last);
+  /// Append a contiguous array of records to the end of the file.
+  void append(const NamedTuple* records, std::size_t size);
+  /// Write all buffered records to the file.
+  void flush();
+
+  /// Return the i/o statistics; only collected with DFE_USE_IO_STATISTICS.
+  const IoStatistics& statistics() const { return m_recorder.statistics(); }
+  /// Set a function that receives the statistics after each flush.
+  void set_statistics_callback(IoStatisticsCallback callback) {
+    m_recorder.set_callback(std::move(callback));
+  }
 
 private:
   // the equivalent std::tuple-like type
   using Tuple = typename NamedTuple::Tuple;
 
+  // size of a single record in the packed on-file layout
+  static constexpr std::size_t kRecordSize =
+    NamedTupleLayout<NamedTuple>::packed_size();
+  static constexpr std::size_t kBufferSize = 1 << 20;
+
   std::ofstream m_file;
   std::size_t m_fixed_header_length;
   std::size_t m_num_tuples;
+  std::vector<char> m_buffer;
+  // true if the in-memory layout matches the packed layout
+  bool m_is_packed;
+  io_statistics_impl::Recorder m_recorder;
 
   void write_header(std::size_t num_tuples);
+  void close();
   template<std::size_t... I>
   void write_record(const NamedTuple& record, std::index_sequence<I...>);
   template<typename T>
   void write_bytes(const T* ptr);
 };
 
+/// Read records from a binary NumPy-compatible `.npy` file.
+///
+/// The file must contain a one-dimensional structured array with the same
+/// field names and types as the named tuple, e.g. as written by the
+/// `NamedTupleNumpyWriter`. Files stored with the opposite byte order are
+/// supported and converted on access.
+///
+/// The file is memory-mapped and records are accessed in place. Besides
+/// sequential reading, the records can be accessed randomly or iterated as
+/// lightweight views that only load the requested fields.
+template<typename NamedTuple>
+class NamedTupleNumpyReader {
+private:
+  // the equivalent std::tuple-like type
+  using Tuple = typename NamedTuple::Tuple;
+  static constexpr std::size_t kNumFields = std::tuple_size<Tuple>::value;
+
+public:
+  class RecordView;
+  class Iterator;
+
+  NamedTupleNumpyReader() = delete;
+  NamedTupleNumpyReader(const NamedTupleNumpyReader&) = delete;
+  NamedTupleNumpyReader(NamedTupleNumpyReader&&) = default;
+  ~NamedTupleNumpyReader() = default;
+  NamedTupleNumpyReader& operator=(const NamedTupleNumpyReader&) = delete;
+  NamedTupleNumpyReader& operator=(NamedTupleNumpyReader&&) = default;
+
+  /// Open a npy file for reading.
+  ///
+  /// \param path  Path to the input file
+  ///
+  /// Throws if the file can not be read or if the stored array is not
+  /// compatible with the named tuple.
+  NamedTupleNumpyReader(const std::string& path);
+
+  /// Return the total number of records in the file.
+  std::size_t size() const { return m_size; }
+  /// Return the number of records read sequentially so far.
+  std::size_t num_records() const { return m_next; }
+
+  /// Read the next record from the file.
+  ///
+  /// \returns true   if a record was successfully read
+  /// \returns false  if no more records are available
+  bool read(NamedTuple& record);
+  /// Read up to n records into column-oriented storage.
+  ///
+  /// \param n        Maximum number of records to read
+  /// \param columns  Output columns; existing content is replaced
+  /// \returns        Number of records read, less than n at the end-of-file
+  std::size_t read_batch(std::size_t n, NamedTupleColumns<NamedTuple>& columns);
+  /// Read up to n records into new column-oriented storage.
+  NamedTupleColumns<NamedTuple> read_batch(std::size_t n);
+
+  /// Return the record at the given index. Throws if it does not exist.
+  ///
+  /// Random access is independent of the sequential reading position.
+  NamedTuple at(std::size_t idx) const;
+  /// Return a view of the record at the given index w/o bounds checks.
+  RecordView operator[](std::size_t idx) const;
+  /// Return all records as a contiguous array or nullptr if not possible.
+  ///
+  /// Direct access requires that the records are stored in the native byte
+  /// order, that the in-memory layout matches the packed layout on file, see
+  /// `NamedTupleLayout::is_packed()`, and that the stored records are
+  /// suitably aligned. The array contains `size()` records and is valid for
+  /// the lifetime of the reader.
+  const NamedTuple* data() const { return m_direct; }
+  /// Iterate over views of all records in the file.
+  Iterator begin() const;
+  Iterator end() const;
+
+private:
+  MappedFile m_mapped;
+  // file content for platforms w/o memory-mapping
+  std::vector<char> m_contents;
+  const char* m_records = nullptr;
+  std::size_t m_size = 0;
+  std::size_t m_next = 0;
+  // packed record layout and byte order as stored on file
+  std::size_t m_record_size = 0;
+  std::array<std::size_t, kNumFields> m_offsets;
+  std::array<bool, kNumFields> m_swap;
+  // true if records on file can be copied as a whole
+  bool m_is_native = false;
+  // stored records if they can be accessed in-place
+  const NamedTuple* m_direct = nullptr;
+
+  const char* record_data(std::size_t idx) const {
+    return m_records + idx * m_record_size;
+  }
+  template<std::size_t I>
+  std::tuple_element_t<I, Tuple> load(const char* record) const;
+  template<std::size_t... I>
+  void load_fields(
+    const char* record, NamedTuple& nt, std::index_sequence<I...>) const {
+    nt = Tuple(load<I>(record)...);
+  }
+  void load_record(const char* record, NamedTuple& nt) const {
+    if (m_is_native) {
+      // the stored records are not necessarily aligned
+      std::memcpy(static_cast<void*>(&nt), record, sizeof(NamedTuple));
+    } else {
+      load_fields(record, nt, std::make_index_sequence<kNumFields>{});
+    }
+  }
+  template<std::size_t... I>
+  void append_columns(
+    const char* record, NamedTupleColumns<NamedTuple>& columns,
+    std::index_sequence<I...>) const {
+    // see namedtuple_impl::print_tuple for explanation
+    using Vacuum = int[];
+    (void)Vacuum{
+      (columns.template column<I>().push_back(load<I>(record)), 0)...};
+  }
+  template<std::size_t... I>
+  void setup_fields(
+    const std::vector<std::pair<std::string, std::string>>& fields,
+    std::index_sequence<I...>);
+  template<std::size_t I>
+  void setup_field(const std::pair<std::string, std::string>& field);
+};
+
+/// Read-only view of a single record within a npy file.
+///
+/// Fields are loaded directly from the file content on access.
+template<typename NamedTuple>
+class NamedTupleNumpyReader<NamedTuple>::RecordView {
+public:
+  /// Load the I-th field of the record.
+  template<std::size_t I>
+  std::tuple_element_t<I, Tuple> get() const {
+    return m_reader->template load<I>(m_data);
+  }
+  /// Load the complete record.
+  NamedTuple record() const {
+    NamedTuple nt;
+    m_reader->load_record(m_data, nt);
+    return nt;
+  }
+
+private:
+  RecordView(const NamedTupleNumpyReader* reader, const char* data)
+    : m_reader(reader), m_data(data) {}
+
+  const NamedTupleNumpyReader* m_reader;
+  const char* m_data;
+
+  friend class NamedTupleNumpyReader;
+};
+
+/// Iterator over record views of a npy file.
+template<typename NamedTuple>
+class NamedTupleNumpyReader<NamedTuple>::Iterator {
+public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = RecordView;
+  using difference_type = std::ptrdiff_t;
+  using pointer = void;
+  using reference = RecordView;
+
+  RecordView operator*() const { return (*m_reader)[m_idx]; }
+  Iterator& operator++() {
+    ++m_idx;
+    return *this;
+  }
+  Iterator operator++(int) {
+    Iterator prev = *this;
+    ++m_idx;
+    return prev;
+  }
+  bool operator==(const Iterator& other) const {
+    return (m_reader == other.m_reader) and (m_idx == other.m_idx);
+  }
+  bool operator!=(const Iterator& other) const { return not(*this == other); }
+
+private:
+  Iterator(const NamedTupleNumpyReader* reader, std::size_t idx)
+    : m_reader(reader), m_idx(idx) {}
+
+  const NamedTupleNumpyReader* m_reader;
+  std::size_t m_idx;
+
+  friend class NamedTupleNumpyReader;
+};
+
 // implementation helpers
 namespace io_npy_impl {
 
@@ -127,13 +353,13 @@ inline std::string
 dtypes_description(const NamedTuple& nt) {
   std::string descr;
   std::size_t n = std::tuple_size<typename NamedTuple::Tuple>::value;
-  auto names = nt.names();
+  auto names = nt.field_names();
   auto codes = dtypes_codes(nt.tuple());
   auto endianness_modifier = dtype_endianness_modifier();
   descr += '[';
   for (decltype(n) i = 0; i < n; ++i) {
     descr += "('";
-    descr += names[i];
+    descr.append(names[i].data(), names[i].size());
     descr += "', '";
     descr += endianness_modifier;
     descr += codes[i];
@@ -146,14 +372,328 @@ dtypes_description(const NamedTuple& nt) {
   return descr;
 }
 
+// Create the complete header for an array with arbitrary shape.
+//
+// The header is padded w/ spaces to at least the given minimum size.
+inline std::string
+make_header(
+  const std::string& descr, const std::vector<std::size_t>& shape,
+  bool fortran_order, std::size_t min_size) {
+  std::string header;
+  // magic
+  header += "\x93NUMPY";
+  // fixed version number (major, minor), 1byte unsigned each
+  header += static_cast<char>(0x1);
+  header += static_cast<char>(0x0);
+  // placeholder value for the header length, 2byte little endian unsigned
+  header += static_cast<char>(0xAF);
+  header += static_cast<char>(0xFE);
+  // python dict w/ data type and size information
+  header += "{'descr': ";
+  header += descr;
+  header += ", 'fortran_order': ";
+  header += fortran_order ? "True" : "False";
+  header += ", 'shape': (";
+  for (auto size : shape) {
+    header += std::to_string(size);
+    header += ',';
+  }
+  header += ")}";
+  // padd w/ spaces for 16 byte alignment of the whole header
+  while (((header.size() + 1) % 16) != 0) {
+    header += ' ';
+  }
+  while ((header.size() + 1) < min_size) {
+    header += ' ';
+  }
+  header += '\n';
+  // replace the header length place holder
+  std::size_t header_length = header.size() - 10;
+  header[8] = static_cast<char>(header_length >> 0);
+  header[9] = static_cast<char>(header_length >> 8);
+  return header;
+}
+
+// Create the complete header for a one-dimensional array.
+inline std::string
+make_header(
+  const std::string& descr, std::size_t num_records, std::size_t min_size) {
+  return make_header(descr, {num_records}, false, min_size);
+}
+
+// Check whether a stored dtype code describes values of type T.
+//
+// Sets `swap` if the stored byte order differs from the native one.
+template<typename T>
+inline bool
+check_dtype(const std::string& code, bool& swap) {
+  std::string stored = code;
+  char order = '=';
+  if (not stored.empty()
+      and ((stored[0] == '<') or (stored[0] == '>') or (stored[0] == '|')
+           or (stored[0] == '='))) {
+    order = stored.front();
+    stored.erase(0, 1);
+  }
+  std::string expected = kNumpyDtypeCode<T>;
+  // numpy uses both codes for booleans
+  if (stored == "?") {
+    stored = "b1";
+  }
+  if (expected == "?") {
+    expected = "b1";
+  }
+  if (stored != expected) {
+    return false;
+  }
+  // byte order is irrelevant for single-byte types
+  swap = (1 < sizeof(T)) and ((order == '<') or (order == '>'))
+         and (order != dtype_endianness_modifier());
+  return true;
+}
+
+// Reverse the byte order of a value in place.
+template<typename T>
+inline void
+swap_bytes(T& value) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  for (std::size_t i = 0; i < (sizeof(T) / 2); ++i) {
+    std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+  }
+  std::memcpy(&value, bytes, sizeof(T));
+}
+
+// Content of the npy file header that is relevant for reading.
+struct Header {
+  // field name and dtype code for each field of the structured array. a
+  // plain dtype is stored as a single field w/ an empty name.
+  std::vector<std::pair<std::string, std::string>> fields;
+  std::vector<std::size_t> shape;
+  bool fortran_order = false;
+  // number of entries along the first dimension
+  std::size_t num_records = 0;
+  // offset of the first record relative to the start of the file
+  std::size_t data_offset = 0;
+};
+
+[[noreturn]] inline void
+throw_invalid_header(const std::string& reason) {
+  throw std::runtime_error("Invalid npy header: " + reason);
+}
+
+// Minimal parser for the python dict literal stored in the npy header.
+//
+// Only supports the subset generated for structured arrays and arrays of
+// plain numeric types.
+class HeaderParser {
+public:
+  HeaderParser(const char* begin, const char* end) : m_pos(begin), m_end(end) {}
+
+  Header parse();
+
+private:
+  const char* m_pos;
+  const char* m_end;
+
+  void skip_whitespace();
+  bool consume(char c);
+  void expect(char c, const char* reason);
+  std::string parse_string();
+  std::size_t parse_integer();
+  bool parse_bool();
+  std::vector<std::pair<std::string, std::string>> parse_descr();
+  std::vector<std::size_t> parse_shape();
+};
+
+inline Header
+HeaderParser::parse() {
+  Header header;
+  bool has_descr = false;
+  bool has_shape = false;
+
+  expect('{', "missing opening brace");
+  while (not consume('}')) {
+    auto key = parse_string();
+    expect(':', "missing key separator");
+    if (key == "descr") {
+      header.fields = parse_descr();
+      has_descr = true;
+    } else if (key == "fortran_order") {
+      header.fortran_order = parse_bool();
+    } else if (key == "shape") {
+      header.shape = parse_shape();
+      header.num_records = header.shape.empty() ? 1 : header.shape.front();
+      has_shape = true;
+    } else {
+      throw_invalid_header("unknown key '" + key + "'");
+    }
+    if (not consume(',')) {
+      expect('}', "missing closing brace");
+      break;
+    }
+  }
+  if (not has_descr or not has_shape) {
+    throw_invalid_header("missing 'descr' or 'shape'");
+  }
+  return header;
+}
+
+inline void
+HeaderParser::skip_whitespace() {
+  while ((m_pos != m_end)
+         and ((*m_pos == ' ') or (*m_pos == '\t') or (*m_pos == '\n')
+              or (*m_pos == '\r'))) {
+    ++m_pos;
+  }
+}
+
+inline bool
+HeaderParser::consume(char c) {
+  skip_whitespace();
+  if ((m_pos != m_end) and (*m_pos == c)) {
+    ++m_pos;
+    return true;
+  }
+  return false;
+}
+
+inline void
+HeaderParser::expect(char c, const char* reason) {
+  if (not consume(c)) {
+    throw_invalid_header(reason);
+  }
+}
+
+inline std::string
+HeaderParser::parse_string() {
+  skip_whitespace();
+  if ((m_pos == m_end) or ((*m_pos != '\'') and (*m_pos != '"'))) {
+    throw_invalid_header("missing string");
+  }
+  char quote = *m_pos++;
+  const char* begin = m_pos;
+  while ((m_pos != m_end) and (*m_pos != quote)) {
+    ++m_pos;
+  }
+  if (m_pos == m_end) {
+    throw_invalid_header("unterminated string");
+  }
+  return std::string(begin, m_pos++);
+}
+
+inline std::size_t
+HeaderParser::parse_integer() {
+  skip_whitespace();
+  std::size_t value = 0;
+  const char* begin = m_pos;
+  while ((m_pos != m_end) and ('0' <= *m_pos) and (*m_pos <= '9')) {
+    value = 10 * value + static_cast<std::size_t>(*m_pos - '0');
+    ++m_pos;
+  }
+  if (m_pos == begin) {
+    throw_invalid_header("missing integer");
+  }
+  return value;
+}
+
+inline bool
+HeaderParser::parse_bool() {
+  skip_whitespace();
+  auto remaining = static_cast<std::size_t>(m_end - m_pos);
+  if ((4 <= remaining) and (std::memcmp(m_pos, "True", 4) == 0)) {
+    m_pos += 4;
+    return true;
+  }
+  if ((5 <= remaining) and (std::memcmp(m_pos, "False", 5) == 0)) {
+    m_pos += 5;
+    return false;
+  }
+  throw_invalid_header("missing boolean");
+}
+
+inline std::vector<std::pair<std::string, std::string>>
+HeaderParser::parse_descr() {
+  std::vector<std::pair<std::string, std::string>> fields;
+
+  skip_whitespace();
+  if ((m_pos != m_end) and ((*m_pos == '\'') or (*m_pos == '"'))) {
+    fields.emplace_back(std::string(), parse_string());
+    return fields;
+  }
+  expect('[', "only structured or plain dtypes are supported");
+  while (not consume(']')) {
+    expect('(', "missing field opening parenthesis");
+    auto name = parse_string();
+    expect(',', "missing field separator");
+    auto code = parse_string();
+    if (consume(',')) {
+      throw_invalid_header("subarray fields are not supported");
+    }
+    expect(')', "missing field closing parenthesis");
+    fields.emplace_back(std::move(name), std::move(code));
+    if (not consume(',')) {
+      expect(']', "missing closing bracket");
+      break;
+    }
+  }
+  return fields;
+}
+
+inline std::vector<std::size_t>
+HeaderParser::parse_shape() {
+  std::vector<std::size_t> shape;
+
+  expect('(', "missing shape opening parenthesis");
+  while (not consume(')')) {
+    shape.push_back(parse_integer());
+    if (not consume(',')) {
+      expect(')', "missing shape closing parenthesis");
+      break;
+    }
+  }
+  return shape;
+}
+
+// Read and parse the header at the beginning of the file content.
+inline Header
+read_header(const char* data, std::size_t size) {
+  if ((size < 10) or (std::memcmp(data, "\x93NUMPY", 6) != 0)) {
+    throw_invalid_header("missing magic string");
+  }
+  auto byte = [=](std::size_t i) {
+    return static_cast<std::size_t>(static_cast<unsigned char>(data[i]));
+  };
+  std::size_t offset = 0;
+  std::size_t length = 0;
+  // version 1.0 uses a 2byte header length, versions 2.0/3.0 use 4byte
+  if (byte(6) == 1) {
+    offset = 10;
+    length = byte(8) | (byte(9) << 8);
+  } else if (((byte(6) == 2) or (byte(6) == 3)) and (12 <= size)) {
+    offset = 12;
+    length = byte(8) | (byte(9) << 8) | (byte(10) << 16) | (byte(11) << 24);
+  } else {
+    throw_invalid_header("unsupported version");
+  }
+  if ((size - offset) < length) {
+    throw_invalid_header("truncated header");
+  }
+  auto header = HeaderParser(data + offset, data + offset + length).parse();
+  header.data_offset = offset + length;
+  return header;
+}
+
 } // namespace io_npy_impl
 
-// implementation
+// implementation writer
 
 template<typename NamedTuple>
 inline NamedTupleNumpyWriter<NamedTuple>::NamedTupleNumpyWriter(
   const std::string& path)
-  : m_fixed_header_length(0), m_num_tuples(0) {
+  : m_fixed_header_length(0)
+  , m_num_tuples(0)
+  , m_is_packed(NamedTupleLayout<NamedTuple>::is_packed()) {
   // make our life easier. always throw on error
   m_file.exceptions(std::ofstream::badbit | std::ofstream::failbit);
   m_file.open(
@@ -163,13 +703,39 @@ inline NamedTupleNumpyWriter<NamedTuple>::NamedTupleNumpyWriter(
   // overwrite it w/ the actual number of tuples at closing time.
   write_header(SIZE_MAX);
   write_header(0);
+  m_recorder.add_bytes(m_fixed_header_length);
+  m_buffer.reserve(kBufferSize + kRecordSize);
 }
 
 template<typename NamedTuple>
 inline NamedTupleNumpyWriter<NamedTuple>::~NamedTupleNumpyWriter() {
+  close();
+}
+
+template<typename NamedTuple>
+inline NamedTupleNumpyWriter<NamedTuple>&
+NamedTupleNumpyWriter<NamedTuple>::operator=(NamedTupleNumpyWriter&& other) {
+  if (this != &other) {
+    // the buffered records and the record count would be lost otherwise
+    close();
+    m_file = std::move(other.m_file);
+    m_fixed_header_length = other.m_fixed_header_length;
+    m_num_tuples = other.m_num_tuples;
+    m_buffer = std::move(other.m_buffer);
+    m_is_packed = other.m_is_packed;
+    m_recorder = std::move(other.m_recorder);
+  }
+  return *this;
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleNumpyWriter<NamedTuple>::close() {
+  // the writer might have been moved from
   if (!m_file.is_open()) {
     return;
   }
+  flush();
   write_header(m_num_tuples);
   m_file.close();
 }
@@ -177,49 +743,83 @@ inline NamedTupleNumpyWriter<NamedTuple>::~NamedTupleNumpyWriter() {
 template<typename NamedTuple>
 inline void
 NamedTupleNumpyWriter<NamedTuple>::append(const NamedTuple& record) {
-  write_record(
-    record, std::make_index_sequence<std::tuple_size<Tuple>::value>{});
+  {
+    auto timer = m_recorder.time_convert();
+    if (m_is_packed) {
+      auto pos = m_buffer.size();
+      m_buffer.resize(pos + kRecordSize);
+      std::memcpy(&m_buffer[pos], &record, kRecordSize);
+    } else {
+      write_record(
+        record, std::make_index_sequence<std::tuple_size<Tuple>::value>{});
+    }
+  }
   m_num_tuples += 1;
+  m_recorder.add_records(1);
+  m_recorder.update_buffer(m_buffer.size());
+  if (kBufferSize <= m_buffer.size()) {
+    flush();
+  }
 }
 
 template<typename NamedTuple>
+template<typename InputIt>
 inline void
-NamedTupleNumpyWriter<NamedTuple>::write_header(std::size_t num_tuples) {
-  std::string header;
-  // magic
-  header += "\x93NUMPY";
-  // fixed version number (major, minor), 1byte unsigned each
-  header += static_cast<char>(0x1);
-  header += static_cast<char>(0x0);
-  // placeholder value for the header length, 2byte little endian unsigned
-  header += static_cast<char>(0xAF);
-  header += static_cast<char>(0xFE);
-  // python dict w/ data type and size information
-  header += "{'descr': ";
-  header += io_npy_impl::dtypes_description(NamedTuple());
-  header += ", 'fortran_order': False";
-  header += ", 'shape': (";
-  header += std::to_string(num_tuples);
-  header += ",)}";
-  // padd w/ spaces for 16 byte alignment of the whole header
-  while (((header.size() + 1) % 16) != 0) {
-    header += ' ';
+NamedTupleNumpyWriter<NamedTuple>::append(InputIt first, InputIt last) {
+  for (; first != last; ++first) {
+    append(*first);
+  }
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleNumpyWriter<NamedTuple>::append(
+  const NamedTuple* records, std::size_t size) {
+  if (not m_is_packed) {
+    append(records, records + size);
+    return;
+  }
+  // large blocks are written directly w/o going through the buffer
+  if (kBufferSize <= (size * kRecordSize)) {
+    flush();
+    {
+      auto timer = m_recorder.time_io();
+      m_file.write(reinterpret_cast<const char*>(records), size * kRecordSize);
+    }
+    m_num_tuples += size;
+    m_recorder.add_bytes(size * kRecordSize);
+    m_recorder.add_records(size);
+  } else {
+    append(records, records + size);
+  }
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleNumpyWriter<NamedTuple>::flush() {
+  {
+    auto timer = m_recorder.time_io();
+    m_file.write(m_buffer.data(), m_buffer.size());
   }
+  m_recorder.add_bytes(m_buffer.size());
+  m_recorder.add_flush();
+  m_buffer.clear();
+  m_recorder.report();
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleNumpyWriter<NamedTuple>::write_header(std::size_t num_tuples) {
   // the initial header fixes the available header size. updated headers
   // must always occupy the same space and might require additional
   // padding spaces
+  auto header = io_npy_impl::make_header(
+    io_npy_impl::dtypes_description(NamedTuple()), num_tuples,
+    m_fixed_header_length);
   if (m_fixed_header_length == 0) {
     m_fixed_header_length = header.size();
-  } else {
-    while (header.size() < m_fixed_header_length) {
-      header += ' ';
-    }
   }
-  header += '\n';
-  // replace the header length place holder
-  std::size_t header_length = header.size() - 10;
-  header[8] = static_cast<char>(header_length >> 0);
-  header[9] = static_cast<char>(header_length >> 8);
+  auto timer = m_recorder.time_io();
   m_file.seekp(0);
   m_file.write(header.data(), header.size());
 }
@@ -239,7 +839,157 @@ template<typename NamedTuple>
 template<typename T>
 inline void
 NamedTupleNumpyWriter<NamedTuple>::write_bytes(const T* ptr) {
-  m_file.write(reinterpret_cast<const char*>(ptr), sizeof(T));
+  auto pos = m_buffer.size();
+  m_buffer.resize(pos + sizeof(T));
+  std::memcpy(&m_buffer[pos], ptr, sizeof(T));
+}
+
+// implementation reader
+
+template<typename NamedTuple>
+inline NamedTupleNumpyReader<NamedTuple>::NamedTupleNumpyReader(
+  const std::string& path) {
+  const char* data = nullptr;
+  std::size_t size = 0;
+  if (m_mapped.map(path, MappedFile::Access::Random)) {
+    data = m_mapped.data();
+    size = m_mapped.size();
+  } else {
+    // fall back to reading the whole file into memory
+    std::ifstream file(path, std::ios_base::binary | std::ios_base::in);
+    if (not file.is_open() or file.fail()) {
+      throw std::runtime_error("Could not open file '" + path + "'");
+    }
+    m_contents.assign(
+      std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data = m_contents.data();
+    size = m_contents.size();
+  }
+
+  auto header = io_npy_impl::read_header(data, size);
+  if (header.shape.size() != 1) {
+    throw std::runtime_error("Only one-dimensional npy arrays are supported");
+  }
+  if (header.fields.size() != kNumFields) {
+    throw std::runtime_error(
+      "Incompatible npy dtype, expected " +
+      io_npy_impl::dtypes_description(NamedTuple()));
+  }
+  setup_fields(header.fields, std::make_index_sequence<kNumFields>{});
+  if (((size - header.data_offset) / m_record_size) < header.num_records) {
+    throw std::runtime_error("Truncated npy data in '" + path + "'");
+  }
+  m_records = data + header.data_offset;
+  m_size = header.num_records;
+  m_is_native =
+    NamedTupleLayout<NamedTuple>::is_packed() and
+    std::none_of(m_swap.begin(), m_swap.end(), [](bool swap) { return swap; });
+  if (m_is_native and
+      ((reinterpret_cast<std::uintptr_t>(m_records) % alignof(NamedTuple)) ==
+       0)) {
+    m_direct = reinterpret_cast<const NamedTuple*>(m_records);
+  }
+}
+
+template<typename NamedTuple>
+template<std::size_t... I>
+inline void
+NamedTupleNumpyReader<NamedTuple>::setup_fields(
+  const std::vector<std::pair<std::string, std::string>>& fields,
+  std::index_sequence<I...>) {
+  // see namedtuple_impl::print_tuple for explanation
+  using Vacuum = int[];
+  (void)Vacuum{(setup_field<I>(fields[I]), 0)...};
+}
+
+template<typename NamedTuple>
+template<std::size_t I>
+inline void
+NamedTupleNumpyReader<NamedTuple>::setup_field(
+  const std::pair<std::string, std::string>& field) {
+  using Value = std::tuple_element_t<I, Tuple>;
+  if ((field.first != std::get<I>(NamedTuple::field_names()))
+      or not io_npy_impl::check_dtype<Value>(field.second, m_swap[I])) {
+    throw std::runtime_error(
+      "Incompatible npy field ('" + field.first + "', '" + field.second +
+      "'), expected " + io_npy_impl::dtypes_description(NamedTuple()));
+  }
+  // fields are stored packed w/o any padding
+  m_offsets[I] = m_record_size;
+  m_record_size += sizeof(Value);
+}
+
+template<typename NamedTuple>
+template<std::size_t I>
+inline std::tuple_element_t<I, typename NamedTuple::Tuple>
+NamedTupleNumpyReader<NamedTuple>::load(const char* record) const {
+  // the stored fields are not necessarily aligned
+  std::tuple_element_t<I, Tuple> value;
+  std::memcpy(&value, record + m_offsets[I], sizeof(value));
+  if (m_swap[I]) {
+    io_npy_impl::swap_bytes(value);
+  }
+  return value;
+}
+
+template<typename NamedTuple>
+inline bool
+NamedTupleNumpyReader<NamedTuple>::read(NamedTuple& record) {
+  if (m_next == m_size) {
+    return false;
+  }
+  load_record(record_data(m_next), record);
+  m_next += 1;
+  return true;
+}
+
+template<typename NamedTuple>
+inline std::size_t
+NamedTupleNumpyReader<NamedTuple>::read_batch(
+  std::size_t n, NamedTupleColumns<NamedTuple>& columns) {
+  columns.clear();
+  std::size_t i = 0;
+  for (; (i < n) and (m_next < m_size); ++i, ++m_next) {
+    append_columns(
+      record_data(m_next), columns, std::make_index_sequence<kNumFields>{});
+  }
+  return i;
+}
+
+template<typename NamedTuple>
+inline NamedTupleColumns<NamedTuple>
+NamedTupleNumpyReader<NamedTuple>::read_batch(std::size_t n) {
+  NamedTupleColumns<NamedTuple> columns;
+  columns.reserve(std::min(n, m_size - m_next));
+  read_batch(n, columns);
+  return columns;
+}
+
+template<typename NamedTuple>
+inline NamedTuple
+NamedTupleNumpyReader<NamedTuple>::at(std::size_t idx) const {
+  if (m_size <= idx) {
+    throw std::out_of_range("Record index out of range");
+  }
+  return (*this)[idx].record();
+}
+
+template<typename NamedTuple>
+inline typename NamedTupleNumpyReader<NamedTuple>::RecordView
+NamedTupleNumpyReader<NamedTuple>::operator[](std::size_t idx) const {
+  return RecordView(this, record_data(idx));
+}
+
+template<typename NamedTuple>
+inline typename NamedTupleNumpyReader<NamedTuple>::Iterator
+NamedTupleNumpyReader<NamedTuple>::begin() const {
+  return Iterator(this, 0);
+}
+
+template<typename NamedTuple>
+inline typename NamedTupleNumpyReader<NamedTuple>::Iterator
+NamedTupleNumpyReader<NamedTuple>::end() const {
+  return Iterator(this, m_size);
 }
 
 } // namespace dfe
@@ -26,15 +26,35 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
+#include <RVersion.h>
+#include <TBranch.h>
+#include <TChain.h>
 #include <TFile.h>
+#include <TROOT.h>
 #include <TTree.h>
 
+// the bulk branch interface is available (and usable) since ROOT 6.16
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 16, 0)
+#define DFE_USE_ROOT_BULK 1
+#include <TBufferFile.h>
+#endif
+
+#include "dfe_io_statistics.hpp"
+#include "dfe_namedtuple.hpp"
+
 namespace dfe {
 
 /// Write records into a ROOT TTree.
@@ -65,6 +85,31 @@ public:
 
   /// Append a record to the file.
   void append(const NamedTuple& record);
+  /// Append all records stored in columns to the file.
+  void append(const NamedTupleColumns<NamedTuple>& columns);
+
+  /// Set the in-memory buffer size of each branch basket in bytes.
+  ///
+  /// Larger baskets reduce the per-entry overhead and the number of
+  /// compression calls at the cost of memory. Must be set before any
+  /// records are appended.
+  void set_basket_size(std::size_t bytes);
+  /// Set when baskets are flushed to the file.
+  ///
+  /// \param n  Number of entries if positive, number of bytes if negative
+  ///
+  /// The flushed baskets define the clusters that are read together.
+  void set_auto_flush(int64_t n);
+
+  /// Return the i/o statistics; only collected with DFE_USE_IO_STATISTICS.
+  ///
+  /// Bytes are counted before compression and the i/o time includes the
+  /// serialization and compression within ROOT.
+  const IoStatistics& statistics() const { return m_recorder.statistics(); }
+  /// Set a function that receives the statistics on destruction.
+  void set_statistics_callback(IoStatisticsCallback callback) {
+    m_recorder.set_callback(std::move(callback));
+  }
 
 private:
   // the equivalent std::tuple-like type
@@ -73,11 +118,41 @@ private:
   TFile* m_file;
   TTree* m_tree;
   Tuple m_data;
+  io_statistics_impl::Recorder m_recorder;
+
+  void fill();
 
   template<std::size_t... I>
   void setup_branches(std::index_sequence<I...>);
+  template<std::size_t... I>
+  void copy_from_columns(
+    const NamedTupleColumns<NamedTuple>& columns, std::size_t idx,
+    std::index_sequence<I...>) {
+    // see namedtuple_impl::print_tuple for explanation
+    using Vacuum = int[];
+    (void)Vacuum{
+      (std::get<I>(m_data) = static_cast<std::tuple_element_t<I, Tuple>>(
+         columns.template column<I>()[idx]),
+       0)...};
+  }
+};
+
+namespace io_root_impl {
+
+// Branch state for reading complete baskets w/ the bulk interface.
+struct BulkBranch {
+  TBranch* branch = nullptr;
+#ifdef DFE_USE_ROOT_BULK
+  // serialized basket content in big endian byte order
+  TBufferFile buffer{TBuffer::kWrite, 32 * 1024};
+#endif
+  // entry range of the basket that is currently stored in the buffer
+  Long64_t first = 0;
+  Long64_t count = 0;
 };
 
+} // namespace io_root_impl
+
 /// Read records from a ROOT TTree.
 template<typename NamedTuple>
 class NamedTupleRootReader {
@@ -101,6 +176,17 @@ public:
   /// When the reader is created with an existing ROOT directory, the user
   /// is responsible for ensuring the underlying file is closed.
   NamedTupleRootReader(TDirectory* dir, const std::string& tree_name);
+  /// Open the trees in multiple files and read them in sequence.
+  ///
+  /// \param paths      Paths to the input files
+  /// \param tree_name  Name of the input tree within each file
+  /// \param begin      First entry to read
+  /// \param end        Entry after the last entry to read
+  ///
+  /// Multiple files are chained and files are only opened when needed.
+  NamedTupleRootReader(
+    const std::vector<std::string>& paths, const std::string& tree_name,
+    int64_t begin = 0, int64_t end = std::numeric_limits<int64_t>::max());
   /// Write the tree and close the owned file.
   ~NamedTupleRootReader();
 
@@ -109,18 +195,85 @@ public:
   /// \returns true   if a record was successfully read
   /// \returns false  if no more records are available
   bool read(NamedTuple& record);
+  /// Read up to n records into column-oriented storage.
+  ///
+  /// \param n        Maximum number of records to read
+  /// \param columns  Output columns; existing content is replaced
+  /// \returns        Number of records read, less than n at the end-of-file
+  ///
+  /// If supported by ROOT, complete baskets are read for each branch and
+  /// the values are copied directly into the columns w/o reading separate
+  /// entries.
+  std::size_t read_batch(std::size_t n, NamedTupleColumns<NamedTuple>& columns);
+  /// Read up to n records into new column-oriented storage.
+  NamedTupleColumns<NamedTuple> read_batch(std::size_t n);
+
+  /// Set the size of the read cache in bytes. Zero disables the cache.
+  ///
+  /// The cache only contains the branches of the records and prefetches
+  /// them for complete clusters, which avoids many small reads for remote
+  /// files. A cache with `kDefaultCacheSize` is enabled by default.
+  void set_cache_size(std::size_t bytes);
+  /// Split the unread entries into readers for disjoint entry ranges.
+  ///
+  /// \param n  Requested number of readers
+  /// \returns  Up to n readers
+  ///
+  /// Ranges are aligned to cluster boundaries and cover all unread entries
+  /// in order; empty ranges are dropped. Each reader opens its own files and
+  /// can be used independently, e.g. on separate threads; ROOT thread-safety
+  /// is enabled for this purpose. Afterwards, this reader has no unread
+  /// entries left. Only readers opened from paths can be split.
+  std::vector<std::unique_ptr<NamedTupleRootReader>> split(std::size_t n);
+
+  /// Return the i/o statistics; only collected with DFE_USE_IO_STATISTICS.
+  ///
+  /// Bytes are counted after decompression and the i/o time includes the
+  /// decompression and deserialization within ROOT.
+  const IoStatistics& statistics() const { return m_recorder.statistics(); }
+  /// Set a function that receives the statistics on destruction.
+  void set_statistics_callback(IoStatisticsCallback callback) {
+    m_recorder.set_callback(std::move(callback));
+  }
+
+  /// Default size of the read cache in bytes.
+  static constexpr std::size_t kDefaultCacheSize = 32 * 1024 * 1024;
 
 private:
   // the equivalent std::tuple-like type
   using Tuple = typename NamedTuple::Tuple;
 
+  static constexpr std::size_t kNumFields = std::tuple_size<Tuple>::value;
+
   TFile* m_file;
+  // owned chain for multiple input files; identical to the tree if set
+  TChain* m_chain = nullptr;
   TTree* m_tree;
   int64_t m_next;
+  int64_t m_end = std::numeric_limits<int64_t>::max();
   Tuple m_data;
+  std::array<io_root_impl::BulkBranch, kNumFields> m_bulk;
+  bool m_use_bulk = false;
+  // input to create split readers w/ separate file handles
+  std::vector<std::string> m_paths;
+  std::string m_tree_name;
+  io_statistics_impl::Recorder m_recorder;
 
   template<std::size_t... I>
   void setup_branches(std::index_sequence<I...>);
+  bool read_entry();
+  template<std::size_t... I>
+  void read_bulk(
+    std::size_t n, NamedTupleColumns<NamedTuple>& columns,
+    std::index_sequence<I...>);
+  template<std::size_t... I>
+  void append_columns(
+    NamedTupleColumns<NamedTuple>& columns, std::index_sequence<I...>) const {
+    // see namedtuple_impl::print_tuple for explanation
+    using Vacuum = int[];
+    (void)Vacuum{
+      (columns.template column<I>().push_back(std::get<I>(m_data)), 0)...};
+  }
 };
 
 // implementation writer
@@ -225,6 +378,7 @@ template<typename NamedTuple>
 inline NamedTupleRootWriter<NamedTuple>::~NamedTupleRootWriter() {
   // alway overwrite old data
   if (m_tree) {
+    auto timer = m_recorder.time_io();
     m_tree->Write(nullptr, TObject::kOverwrite);
   }
   // writer owns the file
@@ -237,10 +391,54 @@ inline NamedTupleRootWriter<NamedTuple>::~NamedTupleRootWriter() {
 template<typename NamedTuple>
 inline void
 NamedTupleRootWriter<NamedTuple>::append(const NamedTuple& record) {
-  m_data = record;
-  if (m_tree->Fill() == -1) {
+  {
+    auto timer = m_recorder.time_convert();
+    m_data = record;
+  }
+  fill();
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleRootWriter<NamedTuple>::append(
+  const NamedTupleColumns<NamedTuple>& columns) {
+  // ROOT has no bulk interface for writing; entries must be filled one by one
+  for (std::size_t i = 0; i < columns.size(); ++i) {
+    {
+      auto timer = m_recorder.time_convert();
+      copy_from_columns(
+        columns, i, std::make_index_sequence<std::tuple_size<Tuple>::value>{});
+    }
+    fill();
+  }
+}
+
+// fill the local buffer as a new entry into the tree
+template<typename NamedTuple>
+inline void
+NamedTupleRootWriter<NamedTuple>::fill() {
+  Int_t bytes = 0;
+  {
+    auto timer = m_recorder.time_io();
+    bytes = m_tree->Fill();
+  }
+  if (bytes == -1) {
     throw std::runtime_error("Could not fill an entry");
   }
+  m_recorder.add_bytes(bytes);
+  m_recorder.add_records(1);
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleRootWriter<NamedTuple>::set_basket_size(std::size_t bytes) {
+  m_tree->SetBasketSize("*", static_cast<Int_t>(bytes));
+}
+
+template<typename NamedTuple>
+inline void
+NamedTupleRootWriter<NamedTuple>::set_auto_flush(int64_t n) {
+  m_tree->SetAutoFlush(static_cast<Long64_t>(n));
 }
 
 // implementation reader
@@ -248,7 +446,11 @@ NamedTupleRootWriter<NamedTuple>::append(const NamedTuple& record) {
 template<typename NamedTuple>
 inline NamedTupleRootReader<NamedTuple>::NamedTupleRootReader(
   const std::string& path, const std::string& tree_name)
-  : m_file(new TFile(path.c_str(), "READ")), m_tree(nullptr), m_next(0) {
+  : m_file(new TFile(path.c_str(), "READ"))
+  , m_tree(nullptr)
+  , m_next(0)
+  , m_paths{path}
+  , m_tree_name(tree_name) {
   if (not m_file) {
     throw std::runtime_error("Could not open file");
   }
@@ -278,6 +480,47 @@ inline NamedTupleRootReader<NamedTuple>::NamedTupleRootReader(
   setup_branches(std::make_index_sequence<std::tuple_size<Tuple>::value>());
 }
 
+template<typename NamedTuple>
+inline NamedTupleRootReader<NamedTuple>::NamedTupleRootReader(
+  const std::vector<std::string>& paths, const std::string& tree_name,
+  int64_t begin, int64_t end)
+  : m_file(nullptr)
+  , m_tree(nullptr)
+  , m_next(begin)
+  , m_end(end)
+  , m_paths(paths)
+  , m_tree_name(tree_name) {
+  if (paths.empty()) {
+    throw std::runtime_error("No input files given");
+  }
+  if (paths.size() == 1) {
+    // a single tree allows to use the bulk interface
+    m_file = new TFile(paths.front().c_str(), "READ");
+    if (not m_file->IsOpen()) {
+      delete m_file;
+      throw std::runtime_error("Could not open file");
+    }
+    m_tree = static_cast<TTree*>(m_file->Get(tree_name.c_str()));
+  } else {
+    m_chain = new TChain(tree_name.c_str());
+    for (const auto& path : paths) {
+      if (m_chain->Add(path.c_str()) == 0) {
+        delete m_chain;
+        throw std::runtime_error("Could not add file '" + path + "'");
+      }
+    }
+    m_tree = m_chain;
+  }
+  if (not m_tree) {
+    delete m_file;
+    throw std::runtime_error("Could not read tree");
+  }
+  setup_branches(std::make_index_sequence<std::tuple_size<Tuple>::value>());
+}
+
+template<typename NamedTuple>
+constexpr std::size_t NamedTupleRootReader<NamedTuple>::kDefaultCacheSize;
+
 namespace io_root_impl {
 
 // WARNING this is a hack to get around inconsistent ROOT types for 8bit chars
@@ -304,6 +547,117 @@ get_address(T& x) {
   return &x;
 }
 
+inline bool
+is_little_endian() {
+  uint16_t x = 1;
+  unsigned char c;
+  std::memcpy(&c, &x, 1);
+  return (c == 1);
+}
+
+// Copy values stored in big endian byte order into native values.
+template<typename T>
+inline void
+copy_from_big_endian(const char* src, std::size_t n, T* dst) {
+  std::memcpy(dst, src, n * sizeof(T));
+  if ((1 < sizeof(T)) and is_little_endian()) {
+    auto* bytes = reinterpret_cast<unsigned char*>(dst);
+    for (std::size_t i = 0; i < n; ++i, bytes += sizeof(T)) {
+      std::reverse(bytes, bytes + sizeof(T));
+    }
+  }
+}
+
+// Split the entry range into up to n ranges aligned to cluster boundaries.
+//
+// Loads all trees in the range if the tree is a chain.
+inline std::vector<std::pair<int64_t, int64_t>>
+partition_clusters(TTree& tree, int64_t begin, int64_t end, std::size_t n) {
+  std::vector<std::pair<int64_t, int64_t>> ranges;
+  if ((end <= begin) or (n == 0)) {
+    return ranges;
+  }
+  // cluster boundaries within the range including both range limits
+  std::vector<int64_t> boundaries = {begin};
+  int64_t offset = 0;
+  while (offset < end) {
+    Long64_t local = tree.LoadTree(offset);
+    if (local < 0) {
+      break;
+    }
+    // for a chain the current tree, the tree itself otherwise
+    TTree* current = tree.GetTree();
+    int64_t first = offset - local;
+    int64_t entries = current->GetEntries();
+    auto clusters = current->GetClusterIterator(0);
+    for (Long64_t start = clusters(); start < entries; start = clusters()) {
+      int64_t boundary = first + start;
+      if ((begin < boundary) and (boundary < end)) {
+        boundaries.push_back(boundary);
+      }
+    }
+    if (entries <= local) {
+      break;
+    }
+    offset = first + entries;
+  }
+  boundaries.push_back(end);
+  // combine neighboring clusters for ranges w/ similar number of entries
+  auto total = end - begin;
+  std::size_t lower = 0;
+  for (std::size_t i = 0; (i < n) and ((lower + 1) < boundaries.size()); ++i) {
+    int64_t target =
+      begin + (total / static_cast<int64_t>(n)) * static_cast<int64_t>(i + 1);
+    std::size_t upper = lower + 1;
+    while (((upper + 1) < boundaries.size()) and (boundaries[upper] < target)) {
+      ++upper;
+    }
+    // the last range always covers the remaining entries
+    if ((i + 1) == n) {
+      upper = boundaries.size() - 1;
+    }
+    ranges.emplace_back(boundaries[lower], boundaries[upper]);
+    lower = upper;
+  }
+  return ranges;
+}
+
+#ifdef DFE_USE_ROOT_BULK
+// Copy n values starting at the given entry from the branch baskets.
+template<typename T>
+inline void
+read_bulk_column(
+  BulkBranch& bulk, Long64_t entry, std::size_t n, std::vector<T>& column) {
+  static_assert(std::is_arithmetic<T>::value, "Only plain values are allowed");
+
+  column.resize(n);
+  std::size_t done = 0;
+  while (done < n) {
+    Long64_t current = entry + static_cast<Long64_t>(done);
+    if ((current < bulk.first) or ((bulk.first + bulk.count) <= current)) {
+      // the bulk interface always reads a complete basket
+      const Long64_t* begin = bulk.branch->GetBasketEntry();
+      const Long64_t* end = begin + bulk.branch->GetWriteBasket() + 1;
+      const Long64_t* basket = std::upper_bound(begin, end, current) - 1;
+      Int_t count =
+        bulk.branch->GetBulkRead().GetEntriesSerialized(*basket, bulk.buffer);
+      if (count <= 0) {
+        throw std::runtime_error("Could not read basket");
+      }
+      bulk.first = *basket;
+      bulk.count = count;
+    }
+    auto offset = static_cast<std::size_t>(current - bulk.first);
+    auto available = static_cast<std::size_t>(bulk.count) - offset;
+    auto size = std::min(n - done, available);
+    copy_from_big_endian(
+      bulk.buffer.GetCurrent() + offset * sizeof(T), size,
+      column.data() + done);
+    done += size;
+  }
+}
+#endif
+
 } // namespace io_root_impl
 
 template<typename NamedTuple>
@@ -320,11 +674,23 @@ NamedTupleRootReader<NamedTuple>::setup_branches(std::index_sequence<I...>) {
   // construct branches
   (void)std::array<Int_t, sizeof...(I)>{m_tree->SetBranchAddress(
     names[I].c_str(), io_root_impl::get_address(get<I>(m_data)))...};
+  set_cache_size(kDefaultCacheSize);
+#ifdef DFE_USE_ROOT_BULK
+  // bulk reading requires all branches to support it. the branches of a
+  // chain change w/ each file and can not be used directly.
+  m_use_bulk = (m_chain == nullptr);
+  for (std::size_t i = 0; i < kNumFields; ++i) {
+    m_bulk[i].branch = m_tree->GetBranch(names[i].c_str());
+    m_use_bulk = m_use_bulk and m_bulk[i].branch
+                 and m_bulk[i].branch->SupportsBulkRead();
+  }
+#endif
 }
 
 template<typename NamedTuple>
 inline NamedTupleRootReader<NamedTuple>::~NamedTupleRootReader() {
-  // reader owns the file
+  // reader owns the chain and the file
+  delete m_chain;
   if (m_file) {
     m_file->Close();
     delete m_file;
@@ -334,7 +700,82 @@ inline NamedTupleRootReader<NamedTuple>::~NamedTupleRootReader() {
 template<typename NamedTuple>
 inline bool
 NamedTupleRootReader<NamedTuple>::read(NamedTuple& record) {
-  auto ret = m_tree->GetEntry(m_next);
+  if (not read_entry()) {
+    return false;
+  }
+  // GetEntry(...) has already filled the local buffer
+  auto timer = m_recorder.time_convert();
+  record = m_data;
+  return true;
+}
+
+template<typename NamedTuple>
+inline std::size_t
+NamedTupleRootReader<NamedTuple>::read_batch(
+  std::size_t n, NamedTupleColumns<NamedTuple>& columns) {
+  columns.clear();
+  if (m_use_bulk) {
+    auto remaining =
+      std::min<int64_t>(m_tree->GetEntriesFast(), m_end) - m_next;
+    n = std::min(n, static_cast<std::size_t>(std::max<int64_t>(remaining, 0)));
+    {
+      // includes the byte order conversion
+      auto timer = m_recorder.time_io();
+      read_bulk(n, columns, std::make_index_sequence<kNumFields>{});
+    }
+    m_next += n;
+    m_recorder.add_bytes(n * NamedTupleLayout<NamedTuple>::packed_size());
+    m_recorder.add_records(n);
+    return n;
+  }
+  std::size_t i = 0;
+  for (; (i < n) and read_entry(); ++i) {
+    auto timer = m_recorder.time_convert();
+    append_columns(
+      columns, std::make_index_sequence<std::tuple_size<Tuple>::value>{});
+  }
+  return i;
+}
+
+template<typename NamedTuple>
+template<std::size_t... I>
+inline void
+NamedTupleRootReader<NamedTuple>::read_bulk(
+  std::size_t n, NamedTupleColumns<NamedTuple>& columns,
+  std::index_sequence<I...>) {
+#ifdef DFE_USE_ROOT_BULK
+  // see namedtuple_impl::print_tuple for explanation
+  using Vacuum = int[];
+  (void)Vacuum{(io_root_impl::read_bulk_column(
+                  m_bulk[I], m_next, n, columns.template column<I>()),
+                0)...};
+#else
+  (void)n;
+  (void)columns;
+#endif
+}
+
+template<typename NamedTuple>
+inline NamedTupleColumns<NamedTuple>
+NamedTupleRootReader<NamedTuple>::read_batch(std::size_t n) {
+  NamedTupleColumns<NamedTuple> columns;
+  columns.reserve(n);
+  read_batch(n, columns);
+  return columns;
+}
+
+// read the next entry into the local buffer
+template<typename NamedTuple>
+inline bool
+NamedTupleRootReader<NamedTuple>::read_entry() {
+  if (m_end <= m_next) {
+    return false;
+  }
+  Int_t ret = 0;
+  {
+    auto timer = m_recorder.time_io();
+    ret = m_tree->GetEntry(m_next);
+  }
   // i/o error occured
   if (ret < 0) {
     throw std::runtime_error("Could not read entry");
@@ -343,10 +784,48 @@ NamedTupleRootReader<NamedTuple>::read(NamedTuple& record) {
   if (ret == 0) {
     return false;
   }
-  // GetEntry(...) has already filled the local buffer
-  record = m_data;
   m_next += 1;
+  m_recorder.add_bytes(ret);
+  m_recorder.add_records(1);
   return true;
 }
 
+template<typename NamedTuple>
+inline void
+NamedTupleRootReader<NamedTuple>::set_cache_size(std::size_t bytes) {
+  // the cache is attached to the file of the current tree of a chain
+  m_tree->LoadTree(m_next);
+  m_tree->SetCacheSize(static_cast<Long64_t>(bytes));
+  if (bytes == 0) {
+    return;
+  }
+  // only cache the branches that are read to avoid a learning phase
+  for (const auto& name : NamedTuple::names()) {
+    m_tree->AddBranchToCache(name.c_str(), true);
+  }
+  m_tree->StopCacheLearningPhase();
+  if (m_end != std::numeric_limits<int64_t>::max()) {
+    m_tree->SetCacheEntryRange(m_next, m_end);
+  }
+}
+
+template<typename NamedTuple>
+inline std::vector<std::unique_ptr<NamedTupleRootReader<NamedTuple>>>
+NamedTupleRootReader<NamedTuple>::split(std::size_t n) {
+  if (m_paths.empty()) {
+    throw std::runtime_error("Readers w/o input paths can not be split");
+  }
+  // readers are intended to be used on separate threads
+  ROOT::EnableThreadSafety();
+  auto end = std::min<int64_t>(m_end, m_tree->GetEntries());
+  std::vector<std::unique_ptr<NamedTupleRootReader>> readers;
+  for (const auto& range :
+       io_root_impl::partition_clusters(*m_tree, m_next, end, n)) {
+    readers.emplace_back(new NamedTupleRootReader(
+      m_paths, m_tree_name, range.first, range.second));
+  }
+  m_next = std::max(m_next, end);
+  return readers;
+}
+
 } // namespace dfe
@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: MIT
+// Copyright 2020 Moritz Kiehn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/// \file
+/// \brief   Convert histograms to ROOT TH1/TH2/THn histograms
+/// \author  Moritz Kiehn <msmk@cern.ch>
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <TDirectory.h>
+#include <TH1D.h>
+#include <TH2D.h>
+#include <THn.h>
+
+#include "dfe_histogram.hpp"
+
+namespace dfe {
+
+/// Convert a one-dimensional histogram into a ROOT TH1D.
+///
+/// The returned histogram is not attached to any ROOT directory. Bins of
+/// axes w/o under/overflow bins are mapped onto the ROOT data bins and the
+/// ROOT under/overflow bins stay empty.
+template<typename T, typename Axis>
+std::unique_ptr<TH1D> make_th1(
+  const Histogram<T, Axis>& h, const std::string& name,
+  const std::string& title = std::string());
+/// Convert a two-dimensional histogram into a ROOT TH2D.
+///
+/// \see make_th1 for details
+template<typename T, typename Axis0, typename Axis1>
+std::unique_ptr<TH2D> make_th2(
+  const Histogram<T, Axis0, Axis1>& h, const std::string& name,
+  const std::string& title = std::string());
+/// Convert a histogram with arbitrary dimensions into a ROOT THnD.
+///
+/// \see make_th1 for details
+template<typename T, typename... Axes>
+std::unique_ptr<THnD> make_thn(
+  const Histogram<T, Axes...>& h, const std::string& name,
+  const std::string& title = std::string());
+
+/// Write a histogram into a ROOT directory. Overwrites existing objects.
+///
+/// One- and two-dimensional histograms are written as TH1D and TH2D and
+/// histograms with more dimensions as THnD.
+template<typename T, typename... Axes>
+void write_root_histogram(
+  TDirectory& dir, const std::string& name, const Histogram<T, Axes...>& h);
+
+// implementation helpers
+namespace io_root_histogram_impl {
+
+// Binning of a single axis in ROOT conventions.
+struct RootAxis {
+  std::vector<Double_t> edges;
+  // bin index offset, i.e. 1 for axes w/o underflow bin
+  std::size_t offset;
+
+  Int_t nbins() const { return static_cast<Int_t>(edges.size() - 1); }
+};
+
+template<typename Axis>
+inline RootAxis
+make_axis(const Axis& axis) {
+  RootAxis result;
+  const auto& edges = axis.edges();
+  result.edges.assign(edges.begin(), edges.end());
+  // axes with under/overflow bins have more bins than data bins
+  result.offset = (axis.nbins() == (edges.size() - 1)) ? 1u : 0u;
+  return result;
+}
+
+template<typename T, typename... Axes, std::size_t... Is>
+inline std::array<RootAxis, sizeof...(Axes)>
+make_axes(const Histogram<T, Axes...>& h, std::index_sequence<Is...>) {
+  return {{make_axis(h.template axis<Is>())...}};
+}
+
+// Call the function with the ROOT bin indices and each stored bin content.
+template<typename T, typename... Axes, typename Function>
+inline void
+for_each_bin(
+  const Histogram<T, Axes...>& h,
+  const std::array<RootAxis, sizeof...(Axes)>& axes, Function&& fn) {
+  constexpr std::size_t kNDimensions = sizeof...(Axes);
+  using Weight = typename Histogram<T, Axes...>::Weight;
+
+  const auto& size = h.data().size();
+  auto total = histogram_impl::total_size(size);
+  typename Histogram<T, Axes...>::Index idx = {};
+  std::array<Int_t, kNDimensions> root_idx;
+  for (std::size_t i = 0; i < total; ++i) {
+    for (std::size_t d = 0; d < kNDimensions; ++d) {
+      root_idx[d] = static_cast<Int_t>(idx[d] + axes[d].offset);
+    }
+    fn(root_idx, static_cast<Weight>(h.value(idx)));
+    // advance the column-major index
+    for (std::size_t d = 0; d < kNDimensions; ++d) {
+      if (++idx[d] < size[d]) {
+        break;
+      }
+      idx[d] = 0;
+    }
+  }
+}
+
+// Store the content directly in the continuous ROOT bin array.
+template<typename TH, typename T, typename... Axes>
+inline void
+fill_array(
+  TH& th, const Histogram<T, Axes...>& h,
+  const std::array<RootAxis, sizeof...(Axes)>& axes) {
+  constexpr std::size_t kNDimensions = sizeof...(Axes);
+
+  // ROOT uses column-major order including under/overflow bins
+  std::array<std::size_t, kNDimensions> strides;
+  std::size_t step = 1;
+  for (std::size_t d = 0; d < kNDimensions; ++d) {
+    strides[d] = step;
+    step *= axes[d].edges.size() + 1;
+  }
+  Double_t* array = th.GetArray();
+  for_each_bin(
+    h, axes, [&](const std::array<Int_t, kNDimensions>& idx, double value) {
+      std::size_t bin = 0;
+      for (std::size_t d = 0; d < kNDimensions; ++d) {
+        bin += strides[d] * static_cast<std::size_t>(idx[d]);
+      }
+      array[bin] = value;
+    });
+  th.ResetStats();
+}
+
+// Select the ROOT histogram type based on the dimensions.
+template<typename T, typename Axis>
+inline std::unique_ptr<TH1D>
+make_root(const Histogram<T, Axis>& h, const std::string& name) {
+  return make_th1(h, name);
+}
+template<typename T, typename Axis0, typename Axis1>
+inline std::unique_ptr<TH2D>
+make_root(const Histogram<T, Axis0, Axis1>& h, const std::string& name) {
+  return make_th2(h, name);
+}
+template<typename T, typename... Axes>
+inline std::unique_ptr<THnD>
+make_root(const Histogram<T, Axes...>& h, const std::string& name) {
+  return make_thn(h, name);
+}
+
+} // namespace io_root_histogram_impl
+
+// implementation
+
+template<typename T, typename Axis>
+inline std::unique_ptr<TH1D>
+make_th1(
+  const Histogram<T, Axis>& h, const std::string& name,
+  const std::string& title) {
+  auto axes = io_root_histogram_impl::make_axes(h, std::index_sequence<0>());
+  std::unique_ptr<TH1D> th(new TH1D(
+    name.c_str(), title.c_str(), axes[0].nbins(), axes[0].edges.data()));
+  // ownership is handled by the unique_ptr and not by the current directory
+  th->SetDirectory(nullptr);
+  io_root_histogram_impl::fill_array(*th, h, axes);
+  return th;
+}
+
+template<typename T, typename Axis0, typename Axis1>
+inline std::unique_ptr<TH2D>
+make_th2(
+  const Histogram<T, Axis0, Axis1>& h, const std::string& name,
+  const std::string& title) {
+  auto axes =
+    io_root_histogram_impl::make_axes(h, std::index_sequence<0, 1>());
+  std::unique_ptr<TH2D> th(new TH2D(
+    name.c_str(), title.c_str(), axes[0].nbins(), axes[0].edges.data(),
+    axes[1].nbins(), axes[1].edges.data()));
+  // ownership is handled by the unique_ptr and not by the current directory
+  th->SetDirectory(nullptr);
+  io_root_histogram_impl::fill_array(*th, h, axes);
+  return th;
+}
+
+template<typename T, typename... Axes>
+inline std::unique_ptr<THnD>
+make_thn(
+  const Histogram<T, Axes...>& h, const std::string& name,
+  const std::string& title) {
+  constexpr std::size_t kNDimensions = sizeof...(Axes);
+
+  auto axes =
+    io_root_histogram_impl::make_axes(h, std::index_sequence_for<Axes...>());
+  std::array<Int_t, kNDimensions> nbins;
+  std::array<Double_t, kNDimensions> lower;
+  std::array<Double_t, kNDimensions> upper;
+  for (std::size_t d = 0; d < kNDimensions; ++d) {
+    nbins[d] = axes[d].nbins();
+    lower[d] = axes[d].edges.front();
+    upper[d] = axes[d].edges.back();
+  }
+  std::unique_ptr<THnD> th(new THnD(
+    name.c_str(), title.c_str(), static_cast<Int_t>(kNDimensions),
+    nbins.data(), lower.data(), upper.data()));
+  for (std::size_t d = 0; d < kNDimensions; ++d) {
+    th->SetBinEdges(static_cast<Int_t>(d), axes[d].edges.data());
+  }
+  Double_t entries = 0;
+  io_root_histogram_impl::for_each_bin(
+    h, axes, [&](const std::array<Int_t, kNDimensions>& idx, double value) {
+      if (value != 0) {
+        th->SetBinContent(idx.data(), value);
+        entries += value;
+      }
+    });
+  th->SetEntries(entries);
+  return th;
+}
+
+template<typename T, typename... Axes>
+inline void
+write_root_histogram(
+  TDirectory& dir, const std::string& name, const Histogram<T, Axes...>& h) {
+  auto th = io_root_histogram_impl::make_root(h, name);
+  dir.WriteTObject(th.get(), name.c_str(), "Overwrite");
+}
+
+} // namespace dfe
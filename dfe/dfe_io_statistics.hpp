@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: MIT
+// Copyright 2020 Moritz Kiehn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/// \file
+/// \brief   Opt-in i/o statistics shared by the i/o libraries
+/// \author  Moritz Kiehn <msmk@cern.ch>
+///
+/// Statistics are only collected if `DFE_USE_IO_STATISTICS` is defined
+/// before including any i/o header. The definition must be identical for all
+/// translation units of a program. Otherwise, all recording compiles to
+/// no-ops and the reported statistics are always zero.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace dfe {
+
+/// Statistics collected by a single reader or writer instance.
+struct IoStatistics {
+  using Duration = std::chrono::nanoseconds;
+
+  /// Bytes read from or written to the file.
+  uint64_t bytes = 0;
+  /// Records or lines read or written.
+  uint64_t records = 0;
+  /// Buffer flushes for writers or buffer refills for readers.
+  uint64_t flushes = 0;
+  /// Maximum number of bytes held in the internal buffer.
+  uint64_t buffer_high_water = 0;
+  /// Time spent in the raw i/o operations.
+  Duration io_time = Duration::zero();
+  /// Time spent parsing or formatting values.
+  Duration convert_time = Duration::zero();
+};
+
+/// Function to export statistics, e.g. into a metrics system.
+///
+/// Writers call it after each flush; all instances call it on destruction.
+using IoStatisticsCallback = std::function<void(const IoStatistics&)>;
+
+namespace io_statistics_impl {
+
+#ifdef DFE_USE_IO_STATISTICS
+
+/// Record statistics for a single reader or writer instance.
+class Recorder {
+public:
+  /// Add the elapsed time during its lifetime to a duration.
+  class Timer {
+  public:
+    Timer(const Timer&) = delete;
+    // required to return timers by value; only the moved-to timer counts
+    Timer(Timer&& other)
+      : m_duration(other.m_duration), m_start(other.m_start) {
+      other.m_duration = nullptr;
+    }
+    ~Timer() {
+      if (m_duration) {
+        *m_duration += std::chrono::duration_cast<IoStatistics::Duration>(
+          Clock::now() - m_start);
+      }
+    }
+    Timer& operator=(const Timer&) = delete;
+    Timer& operator=(Timer&&) = delete;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    explicit Timer(IoStatistics::Duration& duration)
+      : m_duration(&duration), m_start(Clock::now()) {}
+
+    IoStatistics::Duration* m_duration;
+    Clock::time_point m_start;
+
+    friend class Recorder;
+  };
+
+  Recorder() = default;
+  Recorder(const Recorder&) = delete;
+  // the moved-from recorder must not report again
+  Recorder(Recorder&& other)
+    : m_statistics(other.m_statistics)
+    , m_callback(std::move(other.m_callback)) {
+    other.m_callback = nullptr;
+  }
+  ~Recorder() { report(); }
+  Recorder& operator=(const Recorder&) = delete;
+  Recorder& operator=(Recorder&& other) {
+    report();
+    m_statistics = other.m_statistics;
+    m_callback = std::move(other.m_callback);
+    other.m_callback = nullptr;
+    return *this;
+  }
+
+  Timer time_io() { return Timer(m_statistics.io_time); }
+  Timer time_convert() { return Timer(m_statistics.convert_time); }
+  void add_bytes(uint64_t n) { m_statistics.bytes += n; }
+  void add_records(uint64_t n) { m_statistics.records += n; }
+  void add_flush() { m_statistics.flushes += 1; }
+  void update_buffer(uint64_t size) {
+    m_statistics.buffer_high_water =
+      std::max(m_statistics.buffer_high_water, size);
+  }
+
+  const IoStatistics& statistics() const { return m_statistics; }
+  void set_callback(IoStatisticsCallback&& callback) {
+    m_callback = std::move(callback);
+  }
+  /// Call the callback, if any, with the current statistics.
+  void report() const {
+    if (m_callback) {
+      m_callback(m_statistics);
+    }
+  }
+
+private:
+  IoStatistics m_statistics;
+  IoStatisticsCallback m_callback;
+};
+
+#else
+
+// All operations are empty and are removed entirely by the compiler.
+class Recorder {
+public:
+  struct Timer {
+    // user-provided to avoid unused variable warnings
+    Timer() {}
+    ~Timer() {}
+  };
+
+  Timer time_io() { return {}; }
+  Timer time_convert() { return {}; }
+  void add_bytes(uint64_t) {}
+  void add_records(uint64_t) {}
+  void add_flush() {}
+  void update_buffer(uint64_t) {}
+
+  const IoStatistics& statistics() const {
+    static const IoStatistics kEmpty;
+    return kEmpty;
+  }
+  void set_callback(IoStatisticsCallback&&) {}
+  void report() const {}
+};
+
+#endif
+
+} // namespace io_statistics_impl
+} // namespace dfe
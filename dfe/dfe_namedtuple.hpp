@@ -31,23 +31,33 @@
 
 #include <array>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <ostream>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 /// Enable tuple-like access and conversion for selected class/struct members.
 ///
 /// This allows access to the selected members via `.get<I>()` or `get<I>(...)`,
 /// conversion to equivalent `std::tuple<...>` via implicit conversion or
 /// explicitely via `.tuple()`,  and assignment from equivalent tuples.
-/// The names can be accessed via `::names()`.
+/// The names can be accessed via `::names()` or without allocations and at
+/// compile time via `::field_names()`.
 #define DFE_NAMEDTUPLE(name, ...) \
   using Tuple = decltype(::std::make_tuple(__VA_ARGS__)); \
+  static constexpr ::std::array< \
+    ::dfe::FieldName, ::std::tuple_size<Tuple>::value> \
+  field_names() { \
+    return ::dfe::namedtuple_impl::split_names< \
+      ::std::tuple_size<Tuple>::value>((#__VA_ARGS__)); \
+  } \
   static ::std::array<::std::string, ::std::tuple_size<Tuple>::value> \
   names() { \
-    return ::dfe::namedtuple_impl::unstringify< \
-      ::std::tuple_size<Tuple>::value>((#__VA_ARGS__)); \
+    return ::dfe::namedtuple_impl::to_strings(field_names()); \
   } \
   template<typename... U> \
   name& operator=(const ::std::tuple<U...>& other) { \
@@ -81,44 +91,261 @@
   friend inline ::std::ostream& operator<<(::std::ostream& os, const name& nt) \
     __attribute__((unused)) { \
     return ::dfe::namedtuple_impl::print_tuple( \
-      os, nt.names(), nt.tuple(), \
+      os, nt.field_names(), nt.tuple(), \
       ::std::make_index_sequence<::std::tuple_size<Tuple>::value>{}); \
   }
 
-// implementation helpers
 namespace dfe {
+
+/// Non-owning view of a member name of a named tuple.
+///
+/// The name is not null-terminated and can be used in constant expressions.
+class FieldName {
+public:
+  constexpr FieldName() = default;
+  constexpr FieldName(const char* data, std::size_t size)
+    : m_data(data), m_size(size) {}
+
+  constexpr const char* data() const { return m_data; }
+  constexpr std::size_t size() const { return m_size; }
+  /// Create an owning copy of the name.
+  std::string to_string() const { return std::string(m_data, m_size); }
+
+  constexpr bool operator==(FieldName other) const;
+  constexpr bool operator==(const char* other) const;
+  bool operator==(const std::string& other) const;
+  template<typename T>
+  constexpr bool operator!=(const T& other) const {
+    return !(*this == other);
+  }
+
+private:
+  const char* m_data = nullptr;
+  std::size_t m_size = 0;
+};
+
+inline bool
+operator==(const std::string& lhs, FieldName rhs) {
+  return (rhs == lhs);
+}
+inline bool
+operator!=(const std::string& lhs, FieldName rhs) {
+  return !(rhs == lhs);
+}
+inline std::ostream&
+operator<<(std::ostream& os, FieldName name) {
+  return os.write(name.data(), name.size());
+}
+
+/// Compile-time information about the members of a named tuple.
+///
+/// \tparam NamedTuple Type created with `DFE_NAMEDTUPLE`
+///
+/// Allows I/O backends to precompute column mappings and copy plans once.
+/// Sizes refer to the in-memory member types; the packed layout stores all
+/// members consecutively without padding in the order given to the macro.
+template<typename NamedTuple>
+struct NamedTupleLayout {
+  using Tuple = typename NamedTuple::Tuple;
+  static constexpr std::size_t kNumFields = std::tuple_size<Tuple>::value;
+  using Names = std::array<FieldName, kNumFields>;
+  using Sizes = std::array<std::size_t, kNumFields>;
+
+  /// Member names in the order given to the macro.
+  static constexpr Names names() { return NamedTuple::field_names(); }
+  /// Index of the member with the given name or `kNumFields` if unknown.
+  template<typename Name>
+  static constexpr std::size_t index(const Name& name);
+  /// Size in bytes of each member.
+  static constexpr Sizes sizes();
+  /// Size in bytes of all members without padding.
+  static constexpr std::size_t packed_size();
+  /// Offsets in bytes of each member in the packed layout.
+  static constexpr Sizes packed_offsets();
+  /// Offsets in bytes of each member within the object.
+  ///
+  /// Computed once from a default-constructed object on first use.
+  static const Sizes& offsets();
+  /// Whether the in-memory layout is identical to the packed layout.
+  ///
+  /// If true, records can be copied from and to the packed layout as a whole
+  /// without handling each member separately.
+  static bool is_packed();
+
+private:
+  template<std::size_t... I>
+  static constexpr Sizes sizes_impl(std::index_sequence<I...>);
+  template<std::size_t... I>
+  static constexpr Sizes packed_offsets_impl(std::index_sequence<I...>);
+  // Total size of the first n members.
+  static constexpr std::size_t sum_sizes(std::size_t n);
+  template<std::size_t... I>
+  static Sizes offsets_impl(std::index_sequence<I...>);
+};
+
 namespace namedtuple_impl {
 
-// Reverse macro stringification.
+// Column storage type for a single tuple member.
 //
-// Splits a string of the form `a, b, c` into components a, b, and c.
-template<std::size_t N>
-constexpr std::array<std::string, N>
-unstringify(const char* str) {
-  assert(str and "Input string must be non-null");
+// `std::vector<bool>` is not contiguous; store booleans as bytes instead.
+template<typename T>
+struct Column {
+  using type = std::vector<T>;
+};
+template<>
+struct Column<bool> {
+  using type = std::vector<uint8_t>;
+};
+template<typename Tuple>
+struct Columns;
+template<typename... T>
+struct Columns<std::tuple<T...>> {
+  using type = std::tuple<typename Column<T>::type...>;
+};
 
-  std::array<std::string, N> out;
+} // namespace namedtuple_impl
 
-  for (std::size_t idx = 0; idx < N; ++idx) {
-    // skip leading whitespace
-    while ((*str != '\0') and (*str == ' ')) {
-      ++str;
+/// Column-oriented storage of named tuples w/ one vector per tuple member.
+///
+/// \tparam NamedTuple Type created with `DFE_NAMEDTUPLE`
+///
+/// Each tuple member is stored in a separate, contiguous `std::vector`.
+/// Boolean members are stored as `uint8_t` since `std::vector<bool>` is not
+/// contiguous.
+template<typename NamedTuple>
+class NamedTupleColumns {
+public:
+  using Tuple = typename NamedTuple::Tuple;
+  using Columns = typename namedtuple_impl::Columns<Tuple>::type;
+  using size_type = std::size_t;
+  /// The column type for the I-th tuple member.
+  template<std::size_t I>
+  using Column = std::tuple_element_t<I, Columns>;
+
+  /// Return true if there are no records stored.
+  bool empty() const { return (size() == 0); }
+  /// Return the number of stored records.
+  size_type size() const { return std::get<0>(m_columns).size(); }
+
+  /// Writable access to the column of the I-th tuple member.
+  template<std::size_t I>
+  Column<I>& column() {
+    return std::get<I>(m_columns);
+  }
+  /// Read-only access to the column of the I-th tuple member.
+  template<std::size_t I>
+  const Column<I>& column() const {
+    return std::get<I>(m_columns);
+  }
+  /// Read-only access to all columns.
+  const Columns& columns() const { return m_columns; }
+
+  /// Remove all records while keeping the allocated memory.
+  void clear() { apply_all(Clear{}); }
+  /// Reserve memory for the given number of records in all columns.
+  void reserve(size_type n) { apply_all(Reserve{n}); }
+  /// Append a record at the end of all columns.
+  void push_back(const NamedTuple& record) {
+    push_back_impl(record, std::make_index_sequence<kNumColumns>{});
+  }
+  /// Construct the record stored at the given position.
+  NamedTuple record(size_type idx) const {
+    return record_impl(idx, std::make_index_sequence<kNumColumns>{});
+  }
+
+private:
+  static constexpr std::size_t kNumColumns = std::tuple_size<Tuple>::value;
+
+  struct Clear {
+    template<typename C>
+    void operator()(C& column) const {
+      column.clear();
     }
-    // find the next separator or end-of-string
-    const char* sep = str;
-    while ((*sep != '\0') and (*sep != ',')) {
-      ++sep;
+  };
+  struct Reserve {
+    size_type n;
+    template<typename C>
+    void operator()(C& column) const {
+      column.reserve(n);
     }
-    // store component w/o the separator
-    out[idx].assign(str, sep - str);
-    // we can quit as soon as we reached the end of the input
-    if (*sep == '\0') {
-      break;
+  };
+
+  template<typename Operation>
+  void apply_all(Operation op) {
+    apply_impl(op, std::make_index_sequence<kNumColumns>{});
+  }
+  template<typename Operation, std::size_t... I>
+  void apply_impl(Operation op, std::index_sequence<I...>) {
+    // see namedtuple_impl::print_tuple for explanation
+    using Vacuum = int[];
+    (void)Vacuum{(op(std::get<I>(m_columns)), 0)...};
+  }
+  template<std::size_t... I>
+  void push_back_impl(const NamedTuple& record, std::index_sequence<I...>) {
+    using std::get;
+    using Vacuum = int[];
+    (void)Vacuum{(std::get<I>(m_columns).push_back(get<I>(record)), 0)...};
+  }
+  template<std::size_t... I>
+  NamedTuple record_impl(size_type idx, std::index_sequence<I...>) const {
+    NamedTuple record;
+    record = Tuple(static_cast<std::tuple_element_t<I, Tuple>>(
+      std::get<I>(m_columns)[idx])...);
+    return record;
+  }
+
+  Columns m_columns;
+};
+
+// implementation helpers
+namespace namedtuple_impl {
+
+// Reverse macro stringification for a single component.
+//
+// Selects the idx-th component b from a string of the form `a, b, c`.
+constexpr FieldName
+split_name(const char* str, std::size_t idx) {
+  // skip all previous components including their separators
+  for (; (*str != '\0') and (0 < idx); ++str) {
+    if (*str == ',') {
+      --idx;
     }
-    // start search for next component after the separator
-    str = ++sep;
   }
-  // TODO handle inconsistent number of entries? can it occur in expected use?
+  // skip leading whitespace
+  while ((*str != '\0') and (*str == ' ')) {
+    ++str;
+  }
+  // find the next separator or end-of-string
+  std::size_t size = 0;
+  while ((str[size] != '\0') and (str[size] != ',') and (str[size] != ' ')) {
+    ++size;
+  }
+  return {str, size};
+}
+
+template<std::size_t... I>
+constexpr std::array<FieldName, sizeof...(I)>
+split_names_impl(const char* str, std::index_sequence<I...>) {
+  // the array can only be filled via aggregate initialization in C++14
+  return {{split_name(str, I)...}};
+}
+
+// Reverse macro stringification.
+//
+// Splits a string of the form `a, b, c` into components a, b, and c.
+template<std::size_t N>
+constexpr std::array<FieldName, N>
+split_names(const char* str) {
+  return split_names_impl(str, std::make_index_sequence<N>{});
+}
+
+template<std::size_t N>
+inline std::array<std::string, N>
+to_strings(const std::array<FieldName, N>& names) {
+  std::array<std::string, N> out;
+  for (std::size_t i = 0; i < N; ++i) {
+    out[i] = names[i].to_string();
+  }
   return out;
 }
 
@@ -166,4 +393,127 @@ print_tuple(
 }
 
 } // namespace namedtuple_impl
+
+// implementation FieldName
+
+constexpr bool
+FieldName::operator==(FieldName other) const {
+  if (m_size != other.m_size) {
+    return false;
+  }
+  for (std::size_t i = 0; i < m_size; ++i) {
+    if (m_data[i] != other.m_data[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+constexpr bool
+FieldName::operator==(const char* other) const {
+  std::size_t i = 0;
+  for (; (i < m_size) and (other[i] != '\0'); ++i) {
+    if (m_data[i] != other[i]) {
+      return false;
+    }
+  }
+  return (i == m_size) and (other[i] == '\0');
+}
+
+inline bool
+FieldName::operator==(const std::string& other) const {
+  return (*this == FieldName(other.data(), other.size()));
+}
+
+// implementation NamedTupleLayout
+
+template<typename NamedTuple>
+constexpr std::size_t NamedTupleLayout<NamedTuple>::kNumFields;
+
+template<typename NamedTuple>
+template<typename Name>
+constexpr std::size_t
+NamedTupleLayout<NamedTuple>::index(const Name& name) {
+  const Names all = names();
+  for (std::size_t i = 0; i < kNumFields; ++i) {
+    if (all[i] == name) {
+      return i;
+    }
+  }
+  return kNumFields;
+}
+
+template<typename NamedTuple>
+constexpr typename NamedTupleLayout<NamedTuple>::Sizes
+NamedTupleLayout<NamedTuple>::sizes() {
+  return sizes_impl(std::make_index_sequence<kNumFields>{});
+}
+
+template<typename NamedTuple>
+template<std::size_t... I>
+constexpr typename NamedTupleLayout<NamedTuple>::Sizes
+NamedTupleLayout<NamedTuple>::sizes_impl(std::index_sequence<I...>) {
+  return {{sizeof(std::tuple_element_t<I, Tuple>)...}};
+}
+
+template<typename NamedTuple>
+constexpr std::size_t
+NamedTupleLayout<NamedTuple>::packed_size() {
+  return sum_sizes(kNumFields);
+}
+
+template<typename NamedTuple>
+constexpr typename NamedTupleLayout<NamedTuple>::Sizes
+NamedTupleLayout<NamedTuple>::packed_offsets() {
+  return packed_offsets_impl(std::make_index_sequence<kNumFields>{});
+}
+
+template<typename NamedTuple>
+template<std::size_t... I>
+constexpr typename NamedTupleLayout<NamedTuple>::Sizes
+NamedTupleLayout<NamedTuple>::packed_offsets_impl(std::index_sequence<I...>) {
+  return {{sum_sizes(I)...}};
+}
+
+template<typename NamedTuple>
+constexpr std::size_t
+NamedTupleLayout<NamedTuple>::sum_sizes(std::size_t n) {
+  const Sizes all = sizes();
+  std::size_t total = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    total += all[i];
+  }
+  return total;
+}
+
+template<typename NamedTuple>
+inline const typename NamedTupleLayout<NamedTuple>::Sizes&
+NamedTupleLayout<NamedTuple>::offsets() {
+  static const Sizes kOffsets =
+    offsets_impl(std::make_index_sequence<kNumFields>{});
+  return kOffsets;
+}
+
+template<typename NamedTuple>
+template<std::size_t... I>
+inline typename NamedTupleLayout<NamedTuple>::Sizes
+NamedTupleLayout<NamedTuple>::offsets_impl(std::index_sequence<I...>) {
+  // the member addresses can only be determined w/ an actual object
+  NamedTuple nt;
+  const char* base = reinterpret_cast<const char*>(&nt);
+  return {{static_cast<std::size_t>(
+    reinterpret_cast<const char*>(&nt.template get<I>()) - base)...}};
+}
+
+template<typename NamedTuple>
+inline bool
+NamedTupleLayout<NamedTuple>::is_packed() {
+  // the in-memory layout can only match w/o padding or unnamed members
+  if (not std::is_trivially_copyable<NamedTuple>::value or
+      (sizeof(NamedTuple) != packed_size())) {
+    return false;
+  }
+  return (offsets() == packed_offsets());
+}
+
 } // namespace dfe
@@ -25,6 +25,7 @@
 /// \date    2018-02-26
 
 #include <array>
+#include <cstddef>
 #include <iterator>
 #include <type_traits>
 #include <utility>
@@ -32,6 +33,31 @@
 #pragma once
 
 namespace dfe {
+namespace poly_impl {
+
+// Number of interleaved evaluations in the batched functions.
+constexpr std::size_t kLanes = 8;
+
+template<std::size_t I, std::size_t N>
+using HasNext = std::integral_constant<bool, ((I + 1) < N)>;
+
+// Unrolled Horner's method starting at the I-th coefficient.
+template<std::size_t I, typename T, typename U, std::size_t N>
+constexpr T horner(const T&, const std::array<U, N>& c, std::false_type);
+template<std::size_t I, typename T, typename U, std::size_t N>
+constexpr T horner(const T& x, const std::array<U, N>& c, std::true_type);
+template<std::size_t I, typename T, typename U, std::size_t N>
+constexpr std::pair<T, T>
+horner_valder(const T&, const std::array<U, N>& c, std::false_type);
+template<std::size_t I, typename T, typename U, std::size_t N>
+constexpr std::pair<T, T>
+horner_valder(const T& x, const std::array<U, N>& c, std::true_type);
+
+// Coefficient or zero if beyond the end.
+template<typename T, typename Container>
+constexpr T coefficient(const Container& c, std::size_t i);
+
+} // namespace poly_impl
 
 /// Evaluate a polynomial of arbitrary order.
 ///
@@ -126,4 +152,190 @@ polynomial_valder(const T& x, std::initializer_list<U> coeffs) {
   return polynomial_valder<T, std::initializer_list<U>>(x, coeffs);
 }
 
+/// Evaluate a polynomial with the order fixed at compile time.
+///
+/// The evaluation is fully unrolled and can be used in constant expressions.
+template<
+  typename T, typename U, std::size_t N,
+  typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+constexpr T
+polynomial_val(const T& x, const std::array<U, N>& coeffs) {
+  return (N == 0) ? T(0)
+                  : poly_impl::horner<0>(x, coeffs, poly_impl::HasNext<0, N>());
+}
+
+/// Evaluate the value and the derivative of a polynomial with the order fixed
+/// at compile time.
+template<
+  typename T, typename U, std::size_t N,
+  typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+constexpr std::pair<T, T>
+polynomial_valder(const T& x, const std::array<U, N>& coeffs) {
+  return (N == 0) ? std::pair<T, T>(T(0), T(0))
+                  : poly_impl::horner_valder<0>(
+                    x, coeffs, poly_impl::HasNext<0, N>());
+}
+
+/// Evaluate the derivative of a polynomial with the order fixed at compile
+/// time.
+template<
+  typename T, typename U, std::size_t N,
+  typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+constexpr T
+polynomial_der(const T& x, const std::array<U, N>& coeffs) {
+  return polynomial_valder(x, coeffs).second;
+}
+
+/// Evaluate a polynomial of arbitrary order using Estrin's scheme.
+///
+/// \param x      Where to evaluate the polynomial.
+/// \param coeffs Container with n+1 coefficients, `size()`, and `operator[]`.
+///
+/// The coefficients are split into blocks of eight, i.e.
+///
+///     f(x) = b0(x) + b1(x) * x^8 + b2(x) * x^16 + ...
+///
+/// Each block is evaluated as a tree of independent multiply-adds and the
+/// blocks are combined using Horner's method. This needs a few more
+/// multiplications but reduces the length of the dependency chain from n to
+/// about n/8 + 3 steps. Faster for higher orders where the latency of the
+/// sequential Horner steps dominates.
+template<typename T, typename Container>
+constexpr T
+polynomial_val_estrin(const T& x, const Container& coeffs) {
+  using poly_impl::coefficient;
+
+  const T x2 = x * x;
+  const T x4 = x2 * x2;
+  const T x8 = x4 * x4;
+  const std::size_t n = coeffs.size();
+  T value = 0;
+  for (std::size_t k = (n + 7) / 8; 0 < k--;) {
+    const std::size_t i = 8 * k;
+    T p0 = coefficient<T>(coeffs, i + 0) + x * coefficient<T>(coeffs, i + 1);
+    T p1 = coefficient<T>(coeffs, i + 2) + x * coefficient<T>(coeffs, i + 3);
+    T p2 = coefficient<T>(coeffs, i + 4) + x * coefficient<T>(coeffs, i + 5);
+    T p3 = coefficient<T>(coeffs, i + 6) + x * coefficient<T>(coeffs, i + 7);
+    value = ((p0 + x2 * p1) + x4 * (p2 + x2 * p3)) + x8 * value;
+  }
+  return value;
+}
+
+/// Evaluate a polynomial of arbitrary order for multiple values at once.
+///
+/// \param x      Pointer to n values where to evaluate the polynomial.
+/// \param n      Number of values.
+/// \param coeffs ReversibleContainer with the coefficients, see above.
+/// \param values Pointer to storage for n results; can be identical to x.
+///
+/// Several independent Horner evaluations are interleaved to hide the latency
+/// of the individual steps and to allow vectorization.
+template<typename T, typename Container>
+inline void
+polynomial_val_n(
+  const T* x, std::size_t n, const Container& coeffs, T* values) {
+  using poly_impl::kLanes;
+
+  std::size_t i = 0;
+  for (; (i + kLanes) <= n; i += kLanes) {
+    T xs[kLanes];
+    T ps[kLanes];
+    for (std::size_t l = 0; l < kLanes; ++l) {
+      xs[l] = x[i + l];
+      ps[l] = 0;
+    }
+    for (auto c = std::rbegin(coeffs); c != std::rend(coeffs); ++c) {
+      const T ci = *c;
+      for (std::size_t l = 0; l < kLanes; ++l) {
+        ps[l] = ci + xs[l] * ps[l];
+      }
+    }
+    for (std::size_t l = 0; l < kLanes; ++l) {
+      values[i + l] = ps[l];
+    }
+  }
+  for (; i < n; ++i) {
+    values[i] = polynomial_val(x[i], coeffs);
+  }
+}
+
+/// Evaluate value and derivative of a polynomial for multiple values at once.
+///
+/// \param x           Pointer to n values where to evaluate the polynomial.
+/// \param n           Number of values.
+/// \param coeffs      ReversibleContainer with the coefficients, see above.
+/// \param values      Pointer to storage for n values; can be identical to x.
+/// \param derivatives Pointer to storage for n derivatives.
+template<typename T, typename Container>
+inline void
+polynomial_valder_n(
+  const T* x, std::size_t n, const Container& coeffs, T* values,
+  T* derivatives) {
+  using poly_impl::kLanes;
+
+  std::size_t i = 0;
+  for (; (i + kLanes) <= n; i += kLanes) {
+    T xs[kLanes];
+    T ps[kLanes];
+    T qs[kLanes];
+    for (std::size_t l = 0; l < kLanes; ++l) {
+      xs[l] = x[i + l];
+      ps[l] = 0;
+      qs[l] = 0;
+    }
+    for (auto c = std::rbegin(coeffs); c != std::rend(coeffs); ++c) {
+      const T ci = *c;
+      for (std::size_t l = 0; l < kLanes; ++l) {
+        qs[l] = ps[l] + xs[l] * qs[l];
+        ps[l] = ci + xs[l] * ps[l];
+      }
+    }
+    for (std::size_t l = 0; l < kLanes; ++l) {
+      values[i + l] = ps[l];
+      derivatives[i + l] = qs[l];
+    }
+  }
+  for (; i < n; ++i) {
+    auto yd = polynomial_valder(x[i], coeffs);
+    values[i] = yd.first;
+    derivatives[i] = yd.second;
+  }
+}
+
+// implementation helpers
+
+template<std::size_t I, typename T, typename U, std::size_t N>
+constexpr T
+poly_impl::horner(const T&, const std::array<U, N>& c, std::false_type) {
+  return c[I];
+}
+
+template<std::size_t I, typename T, typename U, std::size_t N>
+constexpr T
+poly_impl::horner(const T& x, const std::array<U, N>& c, std::true_type) {
+  return c[I] + x * horner<I + 1>(x, c, HasNext<I + 1, N>());
+}
+
+template<std::size_t I, typename T, typename U, std::size_t N>
+constexpr std::pair<T, T>
+poly_impl::horner_valder(
+  const T&, const std::array<U, N>& c, std::false_type) {
+  return {c[I], T(0)};
+}
+
+template<std::size_t I, typename T, typename U, std::size_t N>
+constexpr std::pair<T, T>
+poly_impl::horner_valder(
+  const T& x, const std::array<U, N>& c, std::true_type) {
+  // same recursion as in the runtime version above
+  auto next = horner_valder<I + 1>(x, c, HasNext<I + 1, N>());
+  return {c[I] + x * next.first, next.first + x * next.second};
+}
+
+template<typename T, typename Container>
+constexpr T
+poly_impl::coefficient(const Container& c, std::size_t i) {
+  return (i < c.size()) ? static_cast<T>(c[i]) : T(0);
+}
+
 } // namespace dfe
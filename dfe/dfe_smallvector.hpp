@@ -26,8 +26,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
 #include <iterator>
 #include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 namespace dfe {
 
@@ -38,206 +44,534 @@ namespace dfe {
 /// \tparam Allocator Allocator for elements of type T
 ///
 /// If the vector contains less or equal than N elements, they are stored in
-/// the vector itself without the need to allocate additional memory.
+/// the vector itself without the need to allocate additional memory. Larger
+/// vectors move to heap-allocated storage whose capacity grows geometrically.
 ///
-/// Supports access by index, iteration over elements, deleting all existing
-/// elements from the vector, and adding elements at a specified location or at
-/// the back.
+/// Supports the common `std::vector` operations, i.e. access by index,
+/// iteration over elements, copy and move, reserving and releasing memory,
+/// resizing, and adding or removing elements at any position. Moving a vector
+/// with heap-allocated storage only moves the pointer. Trivially copyable
+/// elements are relocated with plain memory copies.
 template<typename T, std::size_t N, typename Allocator = std::allocator<T>>
 class SmallVector {
+  static_assert(0 < N, "In-place capacity must be non-zero");
+
+  template<typename InputIt>
+  using IfIterator = std::enable_if_t<!std::is_integral<InputIt>::value>;
+
 public:
   using value_type = T;
+  using allocator_type = Allocator;
   using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
   using iterator = T*;
   using const_iterator = const T*;
 
-  SmallVector() = default;
-  ~SmallVector() { clear(); }
-
-  value_type& operator[](size_type idx);
-  const value_type& operator[](size_type idx) const;
-
-  iterator begin();
-  iterator end() { return begin() + m_size; }
-  const_iterator begin() const;
-  const_iterator end() const { return begin() + m_size; }
+  SmallVector() : SmallVector(Allocator()) {}
+  explicit SmallVector(const Allocator& alloc);
+  /// Construct with n value-initialized elements.
+  explicit SmallVector(size_type n, const Allocator& alloc = Allocator());
+  /// Construct with n copies of the value.
+  SmallVector(
+    size_type n, const T& value, const Allocator& alloc = Allocator());
+  /// Construct with the elements from the range.
+  template<typename InputIt, typename = IfIterator<InputIt>>
+  SmallVector(
+    InputIt first, InputIt last, const Allocator& alloc = Allocator());
+  SmallVector(
+    std::initializer_list<T> init, const Allocator& alloc = Allocator())
+    : SmallVector(init.begin(), init.end(), alloc) {}
+  SmallVector(const SmallVector& other);
+  /// Steals heap-allocated storage or moves the in-place elements.
+  SmallVector(SmallVector&& other) noexcept(
+    std::is_nothrow_move_constructible<T>::value);
+  ~SmallVector();
+
+  SmallVector& operator=(const SmallVector& other);
+  SmallVector& operator=(SmallVector&& other);
+
+  allocator_type get_allocator() const { return m_alloc; }
+
+  value_type& operator[](size_type idx) { return m_data[idx]; }
+  const value_type& operator[](size_type idx) const { return m_data[idx]; }
+  /// \exception std::out_of_range if the index is invalid
+  value_type& at(size_type idx);
+  /// \exception std::out_of_range if the index is invalid
+  const value_type& at(size_type idx) const;
+  value_type& front() { return m_data[0]; }
+  const value_type& front() const { return m_data[0]; }
+  value_type& back() { return m_data[m_size - 1]; }
+  const value_type& back() const { return m_data[m_size - 1]; }
+  T* data() { return m_data; }
+  const T* data() const { return m_data; }
+
+  iterator begin() { return m_data; }
+  iterator end() { return m_data + m_size; }
+  const_iterator begin() const { return m_data; }
+  const_iterator end() const { return m_data + m_size; }
 
   /// Return true if there are no elements in the vector.
   bool empty() const { return (m_size == 0); }
   /// Return the number of elements in the vector.
   size_type size() const { return m_size; }
   /// Return the number of elements that can be stored in the available memory.
-  size_type capacity() const { return (m_size <= N) ? N : m_onheap.capacity; }
+  size_type capacity() const { return m_capacity; }
 
+  /// Ensure that the given number of elements can be stored w/o reallocation.
+  void reserve(size_type capacity);
+  /// Release unused memory and move back to in-place storage if possible.
+  void shrink_to_fit();
   /// Remove all elements.
   ///
-  /// This will release allocated memory if the vector contains more elements
-  /// than can be stored in-place.
+  /// The allocated memory is kept for further use; use `shrink_to_fit` to
+  /// release it.
   void clear();
+  /// Resize to n elements; additional elements are value-initialized.
+  void resize(size_type n);
+  /// Resize to n elements; additional elements are copies of the value.
+  void resize(size_type n, const T& value);
+
   /// Construct an element directly before the given position in the vector.
   template<typename... Args>
   iterator emplace(const_iterator pos, Args&&... args);
+  /// Insert a copy of the element before the given position.
+  iterator insert(const_iterator pos, const T& value) {
+    return emplace(pos, value);
+  }
+  /// Insert an element before the given position.
+  iterator insert(const_iterator pos, T&& value) {
+    return emplace(pos, std::move(value));
+  }
+  /// Insert all elements from the range before the given position.
+  ///
+  /// Memory is reallocated at most once for forward iterators.
+  template<typename InputIt, typename = IfIterator<InputIt>>
+  iterator insert(const_iterator pos, InputIt first, InputIt last);
   /// Construct an element at the back of the vector and return its reference.
   template<typename... Args>
   T& emplace_back(Args&&... args);
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+  /// Add all elements from the range at the back of the vector.
+  ///
+  /// Memory is reallocated at most once for forward iterators.
+  template<typename InputIt, typename = IfIterator<InputIt>>
+  void append(InputIt first, InputIt last);
+  /// Remove the last element.
+  void pop_back();
+  /// Remove the element at the given position.
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+  /// Remove all elements in the given range.
+  iterator erase(const_iterator first, const_iterator last);
 
 private:
-  struct AllocatedStorage {
-    size_type capacity;
-    T* data;
-  };
-
-  AllocatedStorage allocate_storage(size_type capacity);
-  void destruct_inplace();
-  void destruct_deallocate_onheap();
-
+  using AllocatorTraits = std::allocator_traits<Allocator>;
+  // relocate by copying the bytes if possible
+  using RelocateBytes = typename std::is_trivially_copyable<T>::type;
+
+  T* inplace() { return reinterpret_cast<T*>(m_inplace); }
+  const T* inplace() const { return reinterpret_cast<const T*>(m_inplace); }
+  bool is_inplace() const { return (m_data == inplace()); }
+  size_type grown_capacity(size_type required) const;
+  void reallocate(size_type capacity);
+  template<typename... Args>
+  void emplace_grow(size_type idx, Args&&... args);
+  void relocate(T* first, T* last, T* target);
+  void relocate(T* first, T* last, T* target, std::true_type);
+  void relocate(T* first, T* last, T* target, std::false_type);
+  void destroy(T* first, T* last);
+  void release();
+  template<typename InputIt>
+  void append(InputIt first, InputIt last, std::input_iterator_tag);
+  template<typename ForwardIt>
+  void append(ForwardIt first, ForwardIt last, std::forward_iterator_tag);
+
+  T* m_data;
   size_type m_size = 0;
-  union {
-    AllocatedStorage m_onheap;
-    // use 'raw' memory to have full control over constructor/destructor calls
-    alignas(T) char m_inplace[N * sizeof(T)];
-  };
+  size_type m_capacity = N;
   Allocator m_alloc;
+  // use 'raw' memory to have full control over constructor/destructor calls
+  alignas(T) char m_inplace[N * sizeof(T)];
 };
 
 // implementation
 
 template<typename T, std::size_t N, typename Allocator>
-inline typename SmallVector<T, N, Allocator>::AllocatedStorage
-SmallVector<T, N, Allocator>::allocate_storage(size_type capacity) {
-  AllocatedStorage s;
-  s.capacity = capacity;
-  s.data = std::allocator_traits<Allocator>::allocate(m_alloc, capacity);
-  return s;
+inline SmallVector<T, N, Allocator>::SmallVector(const Allocator& alloc)
+  : m_data(inplace()), m_alloc(alloc) {}
+
+template<typename T, std::size_t N, typename Allocator>
+inline SmallVector<T, N, Allocator>::SmallVector(
+  size_type n, const Allocator& alloc)
+  : SmallVector(alloc) {
+  resize(n);
 }
 
-// Destruct elements in in-place storage assuming they are valid.
 template<typename T, std::size_t N, typename Allocator>
-inline void
-SmallVector<T, N, Allocator>::destruct_inplace() {
-  T* ptr = reinterpret_cast<T*>(m_inplace);
-  for (T* end = ptr + m_size; ptr != end; ++ptr) {
-    ptr->~T();
+inline SmallVector<T, N, Allocator>::SmallVector(
+  size_type n, const T& value, const Allocator& alloc)
+  : SmallVector(alloc) {
+  resize(n, value);
+}
+
+template<typename T, std::size_t N, typename Allocator>
+template<typename InputIt, typename>
+inline SmallVector<T, N, Allocator>::SmallVector(
+  InputIt first, InputIt last, const Allocator& alloc)
+  : SmallVector(alloc) {
+  append(first, last);
+}
+
+template<typename T, std::size_t N, typename Allocator>
+inline SmallVector<T, N, Allocator>::SmallVector(const SmallVector& other)
+  : SmallVector(
+    AllocatorTraits::select_on_container_copy_construction(other.m_alloc)) {
+  append(other.begin(), other.end());
+}
+
+template<typename T, std::size_t N, typename Allocator>
+inline SmallVector<T, N, Allocator>::SmallVector(SmallVector&& other) noexcept(
+  std::is_nothrow_move_constructible<T>::value)
+  : SmallVector(std::move(other.m_alloc)) {
+  if (other.is_inplace()) {
+    relocate(other.begin(), other.end(), inplace());
+  } else {
+    m_data = other.m_data;
+    m_capacity = other.m_capacity;
+    other.m_data = other.inplace();
+    other.m_capacity = N;
   }
+  m_size = other.m_size;
+  other.m_size = 0;
 }
 
-// Destruct and deallocate elements in heap-allocated storage.
 template<typename T, std::size_t N, typename Allocator>
-inline void
-SmallVector<T, N, Allocator>::destruct_deallocate_onheap() {
-  T* ptr = m_onheap.data;
-  for (T* end = ptr + m_size; ptr != end; ++ptr) {
-    std::allocator_traits<Allocator>::destroy(m_alloc, ptr);
+inline SmallVector<T, N, Allocator>::~SmallVector() {
+  clear();
+  release();
+}
+
+template<typename T, std::size_t N, typename Allocator>
+inline SmallVector<T, N, Allocator>&
+SmallVector<T, N, Allocator>::operator=(const SmallVector& other) {
+  if (this == &other) {
+    return *this;
+  }
+  clear();
+  if (
+    AllocatorTraits::propagate_on_container_copy_assignment::value
+    and (m_alloc != other.m_alloc)) {
+    // memory must be released with the allocator that provided it
+    release();
+    m_alloc = other.m_alloc;
   }
-  std::allocator_traits<Allocator>::deallocate(
-    m_alloc, m_onheap.data, m_onheap.capacity);
-  m_onheap.capacity = 0;
-  m_onheap.data = nullptr;
+  append(other.begin(), other.end());
+  return *this;
 }
 
 template<typename T, std::size_t N, typename Allocator>
-inline T& SmallVector<T, N, Allocator>::operator[](size_type idx) {
-  if (m_size <= N) {
-    return *(reinterpret_cast<T*>(m_inplace) + idx);
+inline SmallVector<T, N, Allocator>&
+SmallVector<T, N, Allocator>::operator=(SmallVector&& other) {
+  constexpr bool kPropagate =
+    AllocatorTraits::propagate_on_container_move_assignment::value;
+
+  if (this == &other) {
+    return *this;
+  }
+  clear();
+  if (!other.is_inplace() and (kPropagate or (m_alloc == other.m_alloc))) {
+    release();
+    if (kPropagate) {
+      m_alloc = std::move(other.m_alloc);
+    }
+    m_data = other.m_data;
+    m_capacity = other.m_capacity;
+    m_size = other.m_size;
+    other.m_data = other.inplace();
+    other.m_capacity = N;
+    other.m_size = 0;
   } else {
-    return m_onheap.data[idx];
+    append(
+      std::make_move_iterator(other.begin()),
+      std::make_move_iterator(other.end()));
+    other.clear();
   }
+  return *this;
 }
 
 template<typename T, std::size_t N, typename Allocator>
-inline const T& SmallVector<T, N, Allocator>::operator[](size_type idx) const {
-  if (m_size <= N) {
-    return *(reinterpret_cast<const T*>(m_inplace) + idx);
-  } else {
-    return m_onheap.data[idx];
+inline T&
+SmallVector<T, N, Allocator>::at(size_type idx) {
+  if (m_size <= idx) {
+    throw std::out_of_range("SmallVector index is out of range");
   }
+  return m_data[idx];
 }
 
 template<typename T, std::size_t N, typename Allocator>
-inline typename SmallVector<T, N, Allocator>::iterator
-SmallVector<T, N, Allocator>::begin() {
-  return (m_size <= N) ? reinterpret_cast<T*>(m_inplace) : m_onheap.data;
+inline const T&
+SmallVector<T, N, Allocator>::at(size_type idx) const {
+  if (m_size <= idx) {
+    throw std::out_of_range("SmallVector index is out of range");
+  }
+  return m_data[idx];
 }
 
+// Grow geometrically to get amortized constant-time appends.
 template<typename T, std::size_t N, typename Allocator>
-inline typename SmallVector<T, N, Allocator>::const_iterator
-SmallVector<T, N, Allocator>::begin() const {
-  return (m_size <= N) ? reinterpret_cast<const T*>(m_inplace) : m_onheap.data;
+inline typename SmallVector<T, N, Allocator>::size_type
+SmallVector<T, N, Allocator>::grown_capacity(size_type required) const {
+  return std::max(required, 2 * m_capacity);
 }
 
+// Move all elements to new storage with the given capacity.
 template<typename T, std::size_t N, typename Allocator>
 inline void
-SmallVector<T, N, Allocator>::clear() {
-  if (m_size <= N) {
-    destruct_inplace();
-  } else {
-    destruct_deallocate_onheap();
+SmallVector<T, N, Allocator>::reallocate(size_type capacity) {
+  T* storage = (capacity <= N)
+                 ? inplace()
+                 : AllocatorTraits::allocate(m_alloc, capacity);
+  if (storage == m_data) {
+    return;
   }
-  m_size = 0;
+  relocate(begin(), end(), storage);
+  release();
+  m_data = storage;
+  m_capacity = (capacity <= N) ? N : capacity;
 }
 
+// Move-construct elements into uninitialized memory and destroy the sources.
 template<typename T, std::size_t N, typename Allocator>
-template<typename... Args>
-typename SmallVector<T, N, Allocator>::iterator
-SmallVector<T, N, Allocator>::emplace(const_iterator pos, Args&&... args) {
-  using AllocatorTraits = std::allocator_traits<Allocator>;
+inline void
+SmallVector<T, N, Allocator>::relocate(T* first, T* last, T* target) {
+  relocate(first, last, target, RelocateBytes());
+}
 
-  // TODO how, when to check iterator validity?
+template<typename T, std::size_t N, typename Allocator>
+inline void
+SmallVector<T, N, Allocator>::relocate(
+  T* first, T* last, T* target, std::true_type) {
+  if (first != last) {
+    std::memcpy(target, first, (last - first) * sizeof(T));
+  }
+}
 
-  // available storage is sufficient to hold one extra element.
-  // existing data after the insertion point needs to be shifted by 1 to the
-  // right so the new element can be constructed at the given position.
-  if (size() < capacity()) {
-    T* i = const_cast<T*>(pos);
-    T* e = end();
+template<typename T, std::size_t N, typename Allocator>
+inline void
+SmallVector<T, N, Allocator>::relocate(
+  T* first, T* last, T* target, std::false_type) {
+  for (T* source = first; source != last; ++source, ++target) {
+    AllocatorTraits::construct(m_alloc, target, std::move_if_noexcept(*source));
+  }
+  destroy(first, last);
+}
 
-    // the underlying storage is raw memory. in order for the move assignment
-    // to be well-defined, the memory for the additiona element needs to be
-    // (default-)initialized using placement-new first.
-    (void)new (e) T();
-    std::move_backward(i, e, std::next(e));
-    // insertion points contains moved-from object. move-assignment should be
-    // valid. placement-new construction would double-initialize.
-    *i = T(std::forward<Args>(args)...);
+template<typename T, std::size_t N, typename Allocator>
+inline void
+SmallVector<T, N, Allocator>::destroy(T* first, T* last) {
+  for (; first != last; ++first) {
+    AllocatorTraits::destroy(m_alloc, first);
+  }
+}
 
-    m_size += 1;
-    return i;
+// Release heap-allocated memory; the elements must already be destroyed.
+template<typename T, std::size_t N, typename Allocator>
+inline void
+SmallVector<T, N, Allocator>::release() {
+  if (!is_inplace()) {
+    AllocatorTraits::deallocate(m_alloc, m_data, m_capacity);
+    m_data = inplace();
+    m_capacity = N;
   }
+}
 
-  // available storage is in-sufficient. move to larger heap-allocated storage.
-  auto storage = allocate_storage(1.3f * (m_size + 1));
-  T* source = begin();
-  T* target = storage.data;
+template<typename T, std::size_t N, typename Allocator>
+inline void
+SmallVector<T, N, Allocator>::reserve(size_type capacity) {
+  if (m_capacity < capacity) {
+    reallocate(capacity);
+  }
+}
 
-  // move data before insertion point to the new storage
-  for (T* e = const_cast<T*>(pos); source != e; ++source, ++target) {
-    AllocatorTraits::construct(m_alloc, target, std::move(*source));
+template<typename T, std::size_t N, typename Allocator>
+inline void
+SmallVector<T, N, Allocator>::shrink_to_fit() {
+  if (!is_inplace() and (m_size < m_capacity)) {
+    reallocate(m_size);
   }
-  // construct element directly in the new storage
-  T* insert = target++;
-  AllocatorTraits::construct(m_alloc, insert, std::forward<Args>(args)...);
-  // move data after the insertion point to the new storage
-  for (T* e = end(); source != e; ++source, ++target) {
-    AllocatorTraits::construct(m_alloc, target, std::move(*source));
+}
+
+template<typename T, std::size_t N, typename Allocator>
+inline void
+SmallVector<T, N, Allocator>::clear() {
+  destroy(begin(), end());
+  m_size = 0;
+}
+
+template<typename T, std::size_t N, typename Allocator>
+inline void
+SmallVector<T, N, Allocator>::resize(size_type n) {
+  if (n < m_size) {
+    destroy(begin() + n, end());
+    m_size = n;
+  } else {
+    reserve(n);
+    for (; m_size < n; ++m_size) {
+      AllocatorTraits::construct(m_alloc, m_data + m_size);
+    }
   }
+}
 
-  // clear previous data before replacing it with the next storage
-  if (m_size == N) {
-    destruct_inplace();
+template<typename T, std::size_t N, typename Allocator>
+inline void
+SmallVector<T, N, Allocator>::resize(size_type n, const T& value) {
+  if (n < m_size) {
+    destroy(begin() + n, end());
+    m_size = n;
   } else {
-    destruct_deallocate_onheap();
+    // the value could be an element that is invalidated by the reallocation
+    T copy(value);
+    reserve(n);
+    for (; m_size < n; ++m_size) {
+      AllocatorTraits::construct(m_alloc, m_data + m_size, copy);
+    }
+  }
+}
+
+// Available storage is in-sufficient. Construct the new element directly in a
+// larger storage before moving the existing elements. The arguments might
+// refer to existing elements and must remain valid until then. The caller
+// must update the size.
+template<typename T, std::size_t N, typename Allocator>
+template<typename... Args>
+inline void
+SmallVector<T, N, Allocator>::emplace_grow(size_type idx, Args&&... args) {
+  // the new element could alias the members; use local copies instead.
+  T* data = m_data;
+  size_type size = m_size;
+  size_type capacity = grown_capacity(size + 1);
+  T* storage = AllocatorTraits::allocate(m_alloc, capacity);
+  try {
+    AllocatorTraits::construct(
+      m_alloc, storage + idx, std::forward<Args>(args)...);
+  } catch (...) {
+    AllocatorTraits::deallocate(m_alloc, storage, capacity);
+    throw;
   }
-  m_onheap = storage;
+  relocate(data, data + idx, storage);
+  relocate(data + idx, data + size, storage + idx + 1);
+  release();
+  m_data = storage;
+  m_capacity = capacity;
+}
 
+template<typename T, std::size_t N, typename Allocator>
+template<typename... Args>
+inline typename SmallVector<T, N, Allocator>::iterator
+SmallVector<T, N, Allocator>::emplace(const_iterator pos, Args&&... args) {
+  size_type idx = pos - begin();
+
+  if (m_size == m_capacity) {
+    emplace_grow(idx, std::forward<Args>(args)...);
+  } else if (idx == m_size) {
+    AllocatorTraits::construct(m_alloc, end(), std::forward<Args>(args)...);
+  } else {
+    // construct first since the arguments might refer to existing elements
+    T element(std::forward<Args>(args)...);
+    // existing data after the insertion point needs to be shifted by 1 to
+    // the right. the new last element is constructed in uninitialized memory.
+    AllocatorTraits::construct(m_alloc, end(), std::move(back()));
+    for (size_type i = m_size - 1; idx < i; --i) {
+      m_data[i] = std::move(m_data[i - 1]);
+    }
+    m_data[idx] = std::move(element);
+  }
   m_size += 1;
-  return insert;
+  return begin() + idx;
+}
+
+template<typename T, std::size_t N, typename Allocator>
+template<typename InputIt, typename>
+inline typename SmallVector<T, N, Allocator>::iterator
+SmallVector<T, N, Allocator>::insert(
+  const_iterator pos, InputIt first, InputIt last) {
+  size_type idx = pos - begin();
+  size_type previous_size = m_size;
+  append(first, last);
+  std::rotate(begin() + idx, begin() + previous_size, end());
+  return begin() + idx;
 }
 
 template<typename T, std::size_t N, typename Allocator>
 template<typename... Args>
 inline typename SmallVector<T, N, Allocator>::value_type&
 SmallVector<T, N, Allocator>::emplace_back(Args&&... args) {
-  return *emplace(end(), std::forward<Args>(args)...);
+  if (m_size == m_capacity) {
+    emplace_grow(m_size, std::forward<Args>(args)...);
+  } else {
+    AllocatorTraits::construct(m_alloc, end(), std::forward<Args>(args)...);
+  }
+  m_size += 1;
+  return back();
+}
+
+template<typename T, std::size_t N, typename Allocator>
+template<typename InputIt, typename>
+inline void
+SmallVector<T, N, Allocator>::append(InputIt first, InputIt last) {
+  append(
+    first, last,
+    typename std::iterator_traits<InputIt>::iterator_category());
+}
+
+template<typename T, std::size_t N, typename Allocator>
+template<typename InputIt>
+inline void
+SmallVector<T, N, Allocator>::append(
+  InputIt first, InputIt last, std::input_iterator_tag) {
+  for (; first != last; ++first) {
+    emplace_back(*first);
+  }
+}
+
+template<typename T, std::size_t N, typename Allocator>
+template<typename ForwardIt>
+inline void
+SmallVector<T, N, Allocator>::append(
+  ForwardIt first, ForwardIt last, std::forward_iterator_tag) {
+  size_type required = m_size + std::distance(first, last);
+  if (m_capacity < required) {
+    reallocate(grown_capacity(required));
+  }
+  for (; first != last; ++first, ++m_size) {
+    AllocatorTraits::construct(m_alloc, m_data + m_size, *first);
+  }
+}
+
+template<typename T, std::size_t N, typename Allocator>
+inline void
+SmallVector<T, N, Allocator>::pop_back() {
+  m_size -= 1;
+  AllocatorTraits::destroy(m_alloc, m_data + m_size);
+}
+
+template<typename T, std::size_t N, typename Allocator>
+inline typename SmallVector<T, N, Allocator>::iterator
+SmallVector<T, N, Allocator>::erase(const_iterator first, const_iterator last) {
+  T* target = begin() + (first - begin());
+  // moving the following elements onto themselves would clear them
+  if (first == last) {
+    return target;
+  }
+  T* source = begin() + (last - begin());
+  T* remaining = std::move(source, end(), target);
+  destroy(remaining, end());
+  m_size = remaining - begin();
+  return target;
 }
 
 } // namespace dfe
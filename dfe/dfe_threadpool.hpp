@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MIT
+// Copyright 2020 Moritz Kiehn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/// \file
+/// \brief   Fixed-size thread pool shared by the multi-threaded components
+/// \author  Moritz Kiehn <msmk@cern.ch>
+/// \date    2026-10-15
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dfe {
+namespace threadpool_impl {
+
+// Fixed-size pool of worker threads that execute tasks in submission order.
+class ThreadPool {
+public:
+  explicit ThreadPool(std::size_t num_threads);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  // executes all remaining tasks before joining the workers
+  ~ThreadPool();
+
+  template<typename Function>
+  std::future<decltype(std::declval<Function&>()())> submit(Function&& fn);
+
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<std::function<void()>> m_tasks;
+  bool m_stop = false;
+  std::vector<std::thread> m_threads;
+
+  void work();
+};
+
+inline ThreadPool::ThreadPool(std::size_t num_threads) {
+  for (std::size_t i = 0; i < num_threads; ++i) {
+    m_threads.emplace_back([this]() { work(); });
+  }
+}
+
+inline ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+template<typename Function>
+inline std::future<decltype(std::declval<Function&>()())>
+ThreadPool::submit(Function&& fn) {
+  using Result = decltype(std::declval<Function&>()());
+  // std::function requires a copyable target
+  auto task = std::make_shared<std::packaged_task<Result()>>(
+    std::forward<Function>(fn));
+  auto result = task->get_future();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tasks.emplace_back([task]() { (*task)(); });
+  }
+  m_cv.notify_one();
+  return result;
+}
+
+inline void
+ThreadPool::work() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [this]() { return m_stop or not m_tasks.empty(); });
+      // only stop once all tasks are finished
+      if (m_tasks.empty()) {
+        return;
+      }
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    task();
+  }
+}
+
+} // namespace threadpool_impl
+} // namespace dfe
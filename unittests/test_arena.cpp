@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: MIT
+
+/// \file
+/// \brief Unit tests for dfe::Arena and dfe::ArenaAllocator
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dfe/dfe_arena.hpp"
+#include "dfe/dfe_flat.hpp"
+#include "dfe/dfe_histogram.hpp"
+#include "dfe/dfe_smallvector.hpp"
+
+BOOST_AUTO_TEST_CASE(arena_allocate) {
+  dfe::Arena arena(256);
+
+  BOOST_TEST(arena.used() == 0);
+  BOOST_TEST(arena.capacity() == 0);
+
+  char* c = static_cast<char*>(arena.allocate(1, 1));
+  double* d = static_cast<double*>(arena.allocate(sizeof(double), 8));
+  void* v = arena.allocate(32, 32);
+  BOOST_TEST(c != nullptr);
+  BOOST_TEST((reinterpret_cast<std::uintptr_t>(d) % 8) == 0);
+  BOOST_TEST((reinterpret_cast<std::uintptr_t>(v) % 32) == 0);
+  BOOST_TEST(arena.used() == (1 + sizeof(double) + 32));
+  BOOST_TEST(arena.capacity() == 256);
+  // allocations are consecutive within a block
+  BOOST_TEST(static_cast<void*>(c) < static_cast<void*>(d));
+  BOOST_TEST(static_cast<void*>(d) < v);
+
+  // larger than the remaining block
+  arena.allocate(1024, 8);
+  BOOST_TEST(1024 < arena.used());
+  BOOST_TEST((256 + 1024) <= arena.capacity());
+}
+
+BOOST_AUTO_TEST_CASE(arena_allocate_unaligned_block_end) {
+  // block size that is not a multiple of the alignment
+  dfe::Arena arena(100);
+
+  arena.allocate(99, 1);
+  auto* d = static_cast<double*>(arena.allocate(sizeof(double), 8));
+  BOOST_TEST((reinterpret_cast<std::uintptr_t>(d) % 8) == 0);
+  // the aligned position is beyond the end of the first block
+  BOOST_TEST(100 < arena.capacity());
+  *d = 1.0;
+
+  // odd-sized first block from a large request
+  dfe::Arena large;
+  large.allocate((1 << 17) + 1, 1);
+  for (int i = 0; i < 16; ++i) {
+    auto* x = static_cast<double*>(large.allocate(sizeof(double), 8));
+    BOOST_TEST((reinterpret_cast<std::uintptr_t>(x) % 8) == 0);
+    *x = i;
+  }
+
+  BOOST_CHECK_THROW(
+    arena.allocate(std::numeric_limits<std::size_t>::max() - 4, 8),
+    std::bad_alloc);
+}
+
+BOOST_AUTO_TEST_CASE(arena_reset) {
+  dfe::Arena arena(128);
+
+  for (int i = 0; i < 100; ++i) {
+    arena.allocate(64, 8);
+  }
+  auto capacity = arena.capacity();
+  BOOST_TEST((100 * 64) <= capacity);
+
+  arena.reset();
+  BOOST_TEST(arena.used() == 0);
+  BOOST_TEST(arena.capacity() == capacity);
+  // the merged block is sufficient for the same usage again
+  void* first = arena.allocate(64, 8);
+  for (int i = 1; i < 100; ++i) {
+    arena.allocate(64, 8);
+  }
+  BOOST_TEST(arena.capacity() == capacity);
+  // memory is reused from the beginning
+  arena.reset();
+  BOOST_TEST(arena.allocate(64, 8) == first);
+}
+
+BOOST_AUTO_TEST_CASE(arena_allocator_containers) {
+  dfe::Arena arena;
+  dfe::ArenaAllocator<int> alloc(arena);
+
+  BOOST_TEST((alloc == dfe::ArenaAllocator<double>(arena)));
+  dfe::Arena other;
+  BOOST_TEST((alloc != dfe::ArenaAllocator<int>(other)));
+
+  std::vector<int, dfe::ArenaAllocator<int>> vec(alloc);
+  for (int i = 0; i < 1000; ++i) {
+    vec.push_back(i);
+  }
+  BOOST_TEST(vec.size() == 1000);
+  BOOST_TEST(vec[999] == 999);
+  BOOST_TEST(0 < arena.used());
+
+  dfe::SmallVector<int, 4, dfe::ArenaAllocator<int>> small(alloc);
+  for (int i = 0; i < 100; ++i) {
+    small.push_back(i);
+  }
+  BOOST_TEST(small.size() == 100);
+  BOOST_TEST(small[50] == 50);
+}
+
+BOOST_AUTO_TEST_CASE(arena_allocator_flat) {
+  dfe::Arena arena;
+
+  using Set = dfe::FlatSet<
+    int, std::less<int>, std::vector<int, dfe::ArenaAllocator<int>>>;
+  Set set(arena);
+  set.set_eytzinger_index(true);
+  for (int i = 0; i < 100; ++i) {
+    set.insert_or_assign(99 - i);
+  }
+  BOOST_TEST(set.size() == 100);
+  BOOST_TEST(set.contains(42));
+  BOOST_TEST(!set.contains(100));
+  BOOST_TEST(*set.begin() == 0);
+
+  using Map = dfe::FlatMap<
+    std::string, int, std::less<std::string>,
+    dfe::ArenaAllocator<std::pair<const std::string, int>>>;
+  Map map(arena);
+  map.emplace("b", 2);
+  map.emplace("a", 1);
+  std::vector<std::pair<std::string, int>> elements = {{"c", 3}, {"a", 4}};
+  map.insert(elements.begin(), elements.end());
+  BOOST_TEST(map.size() == 3);
+  BOOST_TEST(map.at("a") == 4);
+  BOOST_TEST(map.at("c") == 3);
+}
+
+BOOST_AUTO_TEST_CASE(arena_allocator_histogram) {
+  using Axis = dfe::UniformAxis<double>;
+  using Storage = dfe::DenseStorage<double, dfe::ArenaAllocator<double>>;
+  using Hist = dfe::Histogram<Storage, Axis, Axis>;
+
+  dfe::Arena arena;
+  for (int ievent = 0; ievent < 4; ++ievent) {
+    {
+      Hist h(
+        std::allocator_arg, dfe::ArenaAllocator<double>(arena),
+        Axis(0.0, 1.0, 10), Axis(0.0, 2.0, 20));
+      BOOST_TEST(arena.used() == (10 * 20 * sizeof(double)));
+      h.fill(0.55, 1.05);
+      h.fill(0.55, 1.05, 2.0);
+      BOOST_TEST(h.value({5, 10}) == 3.0);
+      BOOST_TEST(h.value({0, 0}) == 0.0);
+    }
+    arena.reset();
+  }
+}
@@ -4,7 +4,13 @@
 /// \brief Unit tests for dfe::Dispatcher
 
 #include <boost/test/unit_test.hpp>
+#include <future>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "dfe/dfe_dispatcher.hpp"
 
@@ -112,6 +118,40 @@ BOOST_AUTO_TEST_CASE(dispatcher_variable_string) {
   BOOST_CHECK_THROW(vs.as<int>(), std::invalid_argument); // wrong type
 }
 
+BOOST_AUTO_TEST_CASE(dispatcher_variable_copy_move) {
+  std::string ss("short");
+  std::string sl("a-string-that-is-too-long-for-in-place-storage");
+  Variable vi(42);
+  Variable vs(ss);
+  Variable vl(sl);
+
+  BOOST_TEST(sizeof(Variable) <= 32u);
+  static_assert(
+    std::is_nothrow_move_constructible<Variable>::value,
+    "Variable must be nothrow movable");
+  // copies are independent of the original
+  Variable ci(vi), cs(vs), cl(vl);
+  BOOST_TEST(ci.as<int>() == 42);
+  BOOST_TEST(cs.as<std::string>() == ss);
+  BOOST_TEST(cl.as<std::string>() == sl);
+  cl = vs;
+  BOOST_TEST(cl.as<std::string>() == ss);
+  BOOST_TEST(vl.as<std::string>() == sl);
+  // self-assignment keeps the value
+  vl = *&vl;
+  BOOST_TEST(vl.as<std::string>() == sl);
+  // moved-from objects are empty
+  Variable ml(std::move(vl));
+  BOOST_TEST(ml.as<std::string>() == sl);
+  BOOST_TEST(!vl);
+  vi = std::move(ml);
+  BOOST_TEST(vi.as<std::string>() == sl);
+  BOOST_TEST(!ml);
+  // embedded null characters are preserved
+  Variable vn("a\0b", 3);
+  BOOST_TEST(vn.as<std::string>() == std::string("a\0b", 3));
+}
+
 // basic sanity checks
 
 BOOST_AUTO_TEST_CASE(dispatcher_add) {
@@ -169,6 +209,33 @@ BOOST_AUTO_TEST_CASE(dispatcher_native) {
     == "xyz12");
 }
 
+Variable
+native_arguments(const Dispatcher::Arguments& args) {
+  int64_t sum = 0;
+  for (const auto& arg : args) {
+    sum += arg.as<int64_t>();
+  }
+  BOOST_CHECK_THROW(args.at(args.size()), std::out_of_range);
+  return Variable(sum);
+}
+
+BOOST_AUTO_TEST_CASE(dispatcher_native_arguments) {
+  Dispatcher dp;
+  std::vector<Type> types(Dispatcher::kInlineArguments + 2, Type::Integer);
+  BOOST_REQUIRE_NO_THROW(
+    dp.add("sum2", native_arguments, {Type::Integer, Type::Integer}));
+  BOOST_REQUIRE_NO_THROW(dp.add("sumN", native_arguments, std::move(types)));
+  BOOST_TEST(dp.call("sum2", 1, 2).as<int64_t>() == 3);
+  BOOST_TEST(
+    dp.call("sumN", 1, 2, 3, 4, 5, 6, 7, 8, 9, 10).as<int64_t>() == 55);
+  BOOST_TEST(
+    dp.call_parsed("sumN", {"1", "2", "3", "4", "5", "6", "7", "8", "9", "10"})
+      .as<int64_t>()
+    == 55);
+  BOOST_TEST(
+    dp.call_native("sum2", {Variable(4), Variable(5)}).as<int64_t>() == 9);
+}
+
 // regular function
 
 double
@@ -226,3 +293,192 @@ BOOST_AUTO_TEST_CASE(dispatcher_member) {
   BOOST_TEST(!dp.call_parsed("noreturn", {"2.6"}));
   BOOST_TEST(!dp.call_parsed("noreturn", {"1.25"}));
 }
+
+// pre-resolved command handles
+
+BOOST_AUTO_TEST_CASE(dispatcher_invoke) {
+  dfe::Dispatcher dp;
+  FuncStruct f = {4};
+  BOOST_REQUIRE_NO_THROW(dp.add("func", func));
+  BOOST_REQUIRE_NO_THROW(dp.add("member", &FuncStruct::func, &f));
+  BOOST_REQUIRE_NO_THROW(dp.add("noreturn", func_noreturn));
+  BOOST_REQUIRE_NO_THROW(dp.add("native", native, {Type::String}));
+  BOOST_CHECK_THROW(dp.lookup("does-not-exist"), std::invalid_argument);
+  BOOST_CHECK_THROW(
+    dp.invoke<double>(Dispatcher::Handle(), 2, 2.5f), std::invalid_argument);
+
+  auto hfunc = dp.lookup("func");
+  auto hmember = dp.lookup("member");
+  auto hnoreturn = dp.lookup("noreturn");
+  auto hnative = dp.lookup("native");
+  BOOST_TEST(static_cast<bool>(hfunc));
+  // exactly matching types use the direct call
+  BOOST_TEST(dp.invoke<double>(hfunc, 2, 2.5f) == 5.0);
+  BOOST_TEST(dp.invoke<double>(hmember, 2.75f) == 11.0);
+  dp.invoke<void>(hnoreturn, std::string("a"), std::string("b"));
+  // mismatching types fall back to the converting call
+  BOOST_TEST(dp.invoke<float>(hfunc, 3, 1.25) == 3.75f);
+  BOOST_TEST(!dp.invoke<Variable>(hnoreturn, "a", "b"));
+  BOOST_TEST(dp.invoke<std::string>(hnative, "x") == "x");
+  BOOST_CHECK_THROW(dp.invoke<double>(hfunc, 2), std::invalid_argument);
+  BOOST_CHECK_THROW(dp.invoke<double>(hfunc, "2", 3), std::invalid_argument);
+  // handles remain valid while other commands are registered
+  for (int i = 0; i < 100; ++i) {
+    dp.add("other" + std::to_string(i), func);
+  }
+  BOOST_TEST(dp.invoke<double>(hfunc, 2, 2.5f) == 5.0);
+}
+
+// concurrent use
+
+int
+add_one(int i) {
+  return i + 1;
+}
+
+BOOST_AUTO_TEST_CASE(dispatcher_concurrent) {
+  dfe::Dispatcher dp;
+  BOOST_REQUIRE_NO_THROW(dp.add("add_one", add_one));
+
+  // calls continue to work while new commands are registered
+  std::vector<std::thread> callers;
+  std::vector<int> failures(4, 0);
+  for (std::size_t t = 0; t < failures.size(); ++t) {
+    callers.emplace_back([&dp, &failures, t]() {
+      auto handle = dp.lookup("add_one");
+      for (int i = 0; i < 2000; ++i) {
+        if ((dp.call("add_one", i).as<int>() != (i + 1))
+            or (dp.invoke<int>(handle, i) != (i + 1))) {
+          failures[t] += 1;
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 100; ++i) {
+    dp.add("cmd" + std::to_string(i), add_one);
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  for (auto f : failures) {
+    BOOST_TEST(f == 0);
+  }
+  BOOST_TEST(dp.commands().size() == 101u);
+  BOOST_TEST(dp.call("cmd99", 1).as<int>() == 2);
+}
+
+int
+throw_negative(int i) {
+  if (i < 0) {
+    throw std::runtime_error("negative");
+  }
+  return i;
+}
+
+BOOST_AUTO_TEST_CASE(dispatcher_call_async) {
+  dfe::Dispatcher dp(2);
+  BOOST_REQUIRE_NO_THROW(dp.add("add_one", add_one));
+  BOOST_REQUIRE_NO_THROW(dp.add("throw", throw_negative));
+  BOOST_CHECK_THROW(dp.call_async("does-not-exist"), std::invalid_argument);
+  BOOST_CHECK_THROW(dp.call_async("add_one"), std::invalid_argument);
+
+  std::vector<std::future<Variable>> results;
+  for (int i = 0; i < 64; ++i) {
+    results.push_back(dp.call_async("add_one", i));
+  }
+  for (int i = 0; i < 64; ++i) {
+    BOOST_TEST(results[i].get().as<int>() == (i + 1));
+  }
+  auto error = dp.call_async("throw", -1);
+  BOOST_CHECK_THROW(error.get(), std::runtime_error);
+  BOOST_TEST(dp.call_async("throw", 3).get().as<int>() == 3);
+}
+
+// batch execution
+
+BOOST_AUTO_TEST_CASE(dispatcher_parse_as) {
+  BOOST_TEST(Variable::parse_as("-9223372036854775808", Type::Integer)
+               .as<int64_t>()
+             == INT64_MIN);
+  BOOST_TEST(Variable::parse_as("+42", Type::Integer).as<int>() == 42);
+  BOOST_TEST(Variable::parse_as("0.5e1", Type::Float).as<double>() == 5.0);
+  BOOST_TEST(Variable::parse_as("true", Type::Boolean).as<bool>());
+  BOOST_TEST(!Variable::parse_as("truex", Type::Boolean).as<bool>());
+  BOOST_CHECK_THROW(
+    Variable::parse_as("9223372036854775808", Type::Integer),
+    std::out_of_range);
+  BOOST_CHECK_THROW(
+    Variable::parse_as("12x", Type::Integer), std::invalid_argument);
+  BOOST_CHECK_THROW(
+    Variable::parse_as("", Type::Integer), std::invalid_argument);
+  BOOST_CHECK_THROW(
+    Variable::parse_as("1.5.", Type::Float), std::invalid_argument);
+  BOOST_CHECK_THROW(
+    Variable::parse_as("1e999", Type::Float), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(dispatcher_call_parsed_batch) {
+  dfe::Dispatcher dp;
+  BOOST_REQUIRE_NO_THROW(dp.add("func", func));
+  BOOST_REQUIRE_NO_THROW(dp.add("native", native, {Type::String}));
+
+  auto results = dp.call_parsed({
+    {"func", {"2", "2.5"}},
+    {"native", {"a long string argument that is stored on the heap"}},
+    {"func", {"3", "1.25"}},
+  });
+  BOOST_TEST(results.size() == 3u);
+  BOOST_TEST(results[0].as<double>() == 5.0);
+  BOOST_TEST(
+    results[1].as<std::string>()
+    == "a long string argument that is stored on the heap");
+  BOOST_TEST(results[2].as<double>() == 3.75);
+  BOOST_CHECK_THROW(
+    dp.call_parsed({{"func", {"2", "2.5"}}, {"func", {"2"}}}),
+    std::invalid_argument);
+  BOOST_CHECK_THROW(
+    dp.call_parsed({{"does-not-exist", {}}}), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(dispatcher_call_script) {
+  dfe::Dispatcher dp;
+  FuncStruct f = {4};
+  BOOST_REQUIRE_NO_THROW(dp.add("func", func));
+  BOOST_REQUIRE_NO_THROW(dp.add("member", &FuncStruct::func, &f));
+  BOOST_REQUIRE_NO_THROW(
+    dp.add("native", native, {Type::String, Type::String}));
+
+  std::string script = "# configuration\n"
+                       "func 2 2.5\n"
+                       "\n"
+                       "  member\t1.25  # trailing comment\r\n"
+                       "native \"with spaces\" x\n"
+                       "func 3 1.25";
+  auto results = dp.call_script(script);
+  BOOST_TEST(results.size() == 4u);
+  BOOST_TEST(results[0].as<double>() == 5.0);
+  BOOST_TEST(results[1].as<double>() == 5.0);
+  BOOST_TEST(results[2].as<std::string>() == "with spacesx");
+  BOOST_TEST(results[3].as<double>() == 3.75);
+  BOOST_TEST(dp.call_script("").empty());
+
+  // errors report the failing line
+  try {
+    dp.call_script("func 1 2\nfunc 1 x\n");
+    BOOST_FAIL("Invalid argument must throw");
+  } catch (const std::invalid_argument& e) {
+    BOOST_TEST(std::string(e.what()).find("Line 2") == 0u);
+  }
+  BOOST_CHECK_THROW(dp.call_script("unknown 1\n"), std::invalid_argument);
+  BOOST_CHECK_THROW(
+    dp.call_script("native \"open x\n"), std::invalid_argument);
+
+  // many lines with repeated command names
+  std::string many;
+  for (int i = 0; i < 1000; ++i) {
+    many += "func " + std::to_string(i) + " 0.5\n";
+  }
+  results = dp.call_script(many);
+  BOOST_TEST(results.size() == 1000u);
+  BOOST_TEST(results[999].as<double>() == 499.5);
+}
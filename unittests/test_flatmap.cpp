@@ -5,8 +5,12 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <climits>
 #include <cstdint>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "dfe/dfe_flat.hpp"
 
@@ -46,3 +50,64 @@ BOOST_AUTO_TEST_CASE(flatmap_string_string) {
   BOOST_TEST(!m.contains("asdfasdgasdgadgs"));
   BOOST_TEST(!m.contains("0124"));
 }
+
+BOOST_AUTO_TEST_CASE(flatmap_bulk_insert) {
+  dfe::FlatMap<int, std::string> m;
+  std::vector<std::pair<int, std::string>> values = {
+    {4, "four"}, {1, "one"}, {3, "three"}, {1, "uno"}, {2, "two"}};
+
+  m.emplace(3, "drei");
+  m.reserve(16);
+  m.insert(values.begin(), values.end());
+  BOOST_TEST(m.size() == 4);
+  BOOST_TEST(m.at(1) == "uno");
+  BOOST_TEST(m.at(2) == "two");
+  BOOST_TEST(m.at(3) == "three");
+  BOOST_TEST(m.at(4) == "four");
+  BOOST_CHECK_THROW(m.at(5), std::out_of_range);
+  // further single insertions keep working after compaction
+  m.emplace(5, "five");
+  m.emplace(1, "eins");
+  BOOST_TEST(m.size() == 5);
+  BOOST_TEST(m.at(1) == "eins");
+  BOOST_TEST(m.at(5) == "five");
+}
+
+BOOST_AUTO_TEST_CASE(flatmap_try_emplace_insert_or_assign) {
+  dfe::FlatMap<int, std::string> m;
+
+  // keys in increasing order are appended
+  for (int i = 0; i < 64; ++i) {
+    BOOST_TEST(m.try_emplace(2 * i, 3, 'x'));
+  }
+  // keys in decreasing order are inserted in-between
+  for (int i = 63; 0 <= i; --i) {
+    BOOST_TEST(m.insert_or_assign(2 * i + 1, std::to_string(i)));
+  }
+  BOOST_TEST(m.size() == 128);
+  BOOST_TEST(!m.try_emplace(4, "ignored"));
+  BOOST_TEST(m.at(4) == "xxx");
+  BOOST_TEST(!m.insert_or_assign(4, "four"));
+  BOOST_TEST(m.at(4) == "four");
+  for (int i = 0; i < 64; ++i) {
+    BOOST_TEST(m.at(2 * i + 1) == std::to_string(i));
+  }
+  BOOST_TEST(!m.contains(-1));
+  BOOST_TEST(!m.contains(128));
+}
+
+BOOST_AUTO_TEST_CASE(flatmap_transparent) {
+  dfe::FlatMap<std::string, int, std::less<>> m;
+  const char* name = "module-17";
+
+  m.emplace("module-3", 3);
+  m.emplace(name, 17);
+  BOOST_TEST(m.contains(name));
+  BOOST_TEST(m.contains("module-3"));
+  BOOST_TEST(!m.contains("module-4"));
+  BOOST_TEST(m.at(name) == 17);
+  BOOST_TEST(m.at(std::string("module-3")) == 3);
+  BOOST_CHECK_THROW(m.at("module-4"), std::out_of_range);
+  const auto& cm = m;
+  BOOST_TEST(cm.at("module-3") == 3);
+}
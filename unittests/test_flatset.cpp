@@ -5,6 +5,9 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <vector>
+
 #include "dfe/dfe_flat.hpp"
 
 using dfe::FlatSet;
@@ -90,3 +93,53 @@ BOOST_AUTO_TEST_CASE(flatset_custom_compare) {
   BOOST_CHECK(!set.contains(Thing{4, 1.45}));
   BOOST_CHECK(!set.contains(Thing{27, -1.23}));
 }
+
+BOOST_AUTO_TEST_CASE(flatset_bulk_insert) {
+  FlatSet<Thing, ThingComparator> set;
+  std::vector<Thing> things = {{5, 0.5}, {1, 1.0}, {3, 0.25}, {1, 2.0}};
+
+  set.insert_or_assign({3, -1.0});
+  set.insert(things.begin(), things.end());
+  BOOST_CHECK(set.size() == 3);
+  // the element inserted last replaces existing equivalent ones
+  BOOST_CHECK(set.at(1).value == 2.0);
+  BOOST_CHECK(set.at(3).value == 0.25);
+  BOOST_CHECK(set.at(5).value == 0.5);
+  BOOST_CHECK(std::is_sorted(
+    set.begin(), set.end(),
+    [](const Thing& a, const Thing& b) { return a.index < b.index; }));
+}
+
+BOOST_AUTO_TEST_CASE(flatset_large) {
+  // sizes around the linear scan threshold and full/partial tree levels
+  for (int n : {0, 1, 15, 16, 17, 31, 32, 33, 100, 1023, 1024, 1025, 5000}) {
+    std::vector<int> values;
+    for (int i = 0; i < n; ++i) {
+      // only even values and in a shuffled order
+      values.push_back(2 * ((i * 7919) % n));
+    }
+
+    for (bool eytzinger : {false, true}) {
+      FlatSet<int> set;
+      set.reserve(values.size());
+      set.set_eytzinger_index(eytzinger);
+      set.insert(values.begin(), values.end());
+      BOOST_TEST(set.size() == static_cast<std::size_t>(n));
+      for (int i = -1; i < (2 * n + 1); ++i) {
+        bool expected = (0 <= i) and (i < (2 * n)) and ((i % 2) == 0);
+        BOOST_TEST(set.contains(i) == expected);
+        if (expected) {
+          BOOST_TEST(*set.find(i) == i);
+        } else {
+          BOOST_TEST((set.find(i) == set.end()));
+        }
+      }
+      // single inserts keep the index up-to-date
+      set.insert_or_assign(-10);
+      set.insert_or_assign(2 * n + 11);
+      BOOST_TEST(set.contains(-10));
+      BOOST_TEST(set.contains(2 * n + 11));
+      BOOST_TEST(!set.contains(-9));
+    }
+  }
+}
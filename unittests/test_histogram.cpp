@@ -4,7 +4,14 @@
 /// \brief Unit tests for dfe::Histogram
 
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include "dfe/dfe_histogram.hpp"
 
@@ -181,3 +188,386 @@ BOOST_AUTO_TEST_CASE(histogram_variable1d) {
   BOOST_TEST(h.value({1}) == 1);
   BOOST_TEST(h.value({2}) == 3);
 }
+
+BOOST_AUTO_TEST_CASE(histogram_variable_lookup) {
+  // very uneven binning to exercise the lookup grid
+  std::vector<double> edges;
+  for (size_t i = 0; i <= 500; ++i) {
+    edges.push_back(std::pow(10.0, -3.0 + 0.012 * i));
+  }
+  edges.push_back(edges.back() + 1e-6);
+  edges.push_back(edges.back() + 1e3);
+  dfe::VariableAxis<double> axis{std::vector<double>(edges)};
+  BOOST_TEST(axis.nbins() == edges.size() - 1);
+
+  auto expected = [&](double value) {
+    auto it = std::upper_bound(edges.begin(), edges.end(), value);
+    return static_cast<size_t>(std::distance(edges.begin(), it) - 1);
+  };
+  // exactly on the edges and just below
+  for (size_t i = 0; (i + 1) < edges.size(); ++i) {
+    BOOST_TEST(axis.index(edges[i]) == i);
+    double below = std::nextafter(edges[i + 1], 0.0);
+    BOOST_TEST(axis.index(below) == i);
+  }
+  // random values w/ a simple linear congruential generator
+  uint64_t state = 12345;
+  for (size_t i = 0; i < 10000; ++i) {
+    state = 6364136223846793005u * state + 1442695040888963407u;
+    double u = std::ldexp(static_cast<double>(state >> 11), -53);
+    double value = edges.front() + u * (edges.back() - edges.front());
+    BOOST_TEST(axis.index(value) == expected(value));
+  }
+  BOOST_CHECK_THROW(axis.index(edges.back()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_log) {
+  using H1 = dfe::Histogram<double, dfe::LogAxis<double>>;
+
+  BOOST_CHECK_THROW(H1({0.0, 10.0, 10}), std::invalid_argument);
+  BOOST_CHECK_THROW(H1({-1.0, 10.0, 10}), std::invalid_argument);
+  BOOST_CHECK_THROW(H1({10.0, 1.0, 10}), std::invalid_argument);
+  BOOST_CHECK_THROW(H1({1.0, 10.0, 0}), std::invalid_argument);
+
+  H1 h({1.0, 1000.0, 3});
+  BOOST_TEST(h.size() == H1::Index{3});
+  BOOST_CHECK_THROW(h.fill(0.5), std::out_of_range);
+  BOOST_CHECK_THROW(h.fill(1000.0), std::out_of_range); // on upper limit
+  BOOST_CHECK_THROW(
+    h.fill(std::numeric_limits<double>::infinity()), std::out_of_range);
+  BOOST_CHECK_THROW(
+    h.fill(std::numeric_limits<double>::quiet_NaN()), std::out_of_range);
+  BOOST_CHECK_NO_THROW(h.fill(1));
+  BOOST_CHECK_NO_THROW(h.fill(5));
+  BOOST_CHECK_NO_THROW(h.fill(7));
+  BOOST_CHECK_NO_THROW(h.fill(11));
+  BOOST_CHECK_NO_THROW(h.fill(101));
+  BOOST_CHECK_NO_THROW(h.fill(125));
+  BOOST_CHECK_NO_THROW(h.fill(std::nextafter(1000.0, 0.0)));
+  BOOST_TEST(h.value({0}) == 3);
+  BOOST_TEST(h.value({1}) == 1);
+  BOOST_TEST(h.value({2}) == 3);
+
+  // computed bins agree w/ the equivalent variable binning
+  dfe::LogAxis<double> axis(1e-3, 1e3, 600);
+  std::vector<double> edges;
+  for (size_t i = 0; i <= 600; ++i) {
+    edges.push_back(std::exp(std::log(1e-3) + i * std::log(1e6) / 600));
+  }
+  for (size_t i = 1; (i + 1) < edges.size(); ++i) {
+    double value = edges[i];
+    size_t bin = axis.index(value);
+    BOOST_TEST(((bin == i) or (bin == (i - 1))));
+    BOOST_TEST(axis.index(std::nextafter(value, 0.0)) <= bin);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(histogram_fill_n) {
+  using H3 = dfe::Histogram<
+    double, dfe::OverflowAxis<double>, dfe::UniformAxis<float>,
+    dfe::VariableAxis<double>>;
+
+  // enough entries for multiple blocks
+  std::vector<double> xs, zs, ws;
+  std::vector<float> ys;
+  for (size_t i = 0; i < 1000; ++i) {
+    xs.push_back(-1.0 + 0.0031 * i);
+    ys.push_back(0.001f * i);
+    zs.push_back(1.0 + 0.7 * i);
+    ws.push_back(0.5 * (i % 7));
+  }
+  // values on and beyond the limits
+  xs.back() = std::numeric_limits<double>::infinity();
+  xs.front() = std::numeric_limits<double>::lowest();
+  xs[100] = 1.0;
+  xs[101] = std::nextafter(1.0, 0.0);
+
+  H3 single({0.0, 1.0, 8}, {0.0f, 1.0f, 16}, {1.0, 10.0, 100.0, 1000.0});
+  H3 single_weighted = single;
+  H3 batch = single;
+  H3 batch_weighted = single;
+  for (size_t i = 0; i < xs.size(); ++i) {
+    single.fill(xs[i], ys[i], zs[i]);
+    single_weighted.fill(xs[i], ys[i], zs[i], ws[i]);
+  }
+  batch.fill_n(xs.size(), xs.data(), ys.data(), zs.data());
+  batch_weighted.fill_n(xs.size(), xs.data(), ys.data(), zs.data(), ws.data());
+
+  for (size_t i = 0; i < 10; ++i) {
+    for (size_t j = 0; j < 16; ++j) {
+      for (size_t k = 0; k < 3; ++k) {
+        BOOST_TEST(batch.value({i, j, k}) == single.value({i, j, k}));
+        BOOST_TEST(
+          batch_weighted.value({i, j, k}) ==
+          single_weighted.value({i, j, k}));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(histogram_overflow_index_n) {
+  dfe::OverflowAxis<double> axis(-0.3, 0.7, 10);
+
+  double values[] = {
+    -0.3,
+    std::nextafter(-0.3, -1.0),
+    0.7,
+    std::nextafter(0.7, 0.0),
+    std::numeric_limits<double>::quiet_NaN(),
+    0.25,
+  };
+  size_t expected[] = {1, 0, 11, 10, 11, 6};
+  size_t indices[6];
+  axis.index_n(values, 6, indices);
+  for (size_t i = 0; i < 6; ++i) {
+    BOOST_TEST(axis.index(values[i]) == expected[i]);
+    BOOST_TEST(indices[i] == expected[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(histogram_integer_axes) {
+  dfe::UniformAxis<int> uniform(0, 100, 10);
+  dfe::OverflowAxis<int> overflow(0, 100, 10);
+
+  int values[] = {0, 9, 10, 55, 99};
+  size_t expected[] = {0, 0, 1, 5, 9};
+  size_t indices[5];
+  uniform.index_n(values, 5, indices);
+  for (size_t i = 0; i < 5; ++i) {
+    BOOST_TEST(uniform.index(values[i]) == expected[i]);
+    BOOST_TEST(indices[i] == expected[i]);
+  }
+  overflow.index_n(values, 5, indices);
+  for (size_t i = 0; i < 5; ++i) {
+    BOOST_TEST(overflow.index(values[i]) == (expected[i] + 1));
+    BOOST_TEST(indices[i] == (expected[i] + 1));
+  }
+  BOOST_TEST(overflow.index(-1) == 0u);
+  BOOST_TEST(overflow.index(100) == 11u);
+
+  // bin edges do not have to be commensurate with the bin count
+  dfe::Histogram<double, dfe::OverflowAxis<int>> h({-5, 5, 3});
+  int fills[] = {-6, -5, -2, -1, 1, 2, 4, 5};
+  h.fill_n(8, fills);
+  BOOST_TEST(h.value({0}) == 1); // underflow
+  BOOST_TEST(h.value({1}) == 2);
+  BOOST_TEST(h.value({2}) == 2);
+  BOOST_TEST(h.value({3}) == 2);
+  BOOST_TEST(h.value({4}) == 1); // overflow
+}
+
+BOOST_AUTO_TEST_CASE(histogram_fill_n_invalid) {
+  using H1 = dfe::Histogram<double, dfe::UniformAxis<double>>;
+
+  H1 h({0.0, 1.0, 8});
+  double values[] = {0.5, 1.0};
+  BOOST_CHECK_THROW(h.fill_n(2, values), std::out_of_range);
+  BOOST_CHECK_NO_THROW(h.fill_n(1, values));
+  BOOST_CHECK_NO_THROW(h.fill_n(0, nullptr));
+  BOOST_TEST(h.value({4}) == 1);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_fill_n_invalid_partial) {
+  using H1 = dfe::Histogram<double, dfe::UniformAxis<double>>;
+
+  H1 h({0.0, 1.0, 2});
+  // valid entries in the first bin, followed by an invalid entry and more
+  // valid entries in the second bin.
+  std::vector<double> values(1000, 0.25);
+  values.push_back(2.0);
+  values.resize(2000, 0.75);
+  BOOST_CHECK_THROW(h.fill_n(values.size(), values.data()), std::out_of_range);
+  // earlier entries may have been added, but nothing after the invalid one
+  BOOST_TEST(0.0 < h.value({0}));
+  BOOST_TEST(h.value({0}) <= 1000.0);
+  BOOST_TEST(h.value({1}) == 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_add) {
+  using H2 =
+    dfe::Histogram<double, dfe::OverflowAxis<double>, dfe::UniformAxis<float>>;
+
+  H2 a({0.0, 1.0, 4}, {-1.0f, 1.0f, 2});
+  H2 b = a;
+  a.fill(0.3, 0.5f);
+  b.fill(0.3, 0.5f, 2.0);
+  b.fill(1.3, -0.5f);
+  a += b;
+  BOOST_TEST(a.value({2, 1}) == 3.0);
+  BOOST_TEST(a.value({5, 0}) == 1.0);
+  // different binning
+  BOOST_CHECK_THROW(
+    a += H2({0.0, 1.0, 4}, {-1.0f, 2.0f, 2}), std::invalid_argument);
+  BOOST_CHECK_THROW(
+    a += H2({0.0, 1.0, 5}, {-1.0f, 1.0f, 2}), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_sharded) {
+  using H1 = dfe::Histogram<double, dfe::OverflowAxis<double>>;
+
+  dfe::ShardedHistogram<H1> sharded(H1({0.0, 1.0, 10}));
+  std::vector<std::thread> threads;
+  // the test framework can not be used from multiple threads
+  bool is_stable[4] = {false, false, false, false};
+  for (size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&sharded, &is_stable, t]() {
+      auto& h = sharded.local();
+      for (size_t i = 0; i < 10000; ++i) {
+        h.fill(0.0001 * i);
+      }
+      // repeated access returns the same shard
+      is_stable[t] = (&h == &sharded.local());
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto stable : is_stable) {
+    BOOST_TEST(stable);
+  }
+  auto h = sharded.merge();
+  for (size_t i = 1; i <= 10; ++i) {
+    BOOST_TEST(h.value({i}) == 4000.0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(histogram_sharded_prototype) {
+  using H1 = dfe::Histogram<double, dfe::OverflowAxis<double>>;
+
+  H1 prototype({0.0, 1.0, 10});
+  prototype.fill(0.05);
+  dfe::ShardedHistogram<H1> sharded(prototype);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 3; ++t) {
+    threads.emplace_back([&sharded]() { sharded.local().fill(0.95); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // prototype content is counted exactly once
+  auto h = sharded.merge();
+  BOOST_TEST(h.value({1}) == 1.0);
+  BOOST_TEST(h.value({10}) == 3.0);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_atomic) {
+  using H2 = dfe::Histogram<
+    dfe::AtomicBin<double>, dfe::UniformAxis<double>, dfe::UniformAxis<double>>;
+
+  H2 h({0.0, 1.0, 100}, {0.0, 1.0, 100});
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&h]() {
+      std::vector<double> xs, ys, ws;
+      for (size_t i = 0; i < 100; ++i) {
+        xs.push_back(0.01 * i + 0.005);
+        ys.push_back(0.5);
+        ws.push_back(0.5);
+      }
+      for (size_t r = 0; r < 100; ++r) {
+        h.fill(0.5, 0.99);
+        h.fill_n(xs.size(), xs.data(), ys.data());
+        h.fill_n(xs.size(), xs.data(), ys.data(), ws.data());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  BOOST_TEST(h.value({50, 99}).load() == 400.0);
+  for (size_t i = 0; i < 100; ++i) {
+    BOOST_TEST(h.value({i, 50}).load() == 600.0);
+  }
+  // merging works w/ atomic bins as well
+  H2 sum = h;
+  sum += h;
+  BOOST_TEST(sum.value({50, 99}).load() == 800.0);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_counter_storage) {
+  using H2 = dfe::Histogram<
+    dfe::CounterStorage, dfe::UniformAxis<double>, dfe::UniformAxis<double>>;
+
+  H2 h({0.0, 1.0, 10}, {0.0, 1.0, 10});
+  BOOST_TEST(h.data().counter_size() == 1u);
+  for (size_t i = 0; i < 255; ++i) {
+    h.fill(0.5, 0.5);
+  }
+  BOOST_TEST(h.data().counter_size() == 1u);
+  BOOST_TEST(h.value({5, 5}) == 255u);
+  // overflow of an 8bit counter promotes all counters
+  h.fill(0.5, 0.5);
+  h.fill(0.05, 0.05, 3);
+  BOOST_TEST(h.data().counter_size() == 2u);
+  BOOST_TEST(h.value({5, 5}) == 256u);
+  BOOST_TEST(h.value({0, 0}) == 3u);
+  BOOST_TEST(h.value({9, 9}) == 0u);
+  h.fill(0.95, 0.95, 1u << 20);
+  BOOST_TEST(h.data().counter_size() == 4u);
+  h.fill(0.95, 0.95, uint64_t(1) << 40);
+  BOOST_TEST(h.data().counter_size() == 8u);
+  BOOST_TEST(h.value({9, 9}) == ((uint64_t(1) << 40) + (1u << 20)));
+  BOOST_TEST(h.value({5, 5}) == 256u);
+  BOOST_CHECK_THROW(
+    h.fill(0.95, 0.95, std::numeric_limits<uint64_t>::max()),
+    std::overflow_error);
+  BOOST_CHECK_THROW(h.value({10, 0}), std::out_of_range);
+
+  // batch filling and merging
+  std::vector<double> xs = {0.05, 0.15, 0.15}, ys = {0.05, 0.05, 0.05};
+  H2 other({0.0, 1.0, 10}, {0.0, 1.0, 10});
+  other.fill_n(xs.size(), xs.data(), ys.data());
+  BOOST_TEST(other.data().counter_size() == 1u);
+  h += other;
+  BOOST_TEST(h.value({0, 0}) == 4u);
+  BOOST_TEST(h.value({1, 0}) == 2u);
+  BOOST_TEST(h.value({5, 5}) == 256u);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_sparse_storage) {
+  using Axis = dfe::UniformAxis<double>;
+  using H4 = dfe::Histogram<dfe::SparseStorage<double>, Axis, Axis, Axis, Axis>;
+  using D4 = dfe::Histogram<double, Axis, Axis, Axis, Axis>;
+
+  // 10^8 bins would require 800MB w/ dense storage
+  H4 h({0.0, 1.0, 100}, {0.0, 1.0, 100}, {0.0, 1.0, 100}, {0.0, 1.0, 100});
+  BOOST_TEST(h.data().num_stored() == 0u);
+  BOOST_TEST(h.value({1, 2, 3, 4}) == 0.0);
+  h.fill(0.015, 0.025, 0.035, 0.045);
+  h.fill(0.015, 0.025, 0.035, 0.045, 0.5);
+  h.fill(0.995, 0.995, 0.995, 0.995);
+  BOOST_TEST(h.data().num_stored() == 2u);
+  BOOST_TEST(h.value({1, 2, 3, 4}) == 1.5);
+  BOOST_TEST(h.value({99, 99, 99, 99}) == 1.0);
+  BOOST_CHECK_THROW(h.value({100, 0, 0, 0}), std::out_of_range);
+
+  // same content as dense storage for batch filling
+  std::vector<double> xs, ys, zs, ts, ws;
+  for (size_t i = 0; i < 1000; ++i) {
+    xs.push_back(0.001 * i);
+    ys.push_back(0.5);
+    zs.push_back(0.0005 * i);
+    ts.push_back(0.999 - 0.001 * i);
+    ws.push_back(0.25 * (i % 4));
+  }
+  H4 sparse({0.0, 1.0, 10}, {0.0, 1.0, 10}, {0.0, 1.0, 10}, {0.0, 1.0, 10});
+  D4 dense({0.0, 1.0, 10}, {0.0, 1.0, 10}, {0.0, 1.0, 10}, {0.0, 1.0, 10});
+  sparse.fill_n(xs.size(), xs.data(), ys.data(), zs.data(), ts.data());
+  dense.fill_n(xs.size(), xs.data(), ys.data(), zs.data(), ts.data());
+  sparse.fill_n(
+    xs.size(), xs.data(), ys.data(), zs.data(), ts.data(), ws.data());
+  dense.fill_n(
+    xs.size(), xs.data(), ys.data(), zs.data(), ts.data(), ws.data());
+  H4 merged = sparse;
+  merged += sparse;
+  for (size_t i = 0; i < 10; ++i) {
+    for (size_t k = 0; k < 10; ++k) {
+      for (size_t l = 0; l < 10; ++l) {
+        BOOST_TEST(sparse.value({i, 5, k, l}) == dense.value({i, 5, k, l}));
+        BOOST_TEST(
+          merged.value({i, 5, k, l}) == 2 * dense.value({i, 5, k, l}));
+      }
+    }
+  }
+  BOOST_TEST(sparse.data().num_stored() < 100u);
+}
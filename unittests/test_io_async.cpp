@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: MIT
+
+/// \file
+/// \brief Unit tests for asynchronous writers
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dfe/dfe_io_async.hpp"
+#include "dfe/dfe_io_dsv.hpp"
+#include "dfe/dfe_io_numpy.hpp"
+#include "record.hpp"
+
+constexpr size_t kNRecords = 100000;
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(Record::Tuple)
+
+static std::string
+read_file(const std::string& path) {
+  std::ifstream file(path, std::ios_base::binary);
+  return std::string(
+    std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>{});
+}
+
+// Collect records and optionally slow down or fail writing.
+template<typename NamedTuple>
+struct TestWriter {
+  std::vector<NamedTuple>* records;
+  std::chrono::microseconds delay{0};
+  size_t fail_after = SIZE_MAX;
+  size_t num_flushes = 0;
+
+  void append(const NamedTuple& record) {
+    if (records->size() == fail_after) {
+      throw std::runtime_error("Failed to write");
+    }
+    std::this_thread::sleep_for(delay);
+    records->push_back(record);
+  }
+  void flush() { num_flushes += 1; }
+};
+
+BOOST_AUTO_TEST_CASE(async_writer_csv_numpy) {
+  {
+    dfe::NamedTupleCsvWriter<Record> csv("test_sync.csv");
+    dfe::NamedTupleNumpyWriter<Record> npy("test_sync.npy");
+    dfe::AsyncWriter<dfe::NamedTupleCsvWriter<Record>> async_csv(
+      std::make_unique<dfe::NamedTupleCsvWriter<Record>>("test_async.csv"),
+      128);
+    dfe::AsyncWriter<dfe::NamedTupleNumpyWriter<Record>> async_npy(
+      std::make_unique<dfe::NamedTupleNumpyWriter<Record>>("test_async.npy"));
+    for (size_t i = 0; i < kNRecords; ++i) {
+      auto record = make_record(i);
+      csv.append(record);
+      npy.append(record);
+      async_csv.append(record);
+      async_npy.append(record);
+    }
+    BOOST_TEST(async_csv.num_dropped() == 0u);
+    // all records are written on flush
+    csv.flush();
+    async_csv.flush();
+    BOOST_TEST(read_file("test_async.csv") == read_file("test_sync.csv"));
+  }
+  // all records are written on destruction
+  BOOST_TEST(read_file("test_async.csv") == read_file("test_sync.csv"));
+  BOOST_TEST(read_file("test_async.npy") == read_file("test_sync.npy"));
+}
+
+BOOST_AUTO_TEST_CASE(async_writer_flush) {
+  using Writer = TestWriter<Record>;
+
+  std::vector<Record> records;
+  auto* writer = new Writer{&records};
+  {
+    dfe::AsyncWriter<Writer> async(std::unique_ptr<Writer>(writer), 16);
+    for (size_t i = 0; i < 1000; ++i) {
+      async.append(make_record(i));
+      if ((i % 100) == 99) {
+        async.flush();
+        BOOST_TEST(records.size() == (i + 1));
+      }
+    }
+    BOOST_TEST(writer->num_flushes == 10u);
+  }
+  BOOST_TEST(records.size() == 1000u);
+  for (size_t i = 0; i < records.size(); ++i) {
+    BOOST_TEST(records[i].tuple() == make_record(i).tuple());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(async_writer_drop) {
+  using Writer = TestWriter<Record>;
+
+  std::vector<Record> records;
+  size_t num_dropped = 0;
+  {
+    std::unique_ptr<Writer> writer(new Writer{&records});
+    writer->delay = std::chrono::microseconds(100);
+    dfe::AsyncWriter<Writer> async(
+      std::move(writer), 8, dfe::AsyncPolicy::Drop);
+    for (size_t i = 0; i < 1000; ++i) {
+      async.append(make_record(i));
+    }
+    num_dropped = async.num_dropped();
+  }
+  // a slow writer must lead to dropped records
+  BOOST_TEST(0u < num_dropped);
+  BOOST_TEST((records.size() + num_dropped) == 1000u);
+  // the remaining records are still in order
+  for (size_t i = 1; i < records.size(); ++i) {
+    BOOST_TEST(records[i - 1].x < records[i].x);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(async_writer_error) {
+  using Writer = TestWriter<Record>;
+
+  std::vector<Record> records;
+  std::unique_ptr<Writer> writer(new Writer{&records});
+  writer->fail_after = 10;
+  dfe::AsyncWriter<Writer> async(std::move(writer), 4);
+  for (size_t i = 0; i < 11; ++i) {
+    async.append(make_record(i));
+  }
+  BOOST_CHECK_THROW(async.flush(), std::runtime_error);
+  BOOST_CHECK_THROW(async.append(make_record(12)), std::runtime_error);
+  BOOST_TEST(records.size() == 10u);
+}
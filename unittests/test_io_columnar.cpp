@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: MIT
+
+/// \file
+/// \brief Unit tests for chunked columnar i/o
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "dfe/dfe_io_columnar.hpp"
+#include "dfe/dfe_namedtuple.hpp"
+#include "record.hpp"
+
+static constexpr size_t kNRecords = 1000;
+static constexpr size_t kChunkSize = 128;
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(Record::Tuple)
+
+BOOST_AUTO_TEST_CASE(columnar_namedtuple_read) {
+  {
+    dfe::NamedTupleColumnarWriter<Record> writer("test.dfecol", kChunkSize);
+    for (size_t i = 0; i < kNRecords; ++i) {
+      BOOST_CHECK_NO_THROW(writer.append(make_record(i)));
+    }
+  }
+
+  dfe::NamedTupleColumnarReader<Record> reader("test.dfecol");
+  BOOST_TEST(reader.size() == kNRecords);
+  BOOST_TEST(reader.num_chunks() == 8u);
+  BOOST_TEST(reader.chunk_size(0) == kChunkSize);
+  BOOST_TEST(reader.chunk_size(7) == (kNRecords - 7 * kChunkSize));
+  BOOST_CHECK_THROW(reader.chunk_size(8), std::out_of_range);
+
+  // sequential reading
+  Record record;
+  for (size_t i = 0; i < kNRecords; ++i) {
+    BOOST_TEST_REQUIRE(reader.read(record));
+    BOOST_TEST(record.tuple() == make_record(i).tuple());
+    BOOST_TEST(reader.num_records() == (i + 1));
+  }
+  BOOST_TEST(not reader.read(record));
+
+  // full chunks
+  dfe::NamedTupleColumns<Record> columns;
+  reader.read_chunk(3, columns);
+  BOOST_TEST(columns.size() == kChunkSize);
+  for (size_t i = 0; i < kChunkSize; ++i) {
+    auto expected = make_record(3 * kChunkSize + i);
+    BOOST_TEST(columns.record(i).tuple() == expected.tuple());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(columnar_namedtuple_move_assign) {
+  {
+    dfe::NamedTupleColumnarWriter<Record> writer("test_first.dfecol", 4);
+    dfe::NamedTupleColumnarWriter<Record> other("test_second.dfecol", 4);
+    for (size_t i = 0; i < 10; ++i) {
+      writer.append(make_record(i));
+      other.append(make_record(i));
+    }
+    // the replaced writer must finish its file first
+    writer = std::move(other);
+    writer.append(make_record(10));
+  }
+
+  dfe::NamedTupleColumnarReader<Record> first("test_first.dfecol");
+  dfe::NamedTupleColumnarReader<Record> second("test_second.dfecol");
+  BOOST_TEST(first.size() == 10u);
+  BOOST_TEST(second.size() == 11u);
+  Record record;
+  for (size_t i = 0; second.read(record); ++i) {
+    BOOST_TEST(record.tuple() == make_record(i).tuple());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(columnar_namedtuple_projection) {
+  {
+    dfe::NamedTupleColumnarWriter<Record> writer("test_proj.dfecol", 100);
+    for (size_t i = 0; i < kNRecords; ++i) {
+      writer.append(make_record(i));
+    }
+  }
+
+  dfe::NamedTupleColumnarReader<Record> reader("test_proj.dfecol");
+
+  // single column
+  std::vector<int64_t> z;
+  reader.read_column<2>(4, z);
+  BOOST_TEST(z.size() == 100u);
+  BOOST_TEST(z[0] == make_record(400).z);
+  BOOST_TEST(z[99] == make_record(499).z);
+
+  // selected columns only
+  dfe::NamedTupleColumns<Record> columns;
+  reader.read_columns<1, 6>(9, columns);
+  BOOST_TEST(columns.column<0>().empty());
+  BOOST_TEST(columns.column<1>().size() == 100u);
+  BOOST_TEST(columns.column<6>().size() == 100u);
+  BOOST_TEST(columns.column<1>()[5] == make_record(905).y);
+  BOOST_TEST(columns.column<6>()[5] == make_record(905).d);
+}
+
+BOOST_AUTO_TEST_CASE(columnar_namedtuple_statistics) {
+  {
+    dfe::NamedTupleColumnarWriter<Record> writer("test_stats.dfecol", 100);
+    for (size_t i = 0; i < kNRecords; ++i) {
+      writer.append(make_record(i));
+    }
+  }
+
+  dfe::NamedTupleColumnarReader<Record> reader("test_stats.dfecol");
+  // x increases and c decreases monotonically with the record index
+  for (size_t c = 0; c < reader.num_chunks(); ++c) {
+    BOOST_TEST(reader.min<0>(c) == make_record(100 * c).x);
+    BOOST_TEST(reader.max<0>(c) == make_record(100 * c + 99).x);
+    BOOST_TEST(reader.min<5>(c) == make_record(100 * c + 99).c);
+    BOOST_TEST(reader.max<5>(c) == make_record(100 * c).c);
+    BOOST_TEST(not reader.min<6>(c));
+    BOOST_TEST(reader.max<6>(c));
+  }
+  // select chunks that contain records 250 to 420
+  std::vector<size_t> selected;
+  for (size_t c = 0; c < reader.num_chunks(); ++c) {
+    if (reader.may_contain<0>(c, 250, 420)) {
+      selected.push_back(c);
+    }
+  }
+  BOOST_TEST(selected == (std::vector<size_t>{2, 3, 4}));
+}
+
+struct Measurement {
+  uint64_t id = 0;
+  double value = 0;
+
+  DFE_NAMEDTUPLE(Measurement, id, value)
+};
+struct MeasurementReordered {
+  double value = 0;
+  double extra = 0;
+  uint64_t id = 0;
+
+  DFE_NAMEDTUPLE(MeasurementReordered, value, extra, id)
+};
+
+BOOST_AUTO_TEST_CASE(columnar_namedtuple_statistics_nan) {
+  {
+    dfe::NamedTupleColumnarWriter<Measurement> writer("test_nan.dfecol", 4);
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    for (double value : {nan, 2.0, nan, 1.0, nan, nan, nan, nan}) {
+      Measurement m;
+      m.value = value;
+      writer.append(m);
+    }
+  }
+
+  dfe::NamedTupleColumnarReader<Measurement> reader("test_nan.dfecol");
+  // NaN values are ignored in the statistics if possible
+  BOOST_TEST(reader.min<1>(0) == 1.0);
+  BOOST_TEST(reader.max<1>(0) == 2.0);
+  BOOST_TEST(not reader.may_contain<1>(0, 3.0, 4.0));
+  // chunks w/ only NaN values can never be skipped
+  BOOST_TEST(std::isnan(reader.min<1>(1)));
+  BOOST_TEST(reader.may_contain<1>(1, 3.0, 4.0));
+}
+
+BOOST_AUTO_TEST_CASE(columnar_namedtuple_columns_by_name) {
+  {
+    dfe::NamedTupleColumnarWriter<MeasurementReordered> writer(
+      "test_names.dfecol");
+    for (size_t i = 0; i < 10; ++i) {
+      MeasurementReordered m;
+      m.id = i;
+      m.value = 0.5 * i;
+      writer.append(m);
+    }
+  }
+
+  // columns are matched by name; extra columns are ignored
+  dfe::NamedTupleColumnarReader<Measurement> reader("test_names.dfecol");
+  Measurement m;
+  for (size_t i = 0; i < 10; ++i) {
+    BOOST_TEST_REQUIRE(reader.read(m));
+    BOOST_TEST(m.id == i);
+    BOOST_TEST(m.value == 0.5 * i);
+  }
+  // missing columns are an error
+  BOOST_CHECK_THROW(
+    dfe::NamedTupleColumnarReader<Record>("test_names.dfecol"),
+    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(columnar_namedtuple_read_invalid) {
+  BOOST_CHECK_THROW(
+    dfe::NamedTupleColumnarReader<Record>("does_not_exist.dfecol"),
+    std::runtime_error);
+  {
+    std::ofstream file("test_invalid.dfecol");
+    file << "DFECOL01 but not a valid columnar file DFECOL01";
+  }
+  BOOST_CHECK_THROW(
+    dfe::NamedTupleColumnarReader<Record>("test_invalid.dfecol"),
+    std::runtime_error);
+  // truncated files
+  {
+    dfe::NamedTupleColumnarWriter<Record> writer("test_truncated.dfecol");
+    for (size_t i = 0; i < 100; ++i) {
+      writer.append(make_record(i));
+    }
+  }
+  std::string contents;
+  {
+    std::ifstream file("test_truncated.dfecol", std::ios_base::binary);
+    contents.assign(
+      std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream file("test_truncated.dfecol", std::ios_base::binary);
+    file << contents.substr(contents.size() / 2);
+  }
+  BOOST_CHECK_THROW(
+    dfe::NamedTupleColumnarReader<Record>("test_truncated.dfecol"),
+    std::runtime_error);
+}
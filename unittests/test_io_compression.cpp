@@ -0,0 +1,208 @@
+// SPDX-License-Identifier: MIT
+
+/// \file
+/// \brief Unit tests for transparently compressed delimiter-based i/o
+
+// must be defined consistently before including any i/o header
+#ifndef DFE_USE_IO_ZLIB
+#define DFE_USE_IO_ZLIB
+#endif
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
+#include "dfe/dfe_io_compression.hpp"
+#include "dfe/dfe_io_dsv.hpp"
+#include "record.hpp"
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(Record::Tuple)
+
+// large enough to require multiple compressed blocks
+static constexpr size_t kNRecords = 1 << 15;
+
+static std::string
+read_file(const std::string& path) {
+  std::ifstream file(path, std::ios_base::binary);
+  return {std::istreambuf_iterator<char>(file), {}};
+}
+
+static void
+write_records(const std::string& path, size_t n) {
+  dfe::NamedTupleCsvWriter<Record> writer(path);
+  for (size_t i = 0; i < n; ++i) {
+    writer.append(make_record(i));
+  }
+}
+
+static void
+check_records(const std::string& path, size_t n) {
+  dfe::NamedTupleCsvReader<Record> reader(path);
+  Record record;
+  size_t i = 0;
+  for (; reader.read(record); ++i) {
+    BOOST_TEST(record.tuple() == make_record(i).tuple(), "record " << i);
+  }
+  BOOST_TEST(i == n);
+}
+
+BOOST_AUTO_TEST_CASE(compression_format) {
+  using dfe::io_compression_impl::Format;
+  using dfe::io_compression_impl::format_from_extension;
+
+  BOOST_TEST((format_from_extension("data.csv") == Format::None));
+  BOOST_TEST((format_from_extension("data.csv.gz") == Format::Gzip));
+  BOOST_TEST((format_from_extension("data.tsv.zst") == Format::Zstd));
+  BOOST_TEST((format_from_extension("gz") == Format::None));
+}
+
+BOOST_AUTO_TEST_CASE(compression_gzip_write_read) {
+  write_records("test_compression.csv", kNRecords);
+  write_records("test_compression.csv.gz", kNRecords);
+
+  auto plain = read_file("test_compression.csv");
+  auto compressed = read_file("test_compression.csv.gz");
+  BOOST_TEST(compressed.size() < plain.size());
+  BOOST_TEST(static_cast<unsigned char>(compressed.at(0)) == 0x1fu);
+  BOOST_TEST(static_cast<unsigned char>(compressed.at(1)) == 0x8bu);
+  // compressed input is detected from the content, not the extension
+  {
+    std::ofstream file("test_compression_gz.csv", std::ios_base::binary);
+    file << compressed;
+  }
+  check_records("test_compression.csv.gz", kNRecords);
+  check_records("test_compression_gz.csv", kNRecords);
+}
+
+BOOST_AUTO_TEST_CASE(compression_gzip_explicit_flush) {
+  {
+    dfe::NamedTupleCsvWriter<Record> writer("test_compression_flush.csv.gz");
+    for (size_t i = 0; i < kNRecords; ++i) {
+      writer.append(make_record(i));
+      if ((i % 4096) == 0) {
+        writer.flush();
+      }
+    }
+  }
+  check_records("test_compression_flush.csv.gz", kNRecords);
+}
+
+BOOST_AUTO_TEST_CASE(compression_gzip_explicit_close) {
+  dfe::NamedTupleCsvWriter<Record> writer("test_compression_close.csv.gz");
+  for (size_t i = 0; i < kNRecords; ++i) {
+    writer.append(make_record(i));
+  }
+  writer.close();
+  // the complete stream is available before the writer is destroyed
+  check_records("test_compression_close.csv.gz", kNRecords);
+  // closing again has no effect
+  BOOST_CHECK_NO_THROW(writer.close());
+}
+
+BOOST_AUTO_TEST_CASE(compression_gzip_concatenated) {
+  // concatenated gzip members decompress to the concatenated content
+  const std::string first = "x,y\n1,2\n";
+  const std::string second = "3,4\n";
+  {
+    dfe::io_compression_impl::CompressedOutput out(
+      "test_compression_concat_a.gz", dfe::io_compression_impl::Format::Gzip);
+    out.write(first.data(), first.size());
+    out.finish();
+  }
+  {
+    dfe::io_compression_impl::CompressedOutput out(
+      "test_compression_concat_b.gz", dfe::io_compression_impl::Format::Gzip);
+    out.write(second.data(), second.size());
+    out.finish();
+  }
+  {
+    std::ofstream file("test_compression_concat.csv", std::ios_base::binary);
+    file << read_file("test_compression_concat_a.gz");
+    file << read_file("test_compression_concat_b.gz");
+  }
+  dfe::io_dsv_impl::DsvReader<','> reader("test_compression_concat.csv");
+  std::vector<std::string> row;
+  BOOST_TEST(reader.read(row));
+  BOOST_TEST(reader.read(row));
+  BOOST_TEST(reader.read(row));
+  BOOST_TEST(row.at(0) == "3");
+  BOOST_TEST(row.at(1) == "4");
+  BOOST_TEST(not reader.read(row));
+}
+
+BOOST_AUTO_TEST_CASE(compression_gzip_truncated) {
+  write_records("test_compression_full.csv.gz", kNRecords);
+  auto compressed = read_file("test_compression_full.csv.gz");
+  {
+    std::ofstream file("test_compression_truncated.csv", std::ios_base::binary);
+    file << compressed.substr(0, compressed.size() / 2);
+  }
+  // decoding runs ahead and the error might already surface on construction
+  auto read_all = []() {
+    dfe::NamedTupleCsvReader<Record> reader("test_compression_truncated.csv");
+    Record record;
+    while (reader.read(record)) {
+    }
+  };
+  BOOST_CHECK_THROW(read_all(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(compression_gzip_split) {
+  write_records("test_compression_split.csv.gz", kNRecords);
+  dfe::NamedTupleCsvReader<Record> reader("test_compression_split.csv.gz");
+  // compressed input can not be split and is moved into a single reader
+  auto readers = reader.split(4);
+  BOOST_TEST(readers.size() == 1u);
+  Record record;
+  BOOST_TEST(not reader.read(record));
+  size_t i = 0;
+  for (; readers.front().read(record); ++i) {
+    BOOST_TEST(record.tuple() == make_record(i).tuple(), "record " << i);
+  }
+  BOOST_TEST(i == kNRecords);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+BOOST_AUTO_TEST_CASE(compression_gzip_read_fifo) {
+  write_records("test_compression_fifo_source.csv.gz", kNRecords);
+  auto compressed = read_file("test_compression_fifo_source.csv.gz");
+  // compressed input from a named pipe is detected from the first block
+  std::remove("test_compression_fifo.csv");
+  BOOST_TEST_REQUIRE(::mkfifo("test_compression_fifo.csv", 0600) == 0);
+  std::thread producer([&compressed]() {
+    std::ofstream file("test_compression_fifo.csv", std::ios_base::binary);
+    file << compressed;
+  });
+  size_t n = 0;
+  bool is_consistent = true;
+  {
+    dfe::NamedTupleCsvReader<Record> reader("test_compression_fifo.csv");
+    Record record;
+    for (; reader.read(record); ++n) {
+      is_consistent &= (record.tuple() == make_record(n).tuple());
+    }
+  }
+  producer.join();
+  BOOST_TEST(is_consistent);
+  BOOST_TEST(n == kNRecords);
+}
+#endif
+
+#ifdef DFE_USE_IO_ZSTD
+BOOST_AUTO_TEST_CASE(compression_zstd_write_read) {
+  write_records("test_compression.csv.zst", kNRecords);
+  auto compressed = read_file("test_compression.csv.zst");
+  BOOST_TEST(static_cast<unsigned char>(compressed.at(0)) == 0x28u);
+  BOOST_TEST(static_cast<unsigned char>(compressed.at(1)) == 0xb5u);
+  check_records("test_compression.csv.zst", kNRecords);
+}
+#endif
@@ -5,6 +5,19 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
 #include "dfe/dfe_io_dsv.hpp"
 #include "dfe/dfe_namedtuple.hpp"
 #include "record.hpp"
@@ -24,6 +37,32 @@ BOOST_TEST_DONT_PRINT_LOG_VALUE(Record::Tuple)
     } \
   } while (false)
 
+// Switch to a locale w/ a comma decimal point if one is available.
+//
+// The C library number conversions depend on the `LC_NUMERIC` locale.
+class CommaLocale {
+public:
+  CommaLocale() : m_previous(std::setlocale(LC_NUMERIC, nullptr)) {
+    for (const char* name :
+         {"de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "fr_FR.utf8",
+          "fr_FR"}) {
+      if (std::setlocale(LC_NUMERIC, name)
+          and (std::string(std::localeconv()->decimal_point) == ",")) {
+        m_is_active = true;
+        return;
+      }
+    }
+    std::setlocale(LC_NUMERIC, m_previous.c_str());
+  }
+  ~CommaLocale() { std::setlocale(LC_NUMERIC, m_previous.c_str()); }
+
+  bool is_active() const { return m_is_active; }
+
+private:
+  std::string m_previous;
+  bool m_is_active = false;
+};
+
 // full write/read chain tests
 
 constexpr size_t kNRecords = 1024;
@@ -99,6 +138,237 @@ BOOST_AUTO_TEST_CASE(tsv_untyped_write) {
     writer.append(1, 2, false, true, 123.2), std::invalid_argument);
 }
 
+BOOST_AUTO_TEST_CASE(csv_untyped_write_content) {
+  {
+    dfe::CsvWriter writer({"a", "b", "c"}, "untyped_content.csv", 4);
+
+    writer.append(int8_t(-12), uint8_t(200), 'x');
+    // rejected rows must not leave partial data in the file
+    BOOST_CHECK_THROW(writer.append(1, 2), std::invalid_argument);
+    BOOST_CHECK_THROW(writer.append(1, 2, 3, 4), std::invalid_argument);
+    writer.append(INT64_MIN, UINT64_MAX, true);
+    writer.append(0.1, -1234567.0, std::vector<float>{2.5f});
+    BOOST_CHECK_NO_THROW(writer.flush());
+    writer.append(std::string("abc"), "def", false);
+  }
+  std::ifstream file("untyped_content.csv", std::ios_base::binary);
+  std::string content(
+    (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  BOOST_TEST(
+    content
+    == "a,b,c\n"
+       "-12,200,x\n"
+       "-9223372036854775808,18446744073709551615,1\n"
+       "0.1,-1.235e+06,2.5\n"
+       "abc,def,0\n");
+}
+
+BOOST_AUTO_TEST_CASE(csv_untyped_write_locale) {
+  CommaLocale locale;
+  if (not locale.is_active()) {
+    BOOST_TEST_MESSAGE("No locale w/ a comma decimal point is available");
+    return;
+  }
+  {
+    dfe::CsvWriter writer({"a", "b"}, "untyped_locale.csv", 4);
+    writer.append(1.5, -2.25e-10f);
+  }
+  std::ifstream file("untyped_locale.csv", std::ios_base::binary);
+  std::string content(
+    (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  BOOST_TEST(content == "a,b\n1.5,-2.25e-10\n");
+}
+
+BOOST_AUTO_TEST_CASE(csv_untyped_write_move_assign) {
+  {
+    dfe::CsvWriter writer({"a"}, "untyped_move_first.csv");
+    writer.append(1);
+    dfe::CsvWriter other({"b"}, "untyped_move_second.csv");
+    other.append(2);
+    // the buffered rows of the replaced writer must be written first
+    writer = std::move(other);
+    writer.append(3);
+  }
+  auto read_content = [](const char* path) {
+    std::ifstream file(path, std::ios_base::binary);
+    return std::string(
+      (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  };
+  BOOST_TEST(read_content("untyped_move_first.csv") == "a\n1\n");
+  BOOST_TEST(read_content("untyped_move_second.csv") == "b\n2\n3\n");
+}
+
+BOOST_AUTO_TEST_CASE(tsv_untyped_read) {
+  // last line intentionally w/o trailing newline
+  {
+    std::ofstream file("untyped_read.tsv", std::ios_base::binary);
+    file << "col0\tcol1\tcol2\n";
+    file << "1\tabc\t2.5\n";
+    file << "\t\tx\n";
+    file << "23\tlast";
+  }
+  dfe::io_dsv_impl::DsvReader<'\t'> reader("untyped_read.tsv");
+  std::vector<dfe::io_dsv_impl::StringView> views;
+  std::vector<std::string> columns;
+
+  BOOST_TEST(reader.read(views));
+  BOOST_TEST(views.size() == 3);
+  BOOST_TEST(views[0].to_string() == "col0");
+  BOOST_TEST(views[2].to_string() == "col2");
+  BOOST_TEST(reader.read(columns));
+  BOOST_TEST(columns == (std::vector<std::string>{"1", "abc", "2.5"}));
+  BOOST_TEST(reader.read(columns));
+  BOOST_TEST(columns == (std::vector<std::string>{"", "", "x"}));
+  BOOST_TEST(reader.read(views));
+  BOOST_TEST(views.size() == 2);
+  BOOST_TEST(views[0].to_string() == "23");
+  BOOST_TEST(views[1].to_string() == "last");
+  BOOST_TEST(not reader.read(views));
+  BOOST_TEST(reader.num_lines() == 4);
+}
+
+BOOST_AUTO_TEST_CASE(tsv_untyped_read_empty) {
+  // empty files can not be mapped and use the buffered reader
+  { std::ofstream file("untyped_empty.tsv", std::ios_base::binary); }
+  dfe::io_dsv_impl::DsvReader<'\t'> reader("untyped_empty.tsv");
+  std::vector<std::string> columns;
+
+  BOOST_TEST(not reader.read(columns));
+  BOOST_TEST(reader.num_lines() == 0);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+BOOST_AUTO_TEST_CASE(csv_untyped_read_fifo) {
+  // named pipes can only be read once and use the buffered reader
+  std::remove("untyped_fifo.csv");
+  BOOST_TEST_REQUIRE(::mkfifo("untyped_fifo.csv", 0600) == 0);
+  std::thread producer([]() {
+    std::ofstream file("untyped_fifo.csv", std::ios_base::binary);
+    file << "abcd,1\nefgh,2\n";
+  });
+  std::vector<std::vector<std::string>> rows;
+  {
+    dfe::io_dsv_impl::DsvReader<','> reader("untyped_fifo.csv");
+    std::vector<std::string> columns;
+    while (reader.read(columns)) {
+      rows.push_back(columns);
+    }
+  }
+  producer.join();
+  BOOST_TEST(rows.size() == 2u);
+  BOOST_TEST(rows.at(0) == (std::vector<std::string>{"abcd", "1"}));
+  BOOST_TEST(rows.at(1) == (std::vector<std::string>{"efgh", "2"}));
+}
+#endif
+
+// conversion tests
+
+template<typename T>
+static T
+parse_as(const std::string& str) {
+  T value;
+  dfe::io_dsv_impl::parse(str, value);
+  return value;
+}
+
+BOOST_AUTO_TEST_CASE(dsv_parse_integer) {
+  BOOST_TEST(parse_as<int>("0") == 0);
+  BOOST_TEST(parse_as<int>("-0") == 0);
+  BOOST_TEST(parse_as<int>("+12") == 12);
+  BOOST_TEST(parse_as<int>("-12345") == -12345);
+  BOOST_TEST(parse_as<int8_t>("-128") == INT8_MIN);
+  BOOST_TEST(parse_as<int8_t>("127") == INT8_MAX);
+  BOOST_TEST(parse_as<uint8_t>("255") == UINT8_MAX);
+  BOOST_TEST(parse_as<int64_t>("-9223372036854775808") == INT64_MIN);
+  BOOST_TEST(parse_as<int64_t>("9223372036854775807") == INT64_MAX);
+  BOOST_TEST(parse_as<uint64_t>("18446744073709551615") == UINT64_MAX);
+  // out of range
+  BOOST_CHECK_THROW(parse_as<int8_t>("128"), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<int8_t>("-129"), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<uint8_t>("256"), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<uint32_t>("-1"), std::runtime_error);
+  BOOST_CHECK_THROW(
+    parse_as<uint64_t>("18446744073709551616"), std::runtime_error);
+  // invalid content
+  BOOST_CHECK_THROW(parse_as<int>(""), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<int>("-"), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<int>("12a"), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<int>("1.5"), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<int>(" 12"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(dsv_parse_bool_string) {
+  BOOST_TEST(parse_as<bool>("1"));
+  BOOST_TEST(not parse_as<bool>("0"));
+  BOOST_CHECK_THROW(parse_as<bool>("2"), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<bool>(""), std::runtime_error);
+  BOOST_TEST(parse_as<std::string>("a b c") == "a b c");
+  BOOST_TEST(parse_as<std::string>("") == "");
+}
+
+BOOST_AUTO_TEST_CASE(dsv_parse_floating_point) {
+  BOOST_TEST(parse_as<double>("0") == 0.0);
+  BOOST_TEST(parse_as<double>("-0.5") == -0.5);
+  BOOST_TEST(parse_as<double>("1e3") == 1000.0);
+  BOOST_TEST(parse_as<double>(".25") == 0.25);
+  BOOST_TEST(parse_as<double>("1.") == 1.0);
+  BOOST_TEST(parse_as<double>("2.5E-3") == 2.5e-3);
+  BOOST_TEST(parse_as<double>("-42.5342500000000001") == -42.53425);
+  BOOST_TEST(parse_as<double>("1e308") == 1e308);
+  BOOST_TEST(std::isinf(parse_as<double>("inf")));
+  BOOST_TEST(std::isnan(parse_as<double>("nan")));
+  BOOST_TEST(parse_as<float>("0.231261208653450012") == 0.23126121f);
+  BOOST_CHECK_THROW(parse_as<double>(""), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<double>("."), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<double>("1.2.3"), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<double>("1e"), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<float>("0.5x"), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<double>(" 1.5"), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<float>("\t1.5"), std::runtime_error);
+  // overflows are rejected, underflows round towards zero
+  BOOST_CHECK_THROW(parse_as<double>("1e999"), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<double>("-1e999"), std::runtime_error);
+  BOOST_CHECK_THROW(parse_as<float>("1e39"), std::runtime_error);
+  BOOST_TEST(parse_as<double>("1e-999") == 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(dsv_parse_floating_point_locale) {
+  CommaLocale locale;
+  if (not locale.is_active()) {
+    BOOST_TEST_MESSAGE("No locale w/ a comma decimal point is available");
+    return;
+  }
+  // the first input is exact; all others use the C library conversion
+  BOOST_TEST(parse_as<double>("1.5") == 1.5);
+  BOOST_TEST(parse_as<double>("0.1000000000000000055511151231257827") == 0.1);
+  BOOST_TEST(parse_as<float>("1.5e-40") == 1.5e-40f);
+  BOOST_CHECK_THROW(parse_as<double>("1,5"), std::runtime_error);
+  BOOST_CHECK_THROW(
+    parse_as<double>("0,1000000000000000055511151231257827"),
+    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(dsv_parse_floating_point_roundtrip) {
+  std::mt19937_64 rng(12345);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  std::uniform_int_distribution<int> exponent(-30, 30);
+  char buffer[64];
+
+  for (int i = 0; i < 8192; ++i) {
+    double d = std::ldexp(uniform(rng), exponent(rng));
+    float f = static_cast<float>(d);
+    // shortest and full precision representations
+    for (int precision : {6, 15, 17}) {
+      std::snprintf(buffer, sizeof(buffer), "%.*g", precision, d);
+      BOOST_TEST(parse_as<double>(buffer) == std::strtod(buffer, nullptr));
+    }
+    for (int precision : {6, 9}) {
+      std::snprintf(buffer, sizeof(buffer), "%.*g", precision, f);
+      BOOST_TEST(parse_as<float>(buffer) == std::strtof(buffer, nullptr));
+    }
+  }
+}
+
 // construct a path to an example data file
 std::string
 make_data_path(const char* filename) {
@@ -166,6 +436,43 @@ BOOST_AUTO_TEST_CASE(tsv_namedtuple_read_extra_columns) {
   BOOST_TEST(reader.num_extra_columns() == 3);
 }
 
+// columnar batch reads
+
+BOOST_AUTO_TEST_CASE(csv_namedtuple_read_batch) {
+  dfe::NamedTupleCsvReader<Record> reader(make_data_path("extra_columns.csv"));
+  dfe::NamedTupleColumns<Record> columns;
+
+  size_t n = 0;
+  // batch size intentionally not a divisor of the number of records
+  for (size_t nread; 0 < (nread = reader.read_batch(5, columns));) {
+    BOOST_TEST(nread == columns.size());
+    for (size_t i = 0; i < columns.size(); ++i, ++n) {
+      auto expected = make_record(n);
+      BOOST_TEST(columns.column<0>()[i] == expected.x);
+      BOOST_TEST(columns.column<4>()[i] == expected.b);
+      BOOST_TEST(columns.column<6>()[i] == expected.d);
+      BOOST_TEST(columns.record(i).tuple() == expected.tuple());
+    }
+  }
+  BOOST_TEST(n == kNOnfile);
+  BOOST_TEST(reader.num_records() == kNOnfile);
+}
+
+BOOST_AUTO_TEST_CASE(csv_namedtuple_read_batch_optionals) {
+  using Reader = dfe::NamedTupleCsvReader<Record>;
+
+  Reader reader(make_data_path("missing_columns.csv"), {"b", "x"});
+  auto columns = reader.read_batch(1000);
+  BOOST_TEST(columns.size() == kNOnfile);
+  for (size_t i = 0; i < columns.size(); ++i) {
+    auto expected = make_record(i);
+    expected.x = 0;
+    expected.b = 0.0f;
+    BOOST_TEST(columns.record(i).tuple() == expected.tuple());
+  }
+  BOOST_TEST(reader.read_batch(1000).empty());
+}
+
 // w/ optional columns
 
 static void
@@ -231,3 +538,169 @@ BOOST_AUTO_TEST_CASE(tsv_namedtuple_read_bad_files) {
   BOOST_CHECK_THROW(
     Reader(make_data_path("too_many_columns.tsv")).read(r), std::runtime_error);
 }
+
+// parallel read tests
+
+BOOST_AUTO_TEST_CASE(csv_namedtuple_split) {
+  constexpr size_t kNLarge = 20000;
+  {
+    dfe::NamedTupleCsvWriter<Record> writer("test_split.csv");
+    for (size_t i = 0; i < kNLarge; ++i) {
+      writer.append(make_record(i));
+    }
+  }
+  dfe::NamedTupleCsvReader<Record> reader("test_split.csv");
+  auto readers = reader.split(7);
+  BOOST_TEST(readers.size() == 7);
+  // splitting consumes all unread lines
+  Record record;
+  BOOST_TEST(not reader.read(record));
+
+  // read each range on its own thread
+  std::vector<std::vector<Record>> results(readers.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < readers.size(); ++i) {
+    threads.emplace_back([&, i]() {
+      Record r;
+      while (readers[i].read(r)) {
+        results[i].push_back(r);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // ranges are in file order
+  size_t n = 0;
+  for (const auto& result : results) {
+    BOOST_TEST(not result.empty());
+    for (const auto& r : result) {
+      BOOST_TEST(r.tuple() == make_record(n).tuple());
+      n += 1;
+    }
+  }
+  BOOST_TEST(n == kNLarge);
+}
+
+BOOST_AUTO_TEST_CASE(csv_namedtuple_split_small) {
+  dfe::NamedTupleCsvReader<Record> reader(make_data_path("extra_columns.csv"));
+  Record record;
+  std::vector<int> extra;
+  // read some records before splitting
+  BOOST_TEST(reader.read(record, extra));
+  BOOST_TEST(reader.read(record, extra));
+  // more readers than lines
+  auto readers = reader.split(1024);
+  BOOST_TEST(readers.size() == (kNOnfile - 2));
+  for (size_t i = 0; i < readers.size(); ++i) {
+    BOOST_TEST(readers[i].num_extra_columns() == 3);
+    BOOST_TEST(readers[i].read(record, extra));
+    BOOST_TEST(record.tuple() == make_record(2 + i).tuple());
+    BOOST_TEST(extra == std::vector<int>(3, 2 + i));
+    BOOST_TEST(not readers[i].read(record, extra));
+    BOOST_TEST(readers[i].num_records() == 1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(tsv_namedtuple_parallel_read) {
+  constexpr size_t kNLarge = 50000;
+  {
+    dfe::NamedTupleTsvWriter<Record> writer("test_parallel.tsv");
+    for (size_t i = 0; i < kNLarge; ++i) {
+      writer.append(make_record(i));
+    }
+  }
+  for (size_t num_threads : {1u, 3u, 8u}) {
+    BOOST_TEST_CONTEXT("threads " << num_threads) {
+      dfe::NamedTupleTsvParallelReader<Record> reader(
+        "test_parallel.tsv", num_threads);
+      TEST_READER_RECORDS(reader);
+      BOOST_TEST(reader.num_records() == kNLarge);
+    }
+  }
+  // stop before reading all records
+  {
+    dfe::NamedTupleTsvParallelReader<Record> reader("test_parallel.tsv", 4);
+    Record record;
+    BOOST_TEST(reader.read(record));
+    BOOST_TEST(record.tuple() == make_record(0).tuple());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(csv_namedtuple_parallel_read_optionals) {
+  using Reader = dfe::NamedTupleCsvParallelReader<Record>;
+
+  Reader reader(make_data_path("missing_columns.csv"), 4, {"b", "x"});
+  Record data;
+  data.x = 12;
+  data.b = 0.5f;
+
+  for (std::size_t i = 0; reader.read(data); ++i) {
+    Record expected = make_record(i);
+    BOOST_TEST(data.y == expected.y);
+    BOOST_TEST(data.z == expected.z);
+    BOOST_TEST(data.a == expected.a);
+    BOOST_TEST(data.c == expected.c);
+    BOOST_TEST(data.d == expected.d);
+    // missing columns should be left untouched
+    BOOST_TEST(data.x == 12);
+    BOOST_TEST(data.b == 0.5f);
+  }
+  BOOST_TEST(reader.num_records() == kNOnfile);
+  BOOST_TEST(reader.num_extra_columns() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(csv_namedtuple_parallel_read_bad_line) {
+  constexpr size_t kNLarge = 1000;
+  constexpr size_t kNGood = 601;
+  {
+    dfe::NamedTupleCsvWriter<Record> writer("test_parallel_bad_line.csv");
+    for (size_t i = 0; i < kNLarge; ++i) {
+      writer.append(make_record(i));
+    }
+  }
+  // replace a line in the middle of a chunk with invalid content
+  std::vector<std::string> lines;
+  {
+    std::ifstream file("test_parallel_bad_line.csv");
+    for (std::string line; std::getline(file, line);) {
+      lines.push_back(line);
+    }
+  }
+  lines.at(1 + kNGood) = "1,2,3,4,not-a-number,6,7";
+  {
+    std::ofstream file("test_parallel_bad_line.csv");
+    for (const auto& line : lines) {
+      file << line << '\n';
+    }
+  }
+  // collect all records until the first error
+  auto read_until_error = [](auto&& reader) {
+    std::vector<Record::Tuple> records;
+    Record record;
+    BOOST_CHECK_THROW(
+      while (reader.read(record)) { records.push_back(record.tuple()); },
+      std::runtime_error);
+    return records;
+  };
+  auto serial = read_until_error(
+    dfe::NamedTupleCsvReader<Record>("test_parallel_bad_line.csv"));
+  BOOST_TEST(serial.size() == kNGood);
+  for (size_t num_threads : {1u, 2u, 3u}) {
+    BOOST_TEST_CONTEXT("threads " << num_threads) {
+      auto parallel = read_until_error(dfe::NamedTupleCsvParallelReader<Record>(
+        "test_parallel_bad_line.csv", num_threads));
+      BOOST_TEST(parallel.size() == serial.size());
+      BOOST_TEST((parallel == serial));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(csv_namedtuple_parallel_read_bad_file) {
+  using Reader = dfe::NamedTupleCsvParallelReader<Record>;
+
+  Record r;
+  BOOST_CHECK_THROW(Reader("does/not/exist.csv"), std::runtime_error);
+  BOOST_CHECK_THROW(
+    Reader(make_data_path("too_few_columns.csv")).read(r), std::runtime_error);
+}
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: MIT
+
+/// \file
+/// \brief Unit tests for histogram i/o
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "dfe/dfe_histogram.hpp"
+#include "dfe/dfe_io_histogram.hpp"
+
+using H2 = dfe::Histogram<
+  double, dfe::UniformAxis<double>, dfe::OverflowAxis<double>>;
+
+static std::string
+read_file(const std::string& path) {
+  std::ifstream file(path, std::ios_base::binary);
+  return std::string(
+    std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>{});
+}
+
+static H2
+make_filled() {
+  H2 h({0.0, 1.0, 10}, {-1.0, 1.0, 4});
+  for (size_t i = 0; i < 100; ++i) {
+    h.fill(0.01 * i, -1.5 + 0.03 * i, 0.5 * (i % 3));
+  }
+  return h;
+}
+
+BOOST_AUTO_TEST_CASE(histogram_npy_write) {
+  auto h = make_filled();
+  dfe::write_histogram_npy("test_hist", h);
+
+  auto content = read_file("test_hist.npy");
+  BOOST_TEST(content.find("'descr': '<f8'") != std::string::npos);
+  BOOST_TEST(content.find("'fortran_order': True") != std::string::npos);
+  BOOST_TEST(content.find("'shape': (10,6,)") != std::string::npos);
+  BOOST_TEST((content.size() % 16u) == 0u);
+  auto axis0 = read_file("test_hist.axis0.npy");
+  auto axis1 = read_file("test_hist.axis1.npy");
+  BOOST_TEST(axis0.find("'shape': (11,)") != std::string::npos);
+  BOOST_TEST(axis1.find("'shape': (5,)") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_npy_add) {
+  auto h = make_filled();
+  dfe::write_histogram_npy("test_hist_add", h);
+
+  H2 sum({0.0, 1.0, 10}, {-1.0, 1.0, 4});
+  dfe::add_histogram_npy("test_hist_add", sum);
+  dfe::add_histogram_npy("test_hist_add", sum);
+  for (size_t i = 0; i < 10; ++i) {
+    for (size_t j = 0; j < 6; ++j) {
+      BOOST_TEST(sum.value({i, j}) == 2 * h.value({i, j}));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(histogram_npy_storage) {
+  using C2 = dfe::Histogram<
+    dfe::CounterStorage, dfe::VariableAxis<float>, dfe::LogAxis<double>>;
+  using S2 = dfe::Histogram<
+    dfe::SparseStorage<uint64_t>, dfe::VariableAxis<float>,
+    dfe::LogAxis<double>>;
+
+  C2 counts({0.0f, 1.0f, 4.0f, 9.0f}, {1.0, 100.0, 8});
+  counts.fill(0.5f, 2.0);
+  counts.fill(0.5f, 2.0, 300);
+  counts.fill(8.5f, 99.0);
+  dfe::write_histogram_npy("test_hist_counts", counts);
+
+  S2 sparse({0.0f, 1.0f, 4.0f, 9.0f}, {1.0, 100.0, 8});
+  dfe::add_histogram_npy("test_hist_counts", sparse);
+  BOOST_TEST(sparse.data().num_stored() == 2u);
+  BOOST_TEST(sparse.value({0, 1}) == 301u);
+  BOOST_TEST(sparse.value({2, 7}) == 1u);
+  dfe::write_histogram_npy("test_hist_sparse", sparse);
+  dfe::add_histogram_npy("test_hist_sparse", counts);
+  BOOST_TEST(counts.value({0, 1}) == 602u);
+  BOOST_TEST(counts.value({2, 7}) == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_npy_invalid) {
+  auto h = make_filled();
+  dfe::write_histogram_npy("test_hist_invalid", h);
+
+  // different binning
+  H2 other({0.0, 2.0, 10}, {-1.0, 1.0, 4});
+  BOOST_CHECK_THROW(
+    dfe::add_histogram_npy("test_hist_invalid", other), std::runtime_error);
+  BOOST_TEST(other.value({0, 0}) == 0.0);
+  // different weight type
+  using F2 = dfe::Histogram<
+    float, dfe::UniformAxis<double>, dfe::OverflowAxis<double>>;
+  F2 single({0.0, 1.0, 10}, {-1.0, 1.0, 4});
+  BOOST_CHECK_THROW(
+    dfe::add_histogram_npy("test_hist_invalid", single), std::runtime_error);
+  // missing files
+  BOOST_CHECK_THROW(
+    dfe::add_histogram_npy("does-not-exist", other), std::runtime_error);
+}
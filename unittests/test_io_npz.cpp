@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: MIT
+
+/// \file
+/// \brief Unit tests for npz i/o
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+
+#include <zlib.h>
+
+#include "dfe/dfe_io_npz.hpp"
+#include "dfe/dfe_namedtuple.hpp"
+#include "record.hpp"
+
+// enough records to require multiple blocks per column
+static constexpr size_t kNRecords = 150000;
+
+static uint64_t
+get_le(const std::string& data, size_t pos, size_t size) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < size; ++i) {
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(data[pos + i]))
+             << (8 * i);
+  }
+  return value;
+}
+
+// extract all entries from a zip archive w/o zip64 extensions
+static std::map<std::string, std::string>
+read_archive(const std::string& path) {
+  std::ifstream file(path, std::ios_base::binary);
+  std::string archive(
+    std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>{});
+  std::map<std::string, std::string> entries;
+
+  size_t pos = 0;
+  while (get_le(archive, pos, 4) == 0x04034b50) {
+    auto method = get_le(archive, pos + 8, 2);
+    auto crc = get_le(archive, pos + 14, 4);
+    auto compressed_size = get_le(archive, pos + 18, 4);
+    auto size = get_le(archive, pos + 22, 4);
+    auto name_size = get_le(archive, pos + 26, 2);
+    auto extra_size = get_le(archive, pos + 28, 2);
+    auto name = archive.substr(pos + 30, name_size);
+    pos += 30 + name_size + extra_size;
+
+    std::string content(size, '\0');
+    if (method == 0) {
+      BOOST_TEST_REQUIRE(compressed_size == size);
+      content = archive.substr(pos, size);
+    } else {
+      BOOST_TEST_REQUIRE(method == 8u);
+      z_stream stream;
+      std::memset(&stream, 0, sizeof(stream));
+      BOOST_TEST_REQUIRE(inflateInit2(&stream, -15) == Z_OK);
+      stream.next_in = reinterpret_cast<Bytef*>(&archive[pos]);
+      stream.avail_in = compressed_size;
+      stream.next_out = reinterpret_cast<Bytef*>(&content[0]);
+      stream.avail_out = size;
+      BOOST_TEST(inflate(&stream, Z_FINISH) == Z_STREAM_END);
+      BOOST_TEST(stream.total_out == size);
+      inflateEnd(&stream);
+    }
+    auto actual_crc = crc32(
+      0, reinterpret_cast<const Bytef*>(content.data()), content.size());
+    BOOST_TEST(actual_crc == crc);
+    entries[name] = std::move(content);
+    pos += compressed_size;
+  }
+  // central directory follows the entries
+  BOOST_TEST(get_le(archive, pos, 4) == 0x02014b50u);
+  return entries;
+}
+
+template<typename T, typename Getter>
+static std::string
+expected_array(const std::string& code, Getter getter) {
+  std::string descr = "'";
+  descr += dfe::io_npy_impl::dtype_endianness_modifier();
+  descr += code;
+  descr += "'";
+  auto content = dfe::io_npy_impl::make_header(descr, kNRecords, 0);
+  for (size_t i = 0; i < kNRecords; ++i) {
+    T value = getter(make_record(i));
+    content.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+  return content;
+}
+
+static void
+check_archive(const std::string& path) {
+  auto entries = read_archive(path);
+  BOOST_TEST(entries.size() == 7u);
+  BOOST_TEST(
+    entries["x.npy"] ==
+    expected_array<int16_t>("i2", [](const Record& r) { return r.x; }));
+  BOOST_TEST(
+    entries["z.npy"] ==
+    expected_array<int64_t>("i8", [](const Record& r) { return r.z; }));
+  BOOST_TEST(
+    entries["b.npy"] ==
+    expected_array<float>("f4", [](const Record& r) { return r.b; }));
+  BOOST_TEST(
+    entries["d.npy"] ==
+    expected_array<bool>("?", [](const Record& r) { return r.d; }));
+}
+
+BOOST_AUTO_TEST_CASE(npz_namedtuple_write_compressed) {
+  {
+    dfe::NamedTupleNpzWriter<Record> writer("test_compressed.npz", true, 3);
+    for (size_t i = 0; i < kNRecords; ++i) {
+      writer.append(make_record(i));
+    }
+    writer.close();
+    BOOST_CHECK_THROW(writer.append(make_record(0)), std::runtime_error);
+  }
+  check_archive("test_compressed.npz");
+}
+
+BOOST_AUTO_TEST_CASE(npz_namedtuple_write_stored) {
+  {
+    dfe::NamedTupleNpzWriter<Record> writer("test_stored.npz", false);
+    for (size_t i = 0; i < kNRecords; ++i) {
+      writer.append(make_record(i));
+    }
+  }
+  check_archive("test_stored.npz");
+}
+
+BOOST_AUTO_TEST_CASE(npz_namedtuple_write_empty) {
+  { dfe::NamedTupleNpzWriter<Record> writer("test_empty.npz"); }
+  auto entries = read_archive("test_empty.npz");
+  BOOST_TEST(entries.size() == 7u);
+  BOOST_TEST(entries["y.npy"].size() % 16 == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(npz_namedtuple_write_move_assign) {
+  {
+    dfe::NamedTupleNpzWriter<Record> writer("test_move_first.npz");
+    dfe::NamedTupleNpzWriter<Record> other("test_move_second.npz", false);
+    for (size_t i = 0; i < kNRecords; ++i) {
+      writer.append(make_record(i));
+      other.append(make_record(i));
+    }
+    // the replaced writer must write its archive first
+    writer = std::move(other);
+  }
+  check_archive("test_move_first.npz");
+  check_archive("test_move_second.npz");
+}
@@ -5,6 +5,12 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include "dfe/dfe_io_numpy.hpp"
 #include "dfe/dfe_namedtuple.hpp"
 #include "record.hpp"
@@ -23,3 +29,234 @@ BOOST_AUTO_TEST_CASE(numpy_namedtuple_write) {
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(numpy_namedtuple_read) {
+  {
+    dfe::NamedTupleNumpyWriter<Record> writer("test_read.npy");
+    for (size_t i = 0; i < kNRecords; ++i) {
+      writer.append(make_record(i));
+    }
+  }
+
+  dfe::NamedTupleNumpyReader<Record> reader("test_read.npy");
+  BOOST_TEST(reader.size() == kNRecords);
+  // unnamed members and padding prevent direct access
+  BOOST_TEST(reader.data() == nullptr);
+
+  // sequential reading
+  Record record;
+  for (size_t i = 0; i < kNRecords; ++i) {
+    BOOST_TEST_REQUIRE(reader.read(record));
+    BOOST_TEST(record.tuple() == make_record(i).tuple());
+    BOOST_TEST(reader.num_records() == (i + 1));
+  }
+  BOOST_TEST(not reader.read(record));
+
+  // random access
+  BOOST_TEST(reader.at(17).tuple() == make_record(17).tuple());
+  BOOST_TEST(reader[23].get<1>() == make_record(23).y);
+  BOOST_TEST(reader[23].get<4>() == make_record(23).b);
+  BOOST_CHECK_THROW(reader.at(kNRecords), std::out_of_range);
+
+  // range iteration
+  size_t n = 0;
+  for (auto view : reader) {
+    BOOST_TEST(view.record().tuple() == make_record(n).tuple());
+    n += 1;
+  }
+  BOOST_TEST(n == kNRecords);
+}
+
+BOOST_AUTO_TEST_CASE(numpy_namedtuple_write_move_assign) {
+  {
+    dfe::NamedTupleNumpyWriter<Record> writer("test_move_first.npy");
+    dfe::NamedTupleNumpyWriter<Record> other("test_move_second.npy");
+    for (size_t i = 0; i < 10; ++i) {
+      writer.append(make_record(i));
+      other.append(make_record(i));
+    }
+    // the replaced writer must finish its file first
+    writer = std::move(other);
+    writer.append(make_record(10));
+  }
+
+  dfe::NamedTupleNumpyReader<Record> first("test_move_first.npy");
+  dfe::NamedTupleNumpyReader<Record> second("test_move_second.npy");
+  BOOST_TEST(first.size() == 10u);
+  BOOST_TEST(second.size() == 11u);
+  BOOST_TEST(second.at(10).tuple() == make_record(10).tuple());
+}
+
+BOOST_AUTO_TEST_CASE(numpy_namedtuple_read_batch) {
+  {
+    dfe::NamedTupleNumpyWriter<Record> writer("test_read_batch.npy");
+    for (size_t i = 0; i < 100; ++i) {
+      writer.append(make_record(i));
+    }
+  }
+
+  dfe::NamedTupleNumpyReader<Record> reader("test_read_batch.npy");
+  auto columns = reader.read_batch(64);
+  BOOST_TEST(columns.size() == 64u);
+  BOOST_TEST(columns.column<2>()[63] == make_record(63).z);
+  BOOST_TEST(reader.read_batch(64, columns) == 36u);
+  BOOST_TEST(columns.record(0).tuple() == make_record(64).tuple());
+  BOOST_TEST(reader.read_batch(64, columns) == 0u);
+  BOOST_TEST(columns.empty());
+}
+
+// in-memory layout identical to the packed on-file layout
+struct Packed {
+  double c = 0;
+  int64_t z = 0;
+  int32_t y = 0;
+  float b = 0;
+
+  DFE_NAMEDTUPLE(Packed, c, z, y, b)
+};
+
+BOOST_TEST_DONT_PRINT_LOG_VALUE(Packed::Tuple)
+
+static std::string
+read_file(const std::string& path) {
+  std::ifstream file(path, std::ios_base::binary);
+  return std::string(
+    std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+BOOST_AUTO_TEST_CASE(numpy_namedtuple_write_bulk) {
+  // enough records to require multiple buffer flushes
+  std::vector<Record> records;
+  std::vector<Packed> packed;
+  for (size_t i = 0; i < 100000; ++i) {
+    auto r = make_record(i);
+    records.push_back(r);
+    packed.push_back(Packed{r.c, r.z, r.y, r.b});
+  }
+  {
+    dfe::NamedTupleNumpyWriter<Record> single("test_write_single.npy");
+    dfe::NamedTupleNumpyWriter<Record> range("test_write_range.npy");
+    dfe::NamedTupleNumpyWriter<Packed> packed_single("test_write_psingle.npy");
+    dfe::NamedTupleNumpyWriter<Packed> packed_array("test_write_parray.npy");
+    for (size_t i = 0; i < records.size(); ++i) {
+      single.append(records[i]);
+      packed_single.append(packed[i]);
+    }
+    range.append(records.begin(), records.end());
+    // mix small and large appends
+    packed_array.append(packed.data(), 10);
+    packed_array.append(packed.data() + 10, packed.size() - 10);
+  }
+  BOOST_TEST(
+    read_file("test_write_single.npy") == read_file("test_write_range.npy"));
+  BOOST_TEST(
+    read_file("test_write_psingle.npy") == read_file("test_write_parray.npy"));
+
+  dfe::NamedTupleNumpyReader<Packed> reader("test_write_parray.npy");
+  BOOST_TEST(reader.size() == packed.size());
+  size_t i = 0;
+  for (auto view : reader) {
+    BOOST_TEST(view.record().tuple() == packed[i].tuple());
+    i += 1;
+  }
+  // identical layout allows direct access to the stored records
+  const Packed* direct = reader.data();
+  BOOST_TEST_REQUIRE(direct != nullptr);
+  BOOST_TEST(direct[0].tuple() == packed[0].tuple());
+  BOOST_TEST(direct[99999].tuple() == packed[99999].tuple());
+  Packed record;
+  for (i = 0; reader.read(record); ++i) {
+    BOOST_TEST(record.tuple() == packed[i].tuple());
+  }
+  BOOST_TEST(i == packed.size());
+}
+
+// write a npy file w/ a custom header and raw payload
+static void
+write_raw_npy(
+  const std::string& path, const std::string& dict, const std::string& data) {
+  std::string header = "\x93NUMPY";
+  header += '\x01';
+  header += '\x00';
+  header += static_cast<char>(dict.size() + 1);
+  header += '\x00';
+  header += dict;
+  header += '\n';
+  std::ofstream file(path, std::ios_base::binary | std::ios_base::trunc);
+  file.write(header.data(), header.size());
+  file.write(data.data(), data.size());
+}
+
+struct Small {
+  uint8_t u = 0;
+  int32_t i = 0;
+  bool b = false;
+
+  DFE_NAMEDTUPLE(Small, u, i, b)
+};
+
+BOOST_AUTO_TEST_CASE(numpy_namedtuple_read_byte_order) {
+  // single-byte codes as written by numpy and a non-native byte order
+  std::string order = (dfe::io_npy_impl::dtype_endianness_modifier() == '<')
+                        ? ">"
+                        : "<";
+  std::string dict = "{'descr': [('u', '|u1'), ('i', '" + order +
+                     "i4'), ('b', '|b1')], 'fortran_order': False, "
+                     "'shape': (2,), }";
+  std::string data;
+  data += '\x07';
+  if (order == ">") {
+    data += std::string("\x00\x00\x01\x02", 4);
+  } else {
+    data += std::string("\x02\x01\x00\x00", 4);
+  }
+  data += '\x01';
+  data += std::string("\xff\xff\xff\xff\xfe\x00", 6);
+  write_raw_npy("test_byte_order.npy", dict, data);
+
+  dfe::NamedTupleNumpyReader<Small> reader("test_byte_order.npy");
+  BOOST_TEST(reader.size() == 2u);
+  BOOST_TEST(reader.data() == nullptr);
+  Small small;
+  BOOST_TEST(reader.read(small));
+  BOOST_TEST(small.u == 7u);
+  BOOST_TEST(small.i == 0x102);
+  BOOST_TEST(small.b);
+  BOOST_TEST(reader.read(small));
+  BOOST_TEST(small.u == 255u);
+  BOOST_TEST(small.i == ((order == ">") ? -2 : -16777217));
+  BOOST_TEST(not small.b);
+  BOOST_TEST(not reader.read(small));
+}
+
+BOOST_AUTO_TEST_CASE(numpy_namedtuple_read_invalid) {
+  // missing file
+  BOOST_CHECK_THROW(
+    dfe::NamedTupleNumpyReader<Record>("does-not-exist.npy"),
+    std::runtime_error);
+  // incompatible fields
+  {
+    dfe::NamedTupleNumpyWriter<Small> writer("test_incompatible.npy");
+    writer.append(Small());
+  }
+  BOOST_CHECK_THROW(
+    dfe::NamedTupleNumpyReader<Record>("test_incompatible.npy"),
+    std::runtime_error);
+  // non-structured array
+  write_raw_npy(
+    "test_unstructured.npy",
+    "{'descr': '<f8', 'fortran_order': False, 'shape': (1,), }",
+    std::string(8, '\0'));
+  BOOST_CHECK_THROW(
+    dfe::NamedTupleNumpyReader<Small>("test_unstructured.npy"),
+    std::runtime_error);
+  // truncated payload
+  write_raw_npy(
+    "test_truncated.npy",
+    "{'descr': [('u', '|u1'), ('i', '<i4'), ('b', '|b1')], "
+    "'fortran_order': False, 'shape': (3,), }",
+    std::string(12, '\0'));
+  BOOST_CHECK_THROW(
+    dfe::NamedTupleNumpyReader<Small>("test_truncated.npy"),
+    std::runtime_error);
+}
@@ -6,8 +6,13 @@
 #include <boost/test/unit_test.hpp>
 
 #include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "dfe/dfe_histogram.hpp"
 #include "dfe/dfe_io_root.hpp"
+#include "dfe/dfe_io_root_histogram.hpp"
 #include "dfe/dfe_namedtuple.hpp"
 
 static constexpr size_t kNRecords = 4096;
@@ -120,4 +125,166 @@ BOOST_AUTO_TEST_CASE(root_namedtuple_write_read) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(root_namedtuple_read_batch) {
+  {
+    dfe::NamedTupleRootWriter<Record> writer("test_batch.root", "records");
+
+    for (size_t i = 0; i < kNRecords; ++i) {
+      writer.append(make_record(i));
+    }
+  }
+  dfe::NamedTupleRootReader<Record> reader("test_batch.root", "records");
+  dfe::NamedTupleColumns<Record> columns;
+
+  size_t n = 0;
+  while (0 < reader.read_batch(1000, columns)) {
+    BOOST_TEST(columns.size() <= 1000);
+    for (size_t i = 0; i < columns.size(); ++i, ++n) {
+      BOOST_TEST(columns.record(i).tuple() == make_record(n).tuple());
+      BOOST_TEST(columns.column<0>()[i] == make_record(n).u64);
+    }
+  }
+  BOOST_TEST(n == kNRecords);
+}
+
+BOOST_AUTO_TEST_CASE(root_histogram_convert) {
+  using H1 = dfe::Histogram<double, dfe::UniformAxis<double>>;
+  using H2 = dfe::Histogram<
+    double, dfe::OverflowAxis<double>, dfe::VariableAxis<double>>;
+  using H3 = dfe::Histogram<
+    double, dfe::UniformAxis<double>, dfe::OverflowAxis<double>,
+    dfe::UniformAxis<double>>;
+
+  H1 h1({0.0, 1.0, 10});
+  h1.fill(0.05);
+  h1.fill(0.95, 2.0);
+  auto th1 = dfe::make_th1(h1, "h1");
+  BOOST_TEST(th1->GetNbinsX() == 10);
+  BOOST_TEST(th1->GetBinContent(0) == 0.0);
+  BOOST_TEST(th1->GetBinContent(1) == 1.0);
+  BOOST_TEST(th1->GetBinContent(10) == 2.0);
+
+  H2 h2({0.0, 1.0, 4}, {1.0, 2.0, 10.0});
+  h2.fill(-1.0, 1.5);
+  h2.fill(0.3, 5.0, 3.0);
+  auto th2 = dfe::make_th2(h2, "h2");
+  BOOST_TEST(th2->GetBinContent(0, 1) == 1.0);
+  BOOST_TEST(th2->GetBinContent(2, 2) == 3.0);
+
+  H3 h3({0.0, 1.0, 2}, {0.0, 1.0, 2}, {0.0, 1.0, 2});
+  h3.fill(0.75, 2.0, 0.25, 4.0);
+  auto th3 = dfe::make_thn(h3, "h3");
+  Int_t idx[3] = {2, 3, 1};
+  BOOST_TEST(th3->GetNdimensions() == 3);
+  BOOST_TEST(th3->GetBinContent(idx) == 4.0);
+
+  TFile file("test_histogram.root", "RECREATE");
+  BOOST_CHECK_NO_THROW(dfe::write_root_histogram(file, "h1", h1));
+  BOOST_CHECK_NO_THROW(dfe::write_root_histogram(file, "h3", h3));
+  file.Close();
+}
+
+BOOST_AUTO_TEST_CASE(root_namedtuple_bulk) {
+  {
+    dfe::NamedTupleRootWriter<Record> writer("test_bulk.root", "records");
+    // small baskets and clusters to read across multiple baskets
+    writer.set_basket_size(4096);
+    writer.set_auto_flush(1000);
+
+    dfe::NamedTupleColumns<Record> columns;
+    for (size_t i = 0; i < kNRecords; ++i) {
+      columns.push_back(make_record(i));
+      if (columns.size() == 777) {
+        writer.append(columns);
+        columns.clear();
+      }
+    }
+    writer.append(columns);
+  }
+  dfe::NamedTupleRootReader<Record> reader("test_bulk.root", "records");
+  dfe::NamedTupleColumns<Record> columns;
+
+  // mixed batch and single record reads
+  size_t n = 0;
+  Record record;
+  while (true) {
+    auto size = reader.read_batch(1234, columns);
+    BOOST_TEST(size == columns.size());
+    for (size_t i = 0; i < columns.size(); ++i, ++n) {
+      BOOST_TEST(columns.record(i).tuple() == make_record(n).tuple());
+    }
+    if (not reader.read(record)) {
+      break;
+    }
+    BOOST_TEST(record.tuple() == make_record(n).tuple());
+    n += 1;
+  }
+  BOOST_TEST(n == kNRecords);
+}
+
+BOOST_AUTO_TEST_CASE(root_namedtuple_chain_split) {
+  std::vector<std::string> paths = {"test_chain0.root", "test_chain1.root"};
+  for (size_t f = 0; f < paths.size(); ++f) {
+    dfe::NamedTupleRootWriter<Record> writer(paths[f], "records");
+    writer.set_auto_flush(1000);
+    for (size_t i = 0; i < kNRecords; ++i) {
+      writer.append(make_record(f * kNRecords + i));
+    }
+  }
+  // chained files are read in sequence
+  {
+    dfe::NamedTupleRootReader<Record> reader(paths, "records");
+    reader.set_cache_size(1024 * 1024);
+    Record record;
+    size_t n = 0;
+    while (reader.read(record)) {
+      BOOST_TEST(record.tuple() == make_record(n).tuple());
+      n += 1;
+    }
+    BOOST_TEST(n == 2 * kNRecords);
+  }
+  // restricted entry range across the file boundary
+  {
+    dfe::NamedTupleRootReader<Record> reader(
+      paths, "records", kNRecords - 10, kNRecords + 10);
+    Record record;
+    size_t n = 0;
+    while (reader.read(record)) {
+      BOOST_TEST(record.tuple() == make_record(kNRecords - 10 + n).tuple());
+      n += 1;
+    }
+    BOOST_TEST(n == 20u);
+  }
+  // disjoint ranges read on separate threads
+  {
+    dfe::NamedTupleRootReader<Record> reader(paths, "records");
+    auto readers = reader.split(3);
+    BOOST_TEST(0 < readers.size());
+    BOOST_TEST(readers.size() <= 3);
+    std::vector<std::vector<Record>> results(readers.size());
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < readers.size(); ++t) {
+      threads.emplace_back([&, t]() {
+        Record record;
+        while (readers[t]->read(record)) {
+          results[t].push_back(record);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    size_t n = 0;
+    for (const auto& result : results) {
+      for (const auto& record : result) {
+        BOOST_TEST(record.tuple() == make_record(n).tuple());
+        n += 1;
+      }
+    }
+    BOOST_TEST(n == 2 * kNRecords);
+    Record record;
+    BOOST_TEST(not reader.read(record));
+  }
+}
+
 // TODO failure tests
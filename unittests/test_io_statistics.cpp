@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: MIT
+
+/// \file
+/// \brief Unit tests for the opt-in i/o statistics
+
+// must be defined consistently before including any i/o header
+#define DFE_USE_IO_STATISTICS
+
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dfe/dfe_io_dsv.hpp"
+#include "dfe/dfe_io_numpy.hpp"
+#include "dfe/dfe_io_statistics.hpp"
+#include "record.hpp"
+
+static constexpr size_t kNRecords = 1024;
+
+static std::size_t
+file_size(const std::string& path) {
+  std::ifstream file(path, std::ios_base::binary | std::ios_base::ate);
+  return file.tellg();
+}
+
+BOOST_AUTO_TEST_CASE(io_statistics_recorder) {
+  using Recorder = dfe::io_statistics_impl::Recorder;
+
+  std::vector<dfe::IoStatistics> reports;
+  {
+    Recorder recorder;
+    recorder.set_callback(
+      [&](const dfe::IoStatistics& stats) { reports.push_back(stats); });
+    recorder.add_bytes(16);
+    recorder.add_records(2);
+    recorder.add_flush();
+    recorder.update_buffer(64);
+    recorder.update_buffer(32);
+    { auto timer = recorder.time_io(); }
+    recorder.report();
+    BOOST_TEST(reports.size() == 1u);
+    // only the moved-to recorder reports on destruction
+    Recorder moved(std::move(recorder));
+    BOOST_TEST(moved.statistics().bytes == 16u);
+  }
+  BOOST_TEST(reports.size() == 2u);
+  for (const auto& stats : reports) {
+    BOOST_TEST(stats.bytes == 16u);
+    BOOST_TEST(stats.records == 2u);
+    BOOST_TEST(stats.flushes == 1u);
+    BOOST_TEST(stats.buffer_high_water == 64u);
+    BOOST_TEST(stats.convert_time.count() == 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(io_statistics_dsv) {
+  dfe::IoStatistics written;
+  std::size_t num_reports = 0;
+  {
+    dfe::NamedTupleCsvWriter<Record> writer("test_statistics.csv");
+    writer.set_statistics_callback([&](const dfe::IoStatistics& stats) {
+      written = stats;
+      num_reports += 1;
+    });
+    for (size_t i = 0; i < kNRecords; ++i) {
+      writer.append(make_record(i));
+    }
+    // nothing is written before the first flush
+    BOOST_TEST(writer.statistics().bytes == 0u);
+    BOOST_TEST(writer.statistics().records == (kNRecords + 1));
+    BOOST_TEST(0u < writer.statistics().buffer_high_water);
+    BOOST_TEST(0 < writer.statistics().convert_time.count());
+    writer.flush();
+    BOOST_TEST(num_reports == 1u);
+  }
+  // once from the final flush and once on destruction
+  BOOST_TEST(num_reports == 3u);
+  BOOST_TEST(written.bytes == file_size("test_statistics.csv"));
+  BOOST_TEST(written.records == (kNRecords + 1));
+  BOOST_TEST(written.flushes == 2u);
+
+  dfe::IoStatistics read;
+  {
+    dfe::NamedTupleCsvReader<Record> reader("test_statistics.csv");
+    reader.set_statistics_callback(
+      [&](const dfe::IoStatistics& stats) { read = stats; });
+    Record record;
+    while (reader.read(record)) {
+    }
+    BOOST_TEST(reader.statistics().records == (kNRecords + 1));
+    BOOST_TEST(0 < reader.statistics().convert_time.count());
+  }
+  BOOST_TEST(read.bytes == file_size("test_statistics.csv"));
+  BOOST_TEST(read.records == (kNRecords + 1));
+}
+
+BOOST_AUTO_TEST_CASE(io_statistics_numpy) {
+  dfe::IoStatistics written;
+  {
+    dfe::NamedTupleNumpyWriter<Record> writer("test_statistics.npy");
+    writer.set_statistics_callback(
+      [&](const dfe::IoStatistics& stats) { written = stats; });
+    for (size_t i = 0; i < kNRecords; ++i) {
+      writer.append(make_record(i));
+    }
+    BOOST_TEST(writer.statistics().records == kNRecords);
+  }
+  BOOST_TEST(written.bytes == file_size("test_statistics.npy"));
+  BOOST_TEST(written.records == kNRecords);
+  BOOST_TEST(written.flushes == 1u);
+  BOOST_TEST(0 < written.io_time.count());
+}
@@ -5,6 +5,9 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <cstdint>
+#include <string>
+
 #include "dfe/dfe_namedtuple.hpp"
 #include "record.hpp"
 
@@ -37,6 +40,69 @@ BOOST_AUTO_TEST_CASE(namedtuple_names) {
   BOOST_TEST(example.names().at(6) == "d");
 }
 
+BOOST_AUTO_TEST_CASE(namedtuple_field_names) {
+  constexpr auto names = Record::field_names();
+  static_assert(names.size() == 7, "Unexpected number of names");
+  static_assert(names[0] == "x", "Unexpected name");
+  static_assert(names[6] == "d", "Unexpected name");
+  static_assert(names[1] != "yy", "Unexpected name");
+
+  auto strings = Record::names();
+  for (std::size_t i = 0; i < names.size(); ++i) {
+    BOOST_TEST(names[i].size() == 1);
+    BOOST_TEST(names[i].to_string() == strings[i]);
+    BOOST_TEST((names[i] == strings[i]));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(namedtuple_layout) {
+  using Layout = dfe::NamedTupleLayout<Record>;
+
+  static_assert(Layout::kNumFields == 7, "Unexpected number of fields");
+  static_assert(Layout::index("x") == 0, "Unexpected index");
+  static_assert(Layout::index("d") == 6, "Unexpected index");
+  static_assert(Layout::index("THIS_IS_UNUSED") == 7, "Unexpected index");
+  static_assert(Layout::packed_size() == 35, "Unexpected packed size");
+  BOOST_TEST(Layout::index(std::string("c")) == 5);
+
+  constexpr auto sizes = Layout::sizes();
+  constexpr auto packed = Layout::packed_offsets();
+  static_assert(sizes[3] == sizeof(uint64_t), "Unexpected size");
+  static_assert(packed[4] == 22, "Unexpected packed offset");
+  static_assert(packed[6] == 34, "Unexpected packed offset");
+
+  // in-memory offsets must match the member addresses
+  Record r;
+  const char* base = reinterpret_cast<const char*>(&r);
+  const auto& offsets = Layout::offsets();
+  BOOST_TEST(&offsets == &Layout::offsets());
+  BOOST_TEST(offsets[0] == (reinterpret_cast<const char*>(&r.x) - base));
+  BOOST_TEST(offsets[4] == (reinterpret_cast<const char*>(&r.b) - base));
+  BOOST_TEST(offsets[6] == (reinterpret_cast<const char*>(&r.d) - base));
+  // unnamed members and padding prevent a packed layout
+  BOOST_TEST(not Layout::is_packed());
+}
+
+struct Packed {
+  double a = 0;
+  int32_t b = 0;
+  int32_t c = 0;
+
+  DFE_NAMEDTUPLE(Packed, a, b, c)
+};
+struct Reordered {
+  int32_t b = 0;
+  double a = 0;
+  int32_t c = 0;
+
+  DFE_NAMEDTUPLE(Reordered, a, b, c)
+};
+
+BOOST_AUTO_TEST_CASE(namedtuple_layout_packed) {
+  BOOST_TEST(dfe::NamedTupleLayout<Packed>::is_packed());
+  BOOST_TEST(not dfe::NamedTupleLayout<Reordered>::is_packed());
+}
+
 BOOST_AUTO_TEST_CASE(nametuple_assign_from_tuple) {
   // check default values
   Record r;
@@ -106,3 +172,30 @@ BOOST_AUTO_TEST_CASE(namedtuple_get_assign) {
   BOOST_TEST(r.x == updated);
   BOOST_TEST(get<0>(r) == updated);
 }
+
+BOOST_AUTO_TEST_CASE(namedtuple_columns) {
+  dfe::NamedTupleColumns<Record> columns;
+
+  BOOST_TEST(columns.empty());
+  BOOST_TEST(columns.size() == 0);
+  columns.reserve(16);
+  for (size_t i = 0; i < 16; ++i) {
+    columns.push_back(make_record(i));
+  }
+  BOOST_TEST(columns.size() == 16);
+  // boolean members are stored in contiguous bytes
+  BOOST_TEST((std::is_same<
+              dfe::NamedTupleColumns<Record>::Column<6>,
+              std::vector<uint8_t>>::value));
+  for (size_t i = 0; i < 16; ++i) {
+    auto expected = make_record(i);
+    BOOST_TEST(columns.column<0>()[i] == expected.x);
+    BOOST_TEST(columns.column<1>()[i] == expected.y);
+    BOOST_TEST(columns.column<5>()[i] == expected.c);
+    BOOST_TEST(columns.column<6>()[i] == expected.d);
+    BOOST_TEST(columns.record(i).tuple() == expected.tuple());
+  }
+  columns.clear();
+  BOOST_TEST(columns.empty());
+  BOOST_TEST(columns.column<3>().empty());
+}
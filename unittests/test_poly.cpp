@@ -3,6 +3,7 @@
 /// \file
 /// \brief Unit tests for dfe::poly
 
+#include <algorithm>
 #include <array>
 #include <valarray>
 #include <vector>
@@ -107,3 +108,73 @@ BOOST_AUTO_TEST_CASE(poly_cubic) {
   BOOST_TEST(dfe::polynomial_val(+0.0, {42.0, 1.0, 0.5, -1.0}) == 42.0);
   BOOST_TEST(dfe::polynomial_val(+0.5, {42.0, 1.0, 0.5, -1.0}) == 42.5);
 }
+
+// compile-time evaluation with fixed order
+
+BOOST_AUTO_TEST_CASE(poly_stdarray_constexpr) {
+  constexpr std::array<double, 4> coeffs = COEFFS;
+  constexpr double y = dfe::polynomial_val(X0, coeffs);
+  constexpr double d = dfe::polynomial_der(X0, coeffs);
+  constexpr auto yd = dfe::polynomial_valder(X0, coeffs);
+  constexpr double z = dfe::polynomial_val(X0, std::array<double, 0>{});
+  static_assert(y == Y0, "Compile-time evaluation failed");
+  static_assert(z == 0.0, "Compile-time evaluation failed");
+  BOOST_TEST(y == Y0);
+  BOOST_TEST(d == D0);
+  BOOST_TEST(yd == YD0);
+  BOOST_TEST(dfe::polynomial_der(X0, std::array<double, 1>{2.0}) == 0.0);
+}
+
+// Estrin's scheme must agree with Horner's method
+
+BOOST_AUTO_TEST_CASE(poly_estrin) {
+  constexpr std::array<double, 4> fixed = COEFFS;
+  static_assert(
+    dfe::polynomial_val_estrin(X0, fixed) == Y0,
+    "Compile-time evaluation failed");
+
+  for (std::size_t order = 0; order < 24; ++order) {
+    std::vector<double> coeffs;
+    for (std::size_t i = 0; i < order; ++i) {
+      coeffs.push_back(1.0 / (1.0 + i));
+    }
+    for (double x : {-1.5, -0.25, 0.0, 0.5, 2.0}) {
+      auto expected = dfe::polynomial_val(x, coeffs);
+      auto estrin = dfe::polynomial_val_estrin(x, coeffs);
+      BOOST_TEST(estrin == expected, boost::test_tools::tolerance(1e-12));
+    }
+  }
+}
+
+// evaluate multiple values at once
+
+BOOST_AUTO_TEST_CASE(poly_batch) {
+  std::vector<double> coeffs = COEFFS;
+  // not a multiple of the internal block size
+  std::vector<double> x(1027);
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    x[i] = -1.0 + (2.0 / x.size()) * i;
+  }
+  std::vector<double> values(x.size());
+  std::vector<double> derivatives(x.size());
+
+  dfe::polynomial_val_n(x.data(), x.size(), coeffs, values.data());
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    BOOST_TEST(values[i] == dfe::polynomial_val(x[i], coeffs));
+  }
+  std::fill(values.begin(), values.end(), 0.0);
+  dfe::polynomial_valder_n(
+    x.data(), x.size(), coeffs, values.data(), derivatives.data());
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    auto yd = dfe::polynomial_valder(x[i], coeffs);
+    BOOST_TEST(values[i] == yd.first);
+    BOOST_TEST(derivatives[i] == yd.second);
+  }
+  // in-place evaluation with fixed order coefficients
+  std::array<double, 4> fixed = COEFFS;
+  auto y = x;
+  dfe::polynomial_val_n(y.data(), y.size(), fixed, y.data());
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    BOOST_TEST(y[i] == dfe::polynomial_val(x[i], coeffs));
+  }
+}
@@ -6,7 +6,11 @@
 #include <boost/test/unit_test.hpp>
 
 #include <iterator>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "dfe/dfe_smallvector.hpp"
 
@@ -87,3 +91,164 @@ BOOST_AUTO_TEST_CASE(smallvector_simpleclass) {
     BOOST_TEST(j == sm.size());
   }
 }
+
+// counts live objects to detect missing or duplicate destructor calls
+struct Counted {
+  static int alive;
+  int value;
+
+  Counted(int v = 0) : value(v) { alive += 1; }
+  Counted(const Counted& other) : value(other.value) { alive += 1; }
+  Counted(Counted&& other) noexcept : value(other.value) {
+    other.value = -1;
+    alive += 1;
+  }
+  Counted& operator=(const Counted&) = default;
+  Counted& operator=(Counted&& other) noexcept {
+    value = other.value;
+    other.value = -1;
+    return *this;
+  }
+  ~Counted() { alive -= 1; }
+};
+int Counted::alive = 0;
+
+template<typename Vector>
+std::vector<int>
+values(const Vector& v) {
+  std::vector<int> vs;
+  for (const auto& x : v) {
+    vs.push_back(x.value);
+  }
+  return vs;
+}
+
+BOOST_AUTO_TEST_CASE(smallvector_copy_move) {
+  using Vector = dfe::SmallVector<Counted, 4>;
+  {
+    Vector small = {1, 2, 3};
+    Vector large = {1, 2, 3, 4, 5, 6, 7, 8};
+    BOOST_TEST(Counted::alive == 11);
+
+    // copies are independent
+    Vector small_copy(small);
+    Vector large_copy(large);
+    BOOST_TEST(values(small_copy) == values(small));
+    BOOST_TEST(values(large_copy) == values(large));
+    small_copy[0] = 23;
+    BOOST_TEST(small[0].value == 1);
+    BOOST_TEST(Counted::alive == 22);
+
+    // moving heap storage only transfers the pointer
+    const Counted* data = large.data();
+    Vector large_moved(std::move(large));
+    BOOST_TEST(large_moved.data() == data);
+    BOOST_TEST(large.empty());
+    BOOST_TEST(large.capacity() == 4u);
+    Vector small_moved(std::move(small));
+    BOOST_TEST(values(small_moved) == (std::vector<int>{1, 2, 3}));
+    BOOST_TEST(small.empty());
+
+    // assignments in all combinations of in-place and heap storage
+    small = large_moved;
+    BOOST_TEST(values(small) == values(large_moved));
+    large = small_moved;
+    BOOST_TEST(values(large) == (std::vector<int>{1, 2, 3}));
+    data = small.data();
+    large = std::move(small);
+    BOOST_TEST(large.data() == data);
+    BOOST_TEST(large.size() == 8u);
+    small = std::move(small_moved);
+    BOOST_TEST(values(small) == (std::vector<int>{1, 2, 3}));
+    large = *&large;
+    BOOST_TEST(large.size() == 8u);
+  }
+  BOOST_TEST(Counted::alive == 0);
+}
+
+BOOST_AUTO_TEST_CASE(smallvector_reserve_resize) {
+  {
+    dfe::SmallVector<Counted, 4> v;
+    BOOST_TEST(v.capacity() == 4u);
+    v.reserve(2);
+    BOOST_TEST(v.capacity() == 4u);
+    v.reserve(100);
+    BOOST_TEST(v.capacity() == 100u);
+    v.resize(10, Counted(7));
+    BOOST_TEST(v.size() == 10u);
+    BOOST_TEST(v.back().value == 7);
+    BOOST_TEST(Counted::alive == 10);
+    // clear keeps the memory, shrink_to_fit releases it
+    v.clear();
+    BOOST_TEST(v.capacity() == 100u);
+    v.resize(3);
+    BOOST_TEST(Counted::alive == 3);
+    BOOST_TEST(v[2].value == 0);
+    v.shrink_to_fit();
+    BOOST_TEST(v.capacity() == 4u);
+    BOOST_TEST(v.size() == 3u);
+    v.resize(1);
+    BOOST_TEST(Counted::alive == 1);
+    // resize with a reference to an existing element while reallocating
+    v[0].value = 5;
+    v.resize(32, v[0]);
+    BOOST_TEST(v[31].value == 5);
+  }
+  BOOST_TEST(Counted::alive == 0);
+
+  // geometric growth
+  dfe::SmallVector<int, 2> g;
+  std::size_t num_reallocations = 0;
+  for (int i = 0; i < 10000; ++i) {
+    const int* data = g.data();
+    g.push_back(i);
+    num_reallocations += (data != g.data()) ? 1 : 0;
+  }
+  BOOST_TEST(num_reallocations < 20u);
+  BOOST_CHECK_THROW(g.at(10000), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(smallvector_erase_empty_range) {
+  dfe::SmallVector<std::string, 2> v = {"first", "second", "third"};
+  BOOST_TEST(*v.erase(v.begin(), v.begin()) == "first");
+  BOOST_TEST(v.erase(v.end(), v.end()) == v.end());
+  BOOST_TEST(v.size() == 3u);
+  BOOST_TEST(v[0] == "first");
+  BOOST_TEST(v[1] == "second");
+  BOOST_TEST(v[2] == "third");
+}
+
+BOOST_AUTO_TEST_CASE(smallvector_insert_erase) {
+  {
+    dfe::SmallVector<Counted, 4> v = {0, 1, 2};
+    std::vector<Counted> more = {10, 11, 12, 13};
+
+    v.insert(v.begin() + 1, more.begin(), more.end());
+    BOOST_TEST(values(v) == (std::vector<int>{0, 10, 11, 12, 13, 1, 2}));
+    v.append(more.begin(), more.begin() + 2);
+    BOOST_TEST(
+      values(v) == (std::vector<int>{0, 10, 11, 12, 13, 1, 2, 10, 11}));
+    BOOST_TEST(v.erase(v.begin() + 1, v.begin() + 5)->value == 1);
+    BOOST_TEST(values(v) == (std::vector<int>{0, 1, 2, 10, 11}));
+    BOOST_TEST(v.erase(v.begin())->value == 1);
+    v.pop_back();
+    BOOST_TEST(values(v) == (std::vector<int>{1, 2, 10}));
+    // insert a reference to an existing element with and without growth
+    v.insert(v.begin(), v[2]);
+    BOOST_TEST(values(v) == (std::vector<int>{10, 1, 2, 10}));
+    v.insert(v.begin(), v.back());
+    BOOST_TEST(values(v) == (std::vector<int>{10, 10, 1, 2, 10}));
+    BOOST_TEST(Counted::alive == (5 + 4));
+  }
+  BOOST_TEST(Counted::alive == 0);
+
+  // input iterators can only be read once
+  std::istringstream input("1 2 3 4 5 6");
+  dfe::SmallVector<int, 2> v(2, 0);
+  v.insert(
+    v.begin() + 1, std::istream_iterator<int>(input),
+    std::istream_iterator<int>());
+  BOOST_TEST(
+    (std::vector<int>(v.begin(), v.end()))
+    == (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 0}));
+}